@@ -11,6 +11,22 @@
 
 #include "extensions/tweak/tweak.h"
 #include "extensions/pbkdf2/pbkdf2.h"
+#include "extensions/aead/aead.h"
+#include "extensions/poly1305/poly1305.h"
+#include "extensions/x25519/x25519.h"
+#include "extensions/nonce_sequence/nonce_sequence.h"
+#include "extensions/pad/pad.h"
+#include "extensions/box_cache/box_cache.h"
+#include "extensions/box_seal_many/box_seal_many.h"
+#include "extensions/keypair_pool/keypair_pool.h"
+#include "extensions/envelope/envelope.h"
+#include "extensions/noise/noise.h"
+#include "extensions/transport/transport.h"
+#include "extensions/ed25519_convert/ed25519_convert.h"
+#include "extensions/ratchet/ratchet.h"
+#include "extensions/secretstream_engine/secretstream_engine.h"
+#include "extensions/secretstream_file/secretstream_file.h"
+#include "extensions/seal_stream/seal_stream.h"
 #include "sodium/crypto_generichash.h"
 
 static uint8_t typedarray_width (js_typedarray_type_t type) {
@@ -30,6 +46,138 @@ static uint8_t typedarray_width (js_typedarray_type_t type) {
   }
 }
 
+typedef struct sn_iovec_t {
+  uint8_t *data;
+  size_t size;
+} sn_iovec_t;
+
+// reads a TypedArray or an Array of TypedArrays into a list of segments
+static int
+sn_get_iovecs (js_env_t *env, js_value_t *value, bool optional, std::vector<sn_iovec_t> &iov, size_t *total, const char *message) {
+  int err;
+
+  *total = 0;
+
+  js_value_type_t type;
+  err = js_typeof(env, value, &type);
+  assert(err == 0);
+
+  if (optional && (type == js_null || type == js_undefined)) return 0;
+
+  bool is_typedarray;
+  err = js_is_typedarray(env, value, &is_typedarray);
+  assert(err == 0);
+
+  if (is_typedarray) {
+    js_typedarray_type_t value_type;
+    sn_iovec_t seg;
+    err = js_get_typedarray_info(env, value, &value_type, (void **) &seg.data, &seg.size, NULL, NULL);
+    assert(err == 0);
+
+    seg.size *= typedarray_width(value_type);
+
+    iov.push_back(seg);
+    *total = seg.size;
+
+    return 0;
+  }
+
+  bool is_array;
+  err = js_is_array(env, value, &is_array);
+  assert(err == 0);
+
+  if (!is_array) {
+    err = js_throw_type_error(env, NULL, message);
+    assert(err == 0);
+    return -1;
+  }
+
+  uint32_t len;
+  err = js_get_array_length(env, value, &len);
+  assert(err == 0);
+
+  iov.reserve(len);
+
+  for (uint32_t i = 0; i < len; i++) {
+    js_value_t *element;
+    err = js_get_element(env, value, i, &element);
+    assert(err == 0);
+
+    err = js_is_typedarray(env, element, &is_typedarray);
+    assert(err == 0);
+
+    if (!is_typedarray) {
+      err = js_throw_type_error(env, NULL, message);
+      assert(err == 0);
+      return -1;
+    }
+
+    js_typedarray_type_t element_type;
+    sn_iovec_t seg;
+    err = js_get_typedarray_info(env, element, &element_type, (void **) &seg.data, &seg.size, NULL, NULL);
+    assert(err == 0);
+
+    seg.size *= typedarray_width(element_type);
+
+    iov.push_back(seg);
+    *total += seg.size;
+  }
+
+  return 0;
+}
+
+typedef struct sn_iovec_cursor_t {
+  const std::vector<sn_iovec_t> *iov;
+  size_t index;
+  size_t offset;
+} sn_iovec_cursor_t;
+
+// returns the contiguous bytes available at the cursor, skipping exhausted segments
+static inline size_t
+sn_iovec_peek (sn_iovec_cursor_t *cur, uint8_t **data) {
+  while (cur->index < cur->iov->size()) {
+    const sn_iovec_t &seg = (*cur->iov)[cur->index];
+
+    if (cur->offset < seg.size) {
+      *data = seg.data + cur->offset;
+      return seg.size - cur->offset;
+    }
+
+    cur->index++;
+    cur->offset = 0;
+  }
+
+  return 0;
+}
+
+static inline void
+sn_iovec_copy_out (sn_iovec_cursor_t *cur, uint8_t *dst, size_t len) {
+  while (len) {
+    uint8_t *src;
+    size_t n = sn_iovec_peek(cur, &src);
+    if (n > len) n = len;
+
+    memcpy(dst, src, n);
+    cur->offset += n;
+    dst += n;
+    len -= n;
+  }
+}
+
+static inline void
+sn_iovec_copy_in (sn_iovec_cursor_t *cur, const uint8_t *src, size_t len) {
+  while (len) {
+    uint8_t *dst;
+    size_t n = sn_iovec_peek(cur, &dst);
+    if (n > len) n = len;
+
+    memcpy(dst, src, n);
+    cur->offset += n;
+    src += n;
+    len -= n;
+  }
+}
+
 js_value_t *
 sn_sodium_memzero (js_env_t *env, js_callback_info_t *info) {
   SN_ARGV(1, sodium_memzero)
@@ -441,6 +589,58 @@ sn_crypto_sign_ed25519_pk_to_curve25519(js_env_t *env, js_callback_info_t *info)
   SN_RETURN(crypto_sign_ed25519_pk_to_curve25519(x25519_pk_data, ed25519_pk_data), "public key conversion failed")
 }
 
+js_value_t *
+sn_crypto_sign_ed25519_pk_to_curve25519_many (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV_OPTS(3, 4, crypto_sign_ed25519_pk_to_curve25519_many)
+
+  SN_ARGV_TYPEDARRAY(x25519_pks, 0)
+  SN_ARGV_TYPEDARRAY(ed25519_pks, 1)
+  SN_ARGV_UINT32(count, 2)
+  SN_ARGV_OPTS_TYPEDARRAY(cache, 3)
+
+  SN_THROWS(x25519_pks_size != (size_t) count * crypto_box_PUBLICKEYBYTES, "x25519_pks must be 'count * crypto_box_PUBLICKEYBYTES' bytes")
+  SN_THROWS(ed25519_pks_size != (size_t) count * crypto_sign_PUBLICKEYBYTES, "ed25519_pks must be 'count * crypto_sign_PUBLICKEYBYTES' bytes")
+
+  sn__extension_ed25519_convert_cache *convert_cache = (sn__extension_ed25519_convert_cache *) cache_data;
+  unsigned char *skip = NULL;
+
+  if (use_cache) {
+    SN_THROWS(((uintptr_t) cache_data) % 8 != 0, "cache must be 8 byte aligned")
+    SN_THROWS(cache_size < sn__extension_ed25519_convert_HEADERBYTES || convert_cache->capacity != sn__extension_ed25519_convert_cache_capacity(cache_size), "cache must be initialised with extension_ed25519_convert_cache_init")
+
+    skip = (unsigned char *) malloc(count > 0 ? count : 1);
+    SN_THROWS(skip == NULL, "ENOMEM")
+
+    for (size_t i = 0; i < count; i++) {
+      const unsigned char *hit = sn__extension_ed25519_convert_cache_get(convert_cache, ed25519_pks_data + i * crypto_sign_PUBLICKEYBYTES);
+
+      skip[i] = hit != NULL;
+      if (hit != NULL) memcpy(x25519_pks_data + i * crypto_box_PUBLICKEYBYTES, hit, crypto_box_PUBLICKEYBYTES);
+    }
+  }
+
+  size_t failures = sn__extension_ed25519_convert_range(x25519_pks_data, ed25519_pks_data, skip, 0, count);
+
+  if (use_cache) {
+    for (size_t i = 0; i < count; i++) {
+      const unsigned char *ed25519_pk = ed25519_pks_data + i * crypto_sign_PUBLICKEYBYTES;
+      const unsigned char *x25519_pk = x25519_pks_data + i * crypto_box_PUBLICKEYBYTES;
+
+      // failed keys come out all zero, and a batch may repeat a key
+      if (skip[i] || sodium_is_zero(x25519_pk, crypto_box_PUBLICKEYBYTES)) continue;
+      if (sn__extension_ed25519_convert_cache_get(convert_cache, ed25519_pk) != NULL) continue;
+
+      sn__extension_ed25519_convert_cache_put(convert_cache, ed25519_pk, x25519_pk);
+    }
+
+    free(skip);
+  }
+
+  SN_THROWS(failures != 0, "public key conversion failed")
+
+  return NULL;
+}
+
 js_value_t *
 sn_crypto_sign_ed25519_sk_to_curve25519(js_env_t *env, js_callback_info_t *info) {
   SN_ARGV(2, crypto_sign_ed25519_sk_to_pk)
@@ -693,7 +893,7 @@ sn_crypto_box_easy(js_env_t *env, js_callback_info_t *info) {
   SN_ASSERT_LENGTH(sk_size, crypto_box_SECRETKEYBYTES, "sk")
   SN_ASSERT_LENGTH(pk_size, crypto_box_PUBLICKEYBYTES, "pk")
 
-  SN_RETURN(crypto_box_easy(c_data, m_data, m_size, n_data, pk_data, sk_data), "crypto box failed")
+  SN_RETURN(sn__extension_x25519_box_easy(c_data, m_data, m_size, n_data, pk_data, sk_data), "crypto box failed")
 }
 
 js_value_t *
@@ -712,7 +912,7 @@ sn_crypto_box_open_easy(js_env_t *env, js_callback_info_t *info) {
   SN_ASSERT_LENGTH(sk_size, crypto_box_SECRETKEYBYTES, "sk")
   SN_ASSERT_LENGTH(pk_size, crypto_box_PUBLICKEYBYTES, "pk")
 
-  SN_RETURN_BOOLEAN(crypto_box_open_easy(m_data, c_data, c_size, n_data, pk_data, sk_data))
+  SN_RETURN_BOOLEAN(sn__extension_x25519_box_open_easy(m_data, c_data, c_size, n_data, pk_data, sk_data))
 }
 
 js_value_t *
@@ -732,7 +932,7 @@ sn_crypto_box_detached(js_env_t *env, js_callback_info_t *info) {
   SN_ASSERT_LENGTH(sk_size, crypto_box_SECRETKEYBYTES, "sk")
   SN_ASSERT_LENGTH(pk_size, crypto_box_PUBLICKEYBYTES, "pk")
 
-  SN_RETURN(crypto_box_detached(c_data, mac_data, m_data, m_size, n_data, pk_data, sk_data), "signature failed")
+  SN_RETURN(sn__extension_x25519_box_detached(c_data, mac_data, m_data, m_size, n_data, pk_data, sk_data), "signature failed")
 }
 
 js_value_t *
@@ -752,7 +952,91 @@ sn_crypto_box_open_detached(js_env_t *env, js_callback_info_t *info) {
   SN_ASSERT_LENGTH(sk_size, crypto_box_SECRETKEYBYTES, "sk")
   SN_ASSERT_LENGTH(pk_size, crypto_box_PUBLICKEYBYTES, "pk")
 
-  SN_RETURN_BOOLEAN(crypto_box_open_detached(m_data, c_data, mac_data, c_size, n_data, pk_data, sk_data))
+  SN_RETURN_BOOLEAN(sn__extension_x25519_box_open_detached(m_data, c_data, mac_data, c_size, n_data, pk_data, sk_data))
+}
+
+js_value_t *
+sn_crypto_box_beforenm(js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, crypto_box_beforenm)
+
+  SN_ARGV_TYPEDARRAY(k, 0)
+  SN_ARGV_TYPEDARRAY(pk, 1)
+  SN_ARGV_TYPEDARRAY(sk, 2)
+
+  SN_ASSERT_LENGTH(k_size, crypto_box_BEFORENMBYTES, "k")
+  SN_ASSERT_LENGTH(pk_size, crypto_box_PUBLICKEYBYTES, "pk")
+  SN_ASSERT_LENGTH(sk_size, crypto_box_SECRETKEYBYTES, "sk")
+
+  SN_RETURN(sn__extension_x25519_box_beforenm(k_data, pk_data, sk_data), "shared key computation failed")
+}
+
+js_value_t *
+sn_crypto_box_easy_afternm(js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(4, crypto_box_easy_afternm)
+
+  SN_ARGV_TYPEDARRAY(c, 0)
+  SN_ARGV_TYPEDARRAY(m, 1)
+  SN_ARGV_TYPEDARRAY(n, 2)
+  SN_ARGV_TYPEDARRAY(k, 3)
+
+  SN_THROWS(c_size != m_size + crypto_box_MACBYTES, "c must be 'm.byteLength + crypto_box_MACBYTES' bytes")
+  SN_ASSERT_LENGTH(n_size, crypto_box_NONCEBYTES, "n")
+  SN_ASSERT_LENGTH(k_size, crypto_box_BEFORENMBYTES, "k")
+
+  SN_RETURN(crypto_box_easy_afternm(c_data, m_data, m_size, n_data, k_data), "crypto box failed")
+}
+
+js_value_t *
+sn_crypto_box_open_easy_afternm(js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(4, crypto_box_open_easy_afternm)
+
+  SN_ARGV_TYPEDARRAY(m, 0)
+  SN_ARGV_TYPEDARRAY(c, 1)
+  SN_ARGV_TYPEDARRAY(n, 2)
+  SN_ARGV_TYPEDARRAY(k, 3)
+
+  SN_ASSERT_MIN_LENGTH(c_size, crypto_box_MACBYTES, "c")
+  SN_THROWS(m_size != c_size - crypto_box_MACBYTES, "m must be 'c.byteLength - crypto_box_MACBYTES' bytes")
+  SN_ASSERT_LENGTH(n_size, crypto_box_NONCEBYTES, "n")
+  SN_ASSERT_LENGTH(k_size, crypto_box_BEFORENMBYTES, "k")
+
+  SN_RETURN_BOOLEAN(crypto_box_open_easy_afternm(m_data, c_data, c_size, n_data, k_data))
+}
+
+js_value_t *
+sn_crypto_box_detached_afternm(js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(5, crypto_box_detached_afternm)
+
+  SN_ARGV_TYPEDARRAY(c, 0)
+  SN_ARGV_TYPEDARRAY(mac, 1)
+  SN_ARGV_TYPEDARRAY(m, 2)
+  SN_ARGV_TYPEDARRAY(n, 3)
+  SN_ARGV_TYPEDARRAY(k, 4)
+
+  SN_THROWS(c_size != m_size, "c must be 'm.byteLength' bytes")
+  SN_ASSERT_LENGTH(mac_size, crypto_box_MACBYTES, "mac")
+  SN_ASSERT_LENGTH(n_size, crypto_box_NONCEBYTES, "n")
+  SN_ASSERT_LENGTH(k_size, crypto_box_BEFORENMBYTES, "k")
+
+  SN_RETURN(crypto_box_detached_afternm(c_data, mac_data, m_data, m_size, n_data, k_data), "crypto box failed")
+}
+
+js_value_t *
+sn_crypto_box_open_detached_afternm(js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(5, crypto_box_open_detached_afternm)
+
+  SN_ARGV_TYPEDARRAY(m, 0)
+  SN_ARGV_TYPEDARRAY(c, 1)
+  SN_ARGV_TYPEDARRAY(mac, 2)
+  SN_ARGV_TYPEDARRAY(n, 3)
+  SN_ARGV_TYPEDARRAY(k, 4)
+
+  SN_THROWS(m_size != c_size, "m must be 'c.byteLength' bytes")
+  SN_ASSERT_LENGTH(mac_size, crypto_box_MACBYTES, "mac")
+  SN_ASSERT_LENGTH(n_size, crypto_box_NONCEBYTES, "n")
+  SN_ASSERT_LENGTH(k_size, crypto_box_BEFORENMBYTES, "k")
+
+  SN_RETURN_BOOLEAN(crypto_box_open_detached_afternm(m_data, c_data, mac_data, c_size, n_data, k_data))
 }
 
 js_value_t *
@@ -803,6 +1087,7 @@ sn_crypto_box_seal_open(
   return crypto_box_seal_open(&m[m_offset], &c[c_offset], c_len, &pk[pk_offset], &sk[sk_offset]) == 0;
 }
 
+template <bool sequence>
 js_value_t *
 sn_crypto_secretbox_easy(js_env_t *env, js_callback_info_t *info) {
   SN_ARGV(4, crypto_secretbox_easy)
@@ -813,8 +1098,9 @@ sn_crypto_secretbox_easy(js_env_t *env, js_callback_info_t *info) {
   SN_ARGV_TYPEDARRAY(k, 3)
 
   SN_THROWS(c_size != m_size + crypto_secretbox_MACBYTES, "c must be 'm.byteLength + crypto_secretbox_MACBYTES' bytes")
-  SN_ASSERT_LENGTH(n_size, crypto_secretbox_NONCEBYTES, "n")
+  SN_ASSERT_NONCE(sequence, n, crypto_secretbox_NONCEBYTES)
   SN_ASSERT_LENGTH(k_size, crypto_secretbox_KEYBYTES, "k")
+  SN_NONCE_SEQUENCE(sequence, n, crypto_secretbox_NONCEBYTES)
 
   SN_RETURN(crypto_secretbox_easy(c_data, m_data, m_size, n_data, k_data), "crypto secretbox failed")
 }
@@ -836,6 +1122,59 @@ sn_crypto_secretbox_open_easy(js_env_t *env, js_callback_info_t *info) {
   SN_RETURN_BOOLEAN(crypto_secretbox_open_easy(m_data, c_data, c_size, n_data, k_data))
 }
 
+template <bool sequence>
+js_value_t *
+sn_crypto_secretbox_easy_padded(js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(5, crypto_secretbox_easy_padded)
+
+  SN_ARGV_TYPEDARRAY(c, 0)
+  SN_ARGV_TYPEDARRAY(m, 1)
+  SN_ARGV_TYPEDARRAY(n, 2)
+  SN_ARGV_TYPEDARRAY(k, 3)
+  SN_ARGV_UINT32(block_size, 4)
+
+  size_t padded_size = sn__extension_pad_padded_length(m_size, block_size);
+
+  SN_THROWS(block_size < 1, "blockSize must be at least 1")
+  SN_THROWS(padded_size == 0 || c_size < padded_size + crypto_secretbox_MACBYTES, "c must be at least the padded 'm.byteLength + crypto_secretbox_MACBYTES' bytes")
+  SN_THROWS(padded_size + crypto_secretbox_MACBYTES > 0xffffffff, "c.byteLength must be a 32bit integer")
+  SN_ASSERT_NONCE(sequence, n, crypto_secretbox_NONCEBYTES)
+  SN_ASSERT_LENGTH(k_size, crypto_secretbox_KEYBYTES, "k")
+  SN_NONCE_SEQUENCE(sequence, n, crypto_secretbox_NONCEBYTES)
+
+  SN_CALL(sn__extension_pad_secretbox_easy(c_data, m_data, m_size, block_size, n_data, k_data), "crypto secretbox failed")
+
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) (padded_size + crypto_secretbox_MACBYTES), &result), "")
+  return result;
+}
+
+js_value_t *
+sn_crypto_secretbox_open_easy_padded(js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(5, crypto_secretbox_open_easy_padded)
+
+  SN_ARGV_TYPEDARRAY(m, 0)
+  SN_ARGV_TYPEDARRAY(c, 1)
+  SN_ARGV_TYPEDARRAY(n, 2)
+  SN_ARGV_TYPEDARRAY(k, 3)
+  SN_ARGV_UINT32(block_size, 4)
+
+  SN_THROWS(block_size < 1, "blockSize must be at least 1")
+  SN_ASSERT_MIN_LENGTH(c_size, crypto_secretbox_MACBYTES, "c")
+  SN_THROWS(m_size < c_size - crypto_secretbox_MACBYTES, "m must be at least 'c - crypto_secretbox_MACBYTES' bytes")
+  SN_THROWS(c_size > 0xffffffff, "c.byteLength must be a 32bit integer")
+  SN_ASSERT_LENGTH(n_size, crypto_secretbox_NONCEBYTES, "n")
+  SN_ASSERT_LENGTH(k_size, crypto_secretbox_KEYBYTES, "k")
+
+  size_t unpadded_size;
+  SN_CALL(sn__extension_pad_secretbox_open_easy(m_data, &unpadded_size, c_data, c_size, block_size, n_data, k_data), "could not verify data")
+
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) unpadded_size, &result), "")
+  return result;
+}
+
+template <bool sequence>
 js_value_t *
 sn_crypto_secretbox_detached(js_env_t *env, js_callback_info_t *info) {
   SN_ARGV(5, crypto_secretbox_detached)
@@ -848,8 +1187,9 @@ sn_crypto_secretbox_detached(js_env_t *env, js_callback_info_t *info) {
 
   SN_THROWS(c_size != m_size, "c must 'm.byteLength' bytes")
   SN_ASSERT_LENGTH(mac_size, crypto_secretbox_MACBYTES, "mac")
-  SN_ASSERT_LENGTH(n_size, crypto_secretbox_NONCEBYTES, "n")
+  SN_ASSERT_NONCE(sequence, n, crypto_secretbox_NONCEBYTES)
   SN_ASSERT_LENGTH(k_size, crypto_secretbox_KEYBYTES, "k")
+  SN_NONCE_SEQUENCE(sequence, n, crypto_secretbox_NONCEBYTES)
 
   SN_RETURN(crypto_secretbox_detached(c_data, mac_data, m_data, m_size, n_data, k_data), "failed to open box")
 }
@@ -956,7 +1296,7 @@ sn_crypto_stream_chacha20_xor_ic(js_env_t *env, js_callback_info_t *info) {
   SN_ARGV_TYPEDARRAY(c, 0)
   SN_ARGV_TYPEDARRAY(m, 1)
   SN_ARGV_TYPEDARRAY(n, 2)
-  SN_ARGV_UINT32(ic, 3)
+  SN_ARGV_UINT64(ic, 3)
   SN_ARGV_TYPEDARRAY(k, 4)
 
   SN_THROWS(c_size != m_size, "m must be 'c.byteLength' bytes")
@@ -1050,7 +1390,7 @@ sn_crypto_stream_xchacha20_xor_ic(js_env_t *env, js_callback_info_t *info) {
   SN_ARGV_TYPEDARRAY(c, 0)
   SN_ARGV_TYPEDARRAY(m, 1)
   SN_ARGV_TYPEDARRAY(n, 2)
-  SN_ARGV_UINT32(ic, 3)
+  SN_ARGV_UINT64(ic, 3)
   SN_ARGV_TYPEDARRAY(k, 4)
 
   SN_THROWS(c_size != m_size, "m must be 'c.byteLength' bytes")
@@ -1097,7 +1437,7 @@ sn_crypto_stream_salsa20_xor_ic(js_env_t *env, js_callback_info_t *info) {
   SN_ARGV_TYPEDARRAY(c, 0)
   SN_ARGV_TYPEDARRAY(m, 1)
   SN_ARGV_TYPEDARRAY(n, 2)
-  SN_ARGV_UINT32(ic, 3)
+  SN_ARGV_UINT64(ic, 3)
   SN_ARGV_TYPEDARRAY(k, 4)
 
   SN_THROWS(c_size != m_size, "m must be 'c.byteLength' bytes")
@@ -1135,6 +1475,9 @@ sn_crypto_auth_verify (js_env_t *env, js_callback_info_t *info) {
   SN_RETURN_BOOLEAN(crypto_auth_verify(h_data, in_data, in_size, k_data))
 }
 
+// onetimeauth runs on the extension Poly1305 (AVX2 when available), its state fits in crypto_onetimeauth_STATEBYTES
+static_assert(sizeof(sn__extension_poly1305_state) <= sizeof(crypto_onetimeauth_state), "poly1305 state too large");
+
 js_value_t *
 sn_crypto_onetimeauth (js_env_t *env, js_callback_info_t *info) {
   SN_ARGV(3, crypto_onetimeauth)
@@ -1146,45 +1489,51 @@ sn_crypto_onetimeauth (js_env_t *env, js_callback_info_t *info) {
   SN_ASSERT_LENGTH(out_size, crypto_onetimeauth_BYTES, "out")
   SN_ASSERT_LENGTH(k_size, crypto_onetimeauth_KEYBYTES, "k")
 
-  SN_RETURN(crypto_onetimeauth(out_data, in_data, in_size, k_data), "failed to generate onetime authentication tag")
+  SN_RETURN(sn__extension_poly1305(out_data, in_data, in_size, k_data), "failed to generate onetime authentication tag")
 }
 
 js_value_t *
 sn_crypto_onetimeauth_init (js_env_t *env, js_callback_info_t *info) {
   SN_ARGV(2, crypto_onetimeauth_init)
 
-  SN_ARGV_BUFFER_CAST(crypto_onetimeauth_state *, state, 0)
+  SN_ARGV_BUFFER_CAST(sn__extension_poly1305_state *, state, 0)
   SN_ARGV_TYPEDARRAY(k, 1)
 
   SN_THROWS(state_size != sizeof(crypto_onetimeauth_state), "state must be 'crypto_onetimeauth_STATEBYTES' bytes")
   SN_ASSERT_LENGTH(k_size, crypto_onetimeauth_KEYBYTES, "k")
 
-  SN_RETURN(crypto_onetimeauth_init(state, k_data), "failed to initialise onetime authentication")
+  sn__extension_poly1305_init(state, k_data);
+
+  return NULL;
 }
 
 js_value_t *
 sn_crypto_onetimeauth_update(js_env_t *env, js_callback_info_t *info) {
   SN_ARGV(2, crypto_onetimeauth_update)
 
-  SN_ARGV_BUFFER_CAST(crypto_onetimeauth_state *, state, 0)
+  SN_ARGV_BUFFER_CAST(sn__extension_poly1305_state *, state, 0)
   SN_ARGV_TYPEDARRAY(in, 1)
 
   SN_THROWS(state_size != sizeof(crypto_onetimeauth_state), "state must be 'crypto_onetimeauth_STATEBYTES' bytes")
 
-  SN_RETURN(crypto_onetimeauth_update(state, in_data, in_size), "update failed")
+  sn__extension_poly1305_update(state, in_data, in_size);
+
+  return NULL;
 }
 
 js_value_t *
 sn_crypto_onetimeauth_final(js_env_t *env, js_callback_info_t *info) {
   SN_ARGV(2, crypto_onetimeauth_final)
 
-  SN_ARGV_BUFFER_CAST(crypto_onetimeauth_state *, state, 0)
+  SN_ARGV_BUFFER_CAST(sn__extension_poly1305_state *, state, 0)
   SN_ARGV_TYPEDARRAY(out, 1)
 
   SN_THROWS(state_size != sizeof(crypto_onetimeauth_state), "state must be 'crypto_onetimeauth_STATEBYTES' bytes")
   SN_ASSERT_LENGTH(out_size, crypto_onetimeauth_BYTES, "out")
 
-  SN_RETURN(crypto_onetimeauth_final(state, out_data), "failed to generate authentication tag")
+  sn__extension_poly1305_final(state, out_data);
+
+  return NULL;
 }
 
 js_value_t *
@@ -1198,7 +1547,7 @@ sn_crypto_onetimeauth_verify (js_env_t *env, js_callback_info_t *info) {
   SN_ASSERT_LENGTH(h_size, crypto_onetimeauth_BYTES, "h")
   SN_ASSERT_LENGTH(k_size, crypto_onetimeauth_KEYBYTES, "k")
 
-  SN_RETURN_BOOLEAN(crypto_onetimeauth_verify(h_data, in_data, in_size, k_data))
+  SN_RETURN_BOOLEAN(sn__extension_poly1305_verify(h_data, in_data, in_size, k_data))
 }
 
 // CHECK: memlimit can be >32bit
@@ -1390,7 +1739,7 @@ sn_crypto_kx_client_session_keys (js_env_t *env, js_callback_info_t *info) {
   SN_THROWS(tx_size != crypto_kx_SESSIONKEYBYTES && tx_data != NULL, "transmitting key buffer must be 'crypto_kx_SESSIONKEYBYTES' bytes or null")
   SN_THROWS(rx_size != crypto_kx_SESSIONKEYBYTES && rx_data != NULL, "receiving key buffer must be 'crypto_kx_SESSIONKEYBYTES' bytes or null")
 
-  SN_RETURN(crypto_kx_client_session_keys(rx_data, tx_data, client_pk_data, client_sk_data, server_pk_data), "failed to derive session keys")
+  SN_RETURN(sn__extension_x25519_kx_client_session_keys(rx_data, tx_data, client_pk_data, client_sk_data, server_pk_data), "failed to derive session keys")
 }
 
 js_value_t *
@@ -1413,7 +1762,7 @@ sn_crypto_kx_server_session_keys (js_env_t *env, js_callback_info_t *info) {
   SN_THROWS(tx_size != crypto_kx_SESSIONKEYBYTES && tx_data != NULL, "transmitting key buffer must be 'crypto_kx_SESSIONKEYBYTES' bytes or null")
   SN_THROWS(rx_size != crypto_kx_SESSIONKEYBYTES && rx_data != NULL, "receiving key buffer must be 'crypto_kx_SESSIONKEYBYTES' bytes or null")
 
-  SN_RETURN(crypto_kx_server_session_keys(rx_data, tx_data, server_pk_data, server_sk_data, client_pk_data), "failed to derive session keys")
+  SN_RETURN(sn__extension_x25519_kx_server_session_keys(rx_data, tx_data, server_pk_data, server_sk_data, client_pk_data), "failed to derive session keys")
 }
 
 js_value_t *
@@ -1441,7 +1790,44 @@ sn_crypto_scalarmult (js_env_t *env, js_callback_info_t *info) {
   SN_ASSERT_LENGTH(n_size, crypto_scalarmult_SCALARBYTES, "n")
   SN_ASSERT_LENGTH(p_size, crypto_scalarmult_BYTES, "p")
 
-  SN_RETURN(crypto_scalarmult(q_data, n_data, p_data), "failed to derive shared secret")
+  SN_RETURN(sn__extension_x25519_scalarmult(q_data, n_data, p_data), "failed to derive shared secret")
+}
+
+#define SN_CRYPTO_SCALARMULT_MANY_THREADS_MAX 64
+
+// points below which a batch is not worth another lane
+#define SN_CRYPTO_SCALARMULT_MANY_PER_THREAD_MIN 64
+
+// returns the number of points in [from, to) that gave an all zero result
+static size_t
+sn_crypto_scalarmult_many_range (unsigned char *q, const unsigned char *n, const unsigned char *p, size_t from, size_t to) {
+  size_t failures = 0;
+
+  for (size_t i = from; i < to; i++) {
+    size_t at = i * crypto_scalarmult_BYTES;
+
+    if (sn__extension_x25519_scalarmult(q + at, n + i * crypto_scalarmult_SCALARBYTES, p + at) != 0) failures++;
+  }
+
+  return failures;
+}
+
+js_value_t *
+sn_crypto_scalarmult_many (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(4, crypto_scalarmult_many)
+
+  SN_ARGV_TYPEDARRAY(q, 0)
+  SN_ARGV_TYPEDARRAY(n, 1)
+  SN_ARGV_TYPEDARRAY(p, 2)
+  SN_ARGV_UINT32(count, 3)
+
+  SN_THROWS(q_size != (size_t) count * crypto_scalarmult_BYTES, "q must be 'count * crypto_scalarmult_BYTES' bytes")
+  SN_THROWS(n_size != (size_t) count * crypto_scalarmult_SCALARBYTES, "n must be 'count * crypto_scalarmult_SCALARBYTES' bytes")
+  SN_THROWS(p_size != (size_t) count * crypto_scalarmult_BYTES, "p must be 'count * crypto_scalarmult_BYTES' bytes")
+
+  SN_THROWS(sn_crypto_scalarmult_many_range(q_data, n_data, p_data, 0, count) != 0, "failed to derive shared secret")
+
+  return NULL;
 }
 
 js_value_t *
@@ -1824,6 +2210,7 @@ sn_crypto_aead_xchacha20poly1305_ietf_keygen (js_env_t *env, js_callback_info_t
   return NULL;
 }
 
+template <bool sequence>
 js_value_t *
 sn_crypto_aead_xchacha20poly1305_ietf_encrypt (js_env_t *env, js_callback_info_t *info) {
   SN_ARGV(6, crypto_aead_xchacha20poly1305_ietf_encrypt)
@@ -1839,14 +2226,14 @@ sn_crypto_aead_xchacha20poly1305_ietf_encrypt (js_env_t *env, js_callback_info_t
 
   SN_THROWS(c_size != m_size + crypto_aead_xchacha20poly1305_ietf_ABYTES, "c must 'm.byteLength + crypto_aead_xchacha20poly1305_ietf_ABYTES' bytes")
   SN_THROWS(c_size > 0xffffffff, "c.byteLength must be a 32bit integer")
-  SN_ASSERT_LENGTH(npub_size, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, "npub")
+  SN_ASSERT_NONCE(sequence, npub, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES)
   SN_ASSERT_LENGTH(k_size, crypto_aead_xchacha20poly1305_ietf_KEYBYTES, "k")
+  SN_NONCE_SEQUENCE(sequence, npub, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES)
 
-  unsigned long long clen;
-  SN_CALL(crypto_aead_xchacha20poly1305_ietf_encrypt(c_data, &clen, m_data, m_size, ad_data, ad_size, NULL, npub_data, k_data), "could not encrypt data")
+  SN_CALL(sn__extension_aead_xchacha20poly1305_ietf_encrypt_detached(c_data, c_data + m_size, m_data, m_size, ad_data, ad_size, npub_data, k_data), "could not encrypt data")
 
   js_value_t *result;
-  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) clen, &result), "")
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) c_size, &result), "")
   return result;
 }
 
@@ -1868,14 +2255,74 @@ sn_crypto_aead_xchacha20poly1305_ietf_decrypt (js_env_t *env, js_callback_info_t
   SN_ASSERT_LENGTH(k_size, crypto_aead_xchacha20poly1305_ietf_KEYBYTES, "k")
   SN_THROWS(m_size > 0xffffffff, "m.byteLength must be a 32bit integer")
 
-  unsigned long long mlen;
-  SN_CALL(crypto_aead_xchacha20poly1305_ietf_decrypt(m_data, &mlen, NULL, c_data, c_size, ad_data, ad_size, npub_data, k_data), "could not verify data")
+  SN_CALL(sn__extension_aead_xchacha20poly1305_ietf_decrypt_detached(m_data, c_data, m_size, c_data + m_size, ad_data, ad_size, npub_data, k_data), "could not verify data")
+
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) m_size, &result), "")
+  return result;
+}
+
+template <bool sequence>
+js_value_t *
+sn_crypto_aead_xchacha20poly1305_ietf_encrypt_padded (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(7, crypto_aead_xchacha20poly1305_ietf_encrypt_padded)
+
+  SN_ARGV_TYPEDARRAY(c, 0)
+  SN_ARGV_TYPEDARRAY(m, 1)
+  SN_ARGV_OPTS_TYPEDARRAY(ad, 2)
+  SN_ARGV_CHECK_NULL(nsec, 3)
+  SN_ARGV_TYPEDARRAY(npub, 4)
+  SN_ARGV_TYPEDARRAY(k, 5)
+  SN_ARGV_UINT32(block_size, 6)
+
+  SN_THROWS(!nsec_is_null, "nsec must always be set to null")
+
+  size_t padded_size = sn__extension_pad_padded_length(m_size, block_size);
+
+  SN_THROWS(block_size < 1, "blockSize must be at least 1")
+  SN_THROWS(padded_size == 0 || c_size < padded_size + crypto_aead_xchacha20poly1305_ietf_ABYTES, "c must be at least the padded 'm.byteLength + crypto_aead_xchacha20poly1305_ietf_ABYTES' bytes")
+  SN_THROWS(padded_size + crypto_aead_xchacha20poly1305_ietf_ABYTES > 0xffffffff, "c.byteLength must be a 32bit integer")
+  SN_ASSERT_NONCE(sequence, npub, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES)
+  SN_ASSERT_LENGTH(k_size, crypto_aead_xchacha20poly1305_ietf_KEYBYTES, "k")
+  SN_NONCE_SEQUENCE(sequence, npub, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES)
+
+  SN_CALL(sn__extension_pad_aead_xchacha20poly1305_ietf_encrypt(c_data, m_data, m_size, block_size, ad_data, ad_size, npub_data, k_data), "could not encrypt data")
+
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) (padded_size + crypto_aead_xchacha20poly1305_ietf_ABYTES), &result), "")
+  return result;
+}
+
+js_value_t *
+sn_crypto_aead_xchacha20poly1305_ietf_decrypt_padded (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(7, crypto_aead_xchacha20poly1305_ietf_decrypt_padded)
+
+  SN_ARGV_TYPEDARRAY(m, 0)
+  SN_ARGV_CHECK_NULL(nsec, 1)
+  SN_ARGV_TYPEDARRAY(c, 2)
+  SN_ARGV_OPTS_TYPEDARRAY(ad, 3)
+  SN_ARGV_TYPEDARRAY(npub, 4)
+  SN_ARGV_TYPEDARRAY(k, 5)
+  SN_ARGV_UINT32(block_size, 6)
+
+  SN_THROWS(!nsec_is_null, "nsec must always be set to null")
+
+  SN_THROWS(block_size < 1, "blockSize must be at least 1")
+  SN_ASSERT_MIN_LENGTH(c_size, crypto_aead_xchacha20poly1305_ietf_ABYTES, "c")
+  SN_THROWS(m_size < c_size - crypto_aead_xchacha20poly1305_ietf_ABYTES, "m must be at least 'c.byteLength - crypto_aead_xchacha20poly1305_ietf_ABYTES' bytes")
+  SN_THROWS(c_size > 0xffffffff, "c.byteLength must be a 32bit integer")
+  SN_ASSERT_LENGTH(npub_size, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, "npub")
+  SN_ASSERT_LENGTH(k_size, crypto_aead_xchacha20poly1305_ietf_KEYBYTES, "k")
+
+  size_t unpadded_size;
+  SN_CALL(sn__extension_pad_aead_xchacha20poly1305_ietf_decrypt(m_data, &unpadded_size, c_data, c_size, block_size, ad_data, ad_size, npub_data, k_data), "could not verify data")
 
   js_value_t *result;
-  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) mlen, &result), "")
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) unpadded_size, &result), "")
   return result;
 }
 
+template <bool sequence>
 js_value_t *
 sn_crypto_aead_xchacha20poly1305_ietf_encrypt_detached (js_env_t *env, js_callback_info_t *info) {
   SN_ARGV(7, crypto_aead_xchacha20poly1305_ietf_encrypt_detached)
@@ -1892,14 +2339,14 @@ sn_crypto_aead_xchacha20poly1305_ietf_encrypt_detached (js_env_t *env, js_callba
 
   SN_THROWS(c_size != m_size, "c must be 'm.byteLength' bytes")
   SN_ASSERT_LENGTH(mac_size, crypto_aead_xchacha20poly1305_ietf_ABYTES, "mac")
-  SN_ASSERT_LENGTH(npub_size, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, "npub")
+  SN_ASSERT_NONCE(sequence, npub, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES)
   SN_ASSERT_LENGTH(k_size, crypto_aead_xchacha20poly1305_ietf_KEYBYTES, "k")
+  SN_NONCE_SEQUENCE(sequence, npub, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES)
 
-  unsigned long long maclen;
-  SN_CALL(crypto_aead_xchacha20poly1305_ietf_encrypt_detached(c_data, mac_data, &maclen, m_data, m_size, ad_data, ad_size, NULL, npub_data, k_data), "could not encrypt data")
+  SN_CALL(sn__extension_aead_xchacha20poly1305_ietf_encrypt_detached(c_data, mac_data, m_data, m_size, ad_data, ad_size, npub_data, k_data), "could not encrypt data")
 
   js_value_t *result;
-  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) maclen, &result), "")
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) mac_size, &result), "")
   return result;
 }
 
@@ -1922,7 +2369,7 @@ sn_crypto_aead_xchacha20poly1305_ietf_decrypt_detached (js_env_t *env, js_callba
   SN_ASSERT_LENGTH(npub_size, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, "npub")
   SN_ASSERT_LENGTH(k_size, crypto_aead_xchacha20poly1305_ietf_KEYBYTES, "k")
 
-  SN_RETURN(crypto_aead_xchacha20poly1305_ietf_decrypt_detached(m_data, NULL, c_data, c_size, mac_data, ad_data, ad_size, npub_data, k_data), "could not verify data")
+  SN_RETURN(sn__extension_aead_xchacha20poly1305_ietf_decrypt_detached(m_data, c_data, c_size, mac_data, ad_data, ad_size, npub_data, k_data), "could not verify data")
 }
 
 js_value_t *
@@ -1937,6 +2384,7 @@ sn_crypto_aead_chacha20poly1305_ietf_keygen (js_env_t *env, js_callback_info_t *
   return NULL;
 }
 
+template <bool sequence>
 js_value_t *
 sn_crypto_aead_chacha20poly1305_ietf_encrypt (js_env_t *env, js_callback_info_t *info) {
   SN_ARGV(6, crypto_aead_chacha20poly1305_ietf_encrypt)
@@ -1952,14 +2400,14 @@ sn_crypto_aead_chacha20poly1305_ietf_encrypt (js_env_t *env, js_callback_info_t
 
   SN_THROWS(c_size != m_size + crypto_aead_chacha20poly1305_ietf_ABYTES, "c must 'm.byteLength + crypto_aead_chacha20poly1305_ietf_ABYTES' bytes")
   SN_THROWS(c_size > 0xffffffff, "c.byteLength must be a 32bit integer")
-  SN_ASSERT_LENGTH(npub_size, crypto_aead_chacha20poly1305_ietf_NPUBBYTES, "npub")
+  SN_ASSERT_NONCE(sequence, npub, crypto_aead_chacha20poly1305_ietf_NPUBBYTES)
   SN_ASSERT_LENGTH(k_size, crypto_aead_chacha20poly1305_ietf_KEYBYTES, "k")
+  SN_NONCE_SEQUENCE(sequence, npub, crypto_aead_chacha20poly1305_ietf_NPUBBYTES)
 
-  unsigned long long clen;
-  SN_CALL(crypto_aead_chacha20poly1305_ietf_encrypt(c_data, &clen, m_data, m_size, ad_data, ad_size, NULL, npub_data, k_data), "could not encrypt data")
+  SN_CALL(sn__extension_aead_chacha20poly1305_ietf_encrypt_detached(c_data, c_data + m_size, m_data, m_size, ad_data, ad_size, npub_data, k_data), "could not encrypt data")
 
   js_value_t *result;
-  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) clen, &result), "")
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) c_size, &result), "")
   return result;
 }
 
@@ -1981,38 +2429,98 @@ sn_crypto_aead_chacha20poly1305_ietf_decrypt (js_env_t *env, js_callback_info_t
   SN_ASSERT_LENGTH(k_size, crypto_aead_chacha20poly1305_ietf_KEYBYTES, "k")
   SN_THROWS(m_size > 0xffffffff, "m.byteLength must be a 32bit integer")
 
-  unsigned long long mlen;
-  SN_CALL(crypto_aead_chacha20poly1305_ietf_decrypt(m_data, &mlen, NULL, c_data, c_size, ad_data, ad_size, npub_data, k_data), "could not verify data")
+  SN_CALL(sn__extension_aead_chacha20poly1305_ietf_decrypt_detached(m_data, c_data, m_size, c_data + m_size, ad_data, ad_size, npub_data, k_data), "could not verify data")
 
   js_value_t *result;
-  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) mlen, &result), "")
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) m_size, &result), "")
   return result;
 }
 
+template <bool sequence>
 js_value_t *
-sn_crypto_aead_chacha20poly1305_ietf_encrypt_detached (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(7, crypto_aead_chacha20poly1305_ietf_encrypt_detached)
+sn_crypto_aead_chacha20poly1305_ietf_encrypt_padded (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(7, crypto_aead_chacha20poly1305_ietf_encrypt_padded)
 
   SN_ARGV_TYPEDARRAY(c, 0)
-  SN_ARGV_TYPEDARRAY(mac, 1)
-  SN_ARGV_TYPEDARRAY(m, 2)
-  SN_ARGV_OPTS_TYPEDARRAY(ad, 3)
-  SN_ARGV_CHECK_NULL(nsec, 4)
-  SN_ARGV_TYPEDARRAY(npub, 5)
-  SN_ARGV_TYPEDARRAY(k, 6)
+  SN_ARGV_TYPEDARRAY(m, 1)
+  SN_ARGV_OPTS_TYPEDARRAY(ad, 2)
+  SN_ARGV_CHECK_NULL(nsec, 3)
+  SN_ARGV_TYPEDARRAY(npub, 4)
+  SN_ARGV_TYPEDARRAY(k, 5)
+  SN_ARGV_UINT32(block_size, 6)
+
+  SN_THROWS(!nsec_is_null, "nsec must always be set to null")
+
+  size_t padded_size = sn__extension_pad_padded_length(m_size, block_size);
+
+  SN_THROWS(block_size < 1, "blockSize must be at least 1")
+  SN_THROWS(padded_size == 0 || c_size < padded_size + crypto_aead_chacha20poly1305_ietf_ABYTES, "c must be at least the padded 'm.byteLength + crypto_aead_chacha20poly1305_ietf_ABYTES' bytes")
+  SN_THROWS(padded_size + crypto_aead_chacha20poly1305_ietf_ABYTES > 0xffffffff, "c.byteLength must be a 32bit integer")
+  SN_ASSERT_NONCE(sequence, npub, crypto_aead_chacha20poly1305_ietf_NPUBBYTES)
+  SN_ASSERT_LENGTH(k_size, crypto_aead_chacha20poly1305_ietf_KEYBYTES, "k")
+  SN_NONCE_SEQUENCE(sequence, npub, crypto_aead_chacha20poly1305_ietf_NPUBBYTES)
+
+  SN_CALL(sn__extension_pad_aead_chacha20poly1305_ietf_encrypt(c_data, m_data, m_size, block_size, ad_data, ad_size, npub_data, k_data), "could not encrypt data")
+
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) (padded_size + crypto_aead_chacha20poly1305_ietf_ABYTES), &result), "")
+  return result;
+}
+
+js_value_t *
+sn_crypto_aead_chacha20poly1305_ietf_decrypt_padded (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(7, crypto_aead_chacha20poly1305_ietf_decrypt_padded)
+
+  SN_ARGV_TYPEDARRAY(m, 0)
+  SN_ARGV_CHECK_NULL(nsec, 1)
+  SN_ARGV_TYPEDARRAY(c, 2)
+  SN_ARGV_OPTS_TYPEDARRAY(ad, 3)
+  SN_ARGV_TYPEDARRAY(npub, 4)
+  SN_ARGV_TYPEDARRAY(k, 5)
+  SN_ARGV_UINT32(block_size, 6)
+
+  SN_THROWS(!nsec_is_null, "nsec must always be set to null")
+
+  SN_THROWS(block_size < 1, "blockSize must be at least 1")
+  SN_ASSERT_MIN_LENGTH(c_size, crypto_aead_chacha20poly1305_ietf_ABYTES, "c")
+  SN_THROWS(m_size < c_size - crypto_aead_chacha20poly1305_ietf_ABYTES, "m must be at least 'c.byteLength - crypto_aead_chacha20poly1305_ietf_ABYTES' bytes")
+  SN_THROWS(c_size > 0xffffffff, "c.byteLength must be a 32bit integer")
+  SN_ASSERT_LENGTH(npub_size, crypto_aead_chacha20poly1305_ietf_NPUBBYTES, "npub")
+  SN_ASSERT_LENGTH(k_size, crypto_aead_chacha20poly1305_ietf_KEYBYTES, "k")
+
+  size_t unpadded_size;
+  SN_CALL(sn__extension_pad_aead_chacha20poly1305_ietf_decrypt(m_data, &unpadded_size, c_data, c_size, block_size, ad_data, ad_size, npub_data, k_data), "could not verify data")
+
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) unpadded_size, &result), "")
+  return result;
+}
+
+template <bool sequence>
+js_value_t *
+sn_crypto_aead_chacha20poly1305_ietf_encrypt_detached (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(7, crypto_aead_chacha20poly1305_ietf_encrypt_detached)
+
+  SN_ARGV_TYPEDARRAY(c, 0)
+  SN_ARGV_TYPEDARRAY(mac, 1)
+  SN_ARGV_TYPEDARRAY(m, 2)
+  SN_ARGV_OPTS_TYPEDARRAY(ad, 3)
+  SN_ARGV_CHECK_NULL(nsec, 4)
+  SN_ARGV_TYPEDARRAY(npub, 5)
+  SN_ARGV_TYPEDARRAY(k, 6)
 
   SN_THROWS(!nsec_is_null, "nsec must always be set to null")
 
   SN_THROWS(c_size != m_size, "c must be 'm.byteLength' bytes")
   SN_ASSERT_LENGTH(mac_size, crypto_aead_chacha20poly1305_ietf_ABYTES, "mac")
-  SN_ASSERT_LENGTH(npub_size, crypto_aead_chacha20poly1305_ietf_NPUBBYTES, "npub")
+  SN_ASSERT_NONCE(sequence, npub, crypto_aead_chacha20poly1305_ietf_NPUBBYTES)
   SN_ASSERT_LENGTH(k_size, crypto_aead_chacha20poly1305_ietf_KEYBYTES, "k")
+  SN_NONCE_SEQUENCE(sequence, npub, crypto_aead_chacha20poly1305_ietf_NPUBBYTES)
 
-  unsigned long long maclen;
-  SN_CALL(crypto_aead_chacha20poly1305_ietf_encrypt_detached(c_data, mac_data, &maclen, m_data, m_size, ad_data, ad_size, NULL, npub_data, k_data), "could not encrypt data")
+  SN_CALL(sn__extension_aead_chacha20poly1305_ietf_encrypt_detached(c_data, mac_data, m_data, m_size, ad_data, ad_size, npub_data, k_data), "could not encrypt data")
 
   js_value_t *result;
-  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) maclen, &result), "")
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) mac_size, &result), "")
   return result;
 }
 
@@ -2035,212 +2543,1025 @@ sn_crypto_aead_chacha20poly1305_ietf_decrypt_detached (js_env_t *env, js_callbac
   SN_ASSERT_LENGTH(npub_size, crypto_aead_chacha20poly1305_ietf_NPUBBYTES, "npub")
   SN_ASSERT_LENGTH(k_size, crypto_aead_chacha20poly1305_ietf_KEYBYTES, "k")
 
-  SN_RETURN(crypto_aead_chacha20poly1305_ietf_decrypt_detached(m_data, NULL, c_data, c_size, mac_data, ad_data, ad_size, npub_data, k_data), "could not verify data")
+  SN_RETURN(sn__extension_aead_chacha20poly1305_ietf_decrypt_detached(m_data, c_data, c_size, mac_data, ad_data, ad_size, npub_data, k_data), "could not verify data")
 }
 
-js_value_t *
-sn_crypto_secretstream_xchacha20poly1305_keygen (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(1, crypto_secretstream_xchacha20poly1305_keygen)
+typedef void (*sn_aead_transform_t)(sn__extension_aead_chacha20poly1305_ietf_state *, unsigned char *, const unsigned char *, size_t);
 
-  SN_ARGV_TYPEDARRAY(k, 0)
+static inline void
+sn_aead_iovec_transform (sn__extension_aead_chacha20poly1305_ietf_state *state, sn_iovec_cursor_t *out, sn_iovec_cursor_t *in, size_t len, sn_aead_transform_t transform) {
+  while (len) {
+    uint8_t *out_data;
+    uint8_t *in_data;
 
-  SN_ASSERT_LENGTH(k_size, crypto_secretstream_xchacha20poly1305_KEYBYTES, "k")
+    size_t n = sn_iovec_peek(out, &out_data);
+    size_t in_avail = sn_iovec_peek(in, &in_data);
 
-  crypto_secretstream_xchacha20poly1305_keygen(k_data);
+    if (in_avail < n) n = in_avail;
+    if (len < n) n = len;
 
-  return NULL;
+    transform(state, out_data, in_data, n);
+
+    out->offset += n;
+    in->offset += n;
+    len -= n;
+  }
 }
 
-js_value_t *
-sn_crypto_secretstream_xchacha20poly1305_init_push (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(3, crypto_secretstream_xchacha20poly1305_init_push)
+// mac == NULL appends the tag to c
+static void
+sn_aead_iovec_encrypt (sn__extension_aead_chacha20poly1305_ietf_state *state, const std::vector<sn_iovec_t> &c, const std::vector<sn_iovec_t> &m, size_t mlen, const std::vector<sn_iovec_t> &ad, uint8_t *mac) {
+  for (auto &seg : ad) {
+    sn__extension_aead_chacha20poly1305_ietf_update_ad(state, seg.data, seg.size);
+  }
 
-  SN_ARGV_BUFFER_CAST(crypto_secretstream_xchacha20poly1305_state *, state, 0)
-  SN_ARGV_TYPEDARRAY(header, 1)
-  SN_ARGV_TYPEDARRAY(k, 2)
+  sn_iovec_cursor_t c_cursor = { &c, 0, 0 };
+  sn_iovec_cursor_t m_cursor = { &m, 0, 0 };
 
-  SN_THROWS(state_size != sizeof(crypto_secretstream_xchacha20poly1305_state), "state must be 'crypto_secretstream_xchacha20poly1305_STATEBYTES' bytes")
-  SN_ASSERT_LENGTH(header_size, crypto_secretstream_xchacha20poly1305_HEADERBYTES, "header")
-  SN_ASSERT_LENGTH(k_size, crypto_secretstream_xchacha20poly1305_KEYBYTES, "k")
+  sn_aead_iovec_transform(state, &c_cursor, &m_cursor, mlen, sn__extension_aead_chacha20poly1305_ietf_encrypt_update);
 
-  SN_RETURN(crypto_secretstream_xchacha20poly1305_init_push(state, header_data, k_data), "initial push failed")
+  if (mac) {
+    sn__extension_aead_chacha20poly1305_ietf_final(state, mac);
+  } else {
+    uint8_t tag[crypto_aead_chacha20poly1305_ietf_ABYTES];
+    sn__extension_aead_chacha20poly1305_ietf_final(state, tag);
+    sn_iovec_copy_in(&c_cursor, tag, sizeof(tag));
+  }
+
+  sodium_memzero(state, sizeof(*state));
 }
 
-static inline int64_t
-sn_crypto_secretstream_xchacha20poly1305_push (
-  js_env_t *env,
-  js_receiver_t,
+// mac == NULL reads the tag from the end of c, m is only written once the tag is verified
+static int
+sn_aead_iovec_decrypt (sn__extension_aead_chacha20poly1305_ietf_state *state, const std::vector<sn_iovec_t> &m, const std::vector<sn_iovec_t> &c, size_t mlen, const std::vector<sn_iovec_t> &ad, const uint8_t *mac) {
+  for (auto &seg : ad) {
+    sn__extension_aead_chacha20poly1305_ietf_update_ad(state, seg.data, seg.size);
+  }
 
-  js_arraybuffer_span_t state,
-  uint32_t state_offset,
-  uint32_t state_len,
+  sn_iovec_cursor_t c_cursor = { &c, 0, 0 };
 
-  js_arraybuffer_span_t c,
-  uint32_t c_offset,
-  uint32_t c_len,
+  for (size_t len = mlen; len > 0;) {
+    uint8_t *data;
+    size_t n = sn_iovec_peek(&c_cursor, &data);
+    if (len < n) n = len;
 
-  js_arraybuffer_span_t m,
-  uint32_t m_offset,
-  uint32_t m_len,
+    sn__extension_aead_chacha20poly1305_ietf_verify_update(state, data, n);
 
-  js_object_t ad,
-  uint32_t ad_offset,
-  uint32_t ad_len,
+    c_cursor.offset += n;
+    len -= n;
+  }
 
-  uint32_t tag
-) {
-  assert_bounds(state);
-  assert_bounds(c);
-  assert_bounds(m);
+  uint8_t tag[crypto_aead_chacha20poly1305_ietf_ABYTES];
+  if (mac == NULL) {
+    sn_iovec_copy_out(&c_cursor, tag, sizeof(tag));
+    mac = tag;
+  }
 
-  assert(state_len == sizeof(crypto_secretstream_xchacha20poly1305_state));
-  auto state_data = reinterpret_cast<crypto_secretstream_xchacha20poly1305_state *>(&state[state_offset]);
+  int res = sn__extension_aead_chacha20poly1305_ietf_final_verify(state, mac);
 
-  // next-line kept for future rewrites
-  // assert(m_len <= crypto_secretstream_xchacha20poly1305_MESSAGEBYTES_MAX);
-  assert(c_len == m_len + crypto_secretstream_xchacha20poly1305_ABYTES);
-  assert(c_len <= 0xffffffff && "32bit integer");
+  if (res == 0) {
+    sn_iovec_cursor_t m_cursor = { &m, 0, 0 };
+    c_cursor = { &c, 0, 0 };
 
-  uint8_t *ad_data = NULL;
-  if (ad_len) {
-    uint8_t *slab;
-    size_t slab_len;
+    sn_aead_iovec_transform(state, &m_cursor, &c_cursor, mlen, sn__extension_aead_chacha20poly1305_ietf_xor_update);
+  }
 
-    int err = js_get_arraybuffer_info(env, ad, (void **) &slab, &slab_len);
-    assert(err == 0);
+  sodium_memzero(state, sizeof(*state));
 
-    assert(ad_len + ad_offset <= slab_len);
-    ad_data = slab + ad_offset;
-  }
+  return res;
+}
 
-  unsigned long long clen = 0;
+js_value_t *
+sn_crypto_aead_xchacha20poly1305_ietf_verify (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(4, crypto_aead_xchacha20poly1305_ietf_verify)
 
-  int res = crypto_secretstream_xchacha20poly1305_push(state_data, &c[c_offset], &clen, &m[m_offset], m_len, ad_data, ad_len, tag);
-  if (res < 0) return -1;
+  SN_ARGV_TYPEDARRAY(c, 0)
+  SN_ARGV_OPTS_TYPEDARRAY(ad, 1)
+  SN_ARGV_TYPEDARRAY(npub, 2)
+  SN_ARGV_TYPEDARRAY(k, 3)
 
-  return clen;
+  SN_THROWS(c_size < crypto_aead_xchacha20poly1305_ietf_ABYTES, "c must be at least 'crypto_aead_xchacha20poly1305_ietf_ABYTES' bytes")
+  SN_ASSERT_LENGTH(npub_size, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, "npub")
+  SN_ASSERT_LENGTH(k_size, crypto_aead_xchacha20poly1305_ietf_KEYBYTES, "k")
+
+  size_t clen = c_size - crypto_aead_xchacha20poly1305_ietf_ABYTES;
+
+  SN_RETURN_BOOLEAN(sn__extension_aead_xchacha20poly1305_ietf_verify_detached(c_data, clen, c_data + clen, ad_data, ad_size, npub_data, k_data))
 }
 
 js_value_t *
-sn_crypto_secretstream_xchacha20poly1305_init_pull (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(3, crypto_secretstream_xchacha20poly1305_init_pull)
+sn_crypto_aead_xchacha20poly1305_ietf_verify_detached (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(5, crypto_aead_xchacha20poly1305_ietf_verify_detached)
 
-  SN_ARGV_BUFFER_CAST(crypto_secretstream_xchacha20poly1305_state *, state, 0)
-  SN_ARGV_TYPEDARRAY(header, 1)
-  SN_ARGV_TYPEDARRAY(k, 2)
+  SN_ARGV_TYPEDARRAY(c, 0)
+  SN_ARGV_TYPEDARRAY(mac, 1)
+  SN_ARGV_OPTS_TYPEDARRAY(ad, 2)
+  SN_ARGV_TYPEDARRAY(npub, 3)
+  SN_ARGV_TYPEDARRAY(k, 4)
 
-  SN_THROWS(state_size != sizeof(crypto_secretstream_xchacha20poly1305_state), "state must be 'crypto_secretstream_xchacha20poly1305_STATEBYTES' bytes")
-  SN_ASSERT_LENGTH(header_size, crypto_secretstream_xchacha20poly1305_HEADERBYTES, "header")
-  SN_ASSERT_LENGTH(k_size, crypto_secretstream_xchacha20poly1305_KEYBYTES, "k")
+  SN_ASSERT_LENGTH(mac_size, crypto_aead_xchacha20poly1305_ietf_ABYTES, "mac")
+  SN_ASSERT_LENGTH(npub_size, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, "npub")
+  SN_ASSERT_LENGTH(k_size, crypto_aead_xchacha20poly1305_ietf_KEYBYTES, "k")
 
-  SN_RETURN(crypto_secretstream_xchacha20poly1305_init_pull(state, header_data, k_data), "initial pull failed")
+  SN_RETURN_BOOLEAN(sn__extension_aead_xchacha20poly1305_ietf_verify_detached(c_data, c_size, mac_data, ad_data, ad_size, npub_data, k_data))
 }
 
-static inline int64_t
-sn_crypto_secretstream_xchacha20poly1305_pull(
-  js_env_t *env,
-  js_receiver_t,
+template <bool sequence>
+js_value_t *
+sn_crypto_aead_xchacha20poly1305_ietf_encryptv (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(6, crypto_aead_xchacha20poly1305_ietf_encryptv)
 
-  js_arraybuffer_span_t state,
-  uint32_t state_offset,
-  uint32_t state_len,
+  SN_ARGV_IOVECS(c, 0)
+  SN_ARGV_IOVECS(m, 1)
+  SN_ARGV_OPTS_IOVECS(ad, 2)
+  SN_ARGV_CHECK_NULL(nsec, 3)
+  SN_ARGV_TYPEDARRAY(npub, 4)
+  SN_ARGV_TYPEDARRAY(k, 5)
 
-  js_arraybuffer_span_t m,
-  uint32_t m_offset,
-  uint32_t m_len,
+  SN_THROWS(!nsec_is_null, "nsec must always be set to null")
 
-  js_arraybuffer_span_t tag,
-  uint32_t tag_offset,
-  uint32_t tag_len,
+  SN_THROWS(c_size != m_size + crypto_aead_xchacha20poly1305_ietf_ABYTES, "c must 'm.byteLength + crypto_aead_xchacha20poly1305_ietf_ABYTES' bytes")
+  SN_THROWS(c_size > 0xffffffff, "c.byteLength must be a 32bit integer")
+  SN_ASSERT_NONCE(sequence, npub, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES)
+  SN_ASSERT_LENGTH(k_size, crypto_aead_xchacha20poly1305_ietf_KEYBYTES, "k")
+  SN_NONCE_SEQUENCE(sequence, npub, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES)
 
-  js_arraybuffer_span_t c,
-  uint32_t c_offset,
-  uint32_t c_len,
+  sn__extension_aead_chacha20poly1305_ietf_state state;
+  sn__extension_aead_xchacha20poly1305_ietf_init(&state, npub_data, k_data);
 
-  js_object_t ad,
-  uint32_t ad_offset,
-  uint32_t ad_len
-) {
-  assert_bounds(state);
-  assert_bounds(m);
-  assert_bounds(tag);
-  assert_bounds(c);
+  sn_aead_iovec_encrypt(&state, c, m, m_size, ad, NULL);
 
-  assert(state_len == sizeof(crypto_secretstream_xchacha20poly1305_state));
-  auto state_data = reinterpret_cast<crypto_secretstream_xchacha20poly1305_state*>(&state[state_offset]);
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) c_size, &result), "")
+  return result;
+}
 
-  assert(c_len >= crypto_secretstream_xchacha20poly1305_ABYTES);
-  assert(tag_len == 1);
-  assert(m_len == c_len - crypto_secretstream_xchacha20poly1305_ABYTES);
-  assert(m_len <= 0xffffffff);
+js_value_t *
+sn_crypto_aead_xchacha20poly1305_ietf_decryptv (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(6, crypto_aead_xchacha20poly1305_ietf_decryptv)
 
-  uint8_t *ad_data = NULL;
-  if (ad_len) {
-    uint8_t *slab;
-    size_t slab_len;
+  SN_ARGV_IOVECS(m, 0)
+  SN_ARGV_CHECK_NULL(nsec, 1)
+  SN_ARGV_IOVECS(c, 2)
+  SN_ARGV_OPTS_IOVECS(ad, 3)
+  SN_ARGV_TYPEDARRAY(npub, 4)
+  SN_ARGV_TYPEDARRAY(k, 5)
 
-    int err = js_get_arraybuffer_info(env, ad, (void **) &slab, &slab_len);
-    assert(err == 0);
+  SN_THROWS(!nsec_is_null, "nsec must always be set to null")
 
-    assert(ad_len + ad_offset <= slab_len);
-    ad_data = slab + ad_offset;
-  }
+  SN_THROWS(c_size < crypto_aead_xchacha20poly1305_ietf_ABYTES, "c must be at least 'crypto_aead_xchacha20poly1305_ietf_ABYTES' bytes")
+  SN_THROWS(m_size != c_size - crypto_aead_xchacha20poly1305_ietf_ABYTES, "m must 'c.byteLength - crypto_aead_xchacha20poly1305_ietf_ABYTES' bytes")
+  SN_ASSERT_LENGTH(npub_size, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, "npub")
+  SN_ASSERT_LENGTH(k_size, crypto_aead_xchacha20poly1305_ietf_KEYBYTES, "k")
+  SN_THROWS(m_size > 0xffffffff, "m.byteLength must be a 32bit integer")
 
-  unsigned long long mlen = 0;
+  sn__extension_aead_chacha20poly1305_ietf_state state;
+  sn__extension_aead_xchacha20poly1305_ietf_init(&state, npub_data, k_data);
 
-  int res = crypto_secretstream_xchacha20poly1305_pull(state_data, &m[m_offset], &mlen, &tag[tag_offset], &c[c_offset], c_len, ad_data, ad_len);
-  if (res < 0) return -1;
+  SN_CALL(sn_aead_iovec_decrypt(&state, m, c, m_size, ad, NULL), "could not verify data")
 
-  return mlen;
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) m_size, &result), "")
+  return result;
 }
 
+template <bool sequence>
 js_value_t *
-sn_crypto_secretstream_xchacha20poly1305_rekey (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(1, crypto_secretstream_xchacha20poly1305_rekey)
+sn_crypto_aead_xchacha20poly1305_ietf_encryptv_detached (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(7, crypto_aead_xchacha20poly1305_ietf_encryptv_detached)
 
-  SN_ARGV_BUFFER_CAST(crypto_secretstream_xchacha20poly1305_state *, state, 0)
+  SN_ARGV_IOVECS(c, 0)
+  SN_ARGV_TYPEDARRAY(mac, 1)
+  SN_ARGV_IOVECS(m, 2)
+  SN_ARGV_OPTS_IOVECS(ad, 3)
+  SN_ARGV_CHECK_NULL(nsec, 4)
+  SN_ARGV_TYPEDARRAY(npub, 5)
+  SN_ARGV_TYPEDARRAY(k, 6)
 
-  SN_THROWS(state_size != sizeof(crypto_secretstream_xchacha20poly1305_state), "state must be 'crypto_secretstream_xchacha20poly1305_STATEBYTES' bytes")
+  SN_THROWS(!nsec_is_null, "nsec must always be set to null")
 
-  crypto_secretstream_xchacha20poly1305_rekey(state);
+  SN_THROWS(c_size != m_size, "c must be 'm.byteLength' bytes")
+  SN_ASSERT_LENGTH(mac_size, crypto_aead_xchacha20poly1305_ietf_ABYTES, "mac")
+  SN_ASSERT_NONCE(sequence, npub, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES)
+  SN_ASSERT_LENGTH(k_size, crypto_aead_xchacha20poly1305_ietf_KEYBYTES, "k")
+  SN_NONCE_SEQUENCE(sequence, npub, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES)
 
-  return NULL;
+  sn__extension_aead_chacha20poly1305_ietf_state state;
+  sn__extension_aead_xchacha20poly1305_ietf_init(&state, npub_data, k_data);
+
+  sn_aead_iovec_encrypt(&state, c, m, m_size, ad, mac_data);
+
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) mac_size, &result), "")
+  return result;
 }
 
-typedef struct sn_async_task_t {
-  uv_work_t task;
+js_value_t *
+sn_crypto_aead_xchacha20poly1305_ietf_decryptv_detached (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(7, crypto_aead_xchacha20poly1305_ietf_decryptv_detached)
 
-  enum {
-    sn_async_task_promise,
-    sn_async_task_callback
-  } type;
+  SN_ARGV_IOVECS(m, 0)
+  SN_ARGV_CHECK_NULL(nsec, 1)
+  SN_ARGV_IOVECS(c, 2)
+  SN_ARGV_TYPEDARRAY(mac, 3)
+  SN_ARGV_OPTS_IOVECS(ad, 4)
+  SN_ARGV_TYPEDARRAY(npub, 5)
+  SN_ARGV_TYPEDARRAY(k, 6)
 
-  void *req;
-  int code;
+  SN_THROWS(!nsec_is_null, "nsec must always be set to null")
 
-  js_deferred_t *deferred;
-  js_ref_t *cb;
-} sn_async_task_t;
+  SN_THROWS(m_size != c_size, "m must be 'c.byteLength' bytes")
+  SN_ASSERT_LENGTH(mac_size, crypto_aead_xchacha20poly1305_ietf_ABYTES, "mac")
+  SN_ASSERT_LENGTH(npub_size, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, "npub")
+  SN_ASSERT_LENGTH(k_size, crypto_aead_xchacha20poly1305_ietf_KEYBYTES, "k")
 
-typedef struct sn_async_pwhash_request {
-  js_env_t *env;
-  js_ref_t *out_ref;
-  unsigned char *out_data;
-  size_t out_size;
-  js_ref_t *pwd_ref;
-  const char *pwd_data;
-  size_t pwd_size;
-  js_ref_t *salt_ref;
-  unsigned char *salt;
-  uint32_t opslimit;
-  uint32_t memlimit;
-  uint32_t alg;
-} sn_async_pwhash_request;
+  sn__extension_aead_chacha20poly1305_ietf_state state;
+  sn__extension_aead_xchacha20poly1305_ietf_init(&state, npub_data, k_data);
 
-static void async_pwhash_execute (uv_work_t *uv_req) {
-  sn_async_task_t *task = (sn_async_task_t *) uv_req;
-  sn_async_pwhash_request *req = (sn_async_pwhash_request *) task->req;
-  task->code = crypto_pwhash(req->out_data,
+  SN_RETURN(sn_aead_iovec_decrypt(&state, m, c, m_size, ad, mac_data), "could not verify data")
+}
+
+js_value_t *
+sn_crypto_aead_chacha20poly1305_ietf_verify (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(4, crypto_aead_chacha20poly1305_ietf_verify)
+
+  SN_ARGV_TYPEDARRAY(c, 0)
+  SN_ARGV_OPTS_TYPEDARRAY(ad, 1)
+  SN_ARGV_TYPEDARRAY(npub, 2)
+  SN_ARGV_TYPEDARRAY(k, 3)
+
+  SN_THROWS(c_size < crypto_aead_chacha20poly1305_ietf_ABYTES, "c must be at least 'crypto_aead_chacha20poly1305_ietf_ABYTES' bytes")
+  SN_ASSERT_LENGTH(npub_size, crypto_aead_chacha20poly1305_ietf_NPUBBYTES, "npub")
+  SN_ASSERT_LENGTH(k_size, crypto_aead_chacha20poly1305_ietf_KEYBYTES, "k")
+
+  size_t clen = c_size - crypto_aead_chacha20poly1305_ietf_ABYTES;
+
+  SN_RETURN_BOOLEAN(sn__extension_aead_chacha20poly1305_ietf_verify_detached(c_data, clen, c_data + clen, ad_data, ad_size, npub_data, k_data))
+}
+
+js_value_t *
+sn_crypto_aead_chacha20poly1305_ietf_verify_detached (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(5, crypto_aead_chacha20poly1305_ietf_verify_detached)
+
+  SN_ARGV_TYPEDARRAY(c, 0)
+  SN_ARGV_TYPEDARRAY(mac, 1)
+  SN_ARGV_OPTS_TYPEDARRAY(ad, 2)
+  SN_ARGV_TYPEDARRAY(npub, 3)
+  SN_ARGV_TYPEDARRAY(k, 4)
+
+  SN_ASSERT_LENGTH(mac_size, crypto_aead_chacha20poly1305_ietf_ABYTES, "mac")
+  SN_ASSERT_LENGTH(npub_size, crypto_aead_chacha20poly1305_ietf_NPUBBYTES, "npub")
+  SN_ASSERT_LENGTH(k_size, crypto_aead_chacha20poly1305_ietf_KEYBYTES, "k")
+
+  SN_RETURN_BOOLEAN(sn__extension_aead_chacha20poly1305_ietf_verify_detached(c_data, c_size, mac_data, ad_data, ad_size, npub_data, k_data))
+}
+
+template <bool sequence>
+js_value_t *
+sn_crypto_aead_chacha20poly1305_ietf_encryptv (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(6, crypto_aead_chacha20poly1305_ietf_encryptv)
+
+  SN_ARGV_IOVECS(c, 0)
+  SN_ARGV_IOVECS(m, 1)
+  SN_ARGV_OPTS_IOVECS(ad, 2)
+  SN_ARGV_CHECK_NULL(nsec, 3)
+  SN_ARGV_TYPEDARRAY(npub, 4)
+  SN_ARGV_TYPEDARRAY(k, 5)
+
+  SN_THROWS(!nsec_is_null, "nsec must always be set to null")
+
+  SN_THROWS(c_size != m_size + crypto_aead_chacha20poly1305_ietf_ABYTES, "c must 'm.byteLength + crypto_aead_chacha20poly1305_ietf_ABYTES' bytes")
+  SN_THROWS(c_size > 0xffffffff, "c.byteLength must be a 32bit integer")
+  SN_ASSERT_NONCE(sequence, npub, crypto_aead_chacha20poly1305_ietf_NPUBBYTES)
+  SN_ASSERT_LENGTH(k_size, crypto_aead_chacha20poly1305_ietf_KEYBYTES, "k")
+  SN_NONCE_SEQUENCE(sequence, npub, crypto_aead_chacha20poly1305_ietf_NPUBBYTES)
+
+  sn__extension_aead_chacha20poly1305_ietf_state state;
+  sn__extension_aead_chacha20poly1305_ietf_init(&state, npub_data, k_data);
+
+  sn_aead_iovec_encrypt(&state, c, m, m_size, ad, NULL);
+
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) c_size, &result), "")
+  return result;
+}
+
+js_value_t *
+sn_crypto_aead_chacha20poly1305_ietf_decryptv (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(6, crypto_aead_chacha20poly1305_ietf_decryptv)
+
+  SN_ARGV_IOVECS(m, 0)
+  SN_ARGV_CHECK_NULL(nsec, 1)
+  SN_ARGV_IOVECS(c, 2)
+  SN_ARGV_OPTS_IOVECS(ad, 3)
+  SN_ARGV_TYPEDARRAY(npub, 4)
+  SN_ARGV_TYPEDARRAY(k, 5)
+
+  SN_THROWS(!nsec_is_null, "nsec must always be set to null")
+
+  SN_THROWS(c_size < crypto_aead_chacha20poly1305_ietf_ABYTES, "c must be at least 'crypto_aead_chacha20poly1305_ietf_ABYTES' bytes")
+  SN_THROWS(m_size != c_size - crypto_aead_chacha20poly1305_ietf_ABYTES, "m must 'c.byteLength - crypto_aead_chacha20poly1305_ietf_ABYTES' bytes")
+  SN_ASSERT_LENGTH(npub_size, crypto_aead_chacha20poly1305_ietf_NPUBBYTES, "npub")
+  SN_ASSERT_LENGTH(k_size, crypto_aead_chacha20poly1305_ietf_KEYBYTES, "k")
+  SN_THROWS(m_size > 0xffffffff, "m.byteLength must be a 32bit integer")
+
+  sn__extension_aead_chacha20poly1305_ietf_state state;
+  sn__extension_aead_chacha20poly1305_ietf_init(&state, npub_data, k_data);
+
+  SN_CALL(sn_aead_iovec_decrypt(&state, m, c, m_size, ad, NULL), "could not verify data")
+
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) m_size, &result), "")
+  return result;
+}
+
+template <bool sequence>
+js_value_t *
+sn_crypto_aead_chacha20poly1305_ietf_encryptv_detached (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(7, crypto_aead_chacha20poly1305_ietf_encryptv_detached)
+
+  SN_ARGV_IOVECS(c, 0)
+  SN_ARGV_TYPEDARRAY(mac, 1)
+  SN_ARGV_IOVECS(m, 2)
+  SN_ARGV_OPTS_IOVECS(ad, 3)
+  SN_ARGV_CHECK_NULL(nsec, 4)
+  SN_ARGV_TYPEDARRAY(npub, 5)
+  SN_ARGV_TYPEDARRAY(k, 6)
+
+  SN_THROWS(!nsec_is_null, "nsec must always be set to null")
+
+  SN_THROWS(c_size != m_size, "c must be 'm.byteLength' bytes")
+  SN_ASSERT_LENGTH(mac_size, crypto_aead_chacha20poly1305_ietf_ABYTES, "mac")
+  SN_ASSERT_NONCE(sequence, npub, crypto_aead_chacha20poly1305_ietf_NPUBBYTES)
+  SN_ASSERT_LENGTH(k_size, crypto_aead_chacha20poly1305_ietf_KEYBYTES, "k")
+  SN_NONCE_SEQUENCE(sequence, npub, crypto_aead_chacha20poly1305_ietf_NPUBBYTES)
+
+  sn__extension_aead_chacha20poly1305_ietf_state state;
+  sn__extension_aead_chacha20poly1305_ietf_init(&state, npub_data, k_data);
+
+  sn_aead_iovec_encrypt(&state, c, m, m_size, ad, mac_data);
+
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) mac_size, &result), "")
+  return result;
+}
+
+js_value_t *
+sn_crypto_aead_chacha20poly1305_ietf_decryptv_detached (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(7, crypto_aead_chacha20poly1305_ietf_decryptv_detached)
+
+  SN_ARGV_IOVECS(m, 0)
+  SN_ARGV_CHECK_NULL(nsec, 1)
+  SN_ARGV_IOVECS(c, 2)
+  SN_ARGV_TYPEDARRAY(mac, 3)
+  SN_ARGV_OPTS_IOVECS(ad, 4)
+  SN_ARGV_TYPEDARRAY(npub, 5)
+  SN_ARGV_TYPEDARRAY(k, 6)
+
+  SN_THROWS(!nsec_is_null, "nsec must always be set to null")
+
+  SN_THROWS(m_size != c_size, "m must be 'c.byteLength' bytes")
+  SN_ASSERT_LENGTH(mac_size, crypto_aead_chacha20poly1305_ietf_ABYTES, "mac")
+  SN_ASSERT_LENGTH(npub_size, crypto_aead_chacha20poly1305_ietf_NPUBBYTES, "npub")
+  SN_ASSERT_LENGTH(k_size, crypto_aead_chacha20poly1305_ietf_KEYBYTES, "k")
+
+  sn__extension_aead_chacha20poly1305_ietf_state state;
+  sn__extension_aead_chacha20poly1305_ietf_init(&state, npub_data, k_data);
+
+  SN_RETURN(sn_aead_iovec_decrypt(&state, m, c, m_size, ad, mac_data), "could not verify data")
+}
+
+js_value_t *
+sn_crypto_secretstream_xchacha20poly1305_keygen (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(1, crypto_secretstream_xchacha20poly1305_keygen)
+
+  SN_ARGV_TYPEDARRAY(k, 0)
+
+  SN_ASSERT_LENGTH(k_size, crypto_secretstream_xchacha20poly1305_KEYBYTES, "k")
+
+  crypto_secretstream_xchacha20poly1305_keygen(k_data);
+
+  return NULL;
+}
+
+js_value_t *
+sn_crypto_secretstream_xchacha20poly1305_init_push (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, crypto_secretstream_xchacha20poly1305_init_push)
+
+  SN_ARGV_BUFFER_CAST(crypto_secretstream_xchacha20poly1305_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(header, 1)
+  SN_ARGV_TYPEDARRAY(k, 2)
+
+  SN_THROWS(state_size != sizeof(crypto_secretstream_xchacha20poly1305_state), "state must be 'crypto_secretstream_xchacha20poly1305_STATEBYTES' bytes")
+  SN_ASSERT_LENGTH(header_size, crypto_secretstream_xchacha20poly1305_HEADERBYTES, "header")
+  SN_ASSERT_LENGTH(k_size, crypto_secretstream_xchacha20poly1305_KEYBYTES, "k")
+
+  SN_RETURN(crypto_secretstream_xchacha20poly1305_init_push(state, header_data, k_data), "initial push failed")
+}
+
+static inline int64_t
+sn_crypto_secretstream_xchacha20poly1305_push (
+  js_env_t *env,
+  js_receiver_t,
+
+  js_arraybuffer_span_t state,
+  uint32_t state_offset,
+  uint32_t state_len,
+
+  js_arraybuffer_span_t c,
+  uint32_t c_offset,
+  uint32_t c_len,
+
+  js_arraybuffer_span_t m,
+  uint32_t m_offset,
+  uint32_t m_len,
+
+  js_object_t ad,
+  uint32_t ad_offset,
+  uint32_t ad_len,
+
+  uint32_t tag
+) {
+  assert_bounds(state);
+  assert_bounds(c);
+  assert_bounds(m);
+
+  assert(state_len == sizeof(crypto_secretstream_xchacha20poly1305_state));
+  auto state_data = reinterpret_cast<crypto_secretstream_xchacha20poly1305_state *>(&state[state_offset]);
+
+  // next-line kept for future rewrites
+  // assert(m_len <= crypto_secretstream_xchacha20poly1305_MESSAGEBYTES_MAX);
+  assert(c_len == m_len + crypto_secretstream_xchacha20poly1305_ABYTES);
+  assert(c_len <= 0xffffffff && "32bit integer");
+
+  uint8_t *ad_data = NULL;
+  if (ad_len) {
+    uint8_t *slab;
+    size_t slab_len;
+
+    int err = js_get_arraybuffer_info(env, ad, (void **) &slab, &slab_len);
+    assert(err == 0);
+
+    assert(ad_len + ad_offset <= slab_len);
+    ad_data = slab + ad_offset;
+  }
+
+  unsigned long long clen = 0;
+
+  int res = crypto_secretstream_xchacha20poly1305_push(state_data, &c[c_offset], &clen, &m[m_offset], m_len, ad_data, ad_len, tag);
+  if (res < 0) return -1;
+
+  return clen;
+}
+
+js_value_t *
+sn_crypto_secretstream_xchacha20poly1305_init_pull (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, crypto_secretstream_xchacha20poly1305_init_pull)
+
+  SN_ARGV_BUFFER_CAST(crypto_secretstream_xchacha20poly1305_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(header, 1)
+  SN_ARGV_TYPEDARRAY(k, 2)
+
+  SN_THROWS(state_size != sizeof(crypto_secretstream_xchacha20poly1305_state), "state must be 'crypto_secretstream_xchacha20poly1305_STATEBYTES' bytes")
+  SN_ASSERT_LENGTH(header_size, crypto_secretstream_xchacha20poly1305_HEADERBYTES, "header")
+  SN_ASSERT_LENGTH(k_size, crypto_secretstream_xchacha20poly1305_KEYBYTES, "k")
+
+  SN_RETURN(crypto_secretstream_xchacha20poly1305_init_pull(state, header_data, k_data), "initial pull failed")
+}
+
+static inline int64_t
+sn_crypto_secretstream_xchacha20poly1305_pull(
+  js_env_t *env,
+  js_receiver_t,
+
+  js_arraybuffer_span_t state,
+  uint32_t state_offset,
+  uint32_t state_len,
+
+  js_arraybuffer_span_t m,
+  uint32_t m_offset,
+  uint32_t m_len,
+
+  js_arraybuffer_span_t tag,
+  uint32_t tag_offset,
+  uint32_t tag_len,
+
+  js_arraybuffer_span_t c,
+  uint32_t c_offset,
+  uint32_t c_len,
+
+  js_object_t ad,
+  uint32_t ad_offset,
+  uint32_t ad_len
+) {
+  assert_bounds(state);
+  assert_bounds(m);
+  assert_bounds(tag);
+  assert_bounds(c);
+
+  assert(state_len == sizeof(crypto_secretstream_xchacha20poly1305_state));
+  auto state_data = reinterpret_cast<crypto_secretstream_xchacha20poly1305_state*>(&state[state_offset]);
+
+  assert(c_len >= crypto_secretstream_xchacha20poly1305_ABYTES);
+  assert(tag_len == 1);
+  assert(m_len == c_len - crypto_secretstream_xchacha20poly1305_ABYTES);
+  assert(m_len <= 0xffffffff);
+
+  uint8_t *ad_data = NULL;
+  if (ad_len) {
+    uint8_t *slab;
+    size_t slab_len;
+
+    int err = js_get_arraybuffer_info(env, ad, (void **) &slab, &slab_len);
+    assert(err == 0);
+
+    assert(ad_len + ad_offset <= slab_len);
+    ad_data = slab + ad_offset;
+  }
+
+  unsigned long long mlen = 0;
+
+  int res = crypto_secretstream_xchacha20poly1305_pull(state_data, &m[m_offset], &mlen, &tag[tag_offset], &c[c_offset], c_len, ad_data, ad_len);
+  if (res < 0) return -1;
+
+  return mlen;
+}
+
+// frame is tag byte || message || mac, the message is read from and encrypted at frame[1..]
+// libsodium writes the ciphertext over the message byte for byte, so no second buffer is needed
+static inline int64_t
+sn_crypto_secretstream_xchacha20poly1305_push_inplace(
+  js_env_t *env,
+  js_receiver_t,
+
+  js_arraybuffer_span_t state,
+  uint32_t state_offset,
+  uint32_t state_len,
+
+  js_arraybuffer_span_t frame,
+  uint32_t frame_offset,
+  uint32_t frame_len,
+
+  js_object_t ad,
+  uint32_t ad_offset,
+  uint32_t ad_len,
+
+  uint32_t tag
+) {
+  assert_bounds(state);
+  assert_bounds(frame);
+
+  assert(state_len == sizeof(crypto_secretstream_xchacha20poly1305_state));
+  auto state_data = reinterpret_cast<crypto_secretstream_xchacha20poly1305_state *>(&state[state_offset]);
+
+  assert(frame_len >= crypto_secretstream_xchacha20poly1305_ABYTES);
+
+  uint8_t *ad_data = NULL;
+  if (ad_len) {
+    uint8_t *slab;
+    size_t slab_len;
+
+    int err = js_get_arraybuffer_info(env, ad, (void **) &slab, &slab_len);
+    assert(err == 0);
+
+    assert(ad_len + ad_offset <= slab_len);
+    ad_data = slab + ad_offset;
+  }
+
+  uint8_t *frame_data = &frame[frame_offset];
+  unsigned long long clen = 0;
+
+  int res = crypto_secretstream_xchacha20poly1305_push(state_data, frame_data, &clen, frame_data + 1, frame_len - crypto_secretstream_xchacha20poly1305_ABYTES, ad_data, ad_len, tag);
+  if (res < 0) return -1;
+
+  return clen;
+}
+
+// the plaintext is written over the ciphertext at frame[1..], only once the mac has been verified
+static inline int64_t
+sn_crypto_secretstream_xchacha20poly1305_pull_inplace(
+  js_env_t *env,
+  js_receiver_t,
+
+  js_arraybuffer_span_t state,
+  uint32_t state_offset,
+  uint32_t state_len,
+
+  js_arraybuffer_span_t tag,
+  uint32_t tag_offset,
+  uint32_t tag_len,
+
+  js_arraybuffer_span_t frame,
+  uint32_t frame_offset,
+  uint32_t frame_len,
+
+  js_object_t ad,
+  uint32_t ad_offset,
+  uint32_t ad_len
+) {
+  assert_bounds(state);
+  assert_bounds(tag);
+  assert_bounds(frame);
+
+  assert(state_len == sizeof(crypto_secretstream_xchacha20poly1305_state));
+  auto state_data = reinterpret_cast<crypto_secretstream_xchacha20poly1305_state *>(&state[state_offset]);
+
+  assert(frame_len >= crypto_secretstream_xchacha20poly1305_ABYTES);
+  assert(tag_len == 1);
+
+  uint8_t *ad_data = NULL;
+  if (ad_len) {
+    uint8_t *slab;
+    size_t slab_len;
+
+    int err = js_get_arraybuffer_info(env, ad, (void **) &slab, &slab_len);
+    assert(err == 0);
+
+    assert(ad_len + ad_offset <= slab_len);
+    ad_data = slab + ad_offset;
+  }
+
+  uint8_t *frame_data = &frame[frame_offset];
+  unsigned long long mlen = 0;
+
+  int res = crypto_secretstream_xchacha20poly1305_pull(state_data, frame_data + 1, &mlen, &tag[tag_offset], frame_data, frame_len, ad_data, ad_len);
+  if (res < 0) return -1;
+
+  return mlen;
+}
+
+// message i is m[offsets[i]..offsets[i + 1]], ciphertexts are written back to back into c
+js_value_t *
+sn_crypto_secretstream_xchacha20poly1305_push_many (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(6, crypto_secretstream_xchacha20poly1305_push_many)
+
+  SN_ARGV_BUFFER_CAST(crypto_secretstream_xchacha20poly1305_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(c, 1)
+  SN_ARGV_TYPEDARRAY(m, 2)
+  SN_ARGV_UINT32ARRAY(offsets, 3)
+  SN_ARGV_TYPEDARRAY(tags, 4)
+  SN_ARGV_UINT32ARRAY(lengths, 5)
+
+  SN_THROWS(state_size != sizeof(crypto_secretstream_xchacha20poly1305_state), "state must be 'crypto_secretstream_xchacha20poly1305_STATEBYTES' bytes")
+
+  size_t n = tags_size;
+
+  SN_THROWS(offsets_length != n + 1, "offsets must have 'tags.byteLength + 1' entries")
+  SN_THROWS(lengths_length != n, "lengths must have 'tags.byteLength' entries")
+  SN_THROWS(offsets_data[n] > m_size, "offsets must lie within m")
+
+  for (size_t i = 0; i < n; i++) {
+    SN_THROWS(offsets_data[i] > offsets_data[i + 1], "offsets must be ascending")
+  }
+
+  uint64_t total = (uint64_t) (offsets_data[n] - offsets_data[0]) + (uint64_t) n * crypto_secretstream_xchacha20poly1305_ABYTES;
+  SN_THROWS(c_size < total, "c must fit every message plus 'crypto_secretstream_xchacha20poly1305_ABYTES' bytes each")
+  SN_THROWS(total > 0xffffffff, "c.byteLength must be a 32bit integer")
+
+  size_t written = 0;
+
+  for (size_t i = 0; i < n; i++) {
+    unsigned long long clen;
+    size_t mlen = offsets_data[i + 1] - offsets_data[i];
+
+    SN_CALL(crypto_secretstream_xchacha20poly1305_push(state, c_data + written, &clen, m_data + offsets_data[i], mlen, NULL, 0, tags_data[i]), "push failed")
+
+    lengths_data[i] = (uint32_t) clen;
+    written += clen;
+  }
+
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) written, &result), "")
+  return result;
+}
+
+// returns the index of the first message that fails to authenticate, or the number of messages
+js_value_t *
+sn_crypto_secretstream_xchacha20poly1305_pull_many (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(6, crypto_secretstream_xchacha20poly1305_pull_many)
+
+  SN_ARGV_BUFFER_CAST(crypto_secretstream_xchacha20poly1305_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(m, 1)
+  SN_ARGV_TYPEDARRAY(tags, 2)
+  SN_ARGV_TYPEDARRAY(c, 3)
+  SN_ARGV_UINT32ARRAY(offsets, 4)
+  SN_ARGV_UINT32ARRAY(lengths, 5)
+
+  SN_THROWS(state_size != sizeof(crypto_secretstream_xchacha20poly1305_state), "state must be 'crypto_secretstream_xchacha20poly1305_STATEBYTES' bytes")
+
+  size_t n = tags_size;
+
+  SN_THROWS(offsets_length != n + 1, "offsets must have 'tags.byteLength + 1' entries")
+  SN_THROWS(lengths_length != n, "lengths must have 'tags.byteLength' entries")
+  SN_THROWS(offsets_data[n] > c_size, "offsets must lie within c")
+
+  for (size_t i = 0; i < n; i++) {
+    SN_THROWS(offsets_data[i] > offsets_data[i + 1], "offsets must be ascending")
+    SN_THROWS(offsets_data[i + 1] - offsets_data[i] < crypto_secretstream_xchacha20poly1305_ABYTES, "every ciphertext must be at least 'crypto_secretstream_xchacha20poly1305_ABYTES' bytes")
+  }
+
+  SN_THROWS(m_size < offsets_data[n] - offsets_data[0] - n * crypto_secretstream_xchacha20poly1305_ABYTES, "m must fit every message")
+
+  size_t i = 0;
+  size_t written = 0;
+
+  for (; i < n; i++) {
+    unsigned long long mlen;
+    size_t clen = offsets_data[i + 1] - offsets_data[i];
+
+    if (crypto_secretstream_xchacha20poly1305_pull(state, m_data + written, &mlen, tags_data + i, c_data + offsets_data[i], clen, NULL, 0) != 0) break;
+
+    lengths_data[i] = (uint32_t) mlen;
+    written += mlen;
+  }
+
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) i, &result), "")
+  return result;
+}
+
+js_value_t *
+sn_crypto_secretstream_xchacha20poly1305_rekey (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(1, crypto_secretstream_xchacha20poly1305_rekey)
+
+  SN_ARGV_BUFFER_CAST(crypto_secretstream_xchacha20poly1305_state *, state, 0)
+
+  SN_THROWS(state_size != sizeof(crypto_secretstream_xchacha20poly1305_state), "state must be 'crypto_secretstream_xchacha20poly1305_STATEBYTES' bytes")
+
+  crypto_secretstream_xchacha20poly1305_rekey(state);
+
+  return NULL;
+}
+
+typedef struct sn_async_task_t {
+  uv_work_t task;
+
+  enum {
+    sn_async_task_promise,
+    sn_async_task_callback
+  } type;
+
+  void *req;
+  int code;
+
+  js_deferred_t *deferred;
+  js_ref_t *cb;
+} sn_async_task_t;
+
+// A batch split into lanes that run in parallel on the uv pool. Once every
+// lane is done, finish (if any) runs on the pool with the sum of the lane
+// results, then the task is settled and cleanup runs on the loop thread.
+// A strict batch rejects on a non-zero result and otherwise resolves with
+// null, any other resolves with value plus the result.
+
+typedef size_t (*sn_async_lanes_run_fn)(void *data, size_t lane, size_t lanes);
+
+typedef size_t (*sn_async_lanes_finish_fn)(void *data, size_t result);
+
+typedef void (*sn_async_lanes_cleanup_fn)(void *data);
+
+#define SN_ASYNC_LANES_REFS_MAX 8
+
+typedef struct sn_async_lanes_request sn_async_lanes_request;
+
+typedef struct sn_async_lane {
+  uv_work_t work;
+  sn_async_lanes_request *req;
+  size_t lane;
+  size_t result;
+} sn_async_lane;
+
+struct sn_async_lanes_request {
+  js_env_t *env;
+  sn_async_task_t *task;
+  void *data;
+  sn_async_lanes_run_fn run;
+  sn_async_lanes_finish_fn finish;
+  sn_async_lanes_cleanup_fn cleanup;
+  const char *message;
+  bool strict;
+  uint32_t value;
+  size_t result;
+  js_ref_t *refs[SN_ASYNC_LANES_REFS_MAX];
+  size_t refs_len;
+  size_t lanes_len;
+  size_t pending;
+  sn_async_lane tail;
+  sn_async_lane *lanes;
+};
+
+// lanes for a batch of n units of work, one per min units, capped by max and the pool
+static size_t
+sn_async_lanes_count (uint64_t n, uint64_t min, size_t max) {
+  uint64_t lanes = n / min;
+
+  if (lanes > uv_available_parallelism()) lanes = uv_available_parallelism();
+  if (lanes > max) lanes = max;
+
+  return lanes < 1 ? 1 : (size_t) lanes;
+}
+
+static sn_async_lanes_request *
+sn_async_lanes_create (js_env_t *env, size_t lanes, void *data, sn_async_lanes_run_fn run, sn_async_lanes_finish_fn finish, sn_async_lanes_cleanup_fn cleanup, const char *message) {
+  sn_async_lanes_request *req = (sn_async_lanes_request *) malloc(sizeof(sn_async_lanes_request));
+  if (req == NULL) return NULL;
+
+  req->lanes = (sn_async_lane *) malloc(lanes * sizeof(sn_async_lane));
+  if (req->lanes == NULL) {
+    free(req);
+    return NULL;
+  }
+
+  req->env = env;
+  req->task = NULL;
+  req->data = data;
+  req->run = run;
+  req->finish = finish;
+  req->cleanup = cleanup;
+  req->message = message;
+  req->strict = false;
+  req->value = 0;
+  req->result = 0;
+  req->refs_len = 0;
+  req->lanes_len = lanes;
+  req->pending = lanes;
+  req->tail.req = req;
+
+  for (size_t i = 0; i < lanes; i++) {
+    req->lanes[i].req = req;
+    req->lanes[i].lane = i;
+    req->lanes[i].result = 0;
+  }
+
+  return req;
+}
+
+// keeps value alive until the batch is settled
+static void
+sn_async_lanes_ref (sn_async_lanes_request *req, js_value_t *value) {
+  assert(req->refs_len < SN_ASYNC_LANES_REFS_MAX);
+
+  int err = js_create_reference(req->env, value, 1, &req->refs[req->refs_len++]);
+  assert(err == 0);
+}
+
+static void
+sn_async_lanes_settle (sn_async_lanes_request *req) {
+  int err;
+  sn_async_task_t *task = req->task;
+
+  if (req->strict && req->result != 0) task->code = -1;
+
+  js_handle_scope_t *scope;
+  err = js_open_handle_scope(req->env, &scope);
+  assert(err == 0);
+
+  js_value_t *argv[2];
+
+  if (task->code == 0) {
+    err = js_get_null(req->env, &argv[0]);
+    assert(err == 0);
+
+    if (req->strict) {
+      err = js_get_null(req->env, &argv[1]);
+    } else {
+      err = js_create_uint32(req->env, (uint32_t) (req->value + req->result), &argv[1]);
+    }
+    assert(err == 0);
+  } else {
+    js_value_t *err_msg;
+    err = js_create_string_utf8(req->env, (const utf8_t *) req->message, strlen(req->message), &err_msg);
+    assert(err == 0);
+    err = js_create_error(req->env, NULL, err_msg, &argv[0]);
+    assert(err == 0);
+  }
+
+  switch (task->type) {
+  case sn_async_task_t::sn_async_task_promise: {
+    if (task->code == 0) {
+      err = js_resolve_deferred(req->env, task->deferred, argv[1]);
+    } else {
+      err = js_reject_deferred(req->env, task->deferred, argv[0]);
+    }
+    assert(err == 0);
+    task->deferred = NULL;
+    break;
+  }
+  case sn_async_task_t::sn_async_task_callback: {
+    js_value_t *global;
+    err = js_get_global(req->env, &global);
+    assert(err == 0);
+
+    js_value_t *callback;
+    err = js_get_reference_value(req->env, task->cb, &callback);
+    assert(err == 0);
+
+    js_value_t *return_val;
+    SN_CALL_FUNCTION(req->env, global, callback, task->code == 0 ? 2 : 1, argv, &return_val)
+
+    err = js_delete_reference(req->env, task->cb);
+    assert(err == 0);
+    break;
+  }
+  }
+
+  err = js_close_handle_scope(req->env, scope);
+  assert(err == 0);
+
+  for (size_t i = 0; i < req->refs_len; i++) {
+    err = js_delete_reference(req->env, req->refs[i]);
+    assert(err == 0);
+  }
+
+  req->cleanup(req->data);
+
+  free(req->lanes);
+  free(req);
+  free(task);
+}
+
+static void
+async_lanes_finish_execute (uv_work_t *uv_req) {
+  sn_async_lane *tail = (sn_async_lane *) uv_req;
+  sn_async_lanes_request *req = tail->req;
+
+  req->result = req->finish(req->data, req->result);
+}
+
+static void
+async_lanes_finish_complete (uv_work_t *uv_req, int status) {
+  sn_async_lane *tail = (sn_async_lane *) uv_req;
+  sn_async_lanes_request *req = tail->req;
+
+  if (status != 0) req->task->code = status;
+
+  sn_async_lanes_settle(req);
+}
+
+static void
+async_lanes_execute (uv_work_t *uv_req) {
+  sn_async_lane *lane = (sn_async_lane *) uv_req;
+  sn_async_lanes_request *req = lane->req;
+
+  lane->result = req->run(req->data, lane->lane, req->lanes_len);
+}
+
+static void
+async_lanes_complete (uv_work_t *uv_req, int status) {
+  sn_async_lane *lane = (sn_async_lane *) uv_req;
+  sn_async_lanes_request *req = lane->req;
+
+  if (status != 0) req->task->code = status;
+  req->result += lane->result;
+
+  if (--req->pending) return;
+
+  if (req->finish != NULL && req->task->code == 0) {
+    uv_loop_t *loop;
+    int err = js_get_env_loop(req->env, &loop);
+    assert(err == 0);
+
+    err = uv_queue_work(loop, &req->tail.work, async_lanes_finish_execute, async_lanes_finish_complete);
+    assert(err == 0);
+    return;
+  }
+
+  sn_async_lanes_settle(req);
+}
+
+static void
+sn_async_lanes_queue (sn_async_lanes_request *req) {
+  uv_loop_t *loop;
+  int err = js_get_env_loop(req->env, &loop);
+  assert(err == 0);
+
+  req->task->code = 0;
+
+  for (size_t i = 0; i < req->lanes_len; i++) {
+    err = uv_queue_work(loop, &req->lanes[i].work, async_lanes_execute, async_lanes_complete);
+    assert(err == 0);
+  }
+}
+
+typedef struct sn_async_pwhash_request {
+  js_env_t *env;
+  js_ref_t *out_ref;
+  unsigned char *out_data;
+  size_t out_size;
+  js_ref_t *pwd_ref;
+  const char *pwd_data;
+  size_t pwd_size;
+  js_ref_t *salt_ref;
+  unsigned char *salt;
+  uint32_t opslimit;
+  uint32_t memlimit;
+  uint32_t alg;
+} sn_async_pwhash_request;
+
+static void async_pwhash_execute (uv_work_t *uv_req) {
+  sn_async_task_t *task = (sn_async_task_t *) uv_req;
+  sn_async_pwhash_request *req = (sn_async_pwhash_request *) task->req;
+  task->code = crypto_pwhash(req->out_data,
                              req->out_size,
                              req->pwd_data,
                              req->pwd_size,
@@ -2250,10 +3571,1400 @@ static void async_pwhash_execute (uv_work_t *uv_req) {
                              req->alg);
 }
 
-static void async_pwhash_complete (uv_work_t *uv_req, int status) {
+static void async_pwhash_complete (uv_work_t *uv_req, int status) {
+  int err;
+  sn_async_task_t *task = (sn_async_task_t *) uv_req;
+  sn_async_pwhash_request *req = (sn_async_pwhash_request *) task->req;
+
+  js_handle_scope_t *scope;
+  err = js_open_handle_scope(req->env, &scope);
+  assert(err == 0);
+
+  js_value_t *global;
+  err = js_get_global(req->env, &global);
+  assert(err == 0);
+
+  SN_ASYNC_COMPLETE("failed to compute password hash")
+
+  err = js_close_handle_scope(req->env, scope);
+  assert(err == 0);
+
+  err = js_delete_reference(req->env, req->out_ref);
+  assert(err == 0);
+  err = js_delete_reference(req->env, req->pwd_ref);
+  assert(err == 0);
+  err = js_delete_reference(req->env, req->salt_ref);
+  assert(err == 0);
+
+  free(req);
+  free(task);
+}
+
+js_value_t *
+sn_crypto_pwhash_async (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV_OPTS(6, 7, crypto_pwhash_async)
+
+  SN_ARGV_BUFFER_CAST(unsigned char *, out, 0)
+  SN_ARGV_BUFFER_CAST(char *, pwd, 1)
+  SN_ARGV_BUFFER_CAST(unsigned char *, salt, 2)
+  SN_ARGV_UINT64(opslimit, 3)
+  SN_ARGV_UINT64(memlimit, 4)
+  SN_ARGV_UINT8(alg, 5)
+
+  SN_ASSERT_MIN_LENGTH(out_size, crypto_pwhash_BYTES_MIN, "out")
+  SN_ASSERT_MAX_LENGTH(out_size, crypto_pwhash_BYTES_MAX, "out")
+  SN_ASSERT_LENGTH(salt_size, crypto_pwhash_SALTBYTES, "salt")
+  SN_ASSERT_MIN_LENGTH(opslimit, crypto_pwhash_OPSLIMIT_MIN, "opslimit")
+  SN_ASSERT_MAX_LENGTH(opslimit, crypto_pwhash_OPSLIMIT_MAX, "opslimit")
+  SN_ASSERT_MIN_LENGTH(memlimit, crypto_pwhash_MEMLIMIT_MIN, "memlimit")
+  SN_ASSERT_MAX_LENGTH(memlimit, (int64_t) crypto_pwhash_MEMLIMIT_MAX, "memlimit")
+  SN_THROWS(alg < 1 || alg > 2, "alg must be either Argon2i 1.3 or Argon2id 1.3")
+  SN_ASSERT_OPT_CALLBACK(6)
+
+  sn_async_pwhash_request *req = (sn_async_pwhash_request *) malloc(sizeof(sn_async_pwhash_request));
+
+  req->env = env;
+  req->out_data = out;
+  req->out_size = out_size;
+  req->pwd_data = pwd;
+  req->pwd_size = pwd_size;
+  req->salt = salt;
+  req->opslimit = opslimit;
+  req->memlimit = memlimit;
+  req->alg = alg;
+
+  sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
+  SN_ASYNC_TASK(6)
+
+  err = js_create_reference(env, out_argv, 1, &req->out_ref);
+  assert(err == 0);
+  err = js_create_reference(env, pwd_argv, 1, &req->pwd_ref);
+  assert(err == 0);
+  err = js_create_reference(env, salt_argv, 1, &req->salt_ref);
+  assert(err == 0);
+
+  SN_QUEUE_TASK(task, async_pwhash_execute, async_pwhash_complete)
+
+  return promise;
+}
+
+typedef struct sn_async_pwhash_str_request {
+  uv_work_t task;
+  js_env_t *env;
+  js_ref_t *out_ref;
+  char *out_data;
+  js_ref_t *pwd_ref;
+  const char *pwd_data;
+  size_t pwd_size;
+  uint32_t opslimit;
+  uint32_t memlimit;
+} sn_async_pwhash_str_request;
+
+static void async_pwhash_str_execute (uv_work_t *uv_req) {
+  sn_async_task_t *task = (sn_async_task_t *) uv_req;
+  sn_async_pwhash_str_request *req = (sn_async_pwhash_str_request *) task->req;
+  task->code = crypto_pwhash_str(req->out_data,
+                                 req->pwd_data,
+                                 req->pwd_size,
+                                 req->opslimit,
+                                 req->memlimit);
+}
+
+static void async_pwhash_str_complete (uv_work_t *uv_req, int status) {
+  sn_async_task_t *task = (sn_async_task_t *) uv_req;
+  sn_async_pwhash_str_request *req = (sn_async_pwhash_str_request *) task->req;
+  int err;
+  js_handle_scope_t *scope;
+  err = js_open_handle_scope(req->env, &scope);
+  assert(err == 0);
+
+  js_value_t *global;
+  err = js_get_global(req->env, &global);
+  assert(err == 0);
+
+  SN_ASYNC_COMPLETE("failed to compute password hash")
+
+  err = js_close_handle_scope(req->env, scope);
+  assert(err == 0);
+
+  err = js_delete_reference(req->env, req->out_ref);
+  assert(err == 0);
+  err = js_delete_reference(req->env, req->pwd_ref);
+  assert(err == 0);
+
+  free(req);
+  free(task);
+}
+
+js_value_t *
+sn_crypto_pwhash_str_async (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV_OPTS(4, 5, crypto_pwhash_str_async)
+
+  SN_ARGV_BUFFER_CAST(char *, out, 0)
+  SN_ARGV_BUFFER_CAST(char *, pwd, 1)
+  SN_ARGV_UINT64(opslimit, 2)
+  SN_ARGV_UINT64(memlimit, 3)
+
+  SN_ASSERT_LENGTH(out_size, crypto_pwhash_STRBYTES, "out")
+  SN_ASSERT_MIN_LENGTH(opslimit, crypto_pwhash_OPSLIMIT_MIN, "opslimit")
+  SN_ASSERT_MAX_LENGTH(opslimit, crypto_pwhash_OPSLIMIT_MAX, "opslimit")
+  SN_ASSERT_MIN_LENGTH(memlimit, crypto_pwhash_MEMLIMIT_MIN, "memlimit")
+  SN_ASSERT_MAX_LENGTH(memlimit, (int64_t) crypto_pwhash_MEMLIMIT_MAX, "memlimit")
+  SN_ASSERT_OPT_CALLBACK(4)
+
+  sn_async_pwhash_str_request *req = (sn_async_pwhash_str_request *) malloc(sizeof(sn_async_pwhash_str_request));
+  req->env = env;
+  req->out_data = out;
+  req->pwd_data = pwd;
+  req->pwd_size = pwd_size;
+  req->opslimit = opslimit;
+  req->memlimit = memlimit;
+
+  sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
+  SN_ASYNC_TASK(4)
+
+  err = js_create_reference(env, out_argv, 1, &req->out_ref);
+  assert(err == 0);
+  err = js_create_reference(env, pwd_argv, 1, &req->pwd_ref);
+  assert(err == 0);
+
+  SN_QUEUE_TASK(task, async_pwhash_str_execute, async_pwhash_str_complete)
+
+  return promise;
+}
+
+typedef struct sn_async_pwhash_str_verify_request {
+  uv_work_t task;
+  js_env_t *env;
+  js_ref_t *str_ref;
+  char *str_data;
+  js_ref_t *pwd_ref;
+  const char *pwd_data;
+  size_t pwd_size;
+} sn_async_pwhash_str_verify_request;
+
+static void async_pwhash_str_verify_execute (uv_work_t *uv_req) {
+  sn_async_task_t *task = (sn_async_task_t *) uv_req;
+  sn_async_pwhash_str_verify_request *req = (sn_async_pwhash_str_verify_request *) task->req;
+  task->code = crypto_pwhash_str_verify(req->str_data, req->pwd_data, req->pwd_size);
+}
+
+static void async_pwhash_str_verify_complete (uv_work_t *uv_req, int status) {
+  int err;
+  sn_async_task_t *task = (sn_async_task_t *) uv_req;
+  sn_async_pwhash_str_verify_request *req = (sn_async_pwhash_str_verify_request *) task->req;
+
+  js_handle_scope_t *scope;
+  err = js_open_handle_scope(req->env, &scope);
+  assert(err == 0);
+  js_value_t *global;
+  err = js_get_global(req->env, &global);
+  assert(err == 0);
+
+  js_value_t *argv[2];
+
+  // Due to the way that crypto_pwhash_str_verify signals error different
+  // from a verification mismatch, we will count all errors as mismatch.
+  // The other possible error is wrong argument sizes, which is protected
+  // by macros above
+  err = js_get_null(req->env, &argv[0]);
+  assert(err == 0);
+  err = js_get_boolean(req->env, task->code == 0, &argv[1]);
+  assert(err == 0);
+
+  switch (task->type) {
+  case sn_async_task_t::sn_async_task_promise: {
+    err = js_resolve_deferred(req->env, task->deferred, argv[1]);
+    assert(err == 0);
+    task->deferred = NULL;
+    break;
+  }
+
+  case sn_async_task_t::sn_async_task_callback: {
+    js_value_t *callback;
+    err = js_get_reference_value(req->env, task->cb, &callback);
+    assert(err == 0);
+
+    js_value_t *return_val;
+    SN_CALL_FUNCTION(req->env, global, callback, 2, argv, &return_val)
+    break;
+  }
+  }
+
+  err = js_close_handle_scope(req->env, scope);
+  assert(err == 0);
+
+  err = js_delete_reference(req->env, req->str_ref);
+  assert(err == 0);
+  err = js_delete_reference(req->env, req->pwd_ref);
+  assert(err == 0);
+
+  free(req);
+  free(task);
+}
+
+js_value_t *
+sn_crypto_pwhash_str_verify_async (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV_OPTS(2, 3, crypto_pwhash_str_async)
+
+  SN_ARGV_BUFFER_CAST(char *, str, 0)
+  SN_ARGV_BUFFER_CAST(char *, pwd, 1)
+
+  SN_ASSERT_LENGTH(str_size, crypto_pwhash_STRBYTES, "str")
+  SN_ASSERT_OPT_CALLBACK(2)
+
+  sn_async_pwhash_str_verify_request *req = (sn_async_pwhash_str_verify_request *) malloc(sizeof(sn_async_pwhash_str_verify_request));
+  req->env = env;
+  req->str_data = str;
+  req->pwd_data = pwd;
+  req->pwd_size = pwd_size;
+
+  sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
+  SN_ASYNC_TASK(2)
+
+  err = js_create_reference(env, str_argv, 1, &req->str_ref);
+  assert(err == 0);
+  err = js_create_reference(env, pwd_argv, 1, &req->pwd_ref);
+  assert(err == 0);
+
+  SN_QUEUE_TASK(task, async_pwhash_str_verify_execute, async_pwhash_str_verify_complete)
+
+  return promise;
+}
+
+typedef struct sn_async_pwhash_scryptsalsa208sha256_request {
+  uv_work_t task;
+  js_env_t *env;
+  js_ref_t *out_ref;
+  unsigned char *out_data;
+  size_t out_size;
+  js_ref_t *pwd_ref;
+  const char *pwd_data;
+  size_t pwd_size;
+  js_ref_t *salt_ref;
+  unsigned char *salt;
+  uint32_t opslimit;
+  uint32_t memlimit;
+} sn_async_pwhash_scryptsalsa208sha256_request;
+
+static void async_pwhash_scryptsalsa208sha256_execute (uv_work_t *uv_req) {
+  sn_async_task_t *task = (sn_async_task_t *) uv_req;
+  sn_async_pwhash_scryptsalsa208sha256_request *req = (sn_async_pwhash_scryptsalsa208sha256_request *) task->req;
+  task->code = crypto_pwhash_scryptsalsa208sha256(req->out_data,
+                                                  req->out_size,
+                                                  req-> pwd_data,
+                                                  req->pwd_size,
+                                                  req->salt,
+                                                  req->opslimit,
+                                                  req->memlimit);
+}
+
+static void async_pwhash_scryptsalsa208sha256_complete (uv_work_t *uv_req, int status) {
+  int err;
+  sn_async_task_t *task = (sn_async_task_t *) uv_req;
+  sn_async_pwhash_scryptsalsa208sha256_request *req = (sn_async_pwhash_scryptsalsa208sha256_request *) task->req;
+
+  js_handle_scope_t *scope;
+  err = js_open_handle_scope(req->env, &scope);
+  assert(err == 0);
+
+  js_value_t *global;
+  err = js_get_global(req->env, &global);
+  assert(err == 0);
+
+  SN_ASYNC_COMPLETE("failed to compute password hash")
+
+  err = js_close_handle_scope(req->env, scope);
+  assert(err == 0);
+
+  err = js_delete_reference(req->env, req->out_ref);
+  assert(err == 0);
+  err = js_delete_reference(req->env, req->pwd_ref);
+  assert(err == 0);
+  err = js_delete_reference(req->env, req->salt_ref);
+  assert(err == 0);
+
+  free(req);
+  free(task);
+}
+
+js_value_t *
+sn_crypto_pwhash_scryptsalsa208sha256_async (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV_OPTS(5, 6, crypto_pwhash_scryptsalsa208sha256_async)
+
+  SN_ARGV_BUFFER_CAST(unsigned char *, out, 0)
+  SN_ARGV_BUFFER_CAST(char *, pwd, 1)
+  SN_ARGV_BUFFER_CAST(unsigned char *, salt, 2)
+  SN_ARGV_UINT64(opslimit, 3)
+  SN_ARGV_UINT64(memlimit, 4)
+
+  SN_ASSERT_MIN_LENGTH(out_size, crypto_pwhash_scryptsalsa208sha256_BYTES_MIN, "out")
+  SN_ASSERT_MAX_LENGTH(out_size, crypto_pwhash_scryptsalsa208sha256_BYTES_MAX, "out")
+  SN_ASSERT_LENGTH(salt_size, crypto_pwhash_scryptsalsa208sha256_SALTBYTES, "salt")
+  SN_ASSERT_MIN_LENGTH(opslimit, crypto_pwhash_scryptsalsa208sha256_OPSLIMIT_MIN, "opslimit")
+  SN_ASSERT_MAX_LENGTH(opslimit, crypto_pwhash_scryptsalsa208sha256_OPSLIMIT_MAX, "opslimit")
+  SN_ASSERT_MIN_LENGTH(memlimit, crypto_pwhash_scryptsalsa208sha256_MEMLIMIT_MIN, "memlimit")
+  SN_ASSERT_MAX_LENGTH(memlimit, (int64_t) crypto_pwhash_scryptsalsa208sha256_MEMLIMIT_MAX, "memlimit")
+  SN_ASSERT_OPT_CALLBACK(5)
+
+  sn_async_pwhash_scryptsalsa208sha256_request *req = (sn_async_pwhash_scryptsalsa208sha256_request *) malloc(sizeof(sn_async_pwhash_scryptsalsa208sha256_request));
+  req->env = env;
+  req->out_data = out;
+  req->out_size = out_size;
+  req->pwd_data = pwd;
+  req->pwd_size = pwd_size;
+  req-> salt = salt;
+  req->opslimit = opslimit;
+  req->memlimit = memlimit;
+
+  sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
+  SN_ASYNC_TASK(5)
+
+  err = js_create_reference(env, out_argv, 1, &req->out_ref);
+  assert(err == 0);
+  err = js_create_reference(env, pwd_argv, 1, &req->pwd_ref);
+  assert(err == 0);
+  err = js_create_reference(env, salt_argv, 1, &req->salt_ref);
+  assert(err == 0);
+
+  SN_QUEUE_TASK(task, async_pwhash_scryptsalsa208sha256_execute, async_pwhash_scryptsalsa208sha256_complete)
+
+  return promise;
+}
+
+typedef struct sn_async_pwhash_scryptsalsa208sha256_str_request {
+  uv_work_t task;
+  js_env_t *env;
+  js_ref_t *out_ref;
+  char *out_data;
+  js_ref_t *pwd_ref;
+  const char *pwd_data;
+  size_t pwd_size;
+  uint32_t opslimit;
+  uint32_t memlimit;
+} sn_async_pwhash_scryptsalsa208sha256_str_request;
+
+static void async_pwhash_scryptsalsa208sha256_str_execute (uv_work_t *uv_req) {
+  sn_async_task_t *task = (sn_async_task_t *) uv_req;
+  sn_async_pwhash_scryptsalsa208sha256_str_request *req = (sn_async_pwhash_scryptsalsa208sha256_str_request *) task->req;
+  task->code = crypto_pwhash_scryptsalsa208sha256_str(req->out_data,
+                                                      req->pwd_data,
+                                                      req->pwd_size,
+                                                      req->opslimit,
+                                                      req->memlimit);
+}
+
+static void async_pwhash_scryptsalsa208sha256_str_complete (uv_work_t *uv_req, int status) {
+  int err;
+  sn_async_task_t *task = (sn_async_task_t *) uv_req;
+  sn_async_pwhash_scryptsalsa208sha256_str_request *req = (sn_async_pwhash_scryptsalsa208sha256_str_request *) task->req;
+
+  js_handle_scope_t *scope;
+  err = js_open_handle_scope(req->env, &scope);
+  assert(err == 0);
+
+  js_value_t *global;
+  err = js_get_global(req->env, &global);
+  assert(err == 0);
+
+  SN_ASYNC_COMPLETE("failed to compute password hash")
+
+  err = js_close_handle_scope(req->env, scope);
+  assert(err == 0);
+
+  err = js_delete_reference(req->env, req->out_ref);
+  assert(err == 0);
+  err = js_delete_reference(req->env, req->pwd_ref);
+  assert(err == 0);
+
+  free(req);
+  free(task);
+}
+
+js_value_t *
+sn_crypto_pwhash_scryptsalsa208sha256_str_async (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV_OPTS(4, 5, crypto_pwhash_scryptsalsa208sha256_str_async)
+
+  SN_ARGV_BUFFER_CAST(char *, out, 0)
+  SN_ARGV_BUFFER_CAST(char *, pwd, 1)
+  SN_ARGV_UINT64(opslimit, 2)
+  SN_ARGV_UINT64(memlimit, 3)
+
+  SN_ASSERT_LENGTH(out_size, crypto_pwhash_scryptsalsa208sha256_STRBYTES, "out")
+  SN_ASSERT_MIN_LENGTH(opslimit, crypto_pwhash_scryptsalsa208sha256_OPSLIMIT_MIN, "opslimit")
+  SN_ASSERT_MAX_LENGTH(opslimit, crypto_pwhash_scryptsalsa208sha256_OPSLIMIT_MAX, "opslimit")
+  SN_ASSERT_MIN_LENGTH(memlimit, crypto_pwhash_scryptsalsa208sha256_MEMLIMIT_MIN, "memlimit")
+  SN_ASSERT_MAX_LENGTH(memlimit, (int64_t) crypto_pwhash_scryptsalsa208sha256_MEMLIMIT_MAX, "memlimit")
+  SN_ASSERT_OPT_CALLBACK(4)
+
+  sn_async_pwhash_scryptsalsa208sha256_str_request *req = (sn_async_pwhash_scryptsalsa208sha256_str_request *) malloc(sizeof(sn_async_pwhash_scryptsalsa208sha256_str_request));
+  req->env = env;
+  req->out_data = out;
+  req->pwd_data = pwd;
+  req->pwd_size = pwd_size;
+  req->opslimit = opslimit;
+  req->memlimit = memlimit;
+
+  sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
+
+  SN_ASYNC_TASK(4)
+
+  err = js_create_reference(env, out_argv, 1, &req->out_ref);
+  assert(err == 0);
+  err = js_create_reference(env, pwd_argv, 1, &req->pwd_ref);
+  assert(err == 0);
+
+  SN_QUEUE_TASK(task, async_pwhash_scryptsalsa208sha256_str_execute, async_pwhash_scryptsalsa208sha256_str_complete)
+
+  return promise;
+}
+
+typedef struct sn_async_pwhash_scryptsalsa208sha256_str_verify_request {
+  uv_work_t task;
+  js_env_t *env;
+  js_ref_t *str_ref;
+  char *str_data;
+  js_ref_t *pwd_ref;
+  const char *pwd_data;
+  size_t pwd_size;
+} sn_async_pwhash_scryptsalsa208sha256_str_verify_request;
+
+static void async_pwhash_scryptsalsa208sha256_str_verify_execute (uv_work_t *uv_req) {
+  sn_async_task_t *task = (sn_async_task_t *) uv_req;
+  sn_async_pwhash_scryptsalsa208sha256_str_verify_request *req = (sn_async_pwhash_scryptsalsa208sha256_str_verify_request *) task->req;
+  task->code = crypto_pwhash_scryptsalsa208sha256_str_verify(req->str_data, req->pwd_data, req->pwd_size);
+}
+
+static void async_pwhash_scryptsalsa208sha256_str_verify_complete (uv_work_t *uv_req, int status) {
+  int err;
+  sn_async_task_t *task = (sn_async_task_t *) uv_req;
+  sn_async_pwhash_scryptsalsa208sha256_str_verify_request *req = (sn_async_pwhash_scryptsalsa208sha256_str_verify_request *) task->req;
+
+  js_handle_scope_t *scope;
+  err = js_open_handle_scope(req->env, &scope);
+  assert(err == 0);
+
+  js_value_t *global;
+  err = js_get_global(req->env, &global);
+  assert(err == 0);
+
+  js_value_t *argv[2];
+
+  // Due to the way that crypto_pwhash_scryptsalsa208sha256_str_verify
+  // signal serror different from a verification mismatch, we will count
+  // all errors as mismatch. The other possible error is wrong argument
+  // sizes, which is protected by macros above
+  err = js_get_null(req->env, &argv[0]);
+  assert(err == 0);
+  err = js_get_boolean(req->env, task->code == 0, &argv[1]);
+  assert(err == 0);
+
+  switch (task->type) {
+  case sn_async_task_t::sn_async_task_promise: {
+    err = js_resolve_deferred(req->env, task->deferred, argv[1]);
+    assert(err == 0);
+    task->deferred = NULL;
+    break;
+  }
+
+  case sn_async_task_t::sn_async_task_callback: {
+    js_value_t *callback;
+    err = js_get_reference_value(req->env, task->cb, &callback);
+    assert(err == 0);
+
+    js_value_t *return_val;
+    SN_CALL_FUNCTION(req->env, global, callback, 2, argv, &return_val)
+    break;
+  }
+  }
+
+  err = js_close_handle_scope(req->env, scope);
+  assert(err == 0);
+
+  err = js_delete_reference(req->env, req->str_ref);
+  assert(err == 0);
+  err = js_delete_reference(req->env, req->pwd_ref);
+  assert(err == 0);
+
+  free(req);
+  free(task);
+}
+
+js_value_t *
+sn_crypto_pwhash_scryptsalsa208sha256_str_verify_async (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV_OPTS(2, 3, crypto_pwhash_scryptsalsa208sha256_str_async)
+
+  SN_ARGV_BUFFER_CAST(char *, str, 0)
+  SN_ARGV_BUFFER_CAST(char *, pwd, 1)
+
+  SN_ASSERT_LENGTH(str_size, crypto_pwhash_scryptsalsa208sha256_STRBYTES, "str")
+  SN_ASSERT_OPT_CALLBACK(2)
+
+  sn_async_pwhash_scryptsalsa208sha256_str_verify_request *req = (sn_async_pwhash_scryptsalsa208sha256_str_verify_request *) malloc(sizeof(sn_async_pwhash_scryptsalsa208sha256_str_verify_request));
+  req->env = env;
+  req->str_data = str;
+  req->pwd_data = pwd;
+  req->pwd_size = pwd_size;
+
+  sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
+  SN_ASYNC_TASK(2)
+
+  err = js_create_reference(env, str_argv, 1, &req->str_ref);
+  assert(err == 0);
+  err = js_create_reference(env, pwd_argv, 1, &req->pwd_ref);
+  assert(err == 0);
+
+  SN_QUEUE_TASK(task, async_pwhash_scryptsalsa208sha256_str_verify_execute, async_pwhash_scryptsalsa208sha256_str_verify_complete)
+
+  return promise;
+}
+
+#ifndef SN_CRYPTO_STREAM_READAHEAD
+#define SN_CRYPTO_STREAM_READAHEAD 4096
+#endif
+
+static_assert(SN_CRYPTO_STREAM_READAHEAD >= 64 && SN_CRYPTO_STREAM_READAHEAD % 64 == 0, "SN_CRYPTO_STREAM_READAHEAD must be a multiple of 64");
+
+typedef int (*sn_crypto_stream_xor_ic_fn)(unsigned char *c, const unsigned char *m, unsigned long long mlen, const unsigned char *n, uint64_t ic, const unsigned char *k);
+
+// keystream generated ahead of the caller, so small updates are served from
+// the buffer instead of costing a cipher call each. block_counter is the
+// block following the buffered keystream.
+typedef struct sn_crypto_stream_readahead {
+  unsigned char keystream[SN_CRYPTO_STREAM_READAHEAD];
+  uint32_t pos;
+  uint32_t len;
+  uint64_t block_counter;
+} sn_crypto_stream_readahead;
+
+static inline void
+sn_crypto_stream_readahead_init (sn_crypto_stream_readahead *ra) {
+  ra->pos = 0;
+  ra->len = 0;
+  ra->block_counter = 0;
+}
+
+static inline int
+sn_crypto_stream_readahead_fill (sn_crypto_stream_readahead *ra, sn_crypto_stream_xor_ic_fn xor_ic, uint64_t blocks_max, const unsigned char *n, const unsigned char *k) {
+  uint64_t blocks = SN_CRYPTO_STREAM_READAHEAD / 64;
+
+  if (ra->block_counter > blocks_max) return -1;
+  if (blocks_max - ra->block_counter < blocks) blocks = blocks_max - ra->block_counter;
+  if (!blocks) return -1;
+
+  memset(ra->keystream, 0, blocks * 64);
+  xor_ic(ra->keystream, ra->keystream, blocks * 64, n, ra->block_counter, k);
+
+  ra->block_counter += blocks;
+  ra->pos = 0;
+  ra->len = (uint32_t) (blocks * 64);
+
+  return 0;
+}
+
+static inline int
+sn_crypto_stream_readahead_update (sn_crypto_stream_readahead *ra, sn_crypto_stream_xor_ic_fn xor_ic, uint64_t blocks_max, const unsigned char *n, const unsigned char *k, unsigned char *c, const unsigned char *m, size_t m_size) {
+  while (m_size) {
+    if (ra->pos < ra->len) {
+      size_t take = ra->len - ra->pos;
+      if (take > m_size) take = m_size;
+
+      const unsigned char *ks = ra->keystream + ra->pos;
+      for (size_t i = 0; i < take; i++) c[i] = ks[i] ^ m[i];
+
+      ra->pos += take;
+      c += take;
+      m += take;
+      m_size -= take;
+      continue;
+    }
+
+    // large aligned runs bypass the buffer and are xored in place
+    size_t bulk = m_size & ~((size_t) 63);
+
+    if (bulk >= SN_CRYPTO_STREAM_READAHEAD) {
+      if (ra->block_counter > blocks_max || blocks_max - ra->block_counter < bulk / 64) return -1;
+
+      xor_ic(c, m, bulk, n, ra->block_counter, k);
+      ra->block_counter += bulk / 64;
+      c += bulk;
+      m += bulk;
+      m_size -= bulk;
+      continue;
+    }
+
+    if (sn_crypto_stream_readahead_fill(ra, xor_ic, blocks_max, n, k) != 0) return -1;
+  }
+
+  return 0;
+}
+
+static inline int
+sn_crypto_stream_readahead_seek (sn_crypto_stream_readahead *ra, sn_crypto_stream_xor_ic_fn xor_ic, uint64_t blocks_max, const unsigned char *n, const unsigned char *k, uint64_t offset) {
+  ra->block_counter = offset >> 6;
+  ra->pos = 0;
+  ra->len = 0;
+
+  if (offset & 63) {
+    if (sn_crypto_stream_readahead_fill(ra, xor_ic, blocks_max, n, k) != 0) return -1;
+    ra->pos = offset & 63;
+  }
+
+  return 0;
+}
+
+static int
+sn_crypto_stream_chacha20_ietf_xor_ic64 (unsigned char *c, const unsigned char *m, unsigned long long mlen, const unsigned char *n, uint64_t ic, const unsigned char *k) {
+  return crypto_stream_chacha20_ietf_xor_ic(c, m, mlen, n, (uint32_t) ic, k);
+}
+
+// xsalsa20 is salsa20 under the HSalsa20 subkey of the first 16 nonce bytes,
+// derived once here instead of on every keystream call
+typedef struct sn_crypto_stream_xor_state {
+  unsigned char n[crypto_stream_salsa20_NONCEBYTES];
+  unsigned char k[crypto_stream_salsa20_KEYBYTES];
+  sn_crypto_stream_readahead readahead;
+} sn_crypto_stream_xor_state;
+
+js_value_t *
+sn_crypto_stream_xor_wrap_init (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, crypto_stream_xor_instance_init)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_xor_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(n, 1)
+  SN_ARGV_TYPEDARRAY(k, 2)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_xor_state), "state must be 'sn_crypto_stream_xor_STATEBYTES' bytes")
+  SN_ASSERT_LENGTH(n_size, crypto_stream_NONCEBYTES, "n")
+  SN_ASSERT_LENGTH(k_size, crypto_stream_KEYBYTES, "k")
+
+  sn_crypto_stream_readahead_init(&state->readahead);
+  crypto_core_hsalsa20(state->k, n_data, k_data, NULL);
+  memcpy(state->n, n_data + crypto_core_hsalsa20_INPUTBYTES, crypto_stream_salsa20_NONCEBYTES);
+
+  return NULL;
+}
+
+js_value_t *
+sn_crypto_stream_xor_wrap_update (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, crypto_stream_xor_instance_init)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_xor_state *, state, 0)
+  SN_ARGV_BUFFER_CAST(unsigned char *, c, 1)
+  SN_ARGV_BUFFER_CAST(unsigned char *, m, 2)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_xor_state), "state must be 'sn_crypto_stream_xor_STATEBYTES' bytes")
+  SN_THROWS(c_size != m_size, "c must be 'm.byteLength' bytes")
+
+  int success = sn_crypto_stream_readahead_update(&state->readahead, crypto_stream_salsa20_xor_ic, UINT64_MAX, state->n, state->k, c, m, m_size);
+
+  SN_THROWS(success != 0, "keystream exhausted")
+
+  return NULL;
+}
+
+js_value_t *
+sn_crypto_stream_xor_wrap_final (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(1, crypto_stream_xor_instance_init)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_xor_state *, state, 0)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_xor_state), "state must be 'sn_crypto_stream_xor_STATEBYTES' bytes")
+
+  sodium_memzero(state->n, sizeof(state->n));
+  sodium_memzero(state->k, sizeof(state->k));
+  sodium_memzero(&state->readahead, sizeof(state->readahead));
+
+  return NULL;
+}
+
+js_value_t *
+sn_crypto_stream_xor_wrap_seek (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(2, crypto_stream_xor_instance_init)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_xor_state *, state, 0)
+  SN_ARGV_UINT64(offset, 1)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_xor_state), "state must be 'sn_crypto_stream_xor_STATEBYTES' bytes")
+
+  int success = sn_crypto_stream_readahead_seek(&state->readahead, crypto_stream_salsa20_xor_ic, UINT64_MAX, state->n, state->k, offset);
+
+  SN_THROWS(success != 0, "keystream exhausted")
+
+  return NULL;
+}
+
+typedef struct sn_crypto_stream_chacha20_xor_state {
+  unsigned char n[crypto_stream_chacha20_NONCEBYTES];
+  unsigned char k[crypto_stream_chacha20_KEYBYTES];
+  sn_crypto_stream_readahead readahead;
+} sn_crypto_stream_chacha20_xor_state;
+
+js_value_t *
+sn_crypto_stream_chacha20_xor_wrap_init (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, crypto_stream_chacha20_xor_instance_init)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_chacha20_xor_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(n, 1)
+  SN_ARGV_TYPEDARRAY(k, 2)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_chacha20_xor_state), "state must be 'crypto_stream_chacha20_xor_STATEBYTES' bytes")
+  SN_ASSERT_LENGTH(n_size, crypto_stream_chacha20_NONCEBYTES, "n")
+  SN_ASSERT_LENGTH(k_size, crypto_stream_chacha20_KEYBYTES, "k")
+
+  sn_crypto_stream_readahead_init(&state->readahead);
+  memcpy(state->n, n_data, crypto_stream_chacha20_NONCEBYTES);
+  memcpy(state->k, k_data, crypto_stream_chacha20_KEYBYTES);
+
+  return NULL;
+}
+
+js_value_t *
+sn_crypto_stream_chacha20_xor_wrap_update (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, crypto_stream_chacha20_xor_instance_init)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_chacha20_xor_state *, state, 0)
+  SN_ARGV_BUFFER_CAST(unsigned char *, c, 1)
+  SN_ARGV_BUFFER_CAST(unsigned char *, m, 2)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_chacha20_xor_state), "state must be 'crypto_stream_chacha20_xor_STATEBYTES' bytes")
+  SN_THROWS(c_size != m_size, "c must be 'm.byteLength' bytes")
+
+  int success = sn_crypto_stream_readahead_update(&state->readahead, crypto_stream_chacha20_xor_ic, UINT64_MAX, state->n, state->k, c, m, m_size);
+
+  SN_THROWS(success != 0, "keystream exhausted")
+
+  return NULL;
+}
+
+js_value_t *
+sn_crypto_stream_chacha20_xor_wrap_final (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(1, crypto_stream_chacha20_xor_instance_init)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_chacha20_xor_state *, state, 0)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_chacha20_xor_state), "state must be 'crypto_stream_chacha20_xor_STATEBYTES' bytes")
+
+  sodium_memzero(state->n, sizeof(state->n));
+  sodium_memzero(state->k, sizeof(state->k));
+  sodium_memzero(&state->readahead, sizeof(state->readahead));
+
+  return NULL;
+}
+
+js_value_t *
+sn_crypto_stream_chacha20_xor_wrap_seek (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(2, crypto_stream_chacha20_xor_instance_init)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_chacha20_xor_state *, state, 0)
+  SN_ARGV_UINT64(offset, 1)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_chacha20_xor_state), "state must be 'crypto_stream_chacha20_xor_STATEBYTES' bytes")
+
+  int success = sn_crypto_stream_readahead_seek(&state->readahead, crypto_stream_chacha20_xor_ic, UINT64_MAX, state->n, state->k, offset);
+
+  SN_THROWS(success != 0, "keystream exhausted")
+
+  return NULL;
+}
+
+typedef struct sn_crypto_stream_chacha20_ietf_xor_state {
+  unsigned char n[crypto_stream_chacha20_ietf_NONCEBYTES];
+  unsigned char k[crypto_stream_chacha20_ietf_KEYBYTES];
+  sn_crypto_stream_readahead readahead;
+} sn_crypto_stream_chacha20_ietf_xor_state;
+
+js_value_t *
+sn_crypto_stream_chacha20_ietf_xor_wrap_init (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, crypto_stream_chacha20_ietf_xor_wrap_init)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_chacha20_ietf_xor_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(n, 1)
+  SN_ARGV_TYPEDARRAY(k, 2)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_chacha20_ietf_xor_state), "state must be 'crypto_stream_chacha20_ietf_xor_STATEBYTES' bytes")
+  SN_ASSERT_LENGTH(n_size, crypto_stream_chacha20_ietf_NONCEBYTES, "n")
+  SN_ASSERT_LENGTH(k_size, crypto_stream_chacha20_ietf_KEYBYTES, "k")
+
+  sn_crypto_stream_readahead_init(&state->readahead);
+  memcpy(state->n, n_data, crypto_stream_chacha20_ietf_NONCEBYTES);
+  memcpy(state->k, k_data, crypto_stream_chacha20_ietf_KEYBYTES);
+
+  return NULL;
+}
+
+js_value_t *
+sn_crypto_stream_chacha20_ietf_xor_wrap_update (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, crypto_stream_chacha20_ietf_xor_wrap_update)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_chacha20_ietf_xor_state *, state, 0)
+  SN_ARGV_BUFFER_CAST(unsigned char *, c, 1)
+  SN_ARGV_BUFFER_CAST(unsigned char *, m, 2)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_chacha20_ietf_xor_state), "state must be 'crypto_stream_chacha20_ietf_xor_STATEBYTES' bytes")
+  SN_THROWS(c_size != m_size, "c must be 'm.byteLength' bytes")
+
+  int success = sn_crypto_stream_readahead_update(&state->readahead, sn_crypto_stream_chacha20_ietf_xor_ic64, (uint64_t) UINT32_MAX + 1, state->n, state->k, c, m, m_size);
+
+  SN_THROWS(success != 0, "keystream exhausted")
+
+  return NULL;
+}
+
+js_value_t *
+sn_crypto_stream_chacha20_ietf_xor_wrap_final (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(1, crypto_stream_chacha20_ietf_xor_wrap_final)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_chacha20_ietf_xor_state *, state, 0)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_chacha20_ietf_xor_state), "state must be 'crypto_stream_chacha20_ietf_xor_STATEBYTES' bytes")
+
+  sodium_memzero(state->n, sizeof(state->n));
+  sodium_memzero(state->k, sizeof(state->k));
+  sodium_memzero(&state->readahead, sizeof(state->readahead));
+
+  return NULL;
+}
+
+js_value_t *
+sn_crypto_stream_chacha20_ietf_xor_wrap_seek (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(2, crypto_stream_chacha20_ietf_xor_wrap_seek)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_chacha20_ietf_xor_state *, state, 0)
+  SN_ARGV_UINT64(offset, 1)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_chacha20_ietf_xor_state), "state must be 'crypto_stream_chacha20_ietf_xor_STATEBYTES' bytes")
+  SN_THROWS((offset >> 6) > UINT32_MAX, "offset must be within the 32-bit block counter")
+
+  int success = sn_crypto_stream_readahead_seek(&state->readahead, sn_crypto_stream_chacha20_ietf_xor_ic64, (uint64_t) UINT32_MAX + 1, state->n, state->k, offset);
+
+  SN_THROWS(success != 0, "keystream exhausted")
+
+  return NULL;
+}
+
+// likewise chacha20 under the HChaCha20 subkey, with the last 8 nonce bytes
+typedef struct sn_crypto_stream_xchacha20_xor_state {
+  unsigned char n[crypto_stream_chacha20_NONCEBYTES];
+  unsigned char k[crypto_stream_chacha20_KEYBYTES];
+  sn_crypto_stream_readahead readahead;
+} sn_crypto_stream_xchacha20_xor_state;
+
+js_value_t *
+sn_crypto_stream_xchacha20_xor_wrap_init (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, crypto_stream_xchacha20_xor_wrap_init)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_xchacha20_xor_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(n, 1)
+  SN_ARGV_TYPEDARRAY(k, 2)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_xchacha20_xor_state), "state must be 'crypto_stream_xchacha20_xor_STATEBYTES' bytes")
+  SN_ASSERT_LENGTH(n_size, crypto_stream_xchacha20_NONCEBYTES, "n")
+  SN_ASSERT_LENGTH(k_size, crypto_stream_xchacha20_KEYBYTES, "k")
+
+  sn_crypto_stream_readahead_init(&state->readahead);
+  crypto_core_hchacha20(state->k, n_data, k_data, NULL);
+  memcpy(state->n, n_data + crypto_core_hchacha20_INPUTBYTES, crypto_stream_chacha20_NONCEBYTES);
+
+  return NULL;
+}
+
+js_value_t *
+sn_crypto_stream_xchacha20_xor_wrap_update (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, crypto_stream_xchacha20_xor_wrap_update)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_xchacha20_xor_state *, state, 0)
+  SN_ARGV_BUFFER_CAST(unsigned char *, c, 1)
+  SN_ARGV_BUFFER_CAST(unsigned char *, m, 2)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_xchacha20_xor_state), "state must be 'crypto_stream_xchacha20_xor_STATEBYTES' bytes")
+  SN_THROWS(c_size != m_size, "c must be 'm.byteLength' bytes")
+
+  int success = sn_crypto_stream_readahead_update(&state->readahead, crypto_stream_chacha20_xor_ic, UINT64_MAX, state->n, state->k, c, m, m_size);
+
+  SN_THROWS(success != 0, "keystream exhausted")
+
+  return NULL;
+}
+
+js_value_t *
+sn_crypto_stream_xchacha20_xor_wrap_final (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(1, crypto_stream_xchacha20_xor_wrap_final)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_xchacha20_xor_state *, state, 0)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_xchacha20_xor_state), "state must be 'crypto_stream_xchacha20_xor_STATEBYTES' bytes")
+
+  sodium_memzero(state->n, sizeof(state->n));
+  sodium_memzero(state->k, sizeof(state->k));
+  sodium_memzero(&state->readahead, sizeof(state->readahead));
+
+  return NULL;
+}
+
+js_value_t *
+sn_crypto_stream_xchacha20_xor_wrap_seek (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(2, crypto_stream_xchacha20_xor_wrap_seek)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_xchacha20_xor_state *, state, 0)
+  SN_ARGV_UINT64(offset, 1)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_xchacha20_xor_state), "state must be 'crypto_stream_xchacha20_xor_STATEBYTES' bytes")
+
+  int success = sn_crypto_stream_readahead_seek(&state->readahead, crypto_stream_chacha20_xor_ic, UINT64_MAX, state->n, state->k, offset);
+
+  SN_THROWS(success != 0, "keystream exhausted")
+
+  return NULL;
+}
+
+typedef struct sn_crypto_stream_salsa20_xor_state {
+  unsigned char n[crypto_stream_salsa20_NONCEBYTES];
+  unsigned char k[crypto_stream_salsa20_KEYBYTES];
+  sn_crypto_stream_readahead readahead;
+} sn_crypto_stream_salsa20_xor_state;
+
+js_value_t *
+sn_crypto_stream_salsa20_xor_wrap_init (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, crypto_stream_salsa20_xor_wrap_init)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_salsa20_xor_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(n, 1)
+  SN_ARGV_TYPEDARRAY(k, 2)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_salsa20_xor_state), "state must be 'crypto_stream_salsa20_xor_STATEBYTES' bytes")
+  SN_ASSERT_LENGTH(n_size, crypto_stream_salsa20_NONCEBYTES, "n")
+  SN_ASSERT_LENGTH(k_size, crypto_stream_salsa20_KEYBYTES, "k")
+
+  sn_crypto_stream_readahead_init(&state->readahead);
+  memcpy(state->n, n_data, crypto_stream_salsa20_NONCEBYTES);
+  memcpy(state->k, k_data, crypto_stream_salsa20_KEYBYTES);
+
+  return NULL;
+}
+
+js_value_t *
+sn_crypto_stream_salsa20_xor_wrap_update (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, crypto_stream_salsa20_xor_wrap_update)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_salsa20_xor_state *, state, 0)
+  SN_ARGV_BUFFER_CAST(unsigned char *, c, 1)
+  SN_ARGV_BUFFER_CAST(unsigned char *, m, 2)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_salsa20_xor_state), "state must be 'crypto_stream_salsa20_xor_STATEBYTES' bytes")
+  SN_THROWS(c_size != m_size, "c must be 'm.byteLength' bytes")
+
+  int success = sn_crypto_stream_readahead_update(&state->readahead, crypto_stream_salsa20_xor_ic, UINT64_MAX, state->n, state->k, c, m, m_size);
+
+  SN_THROWS(success != 0, "keystream exhausted")
+
+  return NULL;
+}
+
+js_value_t *
+sn_crypto_stream_salsa20_xor_wrap_final (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(1, crypto_stream_salsa20_xor_wrap_final)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_salsa20_xor_state *, state, 0)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_salsa20_xor_state), "state must be 'crypto_stream_salsa20_xor_STATEBYTES' bytes")
+
+  sodium_memzero(state->n, sizeof(state->n));
+  sodium_memzero(state->k, sizeof(state->k));
+  sodium_memzero(&state->readahead, sizeof(state->readahead));
+
+  return NULL;
+}
+
+js_value_t *
+sn_crypto_stream_salsa20_xor_wrap_seek (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(2, crypto_stream_salsa20_xor_wrap_seek)
+
+  SN_ARGV_BUFFER_CAST(sn_crypto_stream_salsa20_xor_state *, state, 0)
+  SN_ARGV_UINT64(offset, 1)
+
+  SN_THROWS(state_size != sizeof(sn_crypto_stream_salsa20_xor_state), "state must be 'crypto_stream_salsa20_xor_STATEBYTES' bytes")
+
+  int success = sn_crypto_stream_readahead_seek(&state->readahead, crypto_stream_salsa20_xor_ic, UINT64_MAX, state->n, state->k, offset);
+
+  SN_THROWS(success != 0, "keystream exhausted")
+
+  return NULL;
+}
+
+// below this many bytes per range the thread handoff costs more than it saves
+#define SN_CRYPTO_STREAM_XOR_PARALLEL_RANGEBYTES_MIN (256 * 1024)
+
+typedef struct sn_crypto_stream_xor_parallel_job {
+  unsigned char *c;
+  const unsigned char *m;
+  size_t len;
+  unsigned char n[crypto_stream_xchacha20_NONCEBYTES];
+  unsigned char k[crypto_stream_xchacha20_KEYBYTES];
+  uint64_t ic;
+  uint64_t lane_blocks;
+  sn_crypto_stream_xor_ic_fn xor_ic;
+} sn_crypto_stream_xor_parallel_job;
+
+// lanes are whole blocks, so lane k starts at counter ic + k * lane_blocks
+static size_t
+sn_crypto_stream_xor_parallel_lane (void *data, size_t lane, size_t lanes) {
+  sn_crypto_stream_xor_parallel_job *job = (sn_crypto_stream_xor_parallel_job *) data;
+
+  uint64_t from = lane * job->lane_blocks * 64;
+  if (from >= job->len) return 0;
+
+  uint64_t len = job->len - from < job->lane_blocks * 64 ? job->len - from : job->lane_blocks * 64;
+
+  job->xor_ic(job->c + from, job->m + from, len, job->n, job->ic + lane * job->lane_blocks, job->k);
+
+  return 0;
+}
+
+static void
+sn_crypto_stream_xor_parallel_cleanup (void *data) {
+  sn_crypto_stream_xor_parallel_job *job = (sn_crypto_stream_xor_parallel_job *) data;
+
+  sodium_memzero(job->k, sizeof(job->k));
+  free(job);
+}
+
+static js_value_t *
+sn_crypto_stream_xor_parallel (js_env_t *env, js_callback_info_t *info, sn_crypto_stream_xor_ic_fn xor_ic, size_t nonce_bytes, size_t key_bytes, uint64_t blocks_max) {
+  SN_ARGV_OPTS(5, 6, crypto_stream_xor_parallel)
+
+  SN_ARGV_TYPEDARRAY(c, 0)
+  SN_ARGV_TYPEDARRAY(m, 1)
+  SN_ARGV_TYPEDARRAY(n, 2)
+  SN_ARGV_TYPEDARRAY(k, 3)
+  SN_ARGV_UINT64(ic, 4)
+
+  SN_THROWS(c_size != m_size, "m must be 'c.byteLength' bytes")
+  SN_THROWS(n_size != nonce_bytes, "n must be 'NONCEBYTES' bytes")
+  SN_THROWS(k_size != key_bytes, "k must be 'KEYBYTES' bytes")
+  SN_ASSERT_OPT_CALLBACK(5)
+
+  uint64_t blocks = ((uint64_t) m_size + 63) / 64;
+  SN_THROWS(ic > blocks_max || blocks_max - ic < blocks, "message exceeds the block counter")
+
+  sn_crypto_stream_xor_parallel_job *job = (sn_crypto_stream_xor_parallel_job *) malloc(sizeof(sn_crypto_stream_xor_parallel_job));
+  SN_THROWS(job == NULL, "failed to allocate request")
+
+  // an empty message still completes through the pool
+  size_t lanes = sn_async_lanes_count(m_size, SN_CRYPTO_STREAM_XOR_PARALLEL_RANGEBYTES_MIN, SIZE_MAX);
+
+  job->c = c_data;
+  job->m = m_data;
+  job->len = m_size;
+  memcpy(job->n, n_data, nonce_bytes);
+  memcpy(job->k, k_data, key_bytes);
+  job->ic = ic;
+  job->lane_blocks = (blocks + lanes - 1) / lanes;
+  job->xor_ic = xor_ic;
+
+  sn_async_lanes_request *req = sn_async_lanes_create(env, lanes, job, sn_crypto_stream_xor_parallel_lane, NULL, sn_crypto_stream_xor_parallel_cleanup, "stream encryption failed");
+  if (req == NULL) {
+    sn_crypto_stream_xor_parallel_cleanup(job);
+    SN_THROWS(true, "failed to allocate request")
+  }
+
+  req->strict = true;
+
+  sn_async_lanes_ref(req, c_argv);
+  sn_async_lanes_ref(req, m_argv);
+
+  sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
+  SN_ASYNC_TASK(5)
+
+  req->task = task;
+  sn_async_lanes_queue(req);
+
+  return promise;
+}
+
+js_value_t *
+sn_crypto_stream_chacha20_xor_parallel (js_env_t *env, js_callback_info_t *info) {
+  return sn_crypto_stream_xor_parallel(env, info, crypto_stream_chacha20_xor_ic, crypto_stream_chacha20_NONCEBYTES, crypto_stream_chacha20_KEYBYTES, UINT64_MAX);
+}
+
+js_value_t *
+sn_crypto_stream_chacha20_ietf_xor_parallel (js_env_t *env, js_callback_info_t *info) {
+  return sn_crypto_stream_xor_parallel(env, info, sn_crypto_stream_chacha20_ietf_xor_ic64, crypto_stream_chacha20_ietf_NONCEBYTES, crypto_stream_chacha20_ietf_KEYBYTES, (uint64_t) UINT32_MAX + 1);
+}
+
+js_value_t *
+sn_crypto_stream_xchacha20_xor_parallel (js_env_t *env, js_callback_info_t *info) {
+  return sn_crypto_stream_xor_parallel(env, info, crypto_stream_xchacha20_xor_ic, crypto_stream_xchacha20_NONCEBYTES, crypto_stream_xchacha20_KEYBYTES, UINT64_MAX);
+}
+
+js_value_t *
+sn_crypto_stream_salsa20_xor_parallel (js_env_t *env, js_callback_info_t *info) {
+  return sn_crypto_stream_xor_parallel(env, info, crypto_stream_salsa20_xor_ic, crypto_stream_salsa20_NONCEBYTES, crypto_stream_salsa20_KEYBYTES, UINT64_MAX);
+}
+
+typedef struct sn_crypto_scalarmult_many_job {
+  unsigned char *q;
+  const unsigned char *n;
+  const unsigned char *p;
+  size_t count;
+} sn_crypto_scalarmult_many_job;
+
+// lane k takes the k-th contiguous range of points
+static size_t
+sn_crypto_scalarmult_many_lane (void *data, size_t lane, size_t lanes) {
+  sn_crypto_scalarmult_many_job *job = (sn_crypto_scalarmult_many_job *) data;
+
+  size_t per_lane = (job->count + lanes - 1) / lanes;
+  size_t from = lane * per_lane < job->count ? lane * per_lane : job->count;
+  size_t to = from + per_lane < job->count ? from + per_lane : job->count;
+
+  return sn_crypto_scalarmult_many_range(job->q, job->n, job->p, from, to);
+}
+
+js_value_t *
+sn_crypto_scalarmult_many_async (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV_OPTS(4, 5, crypto_scalarmult_many_async)
+
+  SN_ARGV_TYPEDARRAY(q, 0)
+  SN_ARGV_TYPEDARRAY(n, 1)
+  SN_ARGV_TYPEDARRAY(p, 2)
+  SN_ARGV_UINT32(count, 3)
+
+  SN_THROWS(q_size != (size_t) count * crypto_scalarmult_BYTES, "q must be 'count * crypto_scalarmult_BYTES' bytes")
+  SN_THROWS(n_size != (size_t) count * crypto_scalarmult_SCALARBYTES, "n must be 'count * crypto_scalarmult_SCALARBYTES' bytes")
+  SN_THROWS(p_size != (size_t) count * crypto_scalarmult_BYTES, "p must be 'count * crypto_scalarmult_BYTES' bytes")
+  SN_ASSERT_OPT_CALLBACK(4)
+
+  sn_crypto_scalarmult_many_job *job = (sn_crypto_scalarmult_many_job *) malloc(sizeof(sn_crypto_scalarmult_many_job));
+  SN_THROWS(job == NULL, "failed to allocate request")
+
+  job->q = q_data;
+  job->n = n_data;
+  job->p = p_data;
+  job->count = count;
+
+  // an empty batch still completes through the pool
+  size_t lanes = sn_async_lanes_count(count, SN_CRYPTO_SCALARMULT_MANY_PER_THREAD_MIN, SN_CRYPTO_SCALARMULT_MANY_THREADS_MAX);
+
+  sn_async_lanes_request *req = sn_async_lanes_create(env, lanes, job, sn_crypto_scalarmult_many_lane, NULL, free, "failed to derive shared secret");
+  if (req == NULL) {
+    free(job);
+    SN_THROWS(true, "failed to allocate request")
+  }
+
+  req->strict = true;
+
+  sn_async_lanes_ref(req, q_argv);
+  sn_async_lanes_ref(req, n_argv);
+  sn_async_lanes_ref(req, p_argv);
+
+  sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
+  SN_ASYNC_TASK(4)
+
+  req->task = task;
+  sn_async_lanes_queue(req);
+
+  return promise;
+}
+
+// Experimental API
+
+js_value_t *
+sn_extension_tweak_ed25519_base (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, extension_tweak_ed25519_base)
+
+  SN_ARGV_TYPEDARRAY(n, 0)
+  SN_ARGV_TYPEDARRAY(p, 1)
+  SN_ARGV_TYPEDARRAY(ns, 2)
+
+  SN_ASSERT_LENGTH(n_size, sn__extension_tweak_ed25519_SCALARBYTES, "n")
+  SN_ASSERT_LENGTH(p_size, sn__extension_tweak_ed25519_BYTES, "p")
+
+  sn__extension_tweak_ed25519_base(p_data, n_data, ns_data, ns_size);
+
+  return NULL;
+}
+
+js_value_t *
+sn_extension_tweak_ed25519_sign_detached (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV_OPTS(3, 4, extension_tweak_ed25519_sign_detached)
+
+  SN_ARGV_TYPEDARRAY(sig, 0)
+  SN_ARGV_TYPEDARRAY(m, 1)
+  SN_ARGV_TYPEDARRAY(scalar, 2)
+  SN_ARGV_OPTS_TYPEDARRAY(pk, 3)
+
+  SN_ASSERT_LENGTH(sig_size, crypto_sign_BYTES, "sig")
+  SN_ASSERT_LENGTH(scalar_size, sn__extension_tweak_ed25519_SCALARBYTES, "scalar")
+
+  if (pk_data != NULL) {
+    SN_ASSERT_LENGTH(pk_size, crypto_sign_PUBLICKEYBYTES, "pk")
+  }
+
+  SN_RETURN(sn__extension_tweak_ed25519_sign_detached(sig_data, NULL, m_data, m_size, scalar_data, pk_data), "failed to compute signature")
+}
+
+js_value_t *
+sn_extension_tweak_ed25519_sk_to_scalar (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(2, extension_tweak_ed25519_sk_to_scalar)
+
+  SN_ARGV_TYPEDARRAY(n, 0)
+  SN_ARGV_TYPEDARRAY(sk, 1)
+
+  SN_ASSERT_LENGTH(n_size, sn__extension_tweak_ed25519_SCALARBYTES, "n")
+  SN_ASSERT_LENGTH(sk_size, crypto_sign_SECRETKEYBYTES, "sk")
+
+  sn__extension_tweak_ed25519_sk_to_scalar(n_data, sk_data);
+
+  return NULL;
+}
+
+js_value_t *
+sn_extension_tweak_ed25519_scalar (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, extension_tweak_ed25519_scalar)
+
+  SN_ARGV_TYPEDARRAY(scalar_out, 0)
+  SN_ARGV_TYPEDARRAY(scalar, 1)
+  SN_ARGV_TYPEDARRAY(ns, 2)
+
+  SN_ASSERT_LENGTH(scalar_out_size, sn__extension_tweak_ed25519_SCALARBYTES, "scalar_out")
+  SN_ASSERT_LENGTH(scalar_size, sn__extension_tweak_ed25519_SCALARBYTES, "scalar")
+
+  sn__extension_tweak_ed25519_scalar(scalar_out_data, scalar_data, ns_data, ns_size);
+
+  return NULL;
+}
+
+js_value_t *
+sn_extension_tweak_ed25519_pk (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, extension_tweak_ed25519_pk)
+
+  SN_ARGV_TYPEDARRAY(tpk, 0)
+  SN_ARGV_TYPEDARRAY(pk, 1)
+  SN_ARGV_TYPEDARRAY(ns, 2)
+
+  SN_ASSERT_LENGTH(tpk_size, crypto_sign_PUBLICKEYBYTES, "tpk")
+  SN_ASSERT_LENGTH(pk_size, crypto_sign_PUBLICKEYBYTES, "pk")
+
+  SN_RETURN(sn__extension_tweak_ed25519_pk(tpk_data, pk_data, ns_data, ns_size), "failed to tweak public key")
+}
+
+js_value_t *
+sn_extension_tweak_ed25519_keypair (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(4, extension_tweak_ed25519_keypair)
+
+  SN_ARGV_TYPEDARRAY(pk, 0)
+  SN_ARGV_TYPEDARRAY(scalar_out, 1)
+  SN_ARGV_TYPEDARRAY(scalar_in, 2)
+  SN_ARGV_TYPEDARRAY(ns, 3)
+
+  SN_ASSERT_LENGTH(pk_size, sn__extension_tweak_ed25519_BYTES, "pk")
+  SN_ASSERT_LENGTH(scalar_out_size, sn__extension_tweak_ed25519_SCALARBYTES, "scalar_out")
+  SN_ASSERT_LENGTH(scalar_in_size, sn__extension_tweak_ed25519_SCALARBYTES, "scalar_in")
+
+  sn__extension_tweak_ed25519_keypair(pk_data, scalar_out_data, scalar_in_data, ns_data, ns_size);
+
+  return NULL;
+}
+
+js_value_t *
+sn_extension_tweak_ed25519_scalar_add (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, extension_tweak_ed25519_scalar_add)
+
+  SN_ARGV_TYPEDARRAY(scalar_out, 0)
+  SN_ARGV_TYPEDARRAY(scalar, 1)
+  SN_ARGV_TYPEDARRAY(n, 2)
+
+  SN_ASSERT_LENGTH(scalar_out_size, sn__extension_tweak_ed25519_SCALARBYTES, "scalar_out")
+  SN_ASSERT_LENGTH(scalar_size, sn__extension_tweak_ed25519_SCALARBYTES, "scalar")
+  SN_ASSERT_LENGTH(n_size, sn__extension_tweak_ed25519_SCALARBYTES, "n")
+
+  sn__extension_tweak_ed25519_scalar_add(scalar_out_data, scalar_data, n_data);
+
+  return NULL;
+}
+
+js_value_t *
+sn_extension_tweak_ed25519_pk_add (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, extension_tweak_ed25519_pk)
+
+  SN_ARGV_TYPEDARRAY(tpk, 0)
+  SN_ARGV_TYPEDARRAY(pk, 1)
+  SN_ARGV_TYPEDARRAY(p, 2)
+
+  SN_ASSERT_LENGTH(tpk_size, crypto_sign_PUBLICKEYBYTES, "tpk")
+  SN_ASSERT_LENGTH(pk_size, crypto_sign_PUBLICKEYBYTES, "pk")
+  SN_ASSERT_LENGTH(p_size, crypto_sign_PUBLICKEYBYTES, "p")
+
+  SN_RETURN(sn__extension_tweak_ed25519_pk_add(tpk_data, pk_data, p_data), "failed to add tweak to public key")
+}
+
+js_value_t *
+sn_extension_tweak_ed25519_keypair_add (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(4, extension_tweak_ed25519_keypair_add)
+
+  SN_ARGV_TYPEDARRAY(pk, 0)
+  SN_ARGV_TYPEDARRAY(scalar_out, 1)
+  SN_ARGV_TYPEDARRAY(scalar_in, 2)
+  SN_ARGV_TYPEDARRAY(tweak, 3)
+
+  SN_ASSERT_LENGTH(pk_size, sn__extension_tweak_ed25519_BYTES, "pk")
+  SN_ASSERT_LENGTH(scalar_out_size, sn__extension_tweak_ed25519_SCALARBYTES, "scalar_out")
+  SN_ASSERT_LENGTH(scalar_in_size, sn__extension_tweak_ed25519_SCALARBYTES, "scalar_in")
+  SN_ASSERT_LENGTH(tweak_size, sn__extension_tweak_ed25519_SCALARBYTES, "tweak")
+
+  SN_RETURN(sn__extension_tweak_ed25519_keypair_add(pk_data, scalar_out_data, scalar_in_data, tweak_data), "failed to add tweak to keypair")
+}
+
+js_value_t *
+sn_extension_pbkdf2_sha512 (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(5, extension_pbkdf2_sha512)
+
+  SN_ARGV_BUFFER_CAST(unsigned char *, out, 0)
+  SN_ARGV_BUFFER_CAST(unsigned char *, passwd, 1)
+  SN_ARGV_BUFFER_CAST(unsigned char *, salt, 2)
+  SN_ARGV_UINT64(iter, 3)
+  SN_ARGV_UINT64(outlen, 4)
+
+  SN_ASSERT_MIN_LENGTH(iter, sn__extension_pbkdf2_sha512_ITERATIONS_MIN, "iterations")
+  SN_ASSERT_MAX_LENGTH(outlen, sn__extension_pbkdf2_sha512_BYTES_MAX, "outlen")
+
+  SN_ASSERT_MIN_LENGTH(out_size, outlen, "out")
+
+  SN_RETURN(sn__extension_pbkdf2_sha512(passwd, passwd_size, salt, salt_size, iter, out, outlen), "failed to add tweak to public key")
+}
+
+typedef struct sn_async_pbkdf2_sha512_request {
+  js_env_t *env;
+  unsigned char *out_data;
+  size_t out_size;
+  js_ref_t *out_ref;
+  size_t outlen;
+  js_ref_t *pwd_ref;
+  const unsigned char *pwd_data;
+  size_t pwd_size;
+  js_ref_t *salt_ref;
+  unsigned char *salt_data;
+  size_t salt_size;
+  uint64_t iter;
+} sn_async_pbkdf2_sha512_request;
+
+static void async_pbkdf2_sha512_execute (uv_work_t *uv_req) {
+  sn_async_task_t *task = (sn_async_task_t *) uv_req;
+  sn_async_pbkdf2_sha512_request *req = (sn_async_pbkdf2_sha512_request *) task->req;
+  task->code = sn__extension_pbkdf2_sha512(req->pwd_data,
+                                    req->pwd_size,
+                                    req->salt_data,
+                                    req->salt_size,
+                                    req->iter,
+                                    req->out_data,
+                                    req->outlen);
+}
+
+static void async_pbkdf2_sha512_complete (uv_work_t *uv_req, int status) {
   int err;
   sn_async_task_t *task = (sn_async_task_t *) uv_req;
-  sn_async_pwhash_request *req = (sn_async_pwhash_request *) task->req;
+  sn_async_pbkdf2_sha512_request *req = (sn_async_pbkdf2_sha512_request *) task->req;
 
   js_handle_scope_t *scope;
   err = js_open_handle_scope(req->env, &scope);
@@ -2263,7 +4974,7 @@ static void async_pwhash_complete (uv_work_t *uv_req, int status) {
   err = js_get_global(req->env, &global);
   assert(err == 0);
 
-  SN_ASYNC_COMPLETE("failed to compute password hash")
+  SN_ASYNC_COMPLETE("failed to compute kdf")
 
   err = js_close_handle_scope(req->env, scope);
   assert(err == 0);
@@ -2280,40 +4991,34 @@ static void async_pwhash_complete (uv_work_t *uv_req, int status) {
 }
 
 js_value_t *
-sn_crypto_pwhash_async (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV_OPTS(6, 7, crypto_pwhash_async)
+sn_extension_pbkdf2_sha512_async (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV_OPTS(5, 6, extension_pbkdf2_sha512_async)
 
   SN_ARGV_BUFFER_CAST(unsigned char *, out, 0)
-  SN_ARGV_BUFFER_CAST(char *, pwd, 1)
+  SN_ARGV_BUFFER_CAST(unsigned char *, pwd, 1)
   SN_ARGV_BUFFER_CAST(unsigned char *, salt, 2)
-  SN_ARGV_UINT64(opslimit, 3)
-  SN_ARGV_UINT64(memlimit, 4)
-  SN_ARGV_UINT8(alg, 5)
+  SN_ARGV_UINT64(iter, 3)
+  SN_ARGV_UINT64(outlen, 4)
 
-  SN_ASSERT_MIN_LENGTH(out_size, crypto_pwhash_BYTES_MIN, "out")
-  SN_ASSERT_MAX_LENGTH(out_size, crypto_pwhash_BYTES_MAX, "out")
-  SN_ASSERT_LENGTH(salt_size, crypto_pwhash_SALTBYTES, "salt")
-  SN_ASSERT_MIN_LENGTH(opslimit, crypto_pwhash_OPSLIMIT_MIN, "opslimit")
-  SN_ASSERT_MAX_LENGTH(opslimit, crypto_pwhash_OPSLIMIT_MAX, "opslimit")
-  SN_ASSERT_MIN_LENGTH(memlimit, crypto_pwhash_MEMLIMIT_MIN, "memlimit")
-  SN_ASSERT_MAX_LENGTH(memlimit, (int64_t) crypto_pwhash_MEMLIMIT_MAX, "memlimit")
-  SN_THROWS(alg < 1 || alg > 2, "alg must be either Argon2i 1.3 or Argon2id 1.3")
-  SN_ASSERT_OPT_CALLBACK(6)
+  SN_ASSERT_MIN_LENGTH(iter, sn__extension_pbkdf2_sha512_ITERATIONS_MIN, "iterations")
+  SN_ASSERT_MAX_LENGTH(outlen, sn__extension_pbkdf2_sha512_BYTES_MAX, "outlen")
+  SN_ASSERT_MIN_LENGTH(out_size, outlen, "output")
+  SN_ASSERT_OPT_CALLBACK(5)
 
-  sn_async_pwhash_request *req = (sn_async_pwhash_request *) malloc(sizeof(sn_async_pwhash_request));
+  sn_async_pbkdf2_sha512_request *req = (sn_async_pbkdf2_sha512_request *) malloc(sizeof(sn_async_pbkdf2_sha512_request));
 
   req->env = env;
   req->out_data = out;
   req->out_size = out_size;
   req->pwd_data = pwd;
   req->pwd_size = pwd_size;
-  req->salt = salt;
-  req->opslimit = opslimit;
-  req->memlimit = memlimit;
-  req->alg = alg;
+  req->salt_data = salt;
+  req->salt_size = salt_size;
+  req->iter = iter;
+  req->outlen = outlen;
 
   sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
-  SN_ASYNC_TASK(6)
+  SN_ASYNC_TASK(5);
 
   err = js_create_reference(env, out_argv, 1, &req->out_ref);
   assert(err == 0);
@@ -2322,37 +5027,56 @@ sn_crypto_pwhash_async (js_env_t *env, js_callback_info_t *info) {
   err = js_create_reference(env, salt_argv, 1, &req->salt_ref);
   assert(err == 0);
 
-  SN_QUEUE_TASK(task, async_pwhash_execute, async_pwhash_complete)
+  SN_QUEUE_TASK(task, async_pbkdf2_sha512_execute, async_pbkdf2_sha512_complete)
 
   return promise;
 }
 
-typedef struct sn_async_pwhash_str_request {
-  uv_work_t task;
+typedef struct sn_async_secretstream_file_request {
   js_env_t *env;
-  js_ref_t *out_ref;
-  char *out_data;
-  js_ref_t *pwd_ref;
-  const char *pwd_data;
-  size_t pwd_size;
-  uint32_t opslimit;
-  uint32_t memlimit;
-} sn_async_pwhash_str_request;
-
-static void async_pwhash_str_execute (uv_work_t *uv_req) {
-  sn_async_task_t *task = (sn_async_task_t *) uv_req;
-  sn_async_pwhash_str_request *req = (sn_async_pwhash_str_request *) task->req;
-  task->code = crypto_pwhash_str(req->out_data,
-                                 req->pwd_data,
-                                 req->pwd_size,
-                                 req->opslimit,
-                                 req->memlimit);
+  enum {
+    sn_secretstream_file_encrypt,
+    sn_secretstream_file_decrypt,
+    sn_seal_stream_file_seal,
+    sn_seal_stream_file_open
+  } mode;
+  sn__extension_secretstream_file_job job;
+  unsigned char pk[sn__extension_seal_stream_PUBLICKEYBYTES];
+  unsigned char sk[sn__extension_seal_stream_SECRETKEYBYTES];
+  char *src;
+  char *dst;
+  js_ref_t *onprogress_ref;
+  uv_async_t progress;
+  uv_mutex_t progress_lock;
+  uint64_t chunks;
+  uint64_t bytes;
+  uint64_t reported;
+} sn_async_secretstream_file_request;
+
+// called on the pool thread, the latest counts are picked up on the loop thread
+static void async_secretstream_file_progress (void *data, uint64_t chunks, uint64_t bytes) {
+  sn_async_secretstream_file_request *req = (sn_async_secretstream_file_request *) data;
+
+  uv_mutex_lock(&req->progress_lock);
+  req->chunks = chunks;
+  req->bytes = bytes;
+  uv_mutex_unlock(&req->progress_lock);
+
+  int err = uv_async_send(&req->progress);
+  assert(err == 0);
 }
 
-static void async_pwhash_str_complete (uv_work_t *uv_req, int status) {
-  sn_async_task_t *task = (sn_async_task_t *) uv_req;
-  sn_async_pwhash_str_request *req = (sn_async_pwhash_str_request *) task->req;
+static void async_secretstream_file_report (sn_async_secretstream_file_request *req) {
   int err;
+
+  uv_mutex_lock(&req->progress_lock);
+  uint64_t chunks = req->chunks;
+  uint64_t bytes = req->bytes;
+  uv_mutex_unlock(&req->progress_lock);
+
+  if (chunks == req->reported) return;
+  req->reported = chunks;
+
   js_handle_scope_t *scope;
   err = js_open_handle_scope(req->env, &scope);
   assert(err == 0);
@@ -2361,99 +5085,124 @@ static void async_pwhash_str_complete (uv_work_t *uv_req, int status) {
   err = js_get_global(req->env, &global);
   assert(err == 0);
 
-  SN_ASYNC_COMPLETE("failed to compute password hash")
-
-  err = js_close_handle_scope(req->env, scope);
+  js_value_t *onprogress;
+  err = js_get_reference_value(req->env, req->onprogress_ref, &onprogress);
   assert(err == 0);
 
-  err = js_delete_reference(req->env, req->out_ref);
+  js_value_t *argv[2];
+  err = js_create_int64(req->env, (int64_t) chunks, &argv[0]);
   assert(err == 0);
-  err = js_delete_reference(req->env, req->pwd_ref);
+  err = js_create_int64(req->env, (int64_t) bytes, &argv[1]);
   assert(err == 0);
 
-  free(req);
-  free(task);
-}
-
-js_value_t *
-sn_crypto_pwhash_str_async (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV_OPTS(4, 5, crypto_pwhash_str_async)
-
-  SN_ARGV_BUFFER_CAST(char *, out, 0)
-  SN_ARGV_BUFFER_CAST(char *, pwd, 1)
-  SN_ARGV_UINT64(opslimit, 2)
-  SN_ARGV_UINT64(memlimit, 3)
-
-  SN_ASSERT_LENGTH(out_size, crypto_pwhash_STRBYTES, "out")
-  SN_ASSERT_MIN_LENGTH(opslimit, crypto_pwhash_OPSLIMIT_MIN, "opslimit")
-  SN_ASSERT_MAX_LENGTH(opslimit, crypto_pwhash_OPSLIMIT_MAX, "opslimit")
-  SN_ASSERT_MIN_LENGTH(memlimit, crypto_pwhash_MEMLIMIT_MIN, "memlimit")
-  SN_ASSERT_MAX_LENGTH(memlimit, (int64_t) crypto_pwhash_MEMLIMIT_MAX, "memlimit")
-  SN_ASSERT_OPT_CALLBACK(4)
-
-  sn_async_pwhash_str_request *req = (sn_async_pwhash_str_request *) malloc(sizeof(sn_async_pwhash_str_request));
-  req->env = env;
-  req->out_data = out;
-  req->pwd_data = pwd;
-  req->pwd_size = pwd_size;
-  req->opslimit = opslimit;
-  req->memlimit = memlimit;
-
-  sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
-  SN_ASYNC_TASK(4)
+  js_value_t *return_val;
+  SN_CALL_FUNCTION(req->env, global, onprogress, 2, argv, &return_val)
 
-  err = js_create_reference(env, out_argv, 1, &req->out_ref);
-  assert(err == 0);
-  err = js_create_reference(env, pwd_argv, 1, &req->pwd_ref);
+  err = js_close_handle_scope(req->env, scope);
   assert(err == 0);
+}
 
-  SN_QUEUE_TASK(task, async_pwhash_str_execute, async_pwhash_str_complete)
-
-  return promise;
+static void async_secretstream_file_on_progress (uv_async_t *handle) {
+  async_secretstream_file_report((sn_async_secretstream_file_request *) handle->data);
 }
 
-typedef struct sn_async_pwhash_str_verify_request {
-  uv_work_t task;
-  js_env_t *env;
-  js_ref_t *str_ref;
-  char *str_data;
-  js_ref_t *pwd_ref;
-  const char *pwd_data;
-  size_t pwd_size;
-} sn_async_pwhash_str_verify_request;
+static void async_secretstream_file_on_close (uv_handle_t *handle) {
+  sn_async_secretstream_file_request *req = (sn_async_secretstream_file_request *) handle->data;
 
-static void async_pwhash_str_verify_execute (uv_work_t *uv_req) {
+  uv_mutex_destroy(&req->progress_lock);
+  free(req);
+}
+
+static void async_secretstream_file_execute (uv_work_t *uv_req) {
   sn_async_task_t *task = (sn_async_task_t *) uv_req;
-  sn_async_pwhash_str_verify_request *req = (sn_async_pwhash_str_verify_request *) task->req;
-  task->code = crypto_pwhash_str_verify(req->str_data, req->pwd_data, req->pwd_size);
+  sn_async_secretstream_file_request *req = (sn_async_secretstream_file_request *) task->req;
+
+  switch (req->mode) {
+  case sn_async_secretstream_file_request::sn_seal_stream_file_seal:
+    task->code = sn__extension_seal_stream_file_run(&req->job, req->pk, NULL);
+    break;
+  case sn_async_secretstream_file_request::sn_seal_stream_file_open:
+    task->code = sn__extension_seal_stream_file_run(&req->job, req->pk, req->sk);
+    break;
+  default:
+    task->code = sn__extension_secretstream_file_run(&req->job);
+  }
 }
 
-static void async_pwhash_str_verify_complete (uv_work_t *uv_req, int status) {
+static void async_secretstream_file_complete (uv_work_t *uv_req, int status) {
   int err;
   sn_async_task_t *task = (sn_async_task_t *) uv_req;
-  sn_async_pwhash_str_verify_request *req = (sn_async_pwhash_str_verify_request *) task->req;
+  sn_async_secretstream_file_request *req = (sn_async_secretstream_file_request *) task->req;
+
+  // deliver the last count before settling, pending progress events are dropped on close
+  if (req->onprogress_ref) async_secretstream_file_report(req);
 
   js_handle_scope_t *scope;
   err = js_open_handle_scope(req->env, &scope);
   assert(err == 0);
+
   js_value_t *global;
   err = js_get_global(req->env, &global);
   assert(err == 0);
 
   js_value_t *argv[2];
 
-  // Due to the way that crypto_pwhash_str_verify signals error different
-  // from a verification mismatch, we will count all errors as mismatch.
-  // The other possible error is wrong argument sizes, which is protected
-  // by macros above
-  err = js_get_null(req->env, &argv[0]);
-  assert(err == 0);
-  err = js_get_boolean(req->env, task->code == 0, &argv[1]);
-  assert(err == 0);
+  if (task->code == 0) {
+    err = js_get_null(req->env, &argv[0]);
+    assert(err == 0);
+    err = js_create_int64(req->env, (int64_t) req->job.chunks, &argv[1]);
+    assert(err == 0);
+  } else {
+    const char *code;
+    const char *message;
+
+    switch (task->code) {
+    case sn__extension_secretstream_file_EAUTH:
+      code = "EAUTH";
+      message = "could not authenticate file";
+      break;
+    case sn__extension_secretstream_file_EFORMAT:
+      code = "EFORMAT";
+      message = "file is not a secretstream";
+      break;
+    case sn__extension_secretstream_file_ECHANGED:
+      code = "ECHANGED";
+      message = "file changed while it was being processed";
+      break;
+    default:
+      code = uv_err_name(task->code);
+      message = uv_strerror(task->code);
+    }
+
+    js_value_t *err_code;
+    err = js_create_string_utf8(req->env, (const utf8_t *) code, strlen(code), &err_code);
+    assert(err == 0);
+
+    js_value_t *err_msg;
+    err = js_create_string_utf8(req->env, (const utf8_t *) message, strlen(message), &err_msg);
+    assert(err == 0);
+
+    err = js_create_error(req->env, err_code, err_msg, &argv[0]);
+    assert(err == 0);
+
+    // chunks that are safely written, pass it back as start to resume
+    js_value_t *chunks;
+    err = js_create_int64(req->env, (int64_t) req->job.chunks, &chunks);
+    assert(err == 0);
+    err = js_set_named_property(req->env, argv[0], "chunks", chunks);
+    assert(err == 0);
+
+    err = js_get_null(req->env, &argv[1]);
+    assert(err == 0);
+  }
 
   switch (task->type) {
   case sn_async_task_t::sn_async_task_promise: {
-    err = js_resolve_deferred(req->env, task->deferred, argv[1]);
+    if (task->code == 0) {
+      err = js_resolve_deferred(req->env, task->deferred, argv[1]);
+    } else {
+      err = js_reject_deferred(req->env, task->deferred, argv[0]);
+    }
     assert(err == 0);
     task->deferred = NULL;
     break;
@@ -2466,6 +5215,8 @@ static void async_pwhash_str_verify_complete (uv_work_t *uv_req, int status) {
 
     js_value_t *return_val;
     SN_CALL_FUNCTION(req->env, global, callback, 2, argv, &return_val)
+    err = js_delete_reference(req->env, task->cb);
+    assert(err == 0);
     break;
   }
   }
@@ -2473,1061 +5224,1528 @@ static void async_pwhash_str_verify_complete (uv_work_t *uv_req, int status) {
   err = js_close_handle_scope(req->env, scope);
   assert(err == 0);
 
-  err = js_delete_reference(req->env, req->str_ref);
-  assert(err == 0);
-  err = js_delete_reference(req->env, req->pwd_ref);
-  assert(err == 0);
-
-  free(req);
+  sodium_memzero(req->job.key, sizeof(req->job.key));
+  sodium_memzero(req->sk, sizeof(req->sk));
+  free(req->src);
+  free(req->dst);
   free(task);
+
+  if (req->onprogress_ref) {
+    err = js_delete_reference(req->env, req->onprogress_ref);
+    assert(err == 0);
+
+    uv_close((uv_handle_t *) &req->progress, async_secretstream_file_on_close);
+  } else {
+    uv_mutex_destroy(&req->progress_lock);
+    free(req);
+  }
 }
 
-js_value_t *
-sn_crypto_pwhash_str_verify_async (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV_OPTS(2, 3, crypto_pwhash_str_async)
+static int
+sn_get_path (js_env_t *env, js_value_t *value, char **path) {
+  size_t len;
+  int err = js_get_value_string_utf8(env, value, NULL, 0, &len);
+  if (err != 0) return err;
 
-  SN_ARGV_BUFFER_CAST(char *, str, 0)
-  SN_ARGV_BUFFER_CAST(char *, pwd, 1)
+  *path = (char *) malloc(len + 1);
+  if (*path == NULL) return -1;
 
-  SN_ASSERT_LENGTH(str_size, crypto_pwhash_STRBYTES, "str")
-  SN_ASSERT_OPT_CALLBACK(2)
+  err = js_get_value_string_utf8(env, value, (utf8_t *) *path, len + 1, NULL);
+  if (err != 0) {
+    free(*path);
+    return err;
+  }
 
-  sn_async_pwhash_str_verify_request *req = (sn_async_pwhash_str_verify_request *) malloc(sizeof(sn_async_pwhash_str_verify_request));
-  req->env = env;
-  req->str_data = str;
-  req->pwd_data = pwd;
-  req->pwd_size = pwd_size;
+  return 0;
+}
 
-  sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
-  SN_ASYNC_TASK(2)
+// (src, dst, key or pk[, sk], chunkSize, start, onprogress[, cb]), sk only when opening a sealed file
+static js_value_t *
+sn_secretstream_file_async (js_env_t *env, js_callback_info_t *info, int mode) {
+  SN_ARGV_OPTS(6, 8, extension_secretstream_file)
 
-  err = js_create_reference(env, str_argv, 1, &req->str_ref);
+  const size_t keys = mode == sn_async_secretstream_file_request::sn_seal_stream_file_open ? 2 : 1;
+  const bool sealed = mode >= sn_async_secretstream_file_request::sn_seal_stream_file_seal;
+
+  SN_THROWS(argc < 5 + keys, "extension_secretstream_file requires more arguments")
+
+  SN_TYPE_ASSERT(src, argv[0], js_string, "src must be a string")
+  SN_TYPE_ASSERT(dst, argv[1], js_string, "dst must be a string")
+  SN_ARGV_TYPEDARRAY(key, 2)
+  SN_ARGV_UINT32(chunk_size, 2 + keys)
+  SN_ARGV_UINT64(start, 3 + keys)
+
+  if (sealed) {
+    SN_ASSERT_LENGTH(key_size, sn__extension_seal_stream_PUBLICKEYBYTES, "pk")
+  } else {
+    SN_ASSERT_LENGTH(key_size, crypto_secretstream_xchacha20poly1305_KEYBYTES, "key")
+  }
+
+  uint8_t *secret = NULL;
+  if (keys == 2) {
+    SN_ARGV_TYPEDARRAY(sk, 3)
+    SN_ASSERT_LENGTH(sk_size, sn__extension_seal_stream_SECRETKEYBYTES, "sk")
+    secret = sk_data;
+  }
+
+  SN_THROWS(chunk_size < 1 || chunk_size > sn__extension_secretstream_file_CHUNKBYTES_MAX, "chunkSize must be between 1 and 'extension_secretstream_file_CHUNKBYTES_MAX'")
+  SN_THROWS(mode == sn_async_secretstream_file_request::sn_seal_stream_file_seal && start != 0, "sealing cannot be resumed")
+
+  js_value_type_t onprogress_type;
+  SN_STATUS_THROWS(js_typeof(env, argv[4 + keys], &onprogress_type), "")
+  SN_THROWS(onprogress_type != js_function && onprogress_type != js_null && onprogress_type != js_undefined, "onprogress must be a function")
+  SN_ASSERT_OPT_CALLBACK(5 + keys)
+
+  sn_async_secretstream_file_request *req = (sn_async_secretstream_file_request *) calloc(1, sizeof(sn_async_secretstream_file_request));
+  SN_THROWS(req == NULL, "failed to allocate request")
+
+  if (sn_get_path(env, argv[0], &req->src) != 0 || sn_get_path(env, argv[1], &req->dst) != 0) {
+    free(req->src);
+    free(req);
+    SN_THROWS(true, "failed to read path")
+  }
+
+  err = uv_mutex_init(&req->progress_lock);
   assert(err == 0);
-  err = js_create_reference(env, pwd_argv, 1, &req->pwd_ref);
+
+  uv_loop_t *loop;
+  err = js_get_env_loop(env, &loop);
   assert(err == 0);
 
-  SN_QUEUE_TASK(task, async_pwhash_str_verify_execute, async_pwhash_str_verify_complete)
+  req->env = env;
+  req->mode = (decltype(req->mode)) mode;
+  req->job.loop = loop;
+  req->job.src = req->src;
+  req->job.dst = req->dst;
+  req->job.chunk_size = chunk_size;
+  req->job.start = (uint64_t) start;
+  req->job.encrypt = mode == sn_async_secretstream_file_request::sn_secretstream_file_encrypt;
+  req->reported = (uint64_t) start;
+
+  if (sealed) {
+    memcpy(req->pk, key_data, sizeof(req->pk));
+    if (secret) memcpy(req->sk, secret, sizeof(req->sk));
+  } else {
+    memcpy(req->job.key, key_data, sizeof(req->job.key));
+  }
+
+  if (onprogress_type == js_function) {
+    err = js_create_reference(env, argv[4 + keys], 1, &req->onprogress_ref);
+    assert(err == 0);
+
+    err = uv_async_init(loop, &req->progress, async_secretstream_file_on_progress);
+    assert(err == 0);
+
+    req->progress.data = req;
+    req->job.progress = async_secretstream_file_progress;
+    req->job.progress_data = req;
+  }
+
+  sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
+  SN_ASYNC_TASK(5 + keys)
+
+  err = uv_queue_work(loop, (uv_work_t *) task, async_secretstream_file_execute, async_secretstream_file_complete);
+  assert(err == 0);
 
   return promise;
 }
 
-typedef struct sn_async_pwhash_scryptsalsa208sha256_request {
-  uv_work_t task;
-  js_env_t *env;
-  js_ref_t *out_ref;
-  unsigned char *out_data;
-  size_t out_size;
-  js_ref_t *pwd_ref;
-  const char *pwd_data;
-  size_t pwd_size;
-  js_ref_t *salt_ref;
-  unsigned char *salt;
-  uint32_t opslimit;
-  uint32_t memlimit;
-} sn_async_pwhash_scryptsalsa208sha256_request;
+js_value_t *
+sn_extension_secretstream_encrypt_file (js_env_t *env, js_callback_info_t *info) {
+  return sn_secretstream_file_async(env, info, sn_async_secretstream_file_request::sn_secretstream_file_encrypt);
+}
+
+js_value_t *
+sn_extension_secretstream_decrypt_file (js_env_t *env, js_callback_info_t *info) {
+  return sn_secretstream_file_async(env, info, sn_async_secretstream_file_request::sn_secretstream_file_decrypt);
+}
+
+js_value_t *
+sn_extension_seal_stream_seal_file (js_env_t *env, js_callback_info_t *info) {
+  return sn_secretstream_file_async(env, info, sn_async_secretstream_file_request::sn_seal_stream_file_seal);
+}
+
+js_value_t *
+sn_extension_seal_stream_open_file (js_env_t *env, js_callback_info_t *info) {
+  return sn_secretstream_file_async(env, info, sn_async_secretstream_file_request::sn_seal_stream_file_open);
+}
+
+js_value_t *
+sn_extension_seal_stream_init (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, extension_seal_stream_init)
+
+  SN_ARGV_BUFFER_CAST(sn__extension_seal_stream_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(header, 1)
+  SN_ARGV_TYPEDARRAY(pk, 2)
+
+  SN_THROWS(state_size != sizeof(sn__extension_seal_stream_state), "state must be 'extension_seal_stream_STATEBYTES' bytes")
+  SN_ASSERT_LENGTH(header_size, sn__extension_seal_stream_HEADERBYTES, "header")
+  SN_ASSERT_LENGTH(pk_size, sn__extension_seal_stream_PUBLICKEYBYTES, "pk")
+
+  SN_RETURN(sn__extension_seal_stream_init(state, header_data, pk_data), "invalid public key")
+}
+
+static js_value_t *
+sn_seal_stream_push (js_env_t *env, js_callback_info_t *info, int final) {
+  SN_ARGV(3, extension_seal_stream_push)
+
+  SN_ARGV_BUFFER_CAST(sn__extension_seal_stream_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(c, 1)
+  SN_ARGV_TYPEDARRAY(m, 2)
+
+  SN_THROWS(state_size != sizeof(sn__extension_seal_stream_state), "state must be 'extension_seal_stream_STATEBYTES' bytes")
+  SN_THROWS(c_size != m_size + sn__extension_seal_stream_ABYTES, "c must be 'm.byteLength + extension_seal_stream_ABYTES' bytes")
+  SN_THROWS(c_size > 0xffffffff, "c.byteLength must be a 32bit integer")
+
+  SN_CALL(sn__extension_seal_stream_push(state, c_data, m_data, m_size, final), "stream is already finished")
+
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) c_size, &result), "")
+  return result;
+}
+
+js_value_t *
+sn_extension_seal_stream_push (js_env_t *env, js_callback_info_t *info) {
+  return sn_seal_stream_push(env, info, 0);
+}
+
+js_value_t *
+sn_extension_seal_stream_final (js_env_t *env, js_callback_info_t *info) {
+  return sn_seal_stream_push(env, info, 1);
+}
+
+js_value_t *
+sn_extension_seal_stream_open_init (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(4, extension_seal_stream_open_init)
+
+  SN_ARGV_BUFFER_CAST(sn__extension_seal_stream_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(header, 1)
+  SN_ARGV_TYPEDARRAY(pk, 2)
+  SN_ARGV_TYPEDARRAY(sk, 3)
+
+  SN_THROWS(state_size != sizeof(sn__extension_seal_stream_state), "state must be 'extension_seal_stream_STATEBYTES' bytes")
+  SN_ASSERT_LENGTH(header_size, sn__extension_seal_stream_HEADERBYTES, "header")
+  SN_ASSERT_LENGTH(pk_size, sn__extension_seal_stream_PUBLICKEYBYTES, "pk")
+  SN_ASSERT_LENGTH(sk_size, sn__extension_seal_stream_SECRETKEYBYTES, "sk")
+
+  SN_RETURN(sn__extension_seal_stream_open_init(state, header_data, pk_data, sk_data), "invalid header")
+}
+
+// returns true once the final chunk has been pulled
+js_value_t *
+sn_extension_seal_stream_pull (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, extension_seal_stream_pull)
+
+  SN_ARGV_BUFFER_CAST(sn__extension_seal_stream_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(m, 1)
+  SN_ARGV_TYPEDARRAY(c, 2)
+
+  SN_THROWS(state_size != sizeof(sn__extension_seal_stream_state), "state must be 'extension_seal_stream_STATEBYTES' bytes")
+  SN_ASSERT_MIN_LENGTH(c_size, sn__extension_seal_stream_ABYTES, "c")
+  SN_THROWS(m_size != c_size - sn__extension_seal_stream_ABYTES, "m must be 'c.byteLength - extension_seal_stream_ABYTES' bytes")
+
+  int final = 0;
+  SN_THROWS(sn__extension_seal_stream_pull(state, m_data, c_data, c_size, &final) != 0, "could not open chunk")
+
+  SN_RETURN_BOOLEAN_FROM_1(final)
+}
+
+#define SN_BOX_CACHE_ASSERT(cache) \
+  SN_THROWS(((uintptr_t) cache) % 8 != 0, #cache " must be 8 byte aligned") \
+  SN_THROWS(cache##_size < sn__extension_box_cache_HEADERBYTES || cache->capacity != sn__extension_box_cache_capacity(cache##_size) || cache->size > cache->capacity, #cache " must be initialised with extension_box_cache_init")
+
+js_value_t *
+sn_extension_box_cache_init (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(2, extension_box_cache_init)
+
+  SN_ARGV_BUFFER_CAST(sn__extension_box_cache *, cache, 0)
+  SN_ARGV_TYPEDARRAY(sk, 1)
+
+  SN_THROWS(((uintptr_t) cache) % 8 != 0, "cache must be 8 byte aligned")
+  SN_ASSERT_MIN_LENGTH(cache_size, sn__extension_box_cache_HEADERBYTES + sn__extension_box_cache_ENTRYBYTES, "cache")
+  SN_THROWS((cache_size - sn__extension_box_cache_HEADERBYTES) % sn__extension_box_cache_ENTRYBYTES != 0, "cache must be 'extension_box_cache_HEADERBYTES + n * extension_box_cache_ENTRYBYTES' bytes")
+  SN_ASSERT_LENGTH(sk_size, crypto_box_SECRETKEYBYTES, "sk")
+
+  SN_RETURN(sn__extension_box_cache_init(cache, cache_size, sk_data), "failed to initialise box cache")
+}
+
+js_value_t *
+sn_extension_box_cache_easy (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(5, extension_box_cache_easy)
+
+  SN_ARGV_TYPEDARRAY(c, 0)
+  SN_ARGV_TYPEDARRAY(m, 1)
+  SN_ARGV_TYPEDARRAY(n, 2)
+  SN_ARGV_TYPEDARRAY(pk, 3)
+  SN_ARGV_BUFFER_CAST(sn__extension_box_cache *, cache, 4)
+
+  SN_THROWS(c_size != m_size + crypto_box_MACBYTES, "c must be 'm.byteLength + crypto_box_MACBYTES' bytes")
+  SN_ASSERT_LENGTH(n_size, crypto_box_NONCEBYTES, "n")
+  SN_ASSERT_LENGTH(pk_size, crypto_box_PUBLICKEYBYTES, "pk")
+  SN_BOX_CACHE_ASSERT(cache)
+
+  const unsigned char *k = sn__extension_box_cache_get(cache, pk_data);
+  SN_THROWS(k == NULL, "shared key computation failed")
+
+  SN_RETURN(crypto_box_easy_afternm(c_data, m_data, m_size, n_data, k), "crypto box failed")
+}
+
+js_value_t *
+sn_extension_box_cache_open_easy (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(5, extension_box_cache_open_easy)
+
+  SN_ARGV_TYPEDARRAY(m, 0)
+  SN_ARGV_TYPEDARRAY(c, 1)
+  SN_ARGV_TYPEDARRAY(n, 2)
+  SN_ARGV_TYPEDARRAY(pk, 3)
+  SN_ARGV_BUFFER_CAST(sn__extension_box_cache *, cache, 4)
+
+  SN_ASSERT_MIN_LENGTH(c_size, crypto_box_MACBYTES, "c")
+  SN_THROWS(m_size != c_size - crypto_box_MACBYTES, "m must be 'c.byteLength - crypto_box_MACBYTES' bytes")
+  SN_ASSERT_LENGTH(n_size, crypto_box_NONCEBYTES, "n")
+  SN_ASSERT_LENGTH(pk_size, crypto_box_PUBLICKEYBYTES, "pk")
+  SN_BOX_CACHE_ASSERT(cache)
+
+  const unsigned char *k = sn__extension_box_cache_get(cache, pk_data);
+
+  SN_RETURN_BOOLEAN(k == NULL ? -1 : crypto_box_open_easy_afternm(m_data, c_data, c_size, n_data, k))
+}
+
+js_value_t *
+sn_extension_box_cache_detached (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(6, extension_box_cache_detached)
+
+  SN_ARGV_TYPEDARRAY(c, 0)
+  SN_ARGV_TYPEDARRAY(mac, 1)
+  SN_ARGV_TYPEDARRAY(m, 2)
+  SN_ARGV_TYPEDARRAY(n, 3)
+  SN_ARGV_TYPEDARRAY(pk, 4)
+  SN_ARGV_BUFFER_CAST(sn__extension_box_cache *, cache, 5)
+
+  SN_THROWS(c_size != m_size, "c must be 'm.byteLength' bytes")
+  SN_ASSERT_LENGTH(mac_size, crypto_box_MACBYTES, "mac")
+  SN_ASSERT_LENGTH(n_size, crypto_box_NONCEBYTES, "n")
+  SN_ASSERT_LENGTH(pk_size, crypto_box_PUBLICKEYBYTES, "pk")
+  SN_BOX_CACHE_ASSERT(cache)
+
+  const unsigned char *k = sn__extension_box_cache_get(cache, pk_data);
+  SN_THROWS(k == NULL, "shared key computation failed")
+
+  SN_RETURN(crypto_box_detached_afternm(c_data, mac_data, m_data, m_size, n_data, k), "crypto box failed")
+}
+
+js_value_t *
+sn_extension_box_cache_open_detached (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(6, extension_box_cache_open_detached)
+
+  SN_ARGV_TYPEDARRAY(m, 0)
+  SN_ARGV_TYPEDARRAY(c, 1)
+  SN_ARGV_TYPEDARRAY(mac, 2)
+  SN_ARGV_TYPEDARRAY(n, 3)
+  SN_ARGV_TYPEDARRAY(pk, 4)
+  SN_ARGV_BUFFER_CAST(sn__extension_box_cache *, cache, 5)
+
+  SN_THROWS(m_size != c_size, "m must be 'c.byteLength' bytes")
+  SN_ASSERT_LENGTH(mac_size, crypto_box_MACBYTES, "mac")
+  SN_ASSERT_LENGTH(n_size, crypto_box_NONCEBYTES, "n")
+  SN_ASSERT_LENGTH(pk_size, crypto_box_PUBLICKEYBYTES, "pk")
+  SN_BOX_CACHE_ASSERT(cache)
+
+  const unsigned char *k = sn__extension_box_cache_get(cache, pk_data);
+
+  SN_RETURN_BOOLEAN(k == NULL ? -1 : crypto_box_open_detached_afternm(m_data, c_data, mac_data, c_size, n_data, k))
+}
+
+js_value_t *
+sn_extension_box_cache_clear (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(1, extension_box_cache_clear)
+
+  SN_ARGV_BUFFER_CAST(sn__extension_box_cache *, cache, 0)
+
+  SN_BOX_CACHE_ASSERT(cache)
+
+  sn__extension_box_cache_clear(cache);
+
+  return NULL;
+}
+
+js_value_t *
+sn_extension_box_cache_final (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(1, extension_box_cache_final)
+
+  SN_ARGV_BUFFER_CAST(sn__extension_box_cache *, cache, 0)
+
+  SN_BOX_CACHE_ASSERT(cache)
+
+  sn__extension_box_cache_final(cache);
 
-static void async_pwhash_scryptsalsa208sha256_execute (uv_work_t *uv_req) {
+  return NULL;
+}
+
+#undef SN_BOX_CACHE_ASSERT
+
+#define SN_KEYPAIR_POOL_ASSERT(pool) \
+  SN_THROWS(((uintptr_t) pool) % 8 != 0, #pool " must be 8 byte aligned") \
+  SN_THROWS(pool##_size < sn__extension_keypair_pool_HEADERBYTES || pool->epoch == 0 || pool->capacity != sn__extension_keypair_pool_capacity(pool##_size) || pool->available > pool->capacity, #pool " must be initialised with extension_keypair_pool_init")
+
+typedef struct sn_async_keypair_pool_fill_request {
+  js_env_t *env;
+  js_ref_t *pool_ref;
+  sn__extension_keypair_pool *pool;
+  uint64_t epoch;
+  uint32_t n;
+  unsigned char *keypairs;
+  bool background;
+} sn_async_keypair_pool_fill_request;
+
+static void async_keypair_pool_fill_execute (uv_work_t *uv_req) {
   sn_async_task_t *task = (sn_async_task_t *) uv_req;
-  sn_async_pwhash_scryptsalsa208sha256_request *req = (sn_async_pwhash_scryptsalsa208sha256_request *) task->req;
-  task->code = crypto_pwhash_scryptsalsa208sha256(req->out_data,
-                                                  req->out_size,
-                                                  req-> pwd_data,
-                                                  req->pwd_size,
-                                                  req->salt,
-                                                  req->opslimit,
-                                                  req->memlimit);
+  sn_async_keypair_pool_fill_request *req = (sn_async_keypair_pool_fill_request *) task->req;
+
+  sn__extension_keypair_pool_generate(req->keypairs, req->n);
+  task->code = 0;
 }
 
-static void async_pwhash_scryptsalsa208sha256_complete (uv_work_t *uv_req, int status) {
+static void async_keypair_pool_fill_complete (uv_work_t *uv_req, int status) {
   int err;
   sn_async_task_t *task = (sn_async_task_t *) uv_req;
-  sn_async_pwhash_scryptsalsa208sha256_request *req = (sn_async_pwhash_scryptsalsa208sha256_request *) task->req;
+  sn_async_keypair_pool_fill_request *req = (sn_async_keypair_pool_fill_request *) task->req;
 
   js_handle_scope_t *scope;
   err = js_open_handle_scope(req->env, &scope);
   assert(err == 0);
 
-  js_value_t *global;
-  err = js_get_global(req->env, &global);
+  // the pool may have been released with sodium_free while the fill was out
+  js_value_t *pool_val;
+  err = js_get_reference_value(req->env, req->pool_ref, &pool_val);
   assert(err == 0);
 
-  SN_ASYNC_COMPLETE("failed to compute password hash")
+  void *pool_data;
+  size_t pool_size;
+  err = js_get_typedarray_info(req->env, pool_val, NULL, &pool_data, &pool_size, NULL, NULL);
+  assert(err == 0);
+
+  // or its header overwritten, publish writes from available up to capacity
+  if (status == 0 && pool_data == req->pool && pool_size >= sn__extension_keypair_pool_HEADERBYTES && req->pool->capacity == sn__extension_keypair_pool_capacity(pool_size) && req->pool->available <= req->pool->capacity) {
+    sn__extension_keypair_pool_publish(req->pool, req->epoch, req->keypairs, req->n);
+  } else {
+    sodium_memzero(req->keypairs, (size_t) req->n * sn__extension_keypair_pool_KEYPAIRBYTES);
+  }
+
+  // a background refill has no promise or callback, a failed one is dropped
+  if (!req->background) {
+    if (status != 0) task->code = status;
+
+    js_value_t *global;
+    err = js_get_global(req->env, &global);
+    assert(err == 0);
+
+    SN_ASYNC_COMPLETE("failed to fill keypair pool")
+  }
 
   err = js_close_handle_scope(req->env, scope);
   assert(err == 0);
 
-  err = js_delete_reference(req->env, req->out_ref);
-  assert(err == 0);
-  err = js_delete_reference(req->env, req->pwd_ref);
-  assert(err == 0);
-  err = js_delete_reference(req->env, req->salt_ref);
+  err = js_delete_reference(req->env, req->pool_ref);
   assert(err == 0);
 
+  sodium_free(req->keypairs);
   free(req);
   free(task);
 }
 
-js_value_t *
-sn_crypto_pwhash_scryptsalsa208sha256_async (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV_OPTS(5, 6, crypto_pwhash_scryptsalsa208sha256_async)
+// a fill for whatever the pool is missing, NULL if it cannot be allocated
+static sn_async_keypair_pool_fill_request *
+sn_keypair_pool_fill_request (js_env_t *env, sn__extension_keypair_pool *pool) {
+  uint32_t n = sn__extension_keypair_pool_wanted(pool);
 
-  SN_ARGV_BUFFER_CAST(unsigned char *, out, 0)
-  SN_ARGV_BUFFER_CAST(char *, pwd, 1)
-  SN_ARGV_BUFFER_CAST(unsigned char *, salt, 2)
-  SN_ARGV_UINT64(opslimit, 3)
-  SN_ARGV_UINT64(memlimit, 4)
+  sn_async_keypair_pool_fill_request *req = (sn_async_keypair_pool_fill_request *) malloc(sizeof(sn_async_keypair_pool_fill_request));
+  if (req == NULL) return NULL;
 
-  SN_ASSERT_MIN_LENGTH(out_size, crypto_pwhash_scryptsalsa208sha256_BYTES_MIN, "out")
-  SN_ASSERT_MAX_LENGTH(out_size, crypto_pwhash_scryptsalsa208sha256_BYTES_MAX, "out")
-  SN_ASSERT_LENGTH(salt_size, crypto_pwhash_scryptsalsa208sha256_SALTBYTES, "salt")
-  SN_ASSERT_MIN_LENGTH(opslimit, crypto_pwhash_scryptsalsa208sha256_OPSLIMIT_MIN, "opslimit")
-  SN_ASSERT_MAX_LENGTH(opslimit, crypto_pwhash_scryptsalsa208sha256_OPSLIMIT_MAX, "opslimit")
-  SN_ASSERT_MIN_LENGTH(memlimit, crypto_pwhash_scryptsalsa208sha256_MEMLIMIT_MIN, "memlimit")
-  SN_ASSERT_MAX_LENGTH(memlimit, (int64_t) crypto_pwhash_scryptsalsa208sha256_MEMLIMIT_MAX, "memlimit")
-  SN_ASSERT_OPT_CALLBACK(5)
+  // an empty fill still settles through the pool
+  req->keypairs = (unsigned char *) sodium_malloc((size_t) n * sn__extension_keypair_pool_KEYPAIRBYTES);
+  if (req->keypairs == NULL) {
+    free(req);
+    return NULL;
+  }
 
-  sn_async_pwhash_scryptsalsa208sha256_request *req = (sn_async_pwhash_scryptsalsa208sha256_request *) malloc(sizeof(sn_async_pwhash_scryptsalsa208sha256_request));
   req->env = env;
-  req->out_data = out;
-  req->out_size = out_size;
-  req->pwd_data = pwd;
-  req->pwd_size = pwd_size;
-  req-> salt = salt;
-  req->opslimit = opslimit;
-  req->memlimit = memlimit;
+  req->pool = pool;
+  req->epoch = pool->epoch;
+  req->n = n;
+  req->background = false;
 
-  sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
-  SN_ASYNC_TASK(5)
+  return req;
+}
 
-  err = js_create_reference(env, out_argv, 1, &req->out_ref);
-  assert(err == 0);
-  err = js_create_reference(env, pwd_argv, 1, &req->pwd_ref);
-  assert(err == 0);
-  err = js_create_reference(env, salt_argv, 1, &req->salt_ref);
+static void
+sn_keypair_pool_queue_fill (js_env_t *env, js_value_t *pool_argv, sn_async_keypair_pool_fill_request *req, sn_async_task_t *task) {
+  int err;
+
+  task->req = (void *) req;
+  task->code = 0;
+
+  err = js_create_reference(env, pool_argv, 1, &req->pool_ref);
   assert(err == 0);
 
-  SN_QUEUE_TASK(task, async_pwhash_scryptsalsa208sha256_execute, async_pwhash_scryptsalsa208sha256_complete)
+  req->pool->pending += req->n;
 
-  return promise;
+  SN_QUEUE_TASK(task, async_keypair_pool_fill_execute, async_keypair_pool_fill_complete)
 }
 
-typedef struct sn_async_pwhash_scryptsalsa208sha256_str_request {
-  uv_work_t task;
-  js_env_t *env;
-  js_ref_t *out_ref;
-  char *out_data;
-  js_ref_t *pwd_ref;
-  const char *pwd_data;
-  size_t pwd_size;
-  uint32_t opslimit;
-  uint32_t memlimit;
-} sn_async_pwhash_scryptsalsa208sha256_str_request;
+// tops the pool up in the background once a draw takes it under the watermark
+static void
+sn_keypair_pool_refill (js_env_t *env, js_value_t *pool_argv, sn__extension_keypair_pool *pool) {
+  if (pool->pending > 0 || pool->available >= pool->watermark) return;
 
-static void async_pwhash_scryptsalsa208sha256_str_execute (uv_work_t *uv_req) {
-  sn_async_task_t *task = (sn_async_task_t *) uv_req;
-  sn_async_pwhash_scryptsalsa208sha256_str_request *req = (sn_async_pwhash_scryptsalsa208sha256_str_request *) task->req;
-  task->code = crypto_pwhash_scryptsalsa208sha256_str(req->out_data,
-                                                      req->pwd_data,
-                                                      req->pwd_size,
-                                                      req->opslimit,
-                                                      req->memlimit);
-}
+  sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
+  if (task == NULL) return;
 
-static void async_pwhash_scryptsalsa208sha256_str_complete (uv_work_t *uv_req, int status) {
-  int err;
-  sn_async_task_t *task = (sn_async_task_t *) uv_req;
-  sn_async_pwhash_scryptsalsa208sha256_str_request *req = (sn_async_pwhash_scryptsalsa208sha256_str_request *) task->req;
+  sn_async_keypair_pool_fill_request *req = sn_keypair_pool_fill_request(env, pool);
+  if (req == NULL) {
+    free(task);
+    return;
+  }
 
-  js_handle_scope_t *scope;
-  err = js_open_handle_scope(req->env, &scope);
-  assert(err == 0);
+  req->background = true;
 
-  js_value_t *global;
-  err = js_get_global(req->env, &global);
-  assert(err == 0);
+  sn_keypair_pool_queue_fill(env, pool_argv, req, task);
+}
 
-  SN_ASYNC_COMPLETE("failed to compute password hash")
+js_value_t *
+sn_extension_keypair_pool_init (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(2, extension_keypair_pool_init)
 
-  err = js_close_handle_scope(req->env, scope);
-  assert(err == 0);
+  SN_ARGV_BUFFER_CAST(sn__extension_keypair_pool *, pool, 0)
+  SN_ARGV_UINT32(watermark, 1)
 
-  err = js_delete_reference(req->env, req->out_ref);
-  assert(err == 0);
-  err = js_delete_reference(req->env, req->pwd_ref);
-  assert(err == 0);
+  SN_THROWS(((uintptr_t) pool) % 8 != 0, "pool must be 8 byte aligned")
+  SN_ASSERT_MIN_LENGTH(pool_size, sn__extension_keypair_pool_HEADERBYTES + sn__extension_keypair_pool_KEYPAIRBYTES, "pool")
+  SN_THROWS((pool_size - sn__extension_keypair_pool_HEADERBYTES) % sn__extension_keypair_pool_KEYPAIRBYTES != 0, "pool must be 'extension_keypair_pool_HEADERBYTES + n * extension_keypair_pool_KEYPAIRBYTES' bytes")
+  SN_THROWS(watermark > sn__extension_keypair_pool_capacity(pool_size), "watermark must not exceed the pool capacity")
 
-  free(req);
-  free(task);
+  SN_RETURN(sn__extension_keypair_pool_init(pool, pool_size, watermark), "failed to initialise keypair pool")
 }
 
 js_value_t *
-sn_crypto_pwhash_scryptsalsa208sha256_str_async (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV_OPTS(4, 5, crypto_pwhash_scryptsalsa208sha256_str_async)
+sn_extension_keypair_pool_fill (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV_OPTS(1, 2, extension_keypair_pool_fill)
 
-  SN_ARGV_BUFFER_CAST(char *, out, 0)
-  SN_ARGV_BUFFER_CAST(char *, pwd, 1)
-  SN_ARGV_UINT64(opslimit, 2)
-  SN_ARGV_UINT64(memlimit, 3)
+  SN_ARGV_BUFFER_CAST(sn__extension_keypair_pool *, pool, 0)
 
-  SN_ASSERT_LENGTH(out_size, crypto_pwhash_scryptsalsa208sha256_STRBYTES, "out")
-  SN_ASSERT_MIN_LENGTH(opslimit, crypto_pwhash_scryptsalsa208sha256_OPSLIMIT_MIN, "opslimit")
-  SN_ASSERT_MAX_LENGTH(opslimit, crypto_pwhash_scryptsalsa208sha256_OPSLIMIT_MAX, "opslimit")
-  SN_ASSERT_MIN_LENGTH(memlimit, crypto_pwhash_scryptsalsa208sha256_MEMLIMIT_MIN, "memlimit")
-  SN_ASSERT_MAX_LENGTH(memlimit, (int64_t) crypto_pwhash_scryptsalsa208sha256_MEMLIMIT_MAX, "memlimit")
-  SN_ASSERT_OPT_CALLBACK(4)
+  SN_KEYPAIR_POOL_ASSERT(pool)
+  SN_ASSERT_OPT_CALLBACK(1)
 
-  sn_async_pwhash_scryptsalsa208sha256_str_request *req = (sn_async_pwhash_scryptsalsa208sha256_str_request *) malloc(sizeof(sn_async_pwhash_scryptsalsa208sha256_str_request));
-  req->env = env;
-  req->out_data = out;
-  req->pwd_data = pwd;
-  req->pwd_size = pwd_size;
-  req->opslimit = opslimit;
-  req->memlimit = memlimit;
+  sn_async_keypair_pool_fill_request *req = sn_keypair_pool_fill_request(env, pool);
+  SN_THROWS(req == NULL, "failed to allocate request")
 
   sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
+  if (task == NULL) {
+    sodium_free(req->keypairs);
+    free(req);
+    SN_THROWS(true, "failed to allocate request")
+  }
 
-  SN_ASYNC_TASK(4)
-
-  err = js_create_reference(env, out_argv, 1, &req->out_ref);
-  assert(err == 0);
-  err = js_create_reference(env, pwd_argv, 1, &req->pwd_ref);
-  assert(err == 0);
+  SN_ASYNC_TASK(1)
 
-  SN_QUEUE_TASK(task, async_pwhash_scryptsalsa208sha256_str_execute, async_pwhash_scryptsalsa208sha256_str_complete)
+  sn_keypair_pool_queue_fill(env, pool_argv, req, task);
 
   return promise;
 }
 
-typedef struct sn_async_pwhash_scryptsalsa208sha256_str_verify_request {
-  uv_work_t task;
-  js_env_t *env;
-  js_ref_t *str_ref;
-  char *str_data;
-  js_ref_t *pwd_ref;
-  const char *pwd_data;
-  size_t pwd_size;
-} sn_async_pwhash_scryptsalsa208sha256_str_verify_request;
+js_value_t *
+sn_extension_keypair_pool_seal (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(4, extension_keypair_pool_seal)
 
-static void async_pwhash_scryptsalsa208sha256_str_verify_execute (uv_work_t *uv_req) {
-  sn_async_task_t *task = (sn_async_task_t *) uv_req;
-  sn_async_pwhash_scryptsalsa208sha256_str_verify_request *req = (sn_async_pwhash_scryptsalsa208sha256_str_verify_request *) task->req;
-  task->code = crypto_pwhash_scryptsalsa208sha256_str_verify(req->str_data, req->pwd_data, req->pwd_size);
+  SN_ARGV_TYPEDARRAY(c, 0)
+  SN_ARGV_TYPEDARRAY(m, 1)
+  SN_ARGV_TYPEDARRAY(pk, 2)
+  SN_ARGV_BUFFER_CAST(sn__extension_keypair_pool *, pool, 3)
+
+  SN_THROWS(c_size != m_size + crypto_box_SEALBYTES, "c must be 'm.byteLength + crypto_box_SEALBYTES' bytes")
+  SN_ASSERT_LENGTH(pk_size, crypto_box_PUBLICKEYBYTES, "pk")
+  SN_KEYPAIR_POOL_ASSERT(pool)
+
+  unsigned char epk[crypto_box_PUBLICKEYBYTES];
+  unsigned char esk[crypto_box_SECRETKEYBYTES];
+
+  if (sn__extension_keypair_pool_draw(pool, epk, esk) != 0) crypto_box_keypair(epk, esk);
+
+  sn_keypair_pool_refill(env, pool_argv, pool);
+
+  int res = sn__extension_keypair_pool_seal(c_data, m_data, m_size, pk_data, epk, esk);
+
+  sodium_memzero(esk, sizeof(esk));
+
+  SN_RETURN(res, "failed to create seal")
 }
 
-static void async_pwhash_scryptsalsa208sha256_str_verify_complete (uv_work_t *uv_req, int status) {
-  int err;
-  sn_async_task_t *task = (sn_async_task_t *) uv_req;
-  sn_async_pwhash_scryptsalsa208sha256_str_verify_request *req = (sn_async_pwhash_scryptsalsa208sha256_str_verify_request *) task->req;
+js_value_t *
+sn_extension_keypair_pool_kx_keypair (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, extension_keypair_pool_kx_keypair)
 
-  js_handle_scope_t *scope;
-  err = js_open_handle_scope(req->env, &scope);
-  assert(err == 0);
+  SN_ARGV_TYPEDARRAY(pk, 0)
+  SN_ARGV_TYPEDARRAY(sk, 1)
+  SN_ARGV_BUFFER_CAST(sn__extension_keypair_pool *, pool, 2)
 
-  js_value_t *global;
-  err = js_get_global(req->env, &global);
-  assert(err == 0);
+  SN_ASSERT_LENGTH(pk_size, crypto_kx_PUBLICKEYBYTES, "pk")
+  SN_ASSERT_LENGTH(sk_size, crypto_kx_SECRETKEYBYTES, "sk")
+  SN_KEYPAIR_POOL_ASSERT(pool)
 
-  js_value_t *argv[2];
+  if (sn__extension_keypair_pool_draw(pool, pk_data, sk_data) != 0) crypto_kx_keypair(pk_data, sk_data);
 
-  // Due to the way that crypto_pwhash_scryptsalsa208sha256_str_verify
-  // signal serror different from a verification mismatch, we will count
-  // all errors as mismatch. The other possible error is wrong argument
-  // sizes, which is protected by macros above
-  err = js_get_null(req->env, &argv[0]);
-  assert(err == 0);
-  err = js_get_boolean(req->env, task->code == 0, &argv[1]);
-  assert(err == 0);
+  sn_keypair_pool_refill(env, pool_argv, pool);
 
-  switch (task->type) {
-  case sn_async_task_t::sn_async_task_promise: {
-    err = js_resolve_deferred(req->env, task->deferred, argv[1]);
-    assert(err == 0);
-    task->deferred = NULL;
-    break;
-  }
+  return NULL;
+}
 
-  case sn_async_task_t::sn_async_task_callback: {
-    js_value_t *callback;
-    err = js_get_reference_value(req->env, task->cb, &callback);
-    assert(err == 0);
+js_value_t *
+sn_extension_keypair_pool_stats (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(2, extension_keypair_pool_stats)
 
-    js_value_t *return_val;
-    SN_CALL_FUNCTION(req->env, global, callback, 2, argv, &return_val)
-    break;
+  SN_ARGV_BUFFER_CAST(sn__extension_keypair_pool *, pool, 0)
+  SN_ARGV_UINT32ARRAY(stats, 1)
+
+  SN_KEYPAIR_POOL_ASSERT(pool)
+  SN_THROWS(stats_length != sn__extension_keypair_pool_STATS, "stats must have 'extension_keypair_pool_STATS' entries")
+
+  sn__extension_keypair_pool_stats(pool, stats_data);
+
+  return NULL;
+}
+
+js_value_t *
+sn_extension_keypair_pool_final (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(1, extension_keypair_pool_final)
+
+  SN_ARGV_BUFFER_CAST(sn__extension_keypair_pool *, pool, 0)
+
+  SN_KEYPAIR_POOL_ASSERT(pool)
+
+  sn__extension_keypair_pool_final(pool);
+
+  return NULL;
+}
+
+#undef SN_KEYPAIR_POOL_ASSERT
+
+js_value_t *
+sn_extension_nonce_sequence_init (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV_OPTS(2, 3, extension_nonce_sequence_init)
+
+  SN_ARGV_BUFFER_CAST(sn__extension_nonce_sequence_state *, state, 0)
+  SN_ARGV_UINT32(noncebytes, 1)
+
+  uint32_t prefixbytes = 0;
+  if (argc > 2) {
+    SN_OPT_ARGV_UINT32(prefixbytes, 2)
   }
+
+  SN_THROWS(state_size != sizeof(sn__extension_nonce_sequence_state), "state must be 'extension_nonce_sequence_STATEBYTES' bytes")
+  SN_ASSERT_MAX_LENGTH(noncebytes, sn__extension_nonce_sequence_NONCEBYTES_MAX, "noncebytes")
+  SN_THROWS(prefixbytes >= noncebytes, "prefixbytes must be less than noncebytes")
+
+  SN_RETURN(sn__extension_nonce_sequence_init(state, noncebytes, prefixbytes), "failed to initialise nonce sequence")
+}
+
+js_value_t *
+sn_extension_nonce_sequence_init_random (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(2, extension_nonce_sequence_init_random)
+
+  SN_ARGV_BUFFER_CAST(sn__extension_nonce_sequence_state *, state, 0)
+  SN_ARGV_UINT32(noncebytes, 1)
+
+  SN_THROWS(state_size != sizeof(sn__extension_nonce_sequence_state), "state must be 'extension_nonce_sequence_STATEBYTES' bytes")
+  SN_ASSERT_MAX_LENGTH(noncebytes, sn__extension_nonce_sequence_NONCEBYTES_MAX, "noncebytes")
+
+  SN_RETURN(sn__extension_nonce_sequence_init_random(state, noncebytes), "failed to initialise nonce sequence")
+}
+
+js_value_t *
+sn_extension_nonce_sequence_next (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(2, extension_nonce_sequence_next)
+
+  SN_ARGV_TYPEDARRAY(nonce, 0)
+  SN_ARGV_BUFFER_CAST(sn__extension_nonce_sequence_state *, state, 1)
+
+  SN_THROWS(state_size != sizeof(sn__extension_nonce_sequence_state), "state must be 'extension_nonce_sequence_STATEBYTES' bytes")
+  SN_THROWS(nonce_size != state->noncebytes, "nonce must be 'noncebytes' bytes long")
+
+  SN_CALL(sn__extension_nonce_sequence_next(state), "nonce sequence exhausted")
+
+  memcpy(nonce_data, state->nonce, nonce_size);
+
+  return NULL;
+}
+
+typedef struct sn_secretstream_engine_job {
+  sn__extension_secretstream_engine_batch batch;
+  uint32_t *index; // checked copy of offsets then streams, js may change them while the lanes run
+  bool pull;
+} sn_secretstream_engine_job;
+
+static size_t
+sn_secretstream_engine_lane (void *data, size_t lane, size_t lanes) {
+  sn_secretstream_engine_job *job = (sn_secretstream_engine_job *) data;
+
+  if (job->pull) return sn__extension_secretstream_engine_pull(&job->batch, lane, lanes);
+
+  sn__extension_secretstream_engine_push(&job->batch, lane, lanes);
+  return 0;
+}
+
+static void
+sn_secretstream_engine_cleanup (void *data) {
+  sn_secretstream_engine_job *job = (sn_secretstream_engine_job *) data;
+
+  free(job->index);
+  free(job->batch.failed);
+  free(job);
+}
+
+// runs the batch on the calling thread, or split by stream over the uv pool when async
+static js_value_t *
+sn_secretstream_engine_run (js_env_t *env, sn_secretstream_engine_job *job, size_t nstreams, bool async, uint32_t value, js_value_t **refs, size_t refs_len, size_t argc, js_value_t **argv) {
+  int err;
+
+  if (!async) {
+    size_t failures = sn_secretstream_engine_lane(job, 0, 1);
+
+    sn_secretstream_engine_cleanup(job);
+
+    js_value_t *result;
+    SN_STATUS_THROWS(js_create_uint32(env, value + (uint32_t) failures, &result), "")
+    return result;
   }
 
-  err = js_close_handle_scope(req->env, scope);
-  assert(err == 0);
+  size_t n = job->batch.n;
 
-  err = js_delete_reference(req->env, req->str_ref);
-  assert(err == 0);
-  err = js_delete_reference(req->env, req->pwd_ref);
-  assert(err == 0);
+  job->index = (uint32_t *) malloc((2 * n + 1) * sizeof(uint32_t));
+  if (job->index == NULL) {
+    sn_secretstream_engine_cleanup(job);
+    SN_THROWS(true, "failed to allocate request")
+  }
 
-  free(req);
-  free(task);
-}
+  memcpy(job->index, job->batch.offsets, (n + 1) * sizeof(uint32_t));
+  memcpy(job->index + n + 1, job->batch.streams, n * sizeof(uint32_t));
 
-js_value_t *
-sn_crypto_pwhash_scryptsalsa208sha256_str_verify_async (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV_OPTS(2, 3, crypto_pwhash_scryptsalsa208sha256_str_async)
+  job->batch.offsets = job->index;
+  job->batch.streams = job->index + n + 1;
 
-  SN_ARGV_BUFFER_CAST(char *, str, 0)
-  SN_ARGV_BUFFER_CAST(char *, pwd, 1)
+  size_t units = nstreams < n ? nstreams : n;
+  size_t lanes = sn_async_lanes_count(units, 1, sn__extension_secretstream_engine_THREADS_MAX);
 
-  SN_ASSERT_LENGTH(str_size, crypto_pwhash_scryptsalsa208sha256_STRBYTES, "str")
-  SN_ASSERT_OPT_CALLBACK(2)
+  sn_async_lanes_request *req = sn_async_lanes_create(env, lanes, job, sn_secretstream_engine_lane, NULL, sn_secretstream_engine_cleanup, "secretstream engine failed");
+  if (req == NULL) {
+    sn_secretstream_engine_cleanup(job);
+    SN_THROWS(true, "failed to allocate request")
+  }
 
-  sn_async_pwhash_scryptsalsa208sha256_str_verify_request *req = (sn_async_pwhash_scryptsalsa208sha256_str_verify_request *) malloc(sizeof(sn_async_pwhash_scryptsalsa208sha256_str_verify_request));
-  req->env = env;
-  req->str_data = str;
-  req->pwd_data = pwd;
-  req->pwd_size = pwd_size;
+  req->value = value;
 
-  sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
-  SN_ASYNC_TASK(2)
+  for (size_t i = 0; i < refs_len; i++) sn_async_lanes_ref(req, refs[i]);
 
-  err = js_create_reference(env, str_argv, 1, &req->str_ref);
-  assert(err == 0);
-  err = js_create_reference(env, pwd_argv, 1, &req->pwd_ref);
-  assert(err == 0);
+  sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
+  SN_ASYNC_TASK(7)
 
-  SN_QUEUE_TASK(task, async_pwhash_scryptsalsa208sha256_str_verify_execute, async_pwhash_scryptsalsa208sha256_str_verify_complete)
+  req->task = task;
+  sn_async_lanes_queue(req);
 
   return promise;
 }
 
-typedef struct sn_crypto_stream_xor_state {
-  unsigned char n[crypto_stream_NONCEBYTES];
-  unsigned char k[crypto_stream_KEYBYTES];
-  unsigned char next_block[64];
-  int remainder;
-  uint64_t block_counter;
-} sn_crypto_stream_xor_state;
+static js_value_t *
+sn_secretstream_engine_push (js_env_t *env, js_callback_info_t *info, bool async) {
+  SN_ARGV_OPTS(7, 8, extension_secretstream_engine_push)
 
-js_value_t *
-sn_crypto_stream_xor_wrap_init (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(3, crypto_stream_xor_instance_init)
+  SN_ARGV_TYPEDARRAY(table, 0)
+  SN_ARGV_TYPEDARRAY(c, 1)
+  SN_ARGV_TYPEDARRAY(m, 2)
+  SN_ARGV_UINT32ARRAY(offsets, 3)
+  SN_ARGV_UINT32ARRAY(streams, 4)
+  SN_ARGV_TYPEDARRAY(tags, 5)
+  SN_ARGV_UINT32ARRAY(lengths, 6)
 
-  SN_ARGV_BUFFER_CAST(sn_crypto_stream_xor_state *, state, 0)
-  SN_ARGV_TYPEDARRAY(n, 1)
-  SN_ARGV_TYPEDARRAY(k, 2)
+  if (async) {
+    SN_ASSERT_OPT_CALLBACK(7)
+  }
 
-  SN_THROWS(state_size != sizeof(sn_crypto_stream_xor_state), "state must be 'sn_crypto_stream_xor_STATEBYTES' bytes")
-  SN_ASSERT_LENGTH(n_size, crypto_stream_NONCEBYTES, "n")
-  SN_ASSERT_LENGTH(k_size, crypto_stream_KEYBYTES, "k")
+  size_t n = tags_size;
 
-  state->remainder = 0;
-  state->block_counter = 0;
-  memcpy(state->n, n_data, crypto_stream_NONCEBYTES);
-  memcpy(state->k, k_data, crypto_stream_KEYBYTES);
+  crypto_secretstream_xchacha20poly1305_state *table = (crypto_secretstream_xchacha20poly1305_state *) table_data;
+  size_t nstreams = table_size / sizeof(crypto_secretstream_xchacha20poly1305_state);
 
-  return NULL;
-}
+  SN_THROWS(table_size % sizeof(crypto_secretstream_xchacha20poly1305_state) != 0, "table must be a multiple of 'crypto_secretstream_xchacha20poly1305_STATEBYTES' bytes")
+  SN_THROWS(offsets_length != n + 1, "offsets must have 'tags.byteLength + 1' entries")
+  SN_THROWS(streams_length != n, "streams must have 'tags.byteLength' entries")
+  SN_THROWS(lengths_length != n, "lengths must have 'tags.byteLength' entries")
+  SN_THROWS(offsets_data[n] > m_size, "offsets must lie within m")
 
-js_value_t *
-sn_crypto_stream_xor_wrap_update (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(3, crypto_stream_xor_instance_init)
+  for (size_t i = 0; i < n; i++) {
+    SN_THROWS(offsets_data[i] > offsets_data[i + 1], "offsets must be ascending")
+    SN_THROWS(streams_data[i] >= nstreams, "streams must index into table")
+  }
 
-  SN_ARGV_BUFFER_CAST(sn_crypto_stream_xor_state *, state, 0)
-  SN_ARGV_BUFFER_CAST(unsigned char *, c, 1)
-  SN_ARGV_BUFFER_CAST(unsigned char *, m, 2)
+  uint64_t total = (uint64_t) (offsets_data[n] - offsets_data[0]) + (uint64_t) n * crypto_secretstream_xchacha20poly1305_ABYTES;
+  SN_THROWS(c_size < total, "c must fit every message plus 'crypto_secretstream_xchacha20poly1305_ABYTES' bytes each")
+  SN_THROWS(total > 0xffffffff, "c.byteLength must be a 32bit integer")
 
-  SN_THROWS(state_size != sizeof(sn_crypto_stream_xor_state), "state must be 'sn_crypto_stream_xor_STATEBYTES' bytes")
-  SN_THROWS(c_size != m_size, "c must be 'm.byteLength' bytes")
+  sn_secretstream_engine_job *job = (sn_secretstream_engine_job *) malloc(sizeof(sn_secretstream_engine_job));
+  SN_THROWS(job == NULL, "failed to allocate request")
 
-  unsigned char *next_block = state->next_block;
+  job->batch = {
+    table, n, streams_data, offsets_data, m_data, c_data, tags_data, lengths_data, NULL
+  };
+  job->index = NULL;
+  job->pull = false;
 
-  if (state->remainder) {
-    uint64_t offset = 0;
-    int rem = state->remainder;
+  js_value_t *refs[] = { table_argv, c_argv, m_argv, tags_argv, lengths_argv };
 
-    while (rem < 64 && offset < m_size) {
-      c[offset] = next_block[rem]  ^ m[offset];
-      offset++;
-      rem++;
-    }
+  return sn_secretstream_engine_run(env, job, nstreams, async, (uint32_t) total, refs, 5, argc, argv);
+}
 
-    c += offset;
-    m += offset;
-    m_size -= offset;
-    state->remainder = rem == 64 ? 0 : rem;
+static js_value_t *
+sn_secretstream_engine_pull (js_env_t *env, js_callback_info_t *info, bool async) {
+  SN_ARGV_OPTS(7, 8, extension_secretstream_engine_pull)
 
-    if (!m_size) return NULL;
+  SN_ARGV_TYPEDARRAY(table, 0)
+  SN_ARGV_TYPEDARRAY(m, 1)
+  SN_ARGV_TYPEDARRAY(tags, 2)
+  SN_ARGV_TYPEDARRAY(c, 3)
+  SN_ARGV_UINT32ARRAY(offsets, 4)
+  SN_ARGV_UINT32ARRAY(streams, 5)
+  SN_ARGV_UINT32ARRAY(lengths, 6)
+
+  if (async) {
+    SN_ASSERT_OPT_CALLBACK(7)
   }
 
-  state->remainder = m_size & 63;
-  m_size -= state->remainder;
-  crypto_stream_xsalsa20_xor_ic(c, m, m_size, state->n, state->block_counter, state->k);
-  state->block_counter += m_size / 64;
+  size_t n = tags_size;
 
-  if (state->remainder) {
-    sodium_memzero(next_block + state->remainder, 64 - state->remainder);
-    memcpy(next_block, m + m_size, state->remainder);
+  crypto_secretstream_xchacha20poly1305_state *table = (crypto_secretstream_xchacha20poly1305_state *) table_data;
+  size_t nstreams = table_size / sizeof(crypto_secretstream_xchacha20poly1305_state);
 
-    crypto_stream_xsalsa20_xor_ic(next_block, next_block, 64, state->n, state->block_counter, state->k);
-    memcpy(c + m_size, next_block, state->remainder);
+  SN_THROWS(table_size % sizeof(crypto_secretstream_xchacha20poly1305_state) != 0, "table must be a multiple of 'crypto_secretstream_xchacha20poly1305_STATEBYTES' bytes")
+  SN_THROWS(offsets_length != n + 1, "offsets must have 'tags.byteLength + 1' entries")
+  SN_THROWS(streams_length != n, "streams must have 'tags.byteLength' entries")
+  SN_THROWS(lengths_length != n, "lengths must have 'tags.byteLength' entries")
+  SN_THROWS(offsets_data[n] > c_size, "offsets must lie within c")
 
-    state->block_counter++;
+  for (size_t i = 0; i < n; i++) {
+    SN_THROWS(offsets_data[i] > offsets_data[i + 1], "offsets must be ascending")
+    SN_THROWS(offsets_data[i + 1] - offsets_data[i] < crypto_secretstream_xchacha20poly1305_ABYTES, "every ciphertext must be at least 'crypto_secretstream_xchacha20poly1305_ABYTES' bytes")
+    SN_THROWS(streams_data[i] >= nstreams, "streams must index into table")
   }
 
-  return NULL;
-}
+  SN_THROWS(m_size < offsets_data[n] - offsets_data[0] - n * crypto_secretstream_xchacha20poly1305_ABYTES, "m must fit every message")
 
-js_value_t *
-sn_crypto_stream_xor_wrap_final (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(1, crypto_stream_xor_instance_init)
+  sn_secretstream_engine_job *job = (sn_secretstream_engine_job *) malloc(sizeof(sn_secretstream_engine_job));
+  SN_THROWS(job == NULL, "failed to allocate request")
 
-  SN_ARGV_BUFFER_CAST(sn_crypto_stream_xor_state *, state, 0)
+  unsigned char *failed = (unsigned char *) calloc(nstreams > 0 ? nstreams : 1, 1);
+  if (failed == NULL) {
+    free(job);
+    SN_THROWS(true, "failed to allocate stream flags")
+  }
 
-  SN_THROWS(state_size != sizeof(sn_crypto_stream_xor_state), "state must be 'sn_crypto_stream_xor_STATEBYTES' bytes")
+  job->batch = {
+    table, n, streams_data, offsets_data, c_data, m_data, tags_data, lengths_data, failed
+  };
+  job->index = NULL;
+  job->pull = true;
 
-  sodium_memzero(state->n, sizeof(state->n));
-  sodium_memzero(state->k, sizeof(state->k));
-  sodium_memzero(state->next_block, sizeof(state->next_block));
-  state->remainder = 0;
+  js_value_t *refs[] = { table_argv, m_argv, tags_argv, c_argv, lengths_argv };
 
-  return NULL;
+  return sn_secretstream_engine_run(env, job, nstreams, async, 0, refs, 5, argc, argv);
 }
 
-typedef struct sn_crypto_stream_chacha20_xor_state {
-  unsigned char n[crypto_stream_chacha20_NONCEBYTES];
-  unsigned char k[crypto_stream_chacha20_KEYBYTES];
-  unsigned char next_block[64];
-  int remainder;
-  uint64_t block_counter;
-} sn_crypto_stream_chacha20_xor_state;
+js_value_t *
+sn_extension_secretstream_engine_push (js_env_t *env, js_callback_info_t *info) {
+  return sn_secretstream_engine_push(env, info, false);
+}
 
 js_value_t *
-sn_crypto_stream_chacha20_xor_wrap_init (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(3, crypto_stream_chacha20_xor_instance_init)
+sn_extension_secretstream_engine_push_async (js_env_t *env, js_callback_info_t *info) {
+  return sn_secretstream_engine_push(env, info, true);
+}
 
-  SN_ARGV_BUFFER_CAST(sn_crypto_stream_chacha20_xor_state *, state, 0)
-  SN_ARGV_TYPEDARRAY(n, 1)
-  SN_ARGV_TYPEDARRAY(k, 2)
+js_value_t *
+sn_extension_secretstream_engine_pull (js_env_t *env, js_callback_info_t *info) {
+  return sn_secretstream_engine_pull(env, info, false);
+}
 
-  SN_THROWS(state_size != sizeof(sn_crypto_stream_chacha20_xor_state), "state must be 'crypto_stream_chacha20_xor_STATEBYTES' bytes")
-  SN_ASSERT_LENGTH(n_size, crypto_stream_chacha20_NONCEBYTES, "n")
-  SN_ASSERT_LENGTH(k_size, crypto_stream_chacha20_KEYBYTES, "k")
+js_value_t *
+sn_extension_secretstream_engine_pull_async (js_env_t *env, js_callback_info_t *info) {
+  return sn_secretstream_engine_pull(env, info, true);
+}
 
-  state->remainder = 0;
-  state->block_counter = 0;
-  memcpy(state->n, n_data, crypto_stream_chacha20_NONCEBYTES);
-  memcpy(state->k, k_data, crypto_stream_chacha20_KEYBYTES);
+typedef struct sn_box_seal_many_job {
+  sn__extension_box_seal_many_batch batch;
+  uint32_t *offsets; // checked copy, js may change the array while the lanes run
+  size_t lanes;
+  bool split_keys;
+} sn_box_seal_many_job;
 
-  return NULL;
+static size_t
+sn_box_seal_many_lane (void *data, size_t lane, size_t lanes) {
+  sn_box_seal_many_job *job = (sn_box_seal_many_job *) data;
+
+  if (!job->split_keys) return sn__extension_box_seal_many_open(&job->batch, lane, lanes);
+
+  sn__extension_box_seal_many_match(&job->batch, lane, lanes);
+  return 0;
 }
 
-js_value_t *
-sn_crypto_stream_chacha20_xor_wrap_update (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(3, crypto_stream_chacha20_xor_instance_init)
+static size_t
+sn_box_seal_many_resolve (void *data, size_t result) {
+  sn_box_seal_many_job *job = (sn_box_seal_many_job *) data;
 
-  SN_ARGV_BUFFER_CAST(sn_crypto_stream_chacha20_xor_state *, state, 0)
-  SN_ARGV_BUFFER_CAST(unsigned char *, c, 1)
-  SN_ARGV_BUFFER_CAST(unsigned char *, m, 2)
+  return sn__extension_box_seal_many_resolve(&job->batch, job->lanes);
+}
 
-  SN_THROWS(state_size != sizeof(sn_crypto_stream_chacha20_xor_state), "state must be 'crypto_stream_chacha20_xor_STATEBYTES' bytes")
-  SN_THROWS(c_size != m_size, "c must be 'm.byteLength' bytes")
+static void
+sn_box_seal_many_cleanup (void *data) {
+  sn_box_seal_many_job *job = (sn_box_seal_many_job *) data;
 
-  unsigned char *next_block = state->next_block;
+  free(job->offsets);
+  free(job->batch.found);
+  if (job->batch.shared != NULL) sodium_free(job->batch.shared);
+  free(job);
+}
 
-  if (state->remainder) {
-    uint64_t offset = 0;
-    int rem = state->remainder;
+// opens on the calling thread, or split by box (by key for a few boxes) over the uv pool when async
+static js_value_t *
+sn_box_seal_open_many (js_env_t *env, size_t argc, js_value_t **argv, bool async) {
+  int err;
 
-    while (rem < 64 && offset < m_size) {
-      c[offset] = next_block[rem]  ^ m[offset];
-      offset++;
-      rem++;
-    }
+  SN_ARGV_TYPEDARRAY(m, 0)
+  SN_ARGV_TYPEDARRAY(c, 1)
+  SN_ARGV_UINT32ARRAY(offsets, 2)
+  SN_ARGV_TYPEDARRAY(pks, 3)
+  SN_ARGV_TYPEDARRAY(sks, 4)
+  SN_ARGV_UINT32ARRAY(matches, 5)
+  SN_ARGV_UINT32ARRAY(lengths, 6)
+
+  if (async) {
+    SN_ASSERT_OPT_CALLBACK(7)
+  }
+
+  SN_THROWS(offsets_length < 1, "offsets must have 'matches.length + 1' entries")
 
-    c += offset;
-    m += offset;
-    m_size -= offset;
-    state->remainder = rem == 64 ? 0 : rem;
+  size_t n = offsets_length - 1;
+  size_t keys = sks_size / crypto_box_SECRETKEYBYTES;
 
-    if (!m_size) return NULL;
+  SN_THROWS(sks_size % crypto_box_SECRETKEYBYTES != 0, "sks must be a multiple of 'crypto_box_SECRETKEYBYTES' bytes")
+  SN_THROWS(keys < 1, "sks must hold at least one key")
+  SN_THROWS(pks_size != keys * crypto_box_PUBLICKEYBYTES, "pks must hold one 'crypto_box_PUBLICKEYBYTES' key per secret key")
+  SN_THROWS(matches_length != n, "matches must have 'offsets.length - 1' entries")
+  SN_THROWS(lengths_length != n, "lengths must have 'offsets.length - 1' entries")
+  SN_THROWS(offsets_data[n] > c_size, "offsets must lie within c")
+
+  for (size_t i = 0; i < n; i++) {
+    SN_THROWS(offsets_data[i] > offsets_data[i + 1], "offsets must be ascending")
+    SN_THROWS(offsets_data[i + 1] - offsets_data[i] < crypto_box_SEALBYTES, "every ciphertext must be at least 'crypto_box_SEALBYTES' bytes")
   }
 
-  state->remainder = m_size & 63;
-  m_size -= state->remainder;
-  crypto_stream_chacha20_xor_ic(c, m, m_size, state->n, state->block_counter, state->k);
-  state->block_counter += m_size / 64;
+  SN_THROWS(m_size < offsets_data[n] - offsets_data[0] - n * crypto_box_SEALBYTES, "m must fit every message")
 
-  if (state->remainder) {
-    sodium_memzero(next_block + state->remainder, 64 - state->remainder);
-    memcpy(next_block, m + m_size, state->remainder);
+  sn__extension_box_seal_many_batch batch = {
+    n, offsets_data, c_data, m_data, keys, pks_data, sks_data, matches_data, lengths_data, NULL, NULL
+  };
 
-    crypto_stream_chacha20_xor_ic(next_block, next_block, 64, state->n, state->block_counter, state->k);
-    memcpy(c + m_size, next_block, state->remainder);
+  if (!async) {
+    size_t opened = sn__extension_box_seal_many_open(&batch, 0, 1);
 
-    state->block_counter++;
+    js_value_t *result;
+    SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) opened, &result), "")
+    return result;
   }
 
-  return NULL;
-}
+  sn_box_seal_many_job *job = (sn_box_seal_many_job *) malloc(sizeof(sn_box_seal_many_job));
+  SN_THROWS(job == NULL, "failed to allocate request")
 
-js_value_t *
-sn_crypto_stream_chacha20_xor_wrap_final (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(1, crypto_stream_chacha20_xor_instance_init)
+  size_t lanes = sn_async_lanes_count((uint64_t) n * keys, sn__extension_box_seal_many_ATTEMPTS_MIN, sn__extension_box_seal_many_THREADS_MAX);
 
-  SN_ARGV_BUFFER_CAST(sn_crypto_stream_chacha20_xor_state *, state, 0)
+  job->batch = batch;
+  job->split_keys = n < lanes && keys > 1;
 
-  SN_THROWS(state_size != sizeof(sn_crypto_stream_chacha20_xor_state), "state must be 'crypto_stream_chacha20_xor_STATEBYTES' bytes")
+  job->offsets = (uint32_t *) malloc((n + 1) * sizeof(uint32_t));
+  if (job->offsets == NULL) {
+    sn_box_seal_many_cleanup(job);
+    SN_THROWS(true, "failed to allocate request")
+  }
 
-  sodium_memzero(state->n, sizeof(state->n));
-  sodium_memzero(state->k, sizeof(state->k));
-  sodium_memzero(state->next_block, sizeof(state->next_block));
-  state->remainder = 0;
+  memcpy(job->offsets, offsets_data, (n + 1) * sizeof(uint32_t));
+  job->batch.offsets = job->offsets;
 
-  return NULL;
+  if (job->split_keys) {
+    if (lanes > keys) lanes = keys;
+
+    job->batch.found = (uint32_t *) malloc(n * lanes * sizeof(uint32_t));
+    job->batch.shared = (unsigned char *) sodium_malloc(n * lanes * crypto_box_BEFORENMBYTES);
+
+    if (job->batch.found == NULL || job->batch.shared == NULL) {
+      sn_box_seal_many_cleanup(job);
+      SN_THROWS(true, "failed to allocate scan state")
+    }
+  } else if (lanes > n) {
+    lanes = n > 0 ? n : 1;
+  }
+
+  job->lanes = lanes;
+
+  sn_async_lanes_request *req = sn_async_lanes_create(env, lanes, job, sn_box_seal_many_lane, job->split_keys ? sn_box_seal_many_resolve : NULL, sn_box_seal_many_cleanup, "failed to open sealed boxes");
+  if (req == NULL) {
+    sn_box_seal_many_cleanup(job);
+    SN_THROWS(true, "failed to allocate request")
+  }
+
+  sn_async_lanes_ref(req, m_argv);
+  sn_async_lanes_ref(req, c_argv);
+  sn_async_lanes_ref(req, pks_argv);
+  sn_async_lanes_ref(req, sks_argv);
+  sn_async_lanes_ref(req, matches_argv);
+  sn_async_lanes_ref(req, lengths_argv);
+
+  sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
+  SN_ASYNC_TASK(7)
+
+  req->task = task;
+  sn_async_lanes_queue(req);
+
+  return promise;
 }
 
-typedef struct sn_crypto_stream_chacha20_ietf_xor_state {
-  unsigned char n[crypto_stream_chacha20_ietf_NONCEBYTES];
-  unsigned char k[crypto_stream_chacha20_ietf_KEYBYTES];
-  unsigned char next_block[64];
-  int remainder;
-  uint64_t block_counter;
-} sn_crypto_stream_chacha20_ietf_xor_state;
+js_value_t *
+sn_crypto_box_seal_open_many (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(7, crypto_box_seal_open_many)
+
+  return sn_box_seal_open_many(env, argc, argv, false);
+}
 
 js_value_t *
-sn_crypto_stream_chacha20_ietf_xor_wrap_init (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(3, crypto_stream_chacha20_ietf_xor_wrap_init)
+sn_crypto_box_seal_open_many_async (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV_OPTS(7, 8, crypto_box_seal_open_many_async)
 
-  SN_ARGV_BUFFER_CAST(sn_crypto_stream_chacha20_ietf_xor_state *, state, 0)
-  SN_ARGV_TYPEDARRAY(n, 1)
-  SN_ARGV_TYPEDARRAY(k, 2)
+  return sn_box_seal_open_many(env, argc, argv, true);
+}
 
-  SN_THROWS(state_size != sizeof(sn_crypto_stream_chacha20_ietf_xor_state), "state must be 'crypto_stream_chacha20_ietf_xor_STATEBYTES' bytes")
-  SN_ASSERT_LENGTH(n_size, crypto_stream_chacha20_ietf_NONCEBYTES, "n")
-  SN_ASSERT_LENGTH(k_size, crypto_stream_chacha20_ietf_KEYBYTES, "k")
+// holds the ephemeral secret and content key, so it lives in sodium_malloc memory
+typedef struct sn_envelope_seal_job {
+  sn__extension_envelope_wrap_batch batch;
+  unsigned char *c;
+  size_t c_size;
+  size_t hlen;
+  const unsigned char *m;
+  size_t m_size;
+  bool sealed;
+  unsigned char epk[crypto_box_PUBLICKEYBYTES];
+  unsigned char esk[crypto_box_SECRETKEYBYTES];
+  unsigned char ck[crypto_aead_xchacha20poly1305_ietf_KEYBYTES];
+} sn_envelope_seal_job;
 
-  state->remainder = 0;
-  state->block_counter = 0;
-  memcpy(state->n, n_data, crypto_stream_chacha20_ietf_NONCEBYTES);
-  memcpy(state->k, k_data, crypto_stream_chacha20_ietf_KEYBYTES);
+static size_t
+sn_envelope_seal_lane (void *data, size_t lane, size_t lanes) {
+  sn_envelope_seal_job *job = (sn_envelope_seal_job *) data;
 
-  return NULL;
+  return sn__extension_envelope_wrap(&job->batch, lane, lanes);
 }
 
-js_value_t *
-sn_crypto_stream_chacha20_ietf_xor_wrap_update (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(3, crypto_stream_chacha20_ietf_xor_wrap_update)
+// seals the body once every entry is wrapped, returns non-zero if the envelope failed
+static size_t
+sn_envelope_seal_finish (void *data, size_t failures) {
+  sn_envelope_seal_job *job = (sn_envelope_seal_job *) data;
 
-  SN_ARGV_BUFFER_CAST(sn_crypto_stream_chacha20_ietf_xor_state *, state, 0)
-  SN_ARGV_BUFFER_CAST(unsigned char *, c, 1)
-  SN_ARGV_BUFFER_CAST(unsigned char *, m, 2)
+  sodium_memzero(job->esk, sizeof(job->esk));
 
-  SN_THROWS(state_size != sizeof(sn_crypto_stream_chacha20_ietf_xor_state), "state must be 'crypto_stream_chacha20_ietf_xor_STATEBYTES' bytes")
-  SN_THROWS(c_size != m_size, "c must be 'm.byteLength' bytes")
+  if (failures != 0) return failures;
+  if (sn__extension_envelope_seal_body(job->c, job->hlen, job->m, job->m_size, job->ck) != 0) return 1;
+
+  job->sealed = true;
+  return 0;
+}
 
-  unsigned char *next_block = state->next_block;
+static void
+sn_envelope_seal_cleanup (void *data) {
+  sn_envelope_seal_job *job = (sn_envelope_seal_job *) data;
 
-  if (state->remainder) {
-    uint64_t offset = 0;
-    int rem = state->remainder;
+  if (!job->sealed) sodium_memzero(job->c, job->c_size);
 
-    while (rem < 64 && offset < m_size) {
-      c[offset] = next_block[rem]  ^ m[offset];
-      offset++;
-      rem++;
-    }
+  sodium_free(job);
+}
+
+// wraps on the calling thread, or split by recipient over the uv pool when async
+static js_value_t *
+sn_envelope_seal (js_env_t *env, size_t argc, js_value_t **argv, bool async) {
+  int err;
 
-    c += offset;
-    m += offset;
-    m_size -= offset;
-    state->remainder = rem == 64 ? 0 : rem;
+  SN_ARGV_TYPEDARRAY(c, 0)
+  SN_ARGV_TYPEDARRAY(m, 1)
+  SN_ARGV_TYPEDARRAY(pks, 2)
 
-    if (!m_size) return NULL;
+  if (async) {
+    SN_ASSERT_OPT_CALLBACK(3)
   }
 
-  state->remainder = m_size & 63;
-  m_size -= state->remainder;
-  crypto_stream_chacha20_ietf_xor_ic(c, m, m_size, state->n, state->block_counter, state->k);
-  state->block_counter += m_size / 64;
+  size_t n = pks_size / crypto_box_PUBLICKEYBYTES;
+  size_t hlen = sn__extension_envelope_HEADERBYTES + n * sn__extension_envelope_ENTRYBYTES;
 
-  if (state->remainder) {
-    sodium_memzero(next_block + state->remainder, 64 - state->remainder);
-    memcpy(next_block, m + m_size, state->remainder);
+  SN_THROWS(pks_size % crypto_box_PUBLICKEYBYTES != 0, "pks must be a multiple of 'crypto_box_PUBLICKEYBYTES' bytes")
+  SN_THROWS(n < 1 || n > sn__extension_envelope_RECIPIENTS_MAX, "pks must hold between 1 and 'extension_envelope_RECIPIENTS_MAX' keys")
+  SN_THROWS(c_size != hlen + m_size + sn__extension_envelope_ABYTES, "c must be 'extension_envelope_HEADERBYTES + recipients * extension_envelope_ENTRYBYTES + m.byteLength + extension_envelope_ABYTES' bytes")
 
-    crypto_stream_chacha20_ietf_xor_ic(next_block, next_block, 64, state->n, state->block_counter, state->k);
-    memcpy(c + m_size, next_block, state->remainder);
+  sn_envelope_seal_job *job = (sn_envelope_seal_job *) sodium_malloc(sizeof(sn_envelope_seal_job));
+  SN_THROWS(job == NULL, "failed to allocate request")
 
-    state->block_counter++;
-  }
+  crypto_box_keypair(job->epk, job->esk);
+  crypto_aead_xchacha20poly1305_ietf_keygen(job->ck);
 
-  return NULL;
-}
+  sn__extension_envelope_header(c_data, job->epk, (uint32_t) n);
 
-js_value_t *
-sn_crypto_stream_chacha20_ietf_xor_wrap_final (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(1, crypto_stream_chacha20_ietf_xor_wrap_final)
+  job->batch = {
+    n, pks_data, job->epk, job->esk, job->ck, c_data + sn__extension_envelope_HEADERBYTES
+  };
+  job->c = c_data;
+  job->c_size = c_size;
+  job->hlen = hlen;
+  job->m = m_data;
+  job->m_size = m_size;
+  job->sealed = false;
 
-  SN_ARGV_BUFFER_CAST(sn_crypto_stream_chacha20_ietf_xor_state *, state, 0)
+  if (!async) {
+    size_t failures = sn__extension_envelope_wrap(&job->batch, 0, 1);
+    size_t res = sn_envelope_seal_finish(job, failures);
 
-  SN_THROWS(state_size != sizeof(sn_crypto_stream_chacha20_ietf_xor_state), "state must be 'crypto_stream_chacha20_ietf_xor_STATEBYTES' bytes")
+    sn_envelope_seal_cleanup(job);
 
-  sodium_memzero(state->n, sizeof(state->n));
-  sodium_memzero(state->k, sizeof(state->k));
-  sodium_memzero(state->next_block, sizeof(state->next_block));
-  state->remainder = 0;
+    SN_THROWS(failures != 0, "every recipient must be a valid public key")
+    SN_THROWS(res != 0, "failed to seal envelope")
 
-  return NULL;
-}
+    return NULL;
+  }
 
-typedef struct sn_crypto_stream_xchacha20_xor_state {
-  unsigned char n[crypto_stream_xchacha20_NONCEBYTES];
-  unsigned char k[crypto_stream_xchacha20_KEYBYTES];
-  unsigned char next_block[64];
-  int remainder;
-  uint64_t block_counter;
-} sn_crypto_stream_xchacha20_xor_state;
+  size_t lanes = sn_async_lanes_count(n, sn__extension_envelope_RECIPIENTS_PER_THREAD_MIN, sn__extension_envelope_THREADS_MAX);
 
-js_value_t *
-sn_crypto_stream_xchacha20_xor_wrap_init (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(3, crypto_stream_xchacha20_xor_wrap_init)
+  sn_async_lanes_request *req = sn_async_lanes_create(env, lanes, job, sn_envelope_seal_lane, sn_envelope_seal_finish, sn_envelope_seal_cleanup, "failed to seal envelope");
+  if (req == NULL) {
+    sn_envelope_seal_cleanup(job);
+    SN_THROWS(true, "failed to allocate request")
+  }
 
-  SN_ARGV_BUFFER_CAST(sn_crypto_stream_xchacha20_xor_state *, state, 0)
-  SN_ARGV_TYPEDARRAY(n, 1)
-  SN_ARGV_TYPEDARRAY(k, 2)
+  req->strict = true;
 
-  SN_THROWS(state_size != sizeof(sn_crypto_stream_xchacha20_xor_state), "state must be 'crypto_stream_xchacha20_xor_STATEBYTES' bytes")
-  SN_ASSERT_LENGTH(n_size, crypto_stream_xchacha20_NONCEBYTES, "n")
-  SN_ASSERT_LENGTH(k_size, crypto_stream_xchacha20_KEYBYTES, "k")
+  sn_async_lanes_ref(req, c_argv);
+  sn_async_lanes_ref(req, m_argv);
+  sn_async_lanes_ref(req, pks_argv);
+
+  sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
+  SN_ASYNC_TASK(3)
 
-  state->remainder = 0;
-  state->block_counter = 0;
-  memcpy(state->n, n_data, crypto_stream_xchacha20_NONCEBYTES);
-  memcpy(state->k, k_data, crypto_stream_xchacha20_KEYBYTES);
+  req->task = task;
+  sn_async_lanes_queue(req);
 
-  return NULL;
+  return promise;
 }
 
 js_value_t *
-sn_crypto_stream_xchacha20_xor_wrap_update (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(3, crypto_stream_xchacha20_xor_wrap_update)
+sn_extension_envelope_seal (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, extension_envelope_seal)
 
-  SN_ARGV_BUFFER_CAST(sn_crypto_stream_xchacha20_xor_state *, state, 0)
-  SN_ARGV_BUFFER_CAST(unsigned char *, c, 1)
-  SN_ARGV_BUFFER_CAST(unsigned char *, m, 2)
+  return sn_envelope_seal(env, argc, argv, false);
+}
 
-  SN_THROWS(state_size != sizeof(sn_crypto_stream_xchacha20_xor_state), "state must be 'crypto_stream_xchacha20_xor_STATEBYTES' bytes")
-  SN_THROWS(c_size != m_size, "c must be 'm.byteLength' bytes")
+js_value_t *
+sn_extension_envelope_seal_async (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV_OPTS(3, 4, extension_envelope_seal_async)
 
-  unsigned char *next_block = state->next_block;
+  return sn_envelope_seal(env, argc, argv, true);
+}
 
-  if (state->remainder) {
-    uint64_t offset = 0;
-    int rem = state->remainder;
+js_value_t *
+sn_extension_envelope_open (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(5, extension_envelope_open)
 
-    while (rem < 64 && offset < m_size) {
-      c[offset] = next_block[rem]  ^ m[offset];
-      offset++;
-      rem++;
-    }
+  SN_ARGV_TYPEDARRAY(m, 0)
+  SN_ARGV_TYPEDARRAY(c, 1)
+  SN_ARGV_UINT32(hint, 2)
+  SN_ARGV_TYPEDARRAY(pk, 3)
+  SN_ARGV_TYPEDARRAY(sk, 4)
 
-    c += offset;
-    m += offset;
-    m_size -= offset;
-    state->remainder = rem == 64 ? 0 : rem;
+  SN_ASSERT_LENGTH(pk_size, crypto_box_PUBLICKEYBYTES, "pk")
+  SN_ASSERT_LENGTH(sk_size, crypto_box_SECRETKEYBYTES, "sk")
 
-    if (!m_size) return NULL;
-  }
+  uint32_t n = sn__extension_envelope_recipients(c_data, c_size);
 
-  state->remainder = m_size & 63;
-  m_size -= state->remainder;
-  crypto_stream_xchacha20_xor_ic(c, m, m_size, state->n, state->block_counter, state->k);
-  state->block_counter += m_size / 64;
+  SN_THROWS(n == 0, "c must be an envelope")
+  SN_THROWS(m_size != c_size - sn__extension_envelope_HEADERBYTES - (size_t) n * sn__extension_envelope_ENTRYBYTES - sn__extension_envelope_ABYTES, "m must be 'c.byteLength' minus the header and 'extension_envelope_ABYTES' bytes")
 
-  if (state->remainder) {
-    sodium_memzero(next_block + state->remainder, 64 - state->remainder);
-    memcpy(next_block, m + m_size, state->remainder);
+  SN_RETURN_BOOLEAN(sn__extension_envelope_open(m_data, c_data, c_size, hint, pk_data, sk_data) < 0 ? -1 : 0)
+}
 
-    crypto_stream_xchacha20_xor_ic(next_block, next_block, 64, state->n, state->block_counter, state->k);
-    memcpy(c + m_size, next_block, state->remainder);
+js_value_t *
+sn_extension_envelope_recipients (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(1, extension_envelope_recipients)
 
-    state->block_counter++;
-  }
+  SN_ARGV_TYPEDARRAY(c, 0)
 
-  return NULL;
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_uint32(env, sn__extension_envelope_recipients(c_data, c_size), &result), "")
+  return result;
 }
 
+#define SN_NOISE_ASSERT_STATE(state) \
+  SN_ASSERT_LENGTH(state##_size, sn__extension_noise_STATEBYTES, #state) \
+  SN_THROWS(!sn__extension_noise_initialised(state), #state " must be initialised with extension_noise_init")
+
 js_value_t *
-sn_crypto_stream_xchacha20_xor_wrap_final (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(1, crypto_stream_xchacha20_xor_wrap_final)
+sn_extension_noise_init (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV_OPTS(6, 7, extension_noise_init)
 
-  SN_ARGV_BUFFER_CAST(sn_crypto_stream_xchacha20_xor_state *, state, 0)
+  SN_ARGV_BUFFER_CAST(sn__extension_noise_state *, state, 0)
+  SN_ARGV_UINT32(pattern, 1)
+  SN_ARGV_UINT32(initiator, 2)
+  SN_ARGV_TYPEDARRAY(prologue, 3)
+  SN_ARGV_TYPEDARRAY(pk, 4)
+  SN_ARGV_TYPEDARRAY(sk, 5)
+  SN_ARGV_OPTS_TYPEDARRAY(rs, 6)
 
-  SN_THROWS(state_size != sizeof(sn_crypto_stream_xchacha20_xor_state), "state must be 'crypto_stream_xchacha20_xor_STATEBYTES' bytes")
+  SN_ASSERT_LENGTH(state_size, sn__extension_noise_STATEBYTES, "state")
+  SN_ASSERT_LENGTH(pk_size, sn__extension_noise_PUBLICKEYBYTES, "pk")
+  SN_ASSERT_LENGTH(sk_size, sn__extension_noise_SECRETKEYBYTES, "sk")
+  if (use_rs) {
+    SN_ASSERT_LENGTH(rs_size, sn__extension_noise_PUBLICKEYBYTES, "rs")
+  }
 
-  sodium_memzero(state->n, sizeof(state->n));
-  sodium_memzero(state->k, sizeof(state->k));
-  sodium_memzero(state->next_block, sizeof(state->next_block));
-  state->remainder = 0;
+  SN_THROWS(pattern != sn__extension_noise_XX && pattern != sn__extension_noise_IK, "pattern must be 'extension_noise_XX' or 'extension_noise_IK'")
+  SN_THROWS(pattern == sn__extension_noise_IK && initiator && !use_rs, "rs must be given to an IK initiator")
 
-  return NULL;
+  SN_RETURN(sn__extension_noise_init(state, pattern, initiator, prologue_data, prologue_size, pk_data, sk_data, rs_data), "failed to initialise noise state")
 }
 
-typedef struct sn_crypto_stream_salsa20_xor_state {
-  unsigned char n[crypto_stream_salsa20_NONCEBYTES];
-  unsigned char k[crypto_stream_salsa20_KEYBYTES];
-  unsigned char next_block[64];
-  int remainder;
-  uint64_t block_counter;
-} sn_crypto_stream_salsa20_xor_state;
-
+// known answer tests only, index.js leaves it out of the public exports
 js_value_t *
-sn_crypto_stream_salsa20_xor_wrap_init (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(3, crypto_stream_salsa20_xor_wrap_init)
-
-  SN_ARGV_BUFFER_CAST(sn_crypto_stream_salsa20_xor_state *, state, 0)
-  SN_ARGV_TYPEDARRAY(n, 1)
-  SN_ARGV_TYPEDARRAY(k, 2)
+sn_extension_noise_fixed_ephemeral (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(2, _extension_noise_fixed_ephemeral)
 
-  SN_THROWS(state_size != sizeof(sn_crypto_stream_salsa20_xor_state), "state must be 'crypto_stream_salsa20_xor_STATEBYTES' bytes")
-  SN_ASSERT_LENGTH(n_size, crypto_stream_salsa20_NONCEBYTES, "n")
-  SN_ASSERT_LENGTH(k_size, crypto_stream_salsa20_KEYBYTES, "k")
+  SN_ARGV_BUFFER_CAST(sn__extension_noise_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(sk, 1)
 
-  state->remainder = 0;
-  state->block_counter = 0;
-  memcpy(state->n, n_data, crypto_stream_salsa20_NONCEBYTES);
-  memcpy(state->k, k_data, crypto_stream_salsa20_KEYBYTES);
+  SN_NOISE_ASSERT_STATE(state)
+  SN_ASSERT_LENGTH(sk_size, sn__extension_noise_SECRETKEYBYTES, "sk")
 
-  return NULL;
+  SN_RETURN(sn__extension_noise_fixed_ephemeral(state, sk_data), "state must not be done")
 }
 
 js_value_t *
-sn_crypto_stream_salsa20_xor_wrap_update (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(3, crypto_stream_salsa20_xor_wrap_update)
+sn_extension_noise_turn (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(1, extension_noise_turn)
 
-  SN_ARGV_BUFFER_CAST(sn_crypto_stream_salsa20_xor_state *, state, 0)
-  SN_ARGV_BUFFER_CAST(unsigned char *, c, 1)
-  SN_ARGV_BUFFER_CAST(unsigned char *, m, 2)
+  SN_ARGV_BUFFER_CAST(sn__extension_noise_state *, state, 0)
 
-  SN_THROWS(state_size != sizeof(sn_crypto_stream_salsa20_xor_state), "state must be 'crypto_stream_salsa20_xor_STATEBYTES' bytes")
-  SN_THROWS(c_size != m_size, "c must be 'm.byteLength' bytes")
+  SN_NOISE_ASSERT_STATE(state)
+
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_int32(env, sn__extension_noise_turn(state), &result), "")
+  return result;
+}
 
-  unsigned char *next_block = state->next_block;
+js_value_t *
+sn_extension_noise_overhead (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(1, extension_noise_overhead)
 
-  if (state->remainder) {
-    uint64_t offset = 0;
-    int rem = state->remainder;
+  SN_ARGV_BUFFER_CAST(sn__extension_noise_state *, state, 0)
 
-    while (rem < 64 && offset < m_size) {
-      c[offset] = next_block[rem]  ^ m[offset];
-      offset++;
-      rem++;
-    }
+  SN_NOISE_ASSERT_STATE(state)
 
-    c += offset;
-    m += offset;
-    m_size -= offset;
-    state->remainder = rem == 64 ? 0 : rem;
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) sn__extension_noise_overhead(state), &result), "")
+  return result;
+}
 
-    if (!m_size) return NULL;
-  }
+js_value_t *
+sn_extension_noise_write_message (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, extension_noise_write_message)
 
-  state->remainder = m_size & 63;
-  m_size -= state->remainder;
-  crypto_stream_salsa20_xor_ic(c, m, m_size, state->n, state->block_counter, state->k);
-  state->block_counter += m_size / 64;
+  SN_ARGV_BUFFER_CAST(sn__extension_noise_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(out, 1)
+  SN_ARGV_TYPEDARRAY(payload, 2)
 
-  if (state->remainder) {
-    sodium_memzero(next_block + state->remainder, 64 - state->remainder);
-    memcpy(next_block, m + m_size, state->remainder);
+  SN_NOISE_ASSERT_STATE(state)
+  SN_THROWS(sn__extension_noise_turn(state) != 1, "state must be expecting to write a message")
 
-    crypto_stream_salsa20_xor_ic(next_block, next_block, 64, state->n, state->block_counter, state->k);
-    memcpy(c + m_size, next_block, state->remainder);
+  size_t overhead = sn__extension_noise_overhead(state);
 
-    state->block_counter++;
-  }
+  SN_THROWS(payload_size > sn__extension_noise_MESSAGEBYTES_MAX - overhead, "payload must leave room for the handshake within 'extension_noise_MESSAGEBYTES_MAX' bytes")
+  SN_THROWS(out_size != payload_size + overhead, "out must be 'payload.byteLength + extension_noise_overhead(state)' bytes")
 
-  return NULL;
+  SN_RETURN(sn__extension_noise_write_message(state, out_data, payload_data, payload_size), "failed to write handshake message")
 }
 
 js_value_t *
-sn_crypto_stream_salsa20_xor_wrap_final (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(1, crypto_stream_salsa20_xor_wrap_final)
+sn_extension_noise_read_message (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, extension_noise_read_message)
 
-  SN_ARGV_BUFFER_CAST(sn_crypto_stream_salsa20_xor_state *, state, 0)
+  SN_ARGV_BUFFER_CAST(sn__extension_noise_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(payload, 1)
+  SN_ARGV_TYPEDARRAY(message, 2)
 
-  SN_THROWS(state_size != sizeof(sn_crypto_stream_salsa20_xor_state), "state must be 'crypto_stream_salsa20_xor_STATEBYTES' bytes")
+  SN_NOISE_ASSERT_STATE(state)
+  SN_THROWS(sn__extension_noise_turn(state) != 0, "state must be expecting to read a message")
 
-  sodium_memzero(state->n, sizeof(state->n));
-  sodium_memzero(state->k, sizeof(state->k));
-  sodium_memzero(state->next_block, sizeof(state->next_block));
-  state->remainder = 0;
+  size_t overhead = sn__extension_noise_overhead(state);
 
-  return NULL;
-}
+  SN_THROWS(message_size < overhead || message_size > sn__extension_noise_MESSAGEBYTES_MAX, "message must be between 'extension_noise_overhead(state)' and 'extension_noise_MESSAGEBYTES_MAX' bytes")
+  SN_THROWS(payload_size != message_size - overhead, "payload must be 'message.byteLength - extension_noise_overhead(state)' bytes")
 
-// Experimental API
+  SN_RETURN_BOOLEAN(sn__extension_noise_read_message(state, payload_data, message_data, message_size) < 0 ? -1 : 0)
+}
 
 js_value_t *
-sn_extension_tweak_ed25519_base (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(3, extension_tweak_ed25519_base)
+sn_extension_noise_split (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, extension_noise_split)
 
-  SN_ARGV_TYPEDARRAY(n, 0)
-  SN_ARGV_TYPEDARRAY(p, 1)
-  SN_ARGV_TYPEDARRAY(ns, 2)
-
-  SN_ASSERT_LENGTH(n_size, sn__extension_tweak_ed25519_SCALARBYTES, "n")
-  SN_ASSERT_LENGTH(p_size, sn__extension_tweak_ed25519_BYTES, "p")
+  SN_ARGV_BUFFER_CAST(sn__extension_noise_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(tx, 1)
+  SN_ARGV_TYPEDARRAY(rx, 2)
 
-  sn__extension_tweak_ed25519_base(p_data, n_data, ns_data, ns_size);
+  SN_NOISE_ASSERT_STATE(state)
+  SN_ASSERT_LENGTH(tx_size, sn__extension_noise_KEYBYTES, "tx")
+  SN_ASSERT_LENGTH(rx_size, sn__extension_noise_KEYBYTES, "rx")
 
-  return NULL;
+  SN_RETURN(sn__extension_noise_split(state, tx_data, rx_data), "handshake must be complete and not yet split")
 }
 
 js_value_t *
-sn_extension_tweak_ed25519_sign_detached (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV_OPTS(3, 4, extension_tweak_ed25519_sign_detached)
-
-  SN_ARGV_TYPEDARRAY(sig, 0)
-  SN_ARGV_TYPEDARRAY(m, 1)
-  SN_ARGV_TYPEDARRAY(scalar, 2)
-  SN_ARGV_OPTS_TYPEDARRAY(pk, 3)
+sn_extension_noise_handshake_hash (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(2, extension_noise_handshake_hash)
 
-  SN_ASSERT_LENGTH(sig_size, crypto_sign_BYTES, "sig")
-  SN_ASSERT_LENGTH(scalar_size, sn__extension_tweak_ed25519_SCALARBYTES, "scalar")
+  SN_ARGV_BUFFER_CAST(sn__extension_noise_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(h, 1)
 
-  if (pk_data != NULL) {
-    SN_ASSERT_LENGTH(pk_size, crypto_sign_PUBLICKEYBYTES, "pk")
-  }
+  SN_NOISE_ASSERT_STATE(state)
+  SN_ASSERT_LENGTH(h_size, sn__extension_noise_HASHBYTES, "h")
 
-  SN_RETURN(sn__extension_tweak_ed25519_sign_detached(sig_data, NULL, m_data, m_size, scalar_data, pk_data), "failed to compute signature")
+  SN_RETURN(sn__extension_noise_handshake_hash(state, h_data), "handshake hash is only available after split")
 }
 
 js_value_t *
-sn_extension_tweak_ed25519_sk_to_scalar (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(2, extension_tweak_ed25519_sk_to_scalar)
-
-  SN_ARGV_TYPEDARRAY(n, 0)
-  SN_ARGV_TYPEDARRAY(sk, 1)
+sn_extension_noise_remote_static (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(2, extension_noise_remote_static)
 
-  SN_ASSERT_LENGTH(n_size, sn__extension_tweak_ed25519_SCALARBYTES, "n")
-  SN_ASSERT_LENGTH(sk_size, crypto_sign_SECRETKEYBYTES, "sk")
+  SN_ARGV_BUFFER_CAST(sn__extension_noise_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(rs, 1)
 
-  sn__extension_tweak_ed25519_sk_to_scalar(n_data, sk_data);
+  SN_NOISE_ASSERT_STATE(state)
+  SN_ASSERT_LENGTH(rs_size, sn__extension_noise_PUBLICKEYBYTES, "rs")
 
-  return NULL;
+  SN_RETURN_BOOLEAN(sn__extension_noise_remote_static(state, rs_data))
 }
 
+#undef SN_NOISE_ASSERT_STATE
+
+#define SN_TRANSPORT_ASSERT_STATE(state) \
+  SN_ASSERT_LENGTH(state##_size, sn__extension_transport_STATEBYTES, #state) \
+  SN_THROWS(!sn__extension_transport_initialised(state), #state " must be initialised with extension_transport_init")
+
 js_value_t *
-sn_extension_tweak_ed25519_scalar (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(3, extension_tweak_ed25519_scalar)
+sn_extension_transport_init (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV_OPTS(3, 4, extension_transport_init)
 
-  SN_ARGV_TYPEDARRAY(scalar_out, 0)
-  SN_ARGV_TYPEDARRAY(scalar, 1)
-  SN_ARGV_TYPEDARRAY(ns, 2)
+  SN_ARGV_BUFFER_CAST(sn__extension_transport_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(tx, 1)
+  SN_ARGV_TYPEDARRAY(rx, 2)
 
-  SN_ASSERT_LENGTH(scalar_out_size, sn__extension_tweak_ed25519_SCALARBYTES, "scalar_out")
-  SN_ASSERT_LENGTH(scalar_size, sn__extension_tweak_ed25519_SCALARBYTES, "scalar")
+  uint32_t rekey = 0;
+  if (argc > 3) {
+    SN_OPT_ARGV_UINT32(rekey, 3)
+  }
 
-  sn__extension_tweak_ed25519_scalar(scalar_out_data, scalar_data, ns_data, ns_size);
+  SN_ASSERT_LENGTH(state_size, sn__extension_transport_STATEBYTES, "state")
+  SN_ASSERT_LENGTH(tx_size, sn__extension_transport_KEYBYTES, "tx")
+  SN_ASSERT_LENGTH(rx_size, sn__extension_transport_KEYBYTES, "rx")
+
+  sn__extension_transport_init(state, tx_data, rx_data, rekey);
 
   return NULL;
 }
 
 js_value_t *
-sn_extension_tweak_ed25519_pk (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(3, extension_tweak_ed25519_pk)
+sn_extension_transport_seal (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, extension_transport_seal)
 
-  SN_ARGV_TYPEDARRAY(tpk, 0)
-  SN_ARGV_TYPEDARRAY(pk, 1)
-  SN_ARGV_TYPEDARRAY(ns, 2)
+  SN_ARGV_BUFFER_CAST(sn__extension_transport_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(c, 1)
+  SN_ARGV_TYPEDARRAY(m, 2)
 
-  SN_ASSERT_LENGTH(tpk_size, crypto_sign_PUBLICKEYBYTES, "tpk")
-  SN_ASSERT_LENGTH(pk_size, crypto_sign_PUBLICKEYBYTES, "pk")
+  SN_TRANSPORT_ASSERT_STATE(state)
+  SN_THROWS(c_size != m_size + sn__extension_transport_HEADERBYTES + sn__extension_transport_ABYTES, "c must be 'm.byteLength + extension_transport_HEADERBYTES + extension_transport_ABYTES' bytes")
 
-  SN_RETURN(sn__extension_tweak_ed25519_pk(tpk_data, pk_data, ns_data, ns_size), "failed to tweak public key")
+  SN_RETURN(sn__extension_transport_seal(state, c_data, m_data, m_size), "transport counter is exhausted")
 }
 
 js_value_t *
-sn_extension_tweak_ed25519_keypair (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(4, extension_tweak_ed25519_keypair)
-
-  SN_ARGV_TYPEDARRAY(pk, 0)
-  SN_ARGV_TYPEDARRAY(scalar_out, 1)
-  SN_ARGV_TYPEDARRAY(scalar_in, 2)
-  SN_ARGV_TYPEDARRAY(ns, 3)
+sn_extension_transport_open (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, extension_transport_open)
 
-  SN_ASSERT_LENGTH(pk_size, sn__extension_tweak_ed25519_BYTES, "pk")
-  SN_ASSERT_LENGTH(scalar_out_size, sn__extension_tweak_ed25519_SCALARBYTES, "scalar_out")
-  SN_ASSERT_LENGTH(scalar_in_size, sn__extension_tweak_ed25519_SCALARBYTES, "scalar_in")
+  SN_ARGV_BUFFER_CAST(sn__extension_transport_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(m, 1)
+  SN_ARGV_TYPEDARRAY(c, 2)
 
-  sn__extension_tweak_ed25519_keypair(pk_data, scalar_out_data, scalar_in_data, ns_data, ns_size);
+  SN_TRANSPORT_ASSERT_STATE(state)
+  SN_THROWS(c_size < sn__extension_transport_HEADERBYTES + sn__extension_transport_ABYTES, "c must be at least 'extension_transport_HEADERBYTES + extension_transport_ABYTES' bytes")
+  SN_THROWS(m_size != c_size - sn__extension_transport_HEADERBYTES - sn__extension_transport_ABYTES, "m must be 'c.byteLength - extension_transport_HEADERBYTES - extension_transport_ABYTES' bytes")
 
-  return NULL;
+  SN_RETURN_BOOLEAN(sn__extension_transport_open(state, m_data, c_data, c_size))
 }
 
 js_value_t *
-sn_extension_tweak_ed25519_scalar_add (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(3, extension_tweak_ed25519_scalar_add)
+sn_extension_transport_open_many (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(5, extension_transport_open_many)
 
-  SN_ARGV_TYPEDARRAY(scalar_out, 0)
-  SN_ARGV_TYPEDARRAY(scalar, 1)
-  SN_ARGV_TYPEDARRAY(n, 2)
+  SN_ARGV_BUFFER_CAST(sn__extension_transport_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(m, 1)
+  SN_ARGV_TYPEDARRAY(c, 2)
+  SN_ARGV_UINT32ARRAY(offsets, 3)
+  SN_ARGV_UINT32ARRAY(lengths, 4)
 
-  SN_ASSERT_LENGTH(scalar_out_size, sn__extension_tweak_ed25519_SCALARBYTES, "scalar_out")
-  SN_ASSERT_LENGTH(scalar_size, sn__extension_tweak_ed25519_SCALARBYTES, "scalar")
-  SN_ASSERT_LENGTH(n_size, sn__extension_tweak_ed25519_SCALARBYTES, "n")
+  SN_TRANSPORT_ASSERT_STATE(state)
+  SN_THROWS(offsets_length < 1, "offsets must have 'lengths.length + 1' entries")
 
-  sn__extension_tweak_ed25519_scalar_add(scalar_out_data, scalar_data, n_data);
+  size_t n = offsets_length - 1;
+  size_t overhead = sn__extension_transport_HEADERBYTES + sn__extension_transport_ABYTES;
 
-  return NULL;
+  SN_THROWS(lengths_length != n, "lengths must have 'offsets.length - 1' entries")
+  SN_THROWS(offsets_data[n] > c_size, "offsets must lie within c")
+
+  for (size_t i = 0; i < n; i++) {
+    SN_THROWS(offsets_data[i] > offsets_data[i + 1], "offsets must be ascending")
+    SN_THROWS(offsets_data[i + 1] - offsets_data[i] < overhead, "every datagram must be at least 'extension_transport_HEADERBYTES + extension_transport_ABYTES' bytes")
+  }
+
+  SN_THROWS(m_size < offsets_data[n] - offsets_data[0] - n * overhead, "m must fit every message")
+
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_uint32(env, (uint32_t) sn__extension_transport_open_many(state, m_data, c_data, offsets_data, lengths_data, n), &result), "")
+  return result;
 }
 
+#undef SN_TRANSPORT_ASSERT_STATE
+
+#define SN_ED25519_CONVERT_CACHE_ASSERT(cache) \
+  SN_THROWS(((uintptr_t) cache) % 8 != 0, #cache " must be 8 byte aligned") \
+  SN_THROWS(cache##_size < sn__extension_ed25519_convert_HEADERBYTES || cache->capacity != sn__extension_ed25519_convert_cache_capacity(cache##_size) || cache->size > cache->capacity, #cache " must be initialised with extension_ed25519_convert_cache_init")
+
 js_value_t *
-sn_extension_tweak_ed25519_pk_add (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(3, extension_tweak_ed25519_pk)
+sn_extension_ed25519_convert_cache_init (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(1, extension_ed25519_convert_cache_init)
 
-  SN_ARGV_TYPEDARRAY(tpk, 0)
-  SN_ARGV_TYPEDARRAY(pk, 1)
-  SN_ARGV_TYPEDARRAY(p, 2)
+  SN_ARGV_BUFFER_CAST(sn__extension_ed25519_convert_cache *, cache, 0)
 
-  SN_ASSERT_LENGTH(tpk_size, crypto_sign_PUBLICKEYBYTES, "tpk")
-  SN_ASSERT_LENGTH(pk_size, crypto_sign_PUBLICKEYBYTES, "pk")
-  SN_ASSERT_LENGTH(p_size, crypto_sign_PUBLICKEYBYTES, "p")
+  SN_THROWS(((uintptr_t) cache) % 8 != 0, "cache must be 8 byte aligned")
+  SN_ASSERT_MIN_LENGTH(cache_size, sn__extension_ed25519_convert_HEADERBYTES + sn__extension_ed25519_convert_ENTRYBYTES, "cache")
+  SN_THROWS((cache_size - sn__extension_ed25519_convert_HEADERBYTES) % sn__extension_ed25519_convert_ENTRYBYTES != 0, "cache must be 'extension_ed25519_convert_HEADERBYTES + n * extension_ed25519_convert_ENTRYBYTES' bytes")
 
-  SN_RETURN(sn__extension_tweak_ed25519_pk_add(tpk_data, pk_data, p_data), "failed to add tweak to public key")
+  SN_RETURN(sn__extension_ed25519_convert_cache_init(cache, cache_size), "failed to initialise conversion cache")
 }
 
 js_value_t *
-sn_extension_tweak_ed25519_keypair_add (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(4, extension_tweak_ed25519_keypair_add)
+sn_extension_ed25519_convert_cache_clear (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(1, extension_ed25519_convert_cache_clear)
 
-  SN_ARGV_TYPEDARRAY(pk, 0)
-  SN_ARGV_TYPEDARRAY(scalar_out, 1)
-  SN_ARGV_TYPEDARRAY(scalar_in, 2)
-  SN_ARGV_TYPEDARRAY(tweak, 3)
+  SN_ARGV_BUFFER_CAST(sn__extension_ed25519_convert_cache *, cache, 0)
 
-  SN_ASSERT_LENGTH(pk_size, sn__extension_tweak_ed25519_BYTES, "pk")
-  SN_ASSERT_LENGTH(scalar_out_size, sn__extension_tweak_ed25519_SCALARBYTES, "scalar_out")
-  SN_ASSERT_LENGTH(scalar_in_size, sn__extension_tweak_ed25519_SCALARBYTES, "scalar_in")
-  SN_ASSERT_LENGTH(tweak_size, sn__extension_tweak_ed25519_SCALARBYTES, "tweak")
+  SN_ED25519_CONVERT_CACHE_ASSERT(cache)
 
-  SN_RETURN(sn__extension_tweak_ed25519_keypair_add(pk_data, scalar_out_data, scalar_in_data, tweak_data), "failed to add tweak to keypair")
+  sn__extension_ed25519_convert_cache_clear(cache);
+
+  return NULL;
 }
 
-js_value_t *
-sn_extension_pbkdf2_sha512 (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV(5, extension_pbkdf2_sha512)
+#undef SN_ED25519_CONVERT_CACHE_ASSERT
 
-  SN_ARGV_BUFFER_CAST(unsigned char *, out, 0)
-  SN_ARGV_BUFFER_CAST(unsigned char *, passwd, 1)
-  SN_ARGV_BUFFER_CAST(unsigned char *, salt, 2)
-  SN_ARGV_UINT64(iter, 3)
-  SN_ARGV_UINT64(outlen, 4)
+#define SN_RATCHET_ASSERT_STATE(state) \
+  SN_THROWS(!sn__extension_ratchet_initialised(state, state##_size), #state " must be initialised with extension_ratchet_init")
 
-  SN_ASSERT_MIN_LENGTH(iter, sn__extension_pbkdf2_sha512_ITERATIONS_MIN, "iterations")
-  SN_ASSERT_MAX_LENGTH(outlen, sn__extension_pbkdf2_sha512_BYTES_MAX, "outlen")
+js_value_t *
+sn_extension_ratchet_init (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(3, extension_ratchet_init)
 
-  SN_ASSERT_MIN_LENGTH(out_size, outlen, "out")
+  SN_ARGV_BUFFER_CAST(sn__extension_ratchet_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(chain_key, 1)
+  SN_ARGV_TYPEDARRAY(ctx, 2)
 
-  SN_RETURN(sn__extension_pbkdf2_sha512(passwd, passwd_size, salt, salt_size, iter, out, outlen), "failed to add tweak to public key")
+  SN_ASSERT_MIN_LENGTH(state_size, sn__extension_ratchet_STATEBYTES, "state")
+  SN_THROWS((state_size - sn__extension_ratchet_STATEBYTES) % sn__extension_ratchet_SKIPBYTES != 0, "state must be 'extension_ratchet_STATEBYTES + n * extension_ratchet_SKIPBYTES' bytes")
+  SN_ASSERT_LENGTH(chain_key_size, sn__extension_ratchet_KEYBYTES, "chain_key")
+  SN_ASSERT_LENGTH(ctx_size, sn__extension_ratchet_CONTEXTBYTES, "ctx")
+
+  SN_RETURN(sn__extension_ratchet_init(state, state_size, chain_key_data, ctx_data), "failed to initialise ratchet")
 }
 
-typedef struct sn_async_pbkdf2_sha512_request {
-  js_env_t *env;
-  unsigned char *out_data;
-  size_t out_size;
-  js_ref_t *out_ref;
-  size_t outlen;
-  js_ref_t *pwd_ref;
-  const unsigned char *pwd_data;
-  size_t pwd_size;
-  js_ref_t *salt_ref;
-  unsigned char *salt_data;
-  size_t salt_size;
-  uint64_t iter;
-} sn_async_pbkdf2_sha512_request;
+js_value_t *
+sn_extension_ratchet_next (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(2, extension_ratchet_next)
 
-static void async_pbkdf2_sha512_execute (uv_work_t *uv_req) {
-  sn_async_task_t *task = (sn_async_task_t *) uv_req;
-  sn_async_pbkdf2_sha512_request *req = (sn_async_pbkdf2_sha512_request *) task->req;
-  task->code = sn__extension_pbkdf2_sha512(req->pwd_data,
-                                    req->pwd_size,
-                                    req->salt_data,
-                                    req->salt_size,
-                                    req->iter,
-                                    req->out_data,
-                                    req->outlen);
-}
+  SN_ARGV_BUFFER_CAST(sn__extension_ratchet_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(key, 1)
 
-static void async_pbkdf2_sha512_complete (uv_work_t *uv_req, int status) {
-  int err;
-  sn_async_task_t *task = (sn_async_task_t *) uv_req;
-  sn_async_pbkdf2_sha512_request *req = (sn_async_pbkdf2_sha512_request *) task->req;
+  SN_RATCHET_ASSERT_STATE(state)
+  SN_ASSERT_LENGTH(key_size, sn__extension_ratchet_KEYBYTES, "key")
 
-  js_handle_scope_t *scope;
-  err = js_open_handle_scope(req->env, &scope);
-  assert(err == 0);
+  uint64_t counter;
+  SN_THROWS(sn__extension_ratchet_next(state, key_data, &counter) != 0, "ratchet counter is exhausted")
 
-  js_value_t *global;
-  err = js_get_global(req->env, &global);
-  assert(err == 0);
+  js_value_t *result;
+  SN_STATUS_THROWS(js_create_int64(env, (int64_t) counter, &result), "")
+  return result;
+}
 
-  SN_ASYNC_COMPLETE("failed to compute kdf")
+js_value_t *
+sn_extension_ratchet_skip (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV(2, extension_ratchet_skip)
 
-  err = js_close_handle_scope(req->env, scope);
-  assert(err == 0);
+  SN_ARGV_BUFFER_CAST(sn__extension_ratchet_state *, state, 0)
+  SN_ARGV_UINT32(n, 1)
 
-  err = js_delete_reference(req->env, req->out_ref);
-  assert(err == 0);
-  err = js_delete_reference(req->env, req->pwd_ref);
-  assert(err == 0);
-  err = js_delete_reference(req->env, req->salt_ref);
-  assert(err == 0);
+  SN_RATCHET_ASSERT_STATE(state)
+  SN_THROWS(n > sn__extension_ratchet_SKIP_MAX, "n must be at most extension_ratchet_SKIP_MAX")
 
-  free(req);
-  free(task);
+  SN_RETURN(sn__extension_ratchet_skip(state, n), "ratchet counter is exhausted")
 }
 
 js_value_t *
-sn_extension_pbkdf2_sha512_async (js_env_t *env, js_callback_info_t *info) {
-  SN_ARGV_OPTS(5, 6, extension_pbkdf2_sha512_async)
+sn_extension_ratchet_encrypt (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV_OPTS(3, 4, extension_ratchet_encrypt)
 
-  SN_ARGV_BUFFER_CAST(unsigned char *, out, 0)
-  SN_ARGV_BUFFER_CAST(unsigned char *, pwd, 1)
-  SN_ARGV_BUFFER_CAST(unsigned char *, salt, 2)
-  SN_ARGV_UINT64(iter, 3)
-  SN_ARGV_UINT64(outlen, 4)
-
-  SN_ASSERT_MIN_LENGTH(iter, sn__extension_pbkdf2_sha512_ITERATIONS_MIN, "iterations")
-  SN_ASSERT_MAX_LENGTH(outlen, sn__extension_pbkdf2_sha512_BYTES_MAX, "outlen")
-  SN_ASSERT_MIN_LENGTH(out_size, outlen, "output")
-  SN_ASSERT_OPT_CALLBACK(5)
+  SN_ARGV_BUFFER_CAST(sn__extension_ratchet_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(c, 1)
+  SN_ARGV_TYPEDARRAY(m, 2)
+  SN_ARGV_OPTS_TYPEDARRAY(ad, 3)
 
-  sn_async_pbkdf2_sha512_request *req = (sn_async_pbkdf2_sha512_request *) malloc(sizeof(sn_async_pbkdf2_sha512_request));
+  SN_RATCHET_ASSERT_STATE(state)
+  SN_THROWS(c_size != m_size + sn__extension_ratchet_HEADERBYTES + sn__extension_ratchet_ABYTES, "c must be 'm.byteLength + extension_ratchet_HEADERBYTES + extension_ratchet_ABYTES' bytes")
 
-  req->env = env;
-  req->out_data = out;
-  req->out_size = out_size;
-  req->pwd_data = pwd;
-  req->pwd_size = pwd_size;
-  req->salt_data = salt;
-  req->salt_size = salt_size;
-  req->iter = iter;
-  req->outlen = outlen;
+  SN_RETURN(sn__extension_ratchet_encrypt(state, c_data, m_data, m_size, ad_data, ad_size), "ratchet counter is exhausted")
+}
 
-  sn_async_task_t *task = (sn_async_task_t *) malloc(sizeof(sn_async_task_t));
-  SN_ASYNC_TASK(5);
+js_value_t *
+sn_extension_ratchet_decrypt (js_env_t *env, js_callback_info_t *info) {
+  SN_ARGV_OPTS(3, 4, extension_ratchet_decrypt)
 
-  err = js_create_reference(env, out_argv, 1, &req->out_ref);
-  assert(err == 0);
-  err = js_create_reference(env, pwd_argv, 1, &req->pwd_ref);
-  assert(err == 0);
-  err = js_create_reference(env, salt_argv, 1, &req->salt_ref);
-  assert(err == 0);
+  SN_ARGV_BUFFER_CAST(sn__extension_ratchet_state *, state, 0)
+  SN_ARGV_TYPEDARRAY(m, 1)
+  SN_ARGV_TYPEDARRAY(c, 2)
+  SN_ARGV_OPTS_TYPEDARRAY(ad, 3)
 
-  SN_QUEUE_TASK(task, async_pbkdf2_sha512_execute, async_pbkdf2_sha512_complete)
+  SN_RATCHET_ASSERT_STATE(state)
+  SN_THROWS(c_size < sn__extension_ratchet_HEADERBYTES + sn__extension_ratchet_ABYTES, "c must be at least 'extension_ratchet_HEADERBYTES + extension_ratchet_ABYTES' bytes")
+  SN_THROWS(m_size != c_size - sn__extension_ratchet_HEADERBYTES - sn__extension_ratchet_ABYTES, "m must be 'c.byteLength - extension_ratchet_HEADERBYTES - extension_ratchet_ABYTES' bytes")
 
-  return promise;
+  SN_RETURN_BOOLEAN(sn__extension_ratchet_decrypt(state, m_data, c_data, c_size, ad_data, ad_size))
 }
 
+#undef SN_RATCHET_ASSERT_STATE
+
 js_value_t *
 sodium_native_exports (js_env_t *env, js_value_t *exports) {
   int err;
@@ -3571,10 +6789,23 @@ sodium_native_exports (js_env_t *env, js_value_t *exports) {
   // crypto_aead
 
   SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_keygen, sn_crypto_aead_xchacha20poly1305_ietf_keygen)
-  SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_encrypt, sn_crypto_aead_xchacha20poly1305_ietf_encrypt)
+  SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_encrypt, sn_crypto_aead_xchacha20poly1305_ietf_encrypt<false>)
+  SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_encrypt_seq, sn_crypto_aead_xchacha20poly1305_ietf_encrypt<true>)
   SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_decrypt, sn_crypto_aead_xchacha20poly1305_ietf_decrypt)
-  SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_encrypt_detached, sn_crypto_aead_xchacha20poly1305_ietf_encrypt_detached)
+  SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_encrypt_padded, sn_crypto_aead_xchacha20poly1305_ietf_encrypt_padded<false>)
+  SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_encrypt_padded_seq, sn_crypto_aead_xchacha20poly1305_ietf_encrypt_padded<true>)
+  SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_decrypt_padded, sn_crypto_aead_xchacha20poly1305_ietf_decrypt_padded)
+  SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_encrypt_detached, sn_crypto_aead_xchacha20poly1305_ietf_encrypt_detached<false>)
+  SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_encrypt_detached_seq, sn_crypto_aead_xchacha20poly1305_ietf_encrypt_detached<true>)
   SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_decrypt_detached, sn_crypto_aead_xchacha20poly1305_ietf_decrypt_detached)
+  SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_verify, sn_crypto_aead_xchacha20poly1305_ietf_verify)
+  SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_verify_detached, sn_crypto_aead_xchacha20poly1305_ietf_verify_detached)
+  SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_encryptv, sn_crypto_aead_xchacha20poly1305_ietf_encryptv<false>)
+  SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_encryptv_seq, sn_crypto_aead_xchacha20poly1305_ietf_encryptv<true>)
+  SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_decryptv, sn_crypto_aead_xchacha20poly1305_ietf_decryptv)
+  SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_encryptv_detached, sn_crypto_aead_xchacha20poly1305_ietf_encryptv_detached<false>)
+  SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_encryptv_detached_seq, sn_crypto_aead_xchacha20poly1305_ietf_encryptv_detached<true>)
+  SN_EXPORT_FUNCTION(crypto_aead_xchacha20poly1305_ietf_decryptv_detached, sn_crypto_aead_xchacha20poly1305_ietf_decryptv_detached)
   SN_EXPORT_UINT32(crypto_aead_xchacha20poly1305_ietf_ABYTES, crypto_aead_xchacha20poly1305_ietf_ABYTES)
   SN_EXPORT_UINT32(crypto_aead_xchacha20poly1305_ietf_KEYBYTES, crypto_aead_xchacha20poly1305_ietf_KEYBYTES)
   SN_EXPORT_UINT32(crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES)
@@ -3582,10 +6813,23 @@ sodium_native_exports (js_env_t *env, js_value_t *exports) {
   SN_EXPORT_UINT64(crypto_aead_xchacha20poly1305_ietf_MESSAGEBYTES_MAX, crypto_aead_xchacha20poly1305_ietf_MESSAGEBYTES_MAX)
 
   SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_keygen, sn_crypto_aead_chacha20poly1305_ietf_keygen)
-  SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_encrypt, sn_crypto_aead_chacha20poly1305_ietf_encrypt)
+  SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_encrypt, sn_crypto_aead_chacha20poly1305_ietf_encrypt<false>)
+  SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_encrypt_seq, sn_crypto_aead_chacha20poly1305_ietf_encrypt<true>)
   SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_decrypt, sn_crypto_aead_chacha20poly1305_ietf_decrypt)
-  SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_encrypt_detached, sn_crypto_aead_chacha20poly1305_ietf_encrypt_detached)
+  SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_encrypt_padded, sn_crypto_aead_chacha20poly1305_ietf_encrypt_padded<false>)
+  SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_encrypt_padded_seq, sn_crypto_aead_chacha20poly1305_ietf_encrypt_padded<true>)
+  SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_decrypt_padded, sn_crypto_aead_chacha20poly1305_ietf_decrypt_padded)
+  SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_encrypt_detached, sn_crypto_aead_chacha20poly1305_ietf_encrypt_detached<false>)
+  SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_encrypt_detached_seq, sn_crypto_aead_chacha20poly1305_ietf_encrypt_detached<true>)
   SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_decrypt_detached, sn_crypto_aead_chacha20poly1305_ietf_decrypt_detached)
+  SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_verify, sn_crypto_aead_chacha20poly1305_ietf_verify)
+  SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_verify_detached, sn_crypto_aead_chacha20poly1305_ietf_verify_detached)
+  SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_encryptv, sn_crypto_aead_chacha20poly1305_ietf_encryptv<false>)
+  SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_encryptv_seq, sn_crypto_aead_chacha20poly1305_ietf_encryptv<true>)
+  SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_decryptv, sn_crypto_aead_chacha20poly1305_ietf_decryptv)
+  SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_encryptv_detached, sn_crypto_aead_chacha20poly1305_ietf_encryptv_detached<false>)
+  SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_encryptv_detached_seq, sn_crypto_aead_chacha20poly1305_ietf_encryptv_detached<true>)
+  SN_EXPORT_FUNCTION(crypto_aead_chacha20poly1305_ietf_decryptv_detached, sn_crypto_aead_chacha20poly1305_ietf_decryptv_detached)
   SN_EXPORT_UINT32(crypto_aead_chacha20poly1305_ietf_ABYTES, crypto_aead_chacha20poly1305_ietf_ABYTES)
   SN_EXPORT_UINT32(crypto_aead_chacha20poly1305_ietf_KEYBYTES, crypto_aead_chacha20poly1305_ietf_KEYBYTES)
   SN_EXPORT_UINT32(crypto_aead_chacha20poly1305_ietf_NPUBBYTES, crypto_aead_chacha20poly1305_ietf_NPUBBYTES)
@@ -3608,15 +6852,24 @@ sodium_native_exports (js_env_t *env, js_value_t *exports) {
   SN_EXPORT_FUNCTION(crypto_box_open_easy, sn_crypto_box_open_easy)
   SN_EXPORT_FUNCTION(crypto_box_detached, sn_crypto_box_detached)
   SN_EXPORT_FUNCTION(crypto_box_open_detached, sn_crypto_box_open_detached)
+  SN_EXPORT_FUNCTION(crypto_box_beforenm, sn_crypto_box_beforenm)
+  SN_EXPORT_FUNCTION(crypto_box_easy_afternm, sn_crypto_box_easy_afternm)
+  SN_EXPORT_FUNCTION(crypto_box_open_easy_afternm, sn_crypto_box_open_easy_afternm)
+  SN_EXPORT_FUNCTION(crypto_box_detached_afternm, sn_crypto_box_detached_afternm)
+  SN_EXPORT_FUNCTION(crypto_box_open_detached_afternm, sn_crypto_box_open_detached_afternm)
   SN_EXPORT_FUNCTION(crypto_box_seal, sn_crypto_box_seal)
 
   SN_EXPORT_FUNCTION_NOSCOPE("crypto_box_seal_open", sn_crypto_box_seal_open)
+  SN_EXPORT_FUNCTION(crypto_box_seal_open_many, sn_crypto_box_seal_open_many)
+  SN_EXPORT_FUNCTION(crypto_box_seal_open_many_async, sn_crypto_box_seal_open_many_async)
   SN_EXPORT_UINT32(crypto_box_SEEDBYTES, crypto_box_SEEDBYTES)
   SN_EXPORT_UINT32(crypto_box_PUBLICKEYBYTES, crypto_box_PUBLICKEYBYTES)
   SN_EXPORT_UINT32(crypto_box_SECRETKEYBYTES, crypto_box_SECRETKEYBYTES)
   SN_EXPORT_UINT32(crypto_box_NONCEBYTES, crypto_box_NONCEBYTES)
   SN_EXPORT_UINT32(crypto_box_MACBYTES, crypto_box_MACBYTES)
   SN_EXPORT_UINT32(crypto_box_SEALBYTES, crypto_box_SEALBYTES)
+  SN_EXPORT_UINT32(crypto_box_BEFORENMBYTES, crypto_box_BEFORENMBYTES)
+  SN_EXPORT_UINT32(crypto_box_seal_open_many_FAILED, sn__extension_box_seal_many_FAILED)
   SN_EXPORT_STRING(crypto_box_PRIMITIVE, crypto_box_PRIMITIVE)
 
   // crypto_core
@@ -3772,6 +7025,8 @@ sodium_native_exports (js_env_t *env, js_value_t *exports) {
 
   SN_EXPORT_FUNCTION(crypto_scalarmult_base, sn_crypto_scalarmult_base)
   SN_EXPORT_FUNCTION(crypto_scalarmult, sn_crypto_scalarmult)
+  SN_EXPORT_FUNCTION(crypto_scalarmult_many, sn_crypto_scalarmult_many)
+  SN_EXPORT_FUNCTION(crypto_scalarmult_many_async, sn_crypto_scalarmult_many_async)
   SN_EXPORT_STRING(crypto_scalarmult_PRIMITIVE, crypto_scalarmult_PRIMITIVE)
   SN_EXPORT_UINT32(crypto_scalarmult_BYTES, crypto_scalarmult_BYTES)
   SN_EXPORT_UINT32(crypto_scalarmult_SCALARBYTES, crypto_scalarmult_SCALARBYTES)
@@ -3785,9 +7040,14 @@ sodium_native_exports (js_env_t *env, js_value_t *exports) {
 
   // crypto_secretbox
 
-  SN_EXPORT_FUNCTION(crypto_secretbox_easy, sn_crypto_secretbox_easy)
+  SN_EXPORT_FUNCTION(crypto_secretbox_easy, sn_crypto_secretbox_easy<false>)
+  SN_EXPORT_FUNCTION(crypto_secretbox_easy_seq, sn_crypto_secretbox_easy<true>)
   SN_EXPORT_FUNCTION(crypto_secretbox_open_easy, sn_crypto_secretbox_open_easy)
-  SN_EXPORT_FUNCTION(crypto_secretbox_detached, sn_crypto_secretbox_detached)
+  SN_EXPORT_FUNCTION(crypto_secretbox_easy_padded, sn_crypto_secretbox_easy_padded<false>)
+  SN_EXPORT_FUNCTION(crypto_secretbox_easy_padded_seq, sn_crypto_secretbox_easy_padded<true>)
+  SN_EXPORT_FUNCTION(crypto_secretbox_open_easy_padded, sn_crypto_secretbox_open_easy_padded)
+  SN_EXPORT_FUNCTION(crypto_secretbox_detached, sn_crypto_secretbox_detached<false>)
+  SN_EXPORT_FUNCTION(crypto_secretbox_detached_seq, sn_crypto_secretbox_detached<true>)
   SN_EXPORT_FUNCTION(crypto_secretbox_open_detached, sn_crypto_secretbox_open_detached)
   SN_EXPORT_UINT32(crypto_secretbox_KEYBYTES, crypto_secretbox_KEYBYTES)
   SN_EXPORT_UINT32(crypto_secretbox_NONCEBYTES, crypto_secretbox_NONCEBYTES)
@@ -3801,6 +7061,10 @@ sodium_native_exports (js_env_t *env, js_value_t *exports) {
   SN_EXPORT_FUNCTION(crypto_secretstream_xchacha20poly1305_init_pull, sn_crypto_secretstream_xchacha20poly1305_init_pull)
   SN_EXPORT_FUNCTION_NOSCOPE("crypto_secretstream_xchacha20poly1305_push", sn_crypto_secretstream_xchacha20poly1305_push)
   SN_EXPORT_FUNCTION_NOSCOPE("crypto_secretstream_xchacha20poly1305_pull", sn_crypto_secretstream_xchacha20poly1305_pull)
+  SN_EXPORT_FUNCTION_NOSCOPE("crypto_secretstream_xchacha20poly1305_push_inplace", sn_crypto_secretstream_xchacha20poly1305_push_inplace)
+  SN_EXPORT_FUNCTION_NOSCOPE("crypto_secretstream_xchacha20poly1305_pull_inplace", sn_crypto_secretstream_xchacha20poly1305_pull_inplace)
+  SN_EXPORT_FUNCTION(crypto_secretstream_xchacha20poly1305_push_many, sn_crypto_secretstream_xchacha20poly1305_push_many)
+  SN_EXPORT_FUNCTION(crypto_secretstream_xchacha20poly1305_pull_many, sn_crypto_secretstream_xchacha20poly1305_pull_many)
 
   SN_EXPORT_FUNCTION(crypto_secretstream_xchacha20poly1305_rekey, sn_crypto_secretstream_xchacha20poly1305_rekey)
   SN_EXPORT_UINT32(crypto_secretstream_xchacha20poly1305_STATEBYTES, sizeof(crypto_secretstream_xchacha20poly1305_state))
@@ -3832,6 +7096,7 @@ sodium_native_exports (js_env_t *env, js_value_t *exports) {
 
   SN_EXPORT_FUNCTION(crypto_sign_ed25519_sk_to_pk, sn_crypto_sign_ed25519_sk_to_pk)
   SN_EXPORT_FUNCTION(crypto_sign_ed25519_pk_to_curve25519, sn_crypto_sign_ed25519_pk_to_curve25519)
+  SN_EXPORT_FUNCTION(crypto_sign_ed25519_pk_to_curve25519_many, sn_crypto_sign_ed25519_pk_to_curve25519_many)
   SN_EXPORT_FUNCTION(crypto_sign_ed25519_sk_to_curve25519, sn_crypto_sign_ed25519_sk_to_curve25519)
   SN_EXPORT_UINT32(crypto_sign_SEEDBYTES, crypto_sign_SEEDBYTES)
   SN_EXPORT_UINT32(crypto_sign_PUBLICKEYBYTES, crypto_sign_PUBLICKEYBYTES)
@@ -3849,6 +7114,7 @@ sodium_native_exports (js_env_t *env, js_value_t *exports) {
   SN_EXPORT_FUNCTION(crypto_stream_xor_init, sn_crypto_stream_xor_wrap_init)
   SN_EXPORT_FUNCTION(crypto_stream_xor_update, sn_crypto_stream_xor_wrap_update)
   SN_EXPORT_FUNCTION(crypto_stream_xor_final, sn_crypto_stream_xor_wrap_final)
+  SN_EXPORT_FUNCTION(crypto_stream_xor_seek, sn_crypto_stream_xor_wrap_seek)
   SN_EXPORT_UINT32(crypto_stream_xor_STATEBYTES, sizeof(sn_crypto_stream_xor_state))
 
   SN_EXPORT_FUNCTION(crypto_stream_chacha20, sn_crypto_stream_chacha20)
@@ -3858,9 +7124,11 @@ sodium_native_exports (js_env_t *env, js_value_t *exports) {
 
   SN_EXPORT_FUNCTION(crypto_stream_chacha20_xor, sn_crypto_stream_chacha20_xor)
   SN_EXPORT_FUNCTION(crypto_stream_chacha20_xor_ic, sn_crypto_stream_chacha20_xor_ic)
+  SN_EXPORT_FUNCTION(crypto_stream_chacha20_xor_parallel, sn_crypto_stream_chacha20_xor_parallel)
   SN_EXPORT_FUNCTION(crypto_stream_chacha20_xor_init, sn_crypto_stream_chacha20_xor_wrap_init)
   SN_EXPORT_FUNCTION(crypto_stream_chacha20_xor_update, sn_crypto_stream_chacha20_xor_wrap_update)
   SN_EXPORT_FUNCTION(crypto_stream_chacha20_xor_final, sn_crypto_stream_chacha20_xor_wrap_final)
+  SN_EXPORT_FUNCTION(crypto_stream_chacha20_xor_seek, sn_crypto_stream_chacha20_xor_wrap_seek)
   SN_EXPORT_UINT32(crypto_stream_chacha20_xor_STATEBYTES, sizeof(sn_crypto_stream_chacha20_xor_state))
 
   SN_EXPORT_FUNCTION(crypto_stream_chacha20_ietf, sn_crypto_stream_chacha20_ietf)
@@ -3871,9 +7139,11 @@ sodium_native_exports (js_env_t *env, js_value_t *exports) {
 
   SN_EXPORT_FUNCTION(crypto_stream_chacha20_ietf_xor, sn_crypto_stream_chacha20_ietf_xor)
   SN_EXPORT_FUNCTION(crypto_stream_chacha20_ietf_xor_ic, sn_crypto_stream_chacha20_ietf_xor_ic)
+  SN_EXPORT_FUNCTION(crypto_stream_chacha20_ietf_xor_parallel, sn_crypto_stream_chacha20_ietf_xor_parallel)
   SN_EXPORT_FUNCTION(crypto_stream_chacha20_ietf_xor_init, sn_crypto_stream_chacha20_ietf_xor_wrap_init)
   SN_EXPORT_FUNCTION(crypto_stream_chacha20_ietf_xor_update, sn_crypto_stream_chacha20_ietf_xor_wrap_update)
   SN_EXPORT_FUNCTION(crypto_stream_chacha20_ietf_xor_final, sn_crypto_stream_chacha20_ietf_xor_wrap_final)
+  SN_EXPORT_FUNCTION(crypto_stream_chacha20_ietf_xor_seek, sn_crypto_stream_chacha20_ietf_xor_wrap_seek)
 
   SN_EXPORT_FUNCTION(crypto_stream_xchacha20, sn_crypto_stream_xchacha20)
   SN_EXPORT_UINT32(crypto_stream_xchacha20_KEYBYTES, crypto_stream_xchacha20_KEYBYTES)
@@ -3882,9 +7152,11 @@ sodium_native_exports (js_env_t *env, js_value_t *exports) {
 
   SN_EXPORT_FUNCTION(crypto_stream_xchacha20_xor, sn_crypto_stream_xchacha20_xor)
   SN_EXPORT_FUNCTION(crypto_stream_xchacha20_xor_ic, sn_crypto_stream_xchacha20_xor_ic)
+  SN_EXPORT_FUNCTION(crypto_stream_xchacha20_xor_parallel, sn_crypto_stream_xchacha20_xor_parallel)
   SN_EXPORT_FUNCTION(crypto_stream_xchacha20_xor_init, sn_crypto_stream_xchacha20_xor_wrap_init)
   SN_EXPORT_FUNCTION(crypto_stream_xchacha20_xor_update, sn_crypto_stream_xchacha20_xor_wrap_update)
   SN_EXPORT_FUNCTION(crypto_stream_xchacha20_xor_final, sn_crypto_stream_xchacha20_xor_wrap_final)
+  SN_EXPORT_FUNCTION(crypto_stream_xchacha20_xor_seek, sn_crypto_stream_xchacha20_xor_wrap_seek)
   SN_EXPORT_FUNCTION(crypto_stream_xchacha20, sn_crypto_stream_xchacha20)
   SN_EXPORT_UINT32(crypto_stream_xchacha20_xor_STATEBYTES, sizeof(sn_crypto_stream_xchacha20_xor_state))
 
@@ -3895,9 +7167,11 @@ sodium_native_exports (js_env_t *env, js_value_t *exports) {
 
   SN_EXPORT_FUNCTION(crypto_stream_salsa20_xor, sn_crypto_stream_salsa20_xor)
   SN_EXPORT_FUNCTION(crypto_stream_salsa20_xor_ic, sn_crypto_stream_salsa20_xor_ic)
+  SN_EXPORT_FUNCTION(crypto_stream_salsa20_xor_parallel, sn_crypto_stream_salsa20_xor_parallel)
   SN_EXPORT_FUNCTION(crypto_stream_salsa20_xor_init, sn_crypto_stream_salsa20_xor_wrap_init)
   SN_EXPORT_FUNCTION(crypto_stream_salsa20_xor_update, sn_crypto_stream_salsa20_xor_wrap_update)
   SN_EXPORT_FUNCTION(crypto_stream_salsa20_xor_final, sn_crypto_stream_salsa20_xor_wrap_final)
+  SN_EXPORT_FUNCTION(crypto_stream_salsa20_xor_seek, sn_crypto_stream_salsa20_xor_wrap_seek)
   SN_EXPORT_UINT32(crypto_stream_salsa20_xor_STATEBYTES, sizeof(sn_crypto_stream_salsa20_xor_state))
 
   // extensions
@@ -3925,6 +7199,129 @@ sodium_native_exports (js_env_t *env, js_value_t *exports) {
   SN_EXPORT_UINT32(extension_pbkdf2_sha512_ITERATIONS_MIN, sn__extension_pbkdf2_sha512_ITERATIONS_MIN)
   SN_EXPORT_UINT64(extension_pbkdf2_sha512_BYTES_MAX, sn__extension_pbkdf2_sha512_BYTES_MAX)
 
+  // nonce sequence
+
+  SN_EXPORT_FUNCTION(extension_nonce_sequence_init, sn_extension_nonce_sequence_init)
+  SN_EXPORT_FUNCTION(extension_nonce_sequence_init_random, sn_extension_nonce_sequence_init_random)
+  SN_EXPORT_FUNCTION(extension_nonce_sequence_next, sn_extension_nonce_sequence_next)
+  SN_EXPORT_UINT32(extension_nonce_sequence_STATEBYTES, sizeof(sn__extension_nonce_sequence_state))
+  SN_EXPORT_UINT32(extension_nonce_sequence_NONCEBYTES_MAX, sn__extension_nonce_sequence_NONCEBYTES_MAX)
+
+  SN_EXPORT_FUNCTION(extension_secretstream_engine_push, sn_extension_secretstream_engine_push)
+  SN_EXPORT_FUNCTION(extension_secretstream_engine_pull, sn_extension_secretstream_engine_pull)
+  SN_EXPORT_FUNCTION(extension_secretstream_engine_push_async, sn_extension_secretstream_engine_push_async)
+  SN_EXPORT_FUNCTION(extension_secretstream_engine_pull_async, sn_extension_secretstream_engine_pull_async)
+  SN_EXPORT_UINT32(extension_secretstream_engine_FAILED, sn__extension_secretstream_engine_FAILED)
+
+  SN_EXPORT_FUNCTION(extension_secretstream_encrypt_file, sn_extension_secretstream_encrypt_file)
+  SN_EXPORT_FUNCTION(extension_secretstream_decrypt_file, sn_extension_secretstream_decrypt_file)
+  SN_EXPORT_UINT32(extension_secretstream_file_CHUNKBYTES_MAX, sn__extension_secretstream_file_CHUNKBYTES_MAX)
+
+  SN_EXPORT_FUNCTION(extension_seal_stream_init, sn_extension_seal_stream_init)
+  SN_EXPORT_FUNCTION(extension_seal_stream_push, sn_extension_seal_stream_push)
+  SN_EXPORT_FUNCTION(extension_seal_stream_final, sn_extension_seal_stream_final)
+  SN_EXPORT_FUNCTION(extension_seal_stream_open_init, sn_extension_seal_stream_open_init)
+  SN_EXPORT_FUNCTION(extension_seal_stream_pull, sn_extension_seal_stream_pull)
+  SN_EXPORT_FUNCTION(extension_seal_stream_seal_file, sn_extension_seal_stream_seal_file)
+  SN_EXPORT_FUNCTION(extension_seal_stream_open_file, sn_extension_seal_stream_open_file)
+  SN_EXPORT_UINT32(extension_seal_stream_STATEBYTES, sizeof(sn__extension_seal_stream_state))
+  SN_EXPORT_UINT32(extension_seal_stream_HEADERBYTES, sn__extension_seal_stream_HEADERBYTES)
+  SN_EXPORT_UINT32(extension_seal_stream_ABYTES, sn__extension_seal_stream_ABYTES)
+  SN_EXPORT_UINT32(extension_seal_stream_PUBLICKEYBYTES, sn__extension_seal_stream_PUBLICKEYBYTES)
+  SN_EXPORT_UINT32(extension_seal_stream_SECRETKEYBYTES, sn__extension_seal_stream_SECRETKEYBYTES)
+
+  // box cache
+
+  SN_EXPORT_FUNCTION(extension_box_cache_init, sn_extension_box_cache_init)
+  SN_EXPORT_FUNCTION(extension_box_cache_easy, sn_extension_box_cache_easy)
+  SN_EXPORT_FUNCTION(extension_box_cache_open_easy, sn_extension_box_cache_open_easy)
+  SN_EXPORT_FUNCTION(extension_box_cache_detached, sn_extension_box_cache_detached)
+  SN_EXPORT_FUNCTION(extension_box_cache_open_detached, sn_extension_box_cache_open_detached)
+  SN_EXPORT_FUNCTION(extension_box_cache_clear, sn_extension_box_cache_clear)
+  SN_EXPORT_FUNCTION(extension_box_cache_final, sn_extension_box_cache_final)
+  SN_EXPORT_UINT32(extension_box_cache_HEADERBYTES, sn__extension_box_cache_HEADERBYTES)
+  SN_EXPORT_UINT32(extension_box_cache_ENTRYBYTES, sn__extension_box_cache_ENTRYBYTES)
+
+  // keypair pool
+
+  SN_EXPORT_FUNCTION(extension_keypair_pool_init, sn_extension_keypair_pool_init)
+  SN_EXPORT_FUNCTION(extension_keypair_pool_fill, sn_extension_keypair_pool_fill)
+  SN_EXPORT_FUNCTION(extension_keypair_pool_seal, sn_extension_keypair_pool_seal)
+  SN_EXPORT_FUNCTION(extension_keypair_pool_kx_keypair, sn_extension_keypair_pool_kx_keypair)
+  SN_EXPORT_FUNCTION(extension_keypair_pool_stats, sn_extension_keypair_pool_stats)
+  SN_EXPORT_FUNCTION(extension_keypair_pool_final, sn_extension_keypair_pool_final)
+  SN_EXPORT_UINT32(extension_keypair_pool_HEADERBYTES, sn__extension_keypair_pool_HEADERBYTES)
+  SN_EXPORT_UINT32(extension_keypair_pool_KEYPAIRBYTES, sn__extension_keypair_pool_KEYPAIRBYTES)
+  SN_EXPORT_UINT32(extension_keypair_pool_STATS, sn__extension_keypair_pool_STATS)
+
+  // envelope
+
+  SN_EXPORT_FUNCTION(extension_envelope_seal, sn_extension_envelope_seal)
+  SN_EXPORT_FUNCTION(extension_envelope_seal_async, sn_extension_envelope_seal_async)
+  SN_EXPORT_FUNCTION(extension_envelope_open, sn_extension_envelope_open)
+  SN_EXPORT_FUNCTION(extension_envelope_recipients, sn_extension_envelope_recipients)
+  SN_EXPORT_UINT32(extension_envelope_HEADERBYTES, sn__extension_envelope_HEADERBYTES)
+  SN_EXPORT_UINT32(extension_envelope_ENTRYBYTES, sn__extension_envelope_ENTRYBYTES)
+  SN_EXPORT_UINT32(extension_envelope_ABYTES, sn__extension_envelope_ABYTES)
+  SN_EXPORT_UINT32(extension_envelope_RECIPIENTS_MAX, sn__extension_envelope_RECIPIENTS_MAX)
+
+  // noise
+
+  SN_EXPORT_FUNCTION(extension_noise_init, sn_extension_noise_init)
+  SN_EXPORT_FUNCTION(_extension_noise_fixed_ephemeral, sn_extension_noise_fixed_ephemeral)
+  SN_EXPORT_FUNCTION(extension_noise_turn, sn_extension_noise_turn)
+  SN_EXPORT_FUNCTION(extension_noise_overhead, sn_extension_noise_overhead)
+  SN_EXPORT_FUNCTION(extension_noise_write_message, sn_extension_noise_write_message)
+  SN_EXPORT_FUNCTION(extension_noise_read_message, sn_extension_noise_read_message)
+  SN_EXPORT_FUNCTION(extension_noise_split, sn_extension_noise_split)
+  SN_EXPORT_FUNCTION(extension_noise_handshake_hash, sn_extension_noise_handshake_hash)
+  SN_EXPORT_FUNCTION(extension_noise_remote_static, sn_extension_noise_remote_static)
+  SN_EXPORT_UINT32(extension_noise_STATEBYTES, sn__extension_noise_STATEBYTES)
+  SN_EXPORT_UINT32(extension_noise_XX, sn__extension_noise_XX)
+  SN_EXPORT_UINT32(extension_noise_IK, sn__extension_noise_IK)
+  SN_EXPORT_UINT32(extension_noise_PUBLICKEYBYTES, sn__extension_noise_PUBLICKEYBYTES)
+  SN_EXPORT_UINT32(extension_noise_SECRETKEYBYTES, sn__extension_noise_SECRETKEYBYTES)
+  SN_EXPORT_UINT32(extension_noise_HASHBYTES, sn__extension_noise_HASHBYTES)
+  SN_EXPORT_UINT32(extension_noise_KEYBYTES, sn__extension_noise_KEYBYTES)
+  SN_EXPORT_UINT32(extension_noise_MACBYTES, sn__extension_noise_MACBYTES)
+  SN_EXPORT_UINT32(extension_noise_MESSAGEBYTES_MAX, sn__extension_noise_MESSAGEBYTES_MAX)
+
+  // transport
+
+  SN_EXPORT_FUNCTION(extension_transport_init, sn_extension_transport_init)
+  SN_EXPORT_FUNCTION(extension_transport_seal, sn_extension_transport_seal)
+  SN_EXPORT_FUNCTION(extension_transport_open, sn_extension_transport_open)
+  SN_EXPORT_FUNCTION(extension_transport_open_many, sn_extension_transport_open_many)
+  SN_EXPORT_UINT32(extension_transport_STATEBYTES, sn__extension_transport_STATEBYTES)
+  SN_EXPORT_UINT32(extension_transport_KEYBYTES, sn__extension_transport_KEYBYTES)
+  SN_EXPORT_UINT32(extension_transport_HEADERBYTES, sn__extension_transport_HEADERBYTES)
+  SN_EXPORT_UINT32(extension_transport_ABYTES, sn__extension_transport_ABYTES)
+  SN_EXPORT_UINT32(extension_transport_WINDOW, sn__extension_transport_WINDOW)
+  SN_EXPORT_UINT32(extension_transport_EPOCHS_AHEAD, sn__extension_transport_EPOCHS_AHEAD)
+  SN_EXPORT_UINT32(extension_transport_FAILED, sn__extension_transport_FAILED)
+
+  // ed25519_convert
+
+  SN_EXPORT_FUNCTION(extension_ed25519_convert_cache_init, sn_extension_ed25519_convert_cache_init)
+  SN_EXPORT_FUNCTION(extension_ed25519_convert_cache_clear, sn_extension_ed25519_convert_cache_clear)
+  SN_EXPORT_UINT32(extension_ed25519_convert_HEADERBYTES, sn__extension_ed25519_convert_HEADERBYTES)
+  SN_EXPORT_UINT32(extension_ed25519_convert_ENTRYBYTES, sn__extension_ed25519_convert_ENTRYBYTES)
+
+  // ratchet
+
+  SN_EXPORT_FUNCTION(extension_ratchet_init, sn_extension_ratchet_init)
+  SN_EXPORT_FUNCTION(extension_ratchet_next, sn_extension_ratchet_next)
+  SN_EXPORT_FUNCTION(extension_ratchet_skip, sn_extension_ratchet_skip)
+  SN_EXPORT_FUNCTION(extension_ratchet_encrypt, sn_extension_ratchet_encrypt)
+  SN_EXPORT_FUNCTION(extension_ratchet_decrypt, sn_extension_ratchet_decrypt)
+  SN_EXPORT_UINT32(extension_ratchet_STATEBYTES, sn__extension_ratchet_STATEBYTES)
+  SN_EXPORT_UINT32(extension_ratchet_SKIPBYTES, sn__extension_ratchet_SKIPBYTES)
+  SN_EXPORT_UINT32(extension_ratchet_KEYBYTES, sn__extension_ratchet_KEYBYTES)
+  SN_EXPORT_UINT32(extension_ratchet_CONTEXTBYTES, sn__extension_ratchet_CONTEXTBYTES)
+  SN_EXPORT_UINT32(extension_ratchet_HEADERBYTES, sn__extension_ratchet_HEADERBYTES)
+  SN_EXPORT_UINT32(extension_ratchet_ABYTES, sn__extension_ratchet_ABYTES)
+  SN_EXPORT_UINT32(extension_ratchet_SKIP_MAX, sn__extension_ratchet_SKIP_MAX)
+
 #undef SN_EXPORT_FUNCTION_NOSCOPE
 
   return exports;
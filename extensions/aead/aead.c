@@ -0,0 +1,353 @@
+#include <string.h>
+
+#include "aead.h"
+#include "chacha20poly1305_x86.h"
+
+static const unsigned char _extension_aead_pad0[16] = { 0 };
+
+static void _extension_aead_store64_le (unsigned char *dst, uint64_t w)
+{
+  for (int i = 0; i < 8; i++) {
+    dst[i] = (unsigned char) (w >> (8 * i));
+  }
+}
+
+static void _extension_aead_finish_ad (sn__extension_aead_chacha20poly1305_ietf_state *state)
+{
+  if (state->ad_done) return;
+
+  sn__extension_poly1305_update(&state->mac, _extension_aead_pad0, (0x10 - state->adlen) & 0xf);
+  state->ad_done = 1;
+}
+
+static int _extension_aead_has_stitched (void)
+{
+#ifdef SN_AEAD_STITCHED
+  return sodium_runtime_has_avx2();
+#else
+  return 0;
+#endif
+}
+
+// run the stitched kernels over the block aligned prefix of in, returns the number of bytes consumed
+static size_t _extension_aead_stitched (sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                        unsigned char *out,
+                                        const unsigned char *in, size_t inlen,
+                                        int encrypt)
+{
+  size_t n = 0;
+
+#ifdef SN_AEAD_STITCHED
+  if (state->remainder != 0 || state->mac.leftover != 0) return 0;
+
+  if (inlen >= sn__extension_chacha20poly1305_avx512_CHUNKBYTES && sodium_runtime_has_avx512f()) {
+    n += sn__extension_chacha20poly1305_avx512(out, in, inlen, state->n, state->block_counter, state->k, &state->mac, encrypt);
+  }
+
+  if (inlen - n >= sn__extension_chacha20poly1305_avx2_CHUNKBYTES && sodium_runtime_has_avx2()) {
+    n += sn__extension_chacha20poly1305_avx2(out + n, in + n, inlen - n, state->n, state->block_counter + (uint32_t) (n / 64), state->k, &state->mac, encrypt);
+  }
+
+  state->block_counter += (uint32_t) (n / 64);
+  state->mlen += n;
+#else
+  (void) state;
+  (void) out;
+  (void) in;
+  (void) inlen;
+  (void) encrypt;
+#endif
+
+  return n;
+}
+
+int sn__extension_aead_chacha20poly1305_ietf_init (sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                                  const unsigned char *npub,
+                                                  const unsigned char *k)
+{
+  unsigned char block0[64];
+
+  memcpy(state->k, k, sizeof state->k);
+  memcpy(state->n, npub, sizeof state->n);
+
+  crypto_stream_chacha20_ietf(block0, sizeof block0, state->n, state->k);
+  sn__extension_poly1305_init(&state->mac, block0);
+  sodium_memzero(block0, sizeof block0);
+
+  state->remainder = 0;
+  state->block_counter = 1;
+  state->adlen = 0;
+  state->mlen = 0;
+  state->ad_done = 0;
+
+  return 0;
+}
+
+int sn__extension_aead_xchacha20poly1305_ietf_init (sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                                   const unsigned char *npub,
+                                                   const unsigned char *k)
+{
+  unsigned char k2[crypto_core_hchacha20_OUTPUTBYTES];
+  unsigned char npub2[crypto_stream_chacha20_ietf_NONCEBYTES] = { 0 };
+
+  crypto_core_hchacha20(k2, npub, k, NULL);
+  memcpy(npub2 + 4, npub + crypto_core_hchacha20_INPUTBYTES, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES - crypto_core_hchacha20_INPUTBYTES);
+
+  int ret = sn__extension_aead_chacha20poly1305_ietf_init(state, npub2, k2);
+  sodium_memzero(k2, sizeof k2);
+
+  return ret;
+}
+
+void sn__extension_aead_chacha20poly1305_ietf_update_ad (sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                                        const unsigned char *ad, size_t adlen)
+{
+  sn__extension_poly1305_update(&state->mac, ad, adlen);
+  state->adlen += adlen;
+}
+
+void sn__extension_aead_chacha20poly1305_ietf_xor_update (sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                                         unsigned char *out,
+                                                         const unsigned char *in, size_t inlen)
+{
+  // drain keystream left over from the previous piece
+  if (state->remainder) {
+    size_t offset = 64 - state->remainder;
+    size_t n = inlen < state->remainder ? inlen : state->remainder;
+
+    for (size_t i = 0; i < n; i++) {
+      out[i] = in[i] ^ state->next_block[offset + i];
+    }
+
+    state->remainder -= n;
+    out += n;
+    in += n;
+    inlen -= n;
+  }
+
+  size_t blocks = inlen / 64;
+
+  if (blocks) {
+    crypto_stream_chacha20_ietf_xor_ic(out, in, blocks * 64, state->n, state->block_counter, state->k);
+
+    state->block_counter += (uint32_t) blocks;
+    out += blocks * 64;
+    in += blocks * 64;
+    inlen -= blocks * 64;
+  }
+
+  if (inlen) {
+    memset(state->next_block, 0, sizeof state->next_block);
+    crypto_stream_chacha20_ietf_xor_ic(state->next_block, state->next_block, sizeof state->next_block, state->n, state->block_counter, state->k);
+    state->block_counter++;
+
+    for (size_t i = 0; i < inlen; i++) {
+      out[i] = in[i] ^ state->next_block[i];
+    }
+
+    state->remainder = 64 - inlen;
+  }
+}
+
+void sn__extension_aead_chacha20poly1305_ietf_verify_update (sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                                            const unsigned char *c, size_t clen)
+{
+  _extension_aead_finish_ad(state);
+
+  sn__extension_poly1305_update(&state->mac, c, clen);
+  state->mlen += clen;
+}
+
+void sn__extension_aead_chacha20poly1305_ietf_encrypt_update (sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                                             unsigned char *c,
+                                                             const unsigned char *m, size_t mlen)
+{
+  _extension_aead_finish_ad(state);
+
+  size_t n = _extension_aead_stitched(state, c, m, mlen, 1);
+
+  sn__extension_aead_chacha20poly1305_ietf_xor_update(state, c + n, m + n, mlen - n);
+  sn__extension_aead_chacha20poly1305_ietf_verify_update(state, c + n, mlen - n);
+}
+
+void sn__extension_aead_chacha20poly1305_ietf_decrypt_update (sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                                             unsigned char *m,
+                                                             const unsigned char *c, size_t clen)
+{
+  _extension_aead_finish_ad(state);
+
+  size_t n = _extension_aead_stitched(state, m, c, clen, 0);
+
+  sn__extension_aead_chacha20poly1305_ietf_verify_update(state, c + n, clen - n);
+  sn__extension_aead_chacha20poly1305_ietf_xor_update(state, m + n, c + n, clen - n);
+}
+
+void sn__extension_aead_chacha20poly1305_ietf_final (sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                                    unsigned char *mac)
+{
+  unsigned char slen[8];
+
+  _extension_aead_finish_ad(state);
+
+  sn__extension_poly1305_update(&state->mac, _extension_aead_pad0, (0x10 - state->mlen) & 0xf);
+
+  _extension_aead_store64_le(slen, state->adlen);
+  sn__extension_poly1305_update(&state->mac, slen, sizeof slen);
+
+  _extension_aead_store64_le(slen, state->mlen);
+  sn__extension_poly1305_update(&state->mac, slen, sizeof slen);
+
+  sn__extension_poly1305_final(&state->mac, mac);
+}
+
+int sn__extension_aead_chacha20poly1305_ietf_final_verify (sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                                          const unsigned char *mac)
+{
+  unsigned char computed_mac[crypto_aead_chacha20poly1305_ietf_ABYTES];
+
+  sn__extension_aead_chacha20poly1305_ietf_final(state, computed_mac);
+
+  int ret = crypto_verify_16(computed_mac, mac);
+  sodium_memzero(computed_mac, sizeof computed_mac);
+
+  return ret;
+}
+
+static int _extension_aead_verify_detached (sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                            const unsigned char *c, size_t clen,
+                                            const unsigned char *mac,
+                                            const unsigned char *ad, size_t adlen)
+{
+  sn__extension_aead_chacha20poly1305_ietf_update_ad(state, ad, adlen);
+  sn__extension_aead_chacha20poly1305_ietf_verify_update(state, c, clen);
+
+  int ret = sn__extension_aead_chacha20poly1305_ietf_final_verify(state, mac);
+  sodium_memzero(state, sizeof(*state));
+
+  return ret;
+}
+
+int sn__extension_aead_chacha20poly1305_ietf_verify_detached (const unsigned char *c, size_t clen,
+                                                             const unsigned char *mac,
+                                                             const unsigned char *ad, size_t adlen,
+                                                             const unsigned char *npub,
+                                                             const unsigned char *k)
+{
+  sn__extension_aead_chacha20poly1305_ietf_state state;
+  sn__extension_aead_chacha20poly1305_ietf_init(&state, npub, k);
+
+  return _extension_aead_verify_detached(&state, c, clen, mac, ad, adlen);
+}
+
+int sn__extension_aead_xchacha20poly1305_ietf_verify_detached (const unsigned char *c, size_t clen,
+                                                              const unsigned char *mac,
+                                                              const unsigned char *ad, size_t adlen,
+                                                              const unsigned char *npub,
+                                                              const unsigned char *k)
+{
+  sn__extension_aead_chacha20poly1305_ietf_state state;
+  sn__extension_aead_xchacha20poly1305_ietf_init(&state, npub, k);
+
+  return _extension_aead_verify_detached(&state, c, clen, mac, ad, adlen);
+}
+
+static void _extension_aead_encrypt_detached (sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                              unsigned char *c,
+                                              unsigned char *mac,
+                                              const unsigned char *m, size_t mlen,
+                                              const unsigned char *ad, size_t adlen)
+{
+  sn__extension_aead_chacha20poly1305_ietf_update_ad(state, ad, adlen);
+  sn__extension_aead_chacha20poly1305_ietf_encrypt_update(state, c, m, mlen);
+  sn__extension_aead_chacha20poly1305_ietf_final(state, mac);
+
+  sodium_memzero(state, sizeof(*state));
+}
+
+static int _extension_aead_decrypt_detached (sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                             unsigned char *m,
+                                             const unsigned char *c, size_t clen,
+                                             const unsigned char *mac,
+                                             const unsigned char *ad, size_t adlen)
+{
+  sn__extension_aead_chacha20poly1305_ietf_update_ad(state, ad, adlen);
+  sn__extension_aead_chacha20poly1305_ietf_decrypt_update(state, m, c, clen);
+
+  int ret = sn__extension_aead_chacha20poly1305_ietf_final_verify(state, mac);
+  sodium_memzero(state, sizeof(*state));
+
+  // never hand out plaintext that failed authentication
+  if (ret != 0) sodium_memzero(m, clen);
+
+  return ret;
+}
+
+int sn__extension_aead_chacha20poly1305_ietf_encrypt_detached (unsigned char *c,
+                                                              unsigned char *mac,
+                                                              const unsigned char *m, size_t mlen,
+                                                              const unsigned char *ad, size_t adlen,
+                                                              const unsigned char *npub,
+                                                              const unsigned char *k)
+{
+  if (!_extension_aead_has_stitched()) {
+    return crypto_aead_chacha20poly1305_ietf_encrypt_detached(c, mac, NULL, m, mlen, ad, adlen, NULL, npub, k);
+  }
+
+  sn__extension_aead_chacha20poly1305_ietf_state state;
+  sn__extension_aead_chacha20poly1305_ietf_init(&state, npub, k);
+  _extension_aead_encrypt_detached(&state, c, mac, m, mlen, ad, adlen);
+
+  return 0;
+}
+
+int sn__extension_aead_chacha20poly1305_ietf_decrypt_detached (unsigned char *m,
+                                                              const unsigned char *c, size_t clen,
+                                                              const unsigned char *mac,
+                                                              const unsigned char *ad, size_t adlen,
+                                                              const unsigned char *npub,
+                                                              const unsigned char *k)
+{
+  if (!_extension_aead_has_stitched()) {
+    return crypto_aead_chacha20poly1305_ietf_decrypt_detached(m, NULL, c, clen, mac, ad, adlen, npub, k);
+  }
+
+  sn__extension_aead_chacha20poly1305_ietf_state state;
+  sn__extension_aead_chacha20poly1305_ietf_init(&state, npub, k);
+
+  return _extension_aead_decrypt_detached(&state, m, c, clen, mac, ad, adlen);
+}
+
+int sn__extension_aead_xchacha20poly1305_ietf_encrypt_detached (unsigned char *c,
+                                                               unsigned char *mac,
+                                                               const unsigned char *m, size_t mlen,
+                                                               const unsigned char *ad, size_t adlen,
+                                                               const unsigned char *npub,
+                                                               const unsigned char *k)
+{
+  if (!_extension_aead_has_stitched()) {
+    return crypto_aead_xchacha20poly1305_ietf_encrypt_detached(c, mac, NULL, m, mlen, ad, adlen, NULL, npub, k);
+  }
+
+  sn__extension_aead_chacha20poly1305_ietf_state state;
+  sn__extension_aead_xchacha20poly1305_ietf_init(&state, npub, k);
+  _extension_aead_encrypt_detached(&state, c, mac, m, mlen, ad, adlen);
+
+  return 0;
+}
+
+int sn__extension_aead_xchacha20poly1305_ietf_decrypt_detached (unsigned char *m,
+                                                               const unsigned char *c, size_t clen,
+                                                               const unsigned char *mac,
+                                                               const unsigned char *ad, size_t adlen,
+                                                               const unsigned char *npub,
+                                                               const unsigned char *k)
+{
+  if (!_extension_aead_has_stitched()) {
+    return crypto_aead_xchacha20poly1305_ietf_decrypt_detached(m, NULL, c, clen, mac, ad, adlen, npub, k);
+  }
+
+  sn__extension_aead_chacha20poly1305_ietf_state state;
+  sn__extension_aead_xchacha20poly1305_ietf_init(&state, npub, k);
+
+  return _extension_aead_decrypt_detached(&state, m, c, clen, mac, ad, adlen);
+}
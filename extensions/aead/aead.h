@@ -0,0 +1,126 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <sodium.h>
+
+#include "../poly1305/poly1305.h"
+
+/*
+  Incremental (X)ChaCha20-Poly1305-IETF.
+
+  Produces exactly the same output as crypto_aead_(x)chacha20poly1305_ietf_*
+  but lets the caller feed the additional data and the message in arbitrary
+  pieces, so segmented buffers can be processed without joining them first.
+
+  All additional data must be passed before the first message byte.
+
+  On x86-64 with AVX2 or AVX-512F, block aligned runs of the message go
+  through a stitched kernel that authenticates while it encrypts, see
+  chacha20poly1305_x86.h.
+*/
+
+#define sn__extension_aead_chacha20poly1305_ietf_KEYBYTES crypto_aead_chacha20poly1305_ietf_KEYBYTES
+
+#define sn__extension_aead_chacha20poly1305_ietf_NPUBBYTES crypto_aead_chacha20poly1305_ietf_NPUBBYTES
+
+#define sn__extension_aead_xchacha20poly1305_ietf_NPUBBYTES crypto_aead_xchacha20poly1305_ietf_NPUBBYTES
+
+#define sn__extension_aead_chacha20poly1305_ietf_ABYTES crypto_aead_chacha20poly1305_ietf_ABYTES
+
+typedef struct sn__extension_aead_chacha20poly1305_ietf_state {
+  sn__extension_poly1305_state mac;
+  unsigned char k[crypto_stream_chacha20_ietf_KEYBYTES];
+  unsigned char n[crypto_stream_chacha20_ietf_NONCEBYTES];
+  unsigned char next_block[64];
+  size_t remainder;
+  uint32_t block_counter;
+  uint64_t adlen;
+  uint64_t mlen;
+  int ad_done;
+} sn__extension_aead_chacha20poly1305_ietf_state;
+
+int sn__extension_aead_chacha20poly1305_ietf_init(sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                                 const unsigned char *npub,
+                                                 const unsigned char *k);
+
+int sn__extension_aead_xchacha20poly1305_ietf_init(sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                                  const unsigned char *npub,
+                                                  const unsigned char *k);
+
+// authenticate a piece of additional data
+void sn__extension_aead_chacha20poly1305_ietf_update_ad(sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                                       const unsigned char *ad, size_t adlen);
+
+// encrypt a piece of the message and authenticate the resulting ciphertext, c may alias m
+void sn__extension_aead_chacha20poly1305_ietf_encrypt_update(sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                                            unsigned char *c,
+                                                            const unsigned char *m, size_t mlen);
+
+// authenticate and decrypt a piece of ciphertext, m may alias c
+void sn__extension_aead_chacha20poly1305_ietf_decrypt_update(sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                                            unsigned char *m,
+                                                            const unsigned char *c, size_t clen);
+
+// authenticate a piece of ciphertext without decrypting it
+void sn__extension_aead_chacha20poly1305_ietf_verify_update(sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                                           const unsigned char *c, size_t clen);
+
+// apply the keystream only, used to decrypt once the tag has been verified
+void sn__extension_aead_chacha20poly1305_ietf_xor_update(sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                                        unsigned char *out,
+                                                        const unsigned char *in, size_t inlen);
+
+void sn__extension_aead_chacha20poly1305_ietf_final(sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                                   unsigned char *mac);
+
+// returns 0 if mac matches the authenticated data, -1 otherwise
+int sn__extension_aead_chacha20poly1305_ietf_final_verify(sn__extension_aead_chacha20poly1305_ietf_state *state,
+                                                         const unsigned char *mac);
+
+// check the tag over ad and c without decrypting, returns 0 if valid, -1 otherwise
+int sn__extension_aead_chacha20poly1305_ietf_verify_detached(const unsigned char *c, size_t clen,
+                                                            const unsigned char *mac,
+                                                            const unsigned char *ad, size_t adlen,
+                                                            const unsigned char *npub,
+                                                            const unsigned char *k);
+
+int sn__extension_aead_xchacha20poly1305_ietf_verify_detached(const unsigned char *c, size_t clen,
+                                                             const unsigned char *mac,
+                                                             const unsigned char *ad, size_t adlen,
+                                                             const unsigned char *npub,
+                                                             const unsigned char *k);
+
+// single pass equivalents of crypto_aead_(x)chacha20poly1305_ietf_{encrypt,decrypt}_detached,
+// on failure m is zeroed and -1 is returned
+int sn__extension_aead_chacha20poly1305_ietf_encrypt_detached(unsigned char *c,
+                                                             unsigned char *mac,
+                                                             const unsigned char *m, size_t mlen,
+                                                             const unsigned char *ad, size_t adlen,
+                                                             const unsigned char *npub,
+                                                             const unsigned char *k);
+
+int sn__extension_aead_chacha20poly1305_ietf_decrypt_detached(unsigned char *m,
+                                                             const unsigned char *c, size_t clen,
+                                                             const unsigned char *mac,
+                                                             const unsigned char *ad, size_t adlen,
+                                                             const unsigned char *npub,
+                                                             const unsigned char *k);
+
+int sn__extension_aead_xchacha20poly1305_ietf_encrypt_detached(unsigned char *c,
+                                                              unsigned char *mac,
+                                                              const unsigned char *m, size_t mlen,
+                                                              const unsigned char *ad, size_t adlen,
+                                                              const unsigned char *npub,
+                                                              const unsigned char *k);
+
+int sn__extension_aead_xchacha20poly1305_ietf_decrypt_detached(unsigned char *m,
+                                                              const unsigned char *c, size_t clen,
+                                                              const unsigned char *mac,
+                                                              const unsigned char *ad, size_t adlen,
+                                                              const unsigned char *npub,
+                                                              const unsigned char *k);
+
+#ifdef __cplusplus
+};
+#endif
@@ -0,0 +1,277 @@
+#include "chacha20poly1305_x86.h"
+
+#ifdef SN_AEAD_STITCHED
+
+#include "../poly1305/poly1305_avx2.h"
+
+static inline uint32_t _stitched_load32_le (const unsigned char *src)
+{
+  return (uint32_t) src[0] | ((uint32_t) src[1] << 8) | ((uint32_t) src[2] << 16) | ((uint32_t) src[3] << 24);
+}
+
+#define SN_STITCHED_POLY1305(p, m, groups) \
+  if (m) { \
+    for (int _g = 0; _g < (groups); _g++) _extension_poly1305_avx2_update(p, (m) + 64 * _g); \
+    (m) += 64 * (groups); \
+  }
+
+#define SN_STITCHED_STATE(name) \
+  const uint32_t name[16] = { \
+    0x61707865, 0x3320646e, 0x79622d32, 0x6b206574, \
+    _stitched_load32_le(k + 0), _stitched_load32_le(k + 4), _stitched_load32_le(k + 8), _stitched_load32_le(k + 12), \
+    _stitched_load32_le(k + 16), _stitched_load32_le(k + 20), _stitched_load32_le(k + 24), _stitched_load32_le(k + 28), \
+    0, _stitched_load32_le(n + 0), _stitched_load32_le(n + 4), _stitched_load32_le(n + 8) \
+  };
+
+#define SN_STITCHED_QUARTERROUND(add, xor, rotl16, rotl12, rotl8, rotl7, a, b, c, d) \
+  a = add(a, b); \
+  d = rotl16(xor(d, a)); \
+  c = add(c, d); \
+  b = rotl12(xor(b, c)); \
+  a = add(a, b); \
+  d = rotl8(xor(d, a)); \
+  c = add(c, d); \
+  b = rotl7(xor(b, c));
+
+#define SN_STITCHED_TRANSPOSE4(unpacklo32, unpackhi32, unpacklo64, unpackhi64, a, b, c, d) \
+  { \
+    t0 = unpacklo32(a, b); \
+    t1 = unpackhi32(a, b); \
+    t2 = unpacklo32(c, d); \
+    t3 = unpackhi32(c, d); \
+    a = unpacklo64(t0, t2); \
+    b = unpackhi64(t0, t2); \
+    c = unpacklo64(t1, t3); \
+    d = unpackhi64(t1, t3); \
+  }
+
+/*
+  AVX2, 8 blocks per iteration
+*/
+
+#define SN_AVX2_ROTL(x, bits) _mm256_or_si256(_mm256_slli_epi32(x, bits), _mm256_srli_epi32(x, 32 - (bits)))
+#define SN_AVX2_ROTL16(x) _mm256_shuffle_epi8(x, rot16)
+#define SN_AVX2_ROTL12(x) SN_AVX2_ROTL(x, 12)
+#define SN_AVX2_ROTL8(x) _mm256_shuffle_epi8(x, rot8)
+#define SN_AVX2_ROTL7(x) SN_AVX2_ROTL(x, 7)
+
+#define SN_AVX2_QUARTERROUND(a, b, c, d) \
+  SN_STITCHED_QUARTERROUND(_mm256_add_epi32, _mm256_xor_si256, SN_AVX2_ROTL16, SN_AVX2_ROTL12, SN_AVX2_ROTL8, SN_AVX2_ROTL7, a, b, c, d)
+
+#define SN_AVX2_TRANSPOSE4(a, b, c, d) \
+  SN_STITCHED_TRANSPOSE4(_mm256_unpacklo_epi32, _mm256_unpackhi_epi32, _mm256_unpacklo_epi64, _mm256_unpackhi_epi64, a, b, c, d)
+
+#define SN_AVX2_XOR(offset, ks) \
+  _mm256_storeu_si256((__m256i *) (out + (offset)), _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (in + (offset))), ks));
+
+// blocks k and k + 4 from the transposed rows
+#define SN_AVX2_OUTPUT(k, a, b, c, d) \
+  SN_AVX2_XOR(64 * (k), _mm256_permute2x128_si256(a, b, 0x20)) \
+  SN_AVX2_XOR(64 * (k) + 32, _mm256_permute2x128_si256(c, d, 0x20)) \
+  SN_AVX2_XOR(64 * ((k) + 4), _mm256_permute2x128_si256(a, b, 0x31)) \
+  SN_AVX2_XOR(64 * ((k) + 4) + 32, _mm256_permute2x128_si256(c, d, 0x31))
+
+__attribute__((target("avx2"))) size_t
+sn__extension_chacha20poly1305_avx2 (unsigned char *out, const unsigned char *in, size_t len,
+                                     const unsigned char *n, uint32_t ic, const unsigned char *k,
+                                     sn__extension_poly1305_state *mac, int encrypt)
+{
+  const __m256i rot16 = _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+                                        13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+  const __m256i rot8 = _mm256_set_epi8(14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+                                       14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3);
+  const __m256i lanes = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+
+  SN_STITCHED_STATE(s)
+
+  sn_poly1305_avx2_t p;
+  _extension_poly1305_avx2_start(&p, mac);
+
+  const unsigned char *pending = NULL;
+  size_t processed = 0;
+
+  while (len - processed >= sn__extension_chacha20poly1305_avx2_CHUNKBYTES) {
+    // encryption authenticates the previous chunk's output, decryption the current input
+    const unsigned char *pm = encrypt ? pending : in;
+
+    __m256i x0 = _mm256_set1_epi32((int) s[0]), x1 = _mm256_set1_epi32((int) s[1]);
+    __m256i x2 = _mm256_set1_epi32((int) s[2]), x3 = _mm256_set1_epi32((int) s[3]);
+    __m256i x4 = _mm256_set1_epi32((int) s[4]), x5 = _mm256_set1_epi32((int) s[5]);
+    __m256i x6 = _mm256_set1_epi32((int) s[6]), x7 = _mm256_set1_epi32((int) s[7]);
+    __m256i x8 = _mm256_set1_epi32((int) s[8]), x9 = _mm256_set1_epi32((int) s[9]);
+    __m256i x10 = _mm256_set1_epi32((int) s[10]), x11 = _mm256_set1_epi32((int) s[11]);
+    __m256i x12 = _mm256_add_epi32(_mm256_set1_epi32((int) ic), lanes);
+    __m256i x13 = _mm256_set1_epi32((int) s[13]), x14 = _mm256_set1_epi32((int) s[14]);
+    __m256i x15 = _mm256_set1_epi32((int) s[15]);
+    const __m256i ctr = x12;
+
+    for (int i = 0; i < 10; i++) {
+      SN_AVX2_QUARTERROUND(x0, x4, x8, x12)
+      SN_AVX2_QUARTERROUND(x1, x5, x9, x13)
+      SN_AVX2_QUARTERROUND(x2, x6, x10, x14)
+      SN_AVX2_QUARTERROUND(x3, x7, x11, x15)
+      SN_STITCHED_POLY1305(&p, pm, i < 8)
+      SN_AVX2_QUARTERROUND(x0, x5, x10, x15)
+      SN_AVX2_QUARTERROUND(x1, x6, x11, x12)
+      SN_AVX2_QUARTERROUND(x2, x7, x8, x13)
+      SN_AVX2_QUARTERROUND(x3, x4, x9, x14)
+    }
+
+    x0 = _mm256_add_epi32(x0, _mm256_set1_epi32((int) s[0]));
+    x1 = _mm256_add_epi32(x1, _mm256_set1_epi32((int) s[1]));
+    x2 = _mm256_add_epi32(x2, _mm256_set1_epi32((int) s[2]));
+    x3 = _mm256_add_epi32(x3, _mm256_set1_epi32((int) s[3]));
+    x4 = _mm256_add_epi32(x4, _mm256_set1_epi32((int) s[4]));
+    x5 = _mm256_add_epi32(x5, _mm256_set1_epi32((int) s[5]));
+    x6 = _mm256_add_epi32(x6, _mm256_set1_epi32((int) s[6]));
+    x7 = _mm256_add_epi32(x7, _mm256_set1_epi32((int) s[7]));
+    x8 = _mm256_add_epi32(x8, _mm256_set1_epi32((int) s[8]));
+    x9 = _mm256_add_epi32(x9, _mm256_set1_epi32((int) s[9]));
+    x10 = _mm256_add_epi32(x10, _mm256_set1_epi32((int) s[10]));
+    x11 = _mm256_add_epi32(x11, _mm256_set1_epi32((int) s[11]));
+    x12 = _mm256_add_epi32(x12, ctr);
+    x13 = _mm256_add_epi32(x13, _mm256_set1_epi32((int) s[13]));
+    x14 = _mm256_add_epi32(x14, _mm256_set1_epi32((int) s[14]));
+    x15 = _mm256_add_epi32(x15, _mm256_set1_epi32((int) s[15]));
+
+    __m256i t0, t1, t2, t3;
+    SN_AVX2_TRANSPOSE4(x0, x1, x2, x3)
+    SN_AVX2_TRANSPOSE4(x4, x5, x6, x7)
+    SN_AVX2_TRANSPOSE4(x8, x9, x10, x11)
+    SN_AVX2_TRANSPOSE4(x12, x13, x14, x15)
+
+    SN_AVX2_OUTPUT(0, x0, x4, x8, x12)
+    SN_AVX2_OUTPUT(1, x1, x5, x9, x13)
+    SN_AVX2_OUTPUT(2, x2, x6, x10, x14)
+    SN_AVX2_OUTPUT(3, x3, x7, x11, x15)
+
+    pending = out;
+    ic += 8;
+    in += sn__extension_chacha20poly1305_avx2_CHUNKBYTES;
+    out += sn__extension_chacha20poly1305_avx2_CHUNKBYTES;
+    processed += sn__extension_chacha20poly1305_avx2_CHUNKBYTES;
+  }
+
+  if (encrypt) SN_STITCHED_POLY1305(&p, pending, 8)
+
+  _extension_poly1305_avx2_finish(&p, mac);
+
+  return processed;
+}
+
+/*
+  AVX-512F, 16 blocks per iteration
+*/
+
+#define SN_AVX512_ROTL16(x) _mm512_rol_epi32(x, 16)
+#define SN_AVX512_ROTL12(x) _mm512_rol_epi32(x, 12)
+#define SN_AVX512_ROTL8(x) _mm512_rol_epi32(x, 8)
+#define SN_AVX512_ROTL7(x) _mm512_rol_epi32(x, 7)
+
+#define SN_AVX512_QUARTERROUND(a, b, c, d) \
+  SN_STITCHED_QUARTERROUND(_mm512_add_epi32, _mm512_xor_si512, SN_AVX512_ROTL16, SN_AVX512_ROTL12, SN_AVX512_ROTL8, SN_AVX512_ROTL7, a, b, c, d)
+
+#define SN_AVX512_TRANSPOSE4(a, b, c, d) \
+  SN_STITCHED_TRANSPOSE4(_mm512_unpacklo_epi32, _mm512_unpackhi_epi32, _mm512_unpacklo_epi64, _mm512_unpackhi_epi64, a, b, c, d)
+
+#define SN_AVX512_XOR(offset, ks) \
+  _mm512_storeu_si512((void *) (out + (offset)), _mm512_xor_si512(_mm512_loadu_si512((const void *) (in + (offset))), ks));
+
+// blocks k, k + 4, k + 8 and k + 12 from the transposed rows
+#define SN_AVX512_OUTPUT(k, a, b, c, d) \
+  { \
+    t0 = _mm512_shuffle_i32x4(a, b, 0x88); \
+    t1 = _mm512_shuffle_i32x4(a, b, 0xdd); \
+    t2 = _mm512_shuffle_i32x4(c, d, 0x88); \
+    t3 = _mm512_shuffle_i32x4(c, d, 0xdd); \
+    SN_AVX512_XOR(64 * (k), _mm512_shuffle_i32x4(t0, t2, 0x88)) \
+    SN_AVX512_XOR(64 * ((k) + 4), _mm512_shuffle_i32x4(t1, t3, 0x88)) \
+    SN_AVX512_XOR(64 * ((k) + 8), _mm512_shuffle_i32x4(t0, t2, 0xdd)) \
+    SN_AVX512_XOR(64 * ((k) + 12), _mm512_shuffle_i32x4(t1, t3, 0xdd)) \
+  }
+
+__attribute__((target("avx512f"))) size_t
+sn__extension_chacha20poly1305_avx512 (unsigned char *out, const unsigned char *in, size_t len,
+                                       const unsigned char *n, uint32_t ic, const unsigned char *k,
+                                       sn__extension_poly1305_state *mac, int encrypt)
+{
+  const __m512i lanes = _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+
+  SN_STITCHED_STATE(s)
+
+  sn_poly1305_avx2_t p;
+  _extension_poly1305_avx2_start(&p, mac);
+
+  const unsigned char *pending = NULL;
+  size_t processed = 0;
+
+  while (len - processed >= sn__extension_chacha20poly1305_avx512_CHUNKBYTES) {
+    const unsigned char *pm = encrypt ? pending : in;
+
+    __m512i x0 = _mm512_set1_epi32((int) s[0]), x1 = _mm512_set1_epi32((int) s[1]);
+    __m512i x2 = _mm512_set1_epi32((int) s[2]), x3 = _mm512_set1_epi32((int) s[3]);
+    __m512i x4 = _mm512_set1_epi32((int) s[4]), x5 = _mm512_set1_epi32((int) s[5]);
+    __m512i x6 = _mm512_set1_epi32((int) s[6]), x7 = _mm512_set1_epi32((int) s[7]);
+    __m512i x8 = _mm512_set1_epi32((int) s[8]), x9 = _mm512_set1_epi32((int) s[9]);
+    __m512i x10 = _mm512_set1_epi32((int) s[10]), x11 = _mm512_set1_epi32((int) s[11]);
+    __m512i x12 = _mm512_add_epi32(_mm512_set1_epi32((int) ic), lanes);
+    __m512i x13 = _mm512_set1_epi32((int) s[13]), x14 = _mm512_set1_epi32((int) s[14]);
+    __m512i x15 = _mm512_set1_epi32((int) s[15]);
+    const __m512i ctr = x12;
+
+    for (int i = 0; i < 10; i++) {
+      SN_AVX512_QUARTERROUND(x0, x4, x8, x12)
+      SN_AVX512_QUARTERROUND(x1, x5, x9, x13)
+      SN_AVX512_QUARTERROUND(x2, x6, x10, x14)
+      SN_AVX512_QUARTERROUND(x3, x7, x11, x15)
+      SN_STITCHED_POLY1305(&p, pm, i < 8)
+      SN_AVX512_QUARTERROUND(x0, x5, x10, x15)
+      SN_AVX512_QUARTERROUND(x1, x6, x11, x12)
+      SN_AVX512_QUARTERROUND(x2, x7, x8, x13)
+      SN_AVX512_QUARTERROUND(x3, x4, x9, x14)
+      SN_STITCHED_POLY1305(&p, pm, i < 8)
+    }
+
+    x0 = _mm512_add_epi32(x0, _mm512_set1_epi32((int) s[0]));
+    x1 = _mm512_add_epi32(x1, _mm512_set1_epi32((int) s[1]));
+    x2 = _mm512_add_epi32(x2, _mm512_set1_epi32((int) s[2]));
+    x3 = _mm512_add_epi32(x3, _mm512_set1_epi32((int) s[3]));
+    x4 = _mm512_add_epi32(x4, _mm512_set1_epi32((int) s[4]));
+    x5 = _mm512_add_epi32(x5, _mm512_set1_epi32((int) s[5]));
+    x6 = _mm512_add_epi32(x6, _mm512_set1_epi32((int) s[6]));
+    x7 = _mm512_add_epi32(x7, _mm512_set1_epi32((int) s[7]));
+    x8 = _mm512_add_epi32(x8, _mm512_set1_epi32((int) s[8]));
+    x9 = _mm512_add_epi32(x9, _mm512_set1_epi32((int) s[9]));
+    x10 = _mm512_add_epi32(x10, _mm512_set1_epi32((int) s[10]));
+    x11 = _mm512_add_epi32(x11, _mm512_set1_epi32((int) s[11]));
+    x12 = _mm512_add_epi32(x12, ctr);
+    x13 = _mm512_add_epi32(x13, _mm512_set1_epi32((int) s[13]));
+    x14 = _mm512_add_epi32(x14, _mm512_set1_epi32((int) s[14]));
+    x15 = _mm512_add_epi32(x15, _mm512_set1_epi32((int) s[15]));
+
+    __m512i t0, t1, t2, t3;
+    SN_AVX512_TRANSPOSE4(x0, x1, x2, x3)
+    SN_AVX512_TRANSPOSE4(x4, x5, x6, x7)
+    SN_AVX512_TRANSPOSE4(x8, x9, x10, x11)
+    SN_AVX512_TRANSPOSE4(x12, x13, x14, x15)
+
+    SN_AVX512_OUTPUT(0, x0, x4, x8, x12)
+    SN_AVX512_OUTPUT(1, x1, x5, x9, x13)
+    SN_AVX512_OUTPUT(2, x2, x6, x10, x14)
+    SN_AVX512_OUTPUT(3, x3, x7, x11, x15)
+
+    pending = out;
+    ic += 16;
+    in += sn__extension_chacha20poly1305_avx512_CHUNKBYTES;
+    out += sn__extension_chacha20poly1305_avx512_CHUNKBYTES;
+    processed += sn__extension_chacha20poly1305_avx512_CHUNKBYTES;
+  }
+
+  if (encrypt) SN_STITCHED_POLY1305(&p, pending, 16)
+
+  _extension_poly1305_avx2_finish(&p, mac);
+
+  return processed;
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <sodium.h>
+
+#include "../poly1305/poly1305.h"
+
+/*
+  Stitched ChaCha20-Poly1305 kernels for x86-64.
+
+  Each iteration generates 8 (AVX2) or 16 (AVX-512) ChaCha20 blocks while
+  the 4-way Poly1305 accumulator absorbs the ciphertext of the same chunk
+  between the rounds, so the data is only pulled through the cache once.
+  Only whole chunks are processed, the caller handles the tail. The MAC
+  state must be block aligned on entry.
+
+  Both return the number of bytes processed.
+*/
+
+#ifdef SN_POLY1305_AVX2
+#define SN_AEAD_STITCHED 1
+
+#define sn__extension_chacha20poly1305_avx2_CHUNKBYTES 512U
+
+#define sn__extension_chacha20poly1305_avx512_CHUNKBYTES 1024U
+
+size_t sn__extension_chacha20poly1305_avx2(unsigned char *out, const unsigned char *in, size_t len,
+                                           const unsigned char *n, uint32_t ic, const unsigned char *k,
+                                           sn__extension_poly1305_state *mac, int encrypt);
+
+size_t sn__extension_chacha20poly1305_avx512(unsigned char *out, const unsigned char *in, size_t len,
+                                             const unsigned char *n, uint32_t ic, const unsigned char *k,
+                                             sn__extension_poly1305_state *mac, int encrypt);
+#endif
+
+#ifdef __cplusplus
+};
+#endif
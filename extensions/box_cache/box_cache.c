@@ -0,0 +1,186 @@
+#include <string.h>
+
+#include "box_cache.h"
+#include "../x25519/x25519.h"
+
+#define _extension_box_cache_NIL UINT32_MAX
+
+_Static_assert(sizeof(sn__extension_box_cache) == sn__extension_box_cache_HEADERBYTES, "box cache header size");
+_Static_assert(sizeof(sn__extension_box_cache_entry) == sn__extension_box_cache_ENTRYBYTES, "box cache entry size");
+
+uint32_t
+sn__extension_box_cache_capacity (size_t len) {
+  if (len < sn__extension_box_cache_HEADERBYTES + sn__extension_box_cache_ENTRYBYTES) return 0;
+
+  size_t capacity = (len - sn__extension_box_cache_HEADERBYTES) / sn__extension_box_cache_ENTRYBYTES;
+
+  return capacity >= _extension_box_cache_NIL ? _extension_box_cache_NIL - 1 : (uint32_t) capacity;
+}
+
+static void
+_extension_box_cache_reset (sn__extension_box_cache *cache) {
+  sodium_memzero(cache->entries, (size_t) cache->capacity * sizeof(sn__extension_box_cache_entry));
+
+  for (uint32_t i = 0; i < cache->capacity; i++) {
+    cache->entries[i].bucket = _extension_box_cache_NIL;
+  }
+
+  cache->size = 0;
+  cache->head = _extension_box_cache_NIL;
+  cache->tail = _extension_box_cache_NIL;
+}
+
+int
+sn__extension_box_cache_init (sn__extension_box_cache *cache, size_t len, const unsigned char *sk) {
+  uint32_t capacity = sn__extension_box_cache_capacity(len);
+
+  if (capacity == 0) return -1;
+  if ((len - sn__extension_box_cache_HEADERBYTES) % sn__extension_box_cache_ENTRYBYTES != 0) return -1;
+
+  memcpy(cache->sk, sk, sizeof(cache->sk));
+  randombytes_buf(cache->hash_key, sizeof(cache->hash_key));
+  cache->capacity = capacity;
+
+  _extension_box_cache_reset(cache);
+
+  return 0;
+}
+
+static uint32_t
+_extension_box_cache_bucket (sn__extension_box_cache *cache, const unsigned char *pk) {
+  unsigned char h[crypto_shorthash_BYTES];
+  crypto_shorthash(h, pk, crypto_box_PUBLICKEYBYTES, cache->hash_key);
+
+  uint64_t v = 0;
+  for (int i = 0; i < 8; i++) v |= (uint64_t) h[i] << (8 * i);
+
+  return (uint32_t) (v % cache->capacity);
+}
+
+// entries past size are unused, so a live index is always below size
+static inline int
+_extension_box_cache_live (sn__extension_box_cache *cache, uint32_t i) {
+  return i < cache->size;
+}
+
+static inline int
+_extension_box_cache_link (sn__extension_box_cache *cache, uint32_t i) {
+  return i == _extension_box_cache_NIL || i < cache->size;
+}
+
+static int
+_extension_box_cache_unlink (sn__extension_box_cache *cache, uint32_t i) {
+  sn__extension_box_cache_entry *e = &cache->entries[i];
+
+  if (!_extension_box_cache_link(cache, e->prev) || !_extension_box_cache_link(cache, e->next)) return -1;
+
+  if (e->prev != _extension_box_cache_NIL) cache->entries[e->prev].next = e->next;
+  else cache->head = e->next;
+
+  if (e->next != _extension_box_cache_NIL) cache->entries[e->next].prev = e->prev;
+  else cache->tail = e->prev;
+
+  return 0;
+}
+
+static void
+_extension_box_cache_push_front (sn__extension_box_cache *cache, uint32_t i) {
+  sn__extension_box_cache_entry *e = &cache->entries[i];
+
+  e->prev = _extension_box_cache_NIL;
+  e->next = cache->head;
+
+  if (cache->head != _extension_box_cache_NIL) cache->entries[cache->head].prev = i;
+  cache->head = i;
+
+  if (cache->tail == _extension_box_cache_NIL) cache->tail = i;
+}
+
+static int
+_extension_box_cache_unchain (sn__extension_box_cache *cache, uint32_t i) {
+  uint32_t *link = &cache->entries[_extension_box_cache_bucket(cache, cache->entries[i].pk)].bucket;
+
+  for (uint32_t n = 0; *link != i; n++) {
+    if (n >= cache->size || !_extension_box_cache_live(cache, *link)) return -1;
+    link = &cache->entries[*link].chain;
+  }
+
+  *link = cache->entries[i].chain;
+
+  return 0;
+}
+
+// the header and links live in caller memory, anything out of range drops every peer
+static int
+_extension_box_cache_sane (sn__extension_box_cache *cache) {
+  if (cache->size > cache->capacity) return 0;
+  if (cache->size == 0) return cache->head == _extension_box_cache_NIL && cache->tail == _extension_box_cache_NIL;
+
+  return _extension_box_cache_live(cache, cache->head) && _extension_box_cache_live(cache, cache->tail);
+}
+
+const unsigned char *
+sn__extension_box_cache_get (sn__extension_box_cache *cache, const unsigned char *pk) {
+  if (!_extension_box_cache_sane(cache)) _extension_box_cache_reset(cache);
+
+  uint32_t b = _extension_box_cache_bucket(cache, pk);
+  uint32_t n = 0;
+
+  for (uint32_t i = cache->entries[b].bucket; i != _extension_box_cache_NIL; i = cache->entries[i].chain) {
+    if (n++ >= cache->size || !_extension_box_cache_live(cache, i)) {
+      _extension_box_cache_reset(cache);
+      break;
+    }
+
+    if (memcmp(cache->entries[i].pk, pk, crypto_box_PUBLICKEYBYTES) != 0) continue;
+
+    if (cache->head != i) {
+      if (_extension_box_cache_unlink(cache, i) != 0) {
+        _extension_box_cache_reset(cache);
+        break;
+      }
+
+      _extension_box_cache_push_front(cache, i);
+    }
+
+    return cache->entries[i].k;
+  }
+
+  unsigned char k[crypto_box_BEFORENMBYTES];
+  if (sn__extension_x25519_box_beforenm(k, pk, cache->sk) != 0) return NULL;
+
+  uint32_t i = _extension_box_cache_NIL;
+
+  if (cache->size == cache->capacity) {
+    i = cache->tail;
+
+    if (_extension_box_cache_unlink(cache, i) != 0 || _extension_box_cache_unchain(cache, i) != 0) {
+      _extension_box_cache_reset(cache);
+    }
+  }
+
+  if (cache->size < cache->capacity) i = cache->size++;
+
+  sn__extension_box_cache_entry *e = &cache->entries[i];
+
+  memcpy(e->pk, pk, sizeof(e->pk));
+  memcpy(e->k, k, sizeof(e->k));
+  sodium_memzero(k, sizeof(k));
+
+  e->chain = cache->entries[b].bucket;
+  cache->entries[b].bucket = i;
+
+  _extension_box_cache_push_front(cache, i);
+
+  return e->k;
+}
+
+void
+sn__extension_box_cache_clear (sn__extension_box_cache *cache) {
+  _extension_box_cache_reset(cache);
+}
+
+void
+sn__extension_box_cache_final (sn__extension_box_cache *cache) {
+  sodium_memzero(cache, sn__extension_box_cache_HEADERBYTES + (size_t) cache->capacity * sn__extension_box_cache_ENTRYBYTES);
+}
@@ -0,0 +1,69 @@
+#ifndef SN_EXTENSION_BOX_CACHE_H
+#define SN_EXTENSION_BOX_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <sodium.h>
+
+/*
+  Shared key cache for crypto_box.
+
+  Holds one local secret key and the crypto_box_beforenm keys it shares
+  with the most recently used peers, so talking to a known peer skips the
+  X25519 scalar multiplication and the HSalsa20 derivation. The cache
+  stands in for the secret key: it is keyed by the peer public key, and
+  distinct local keys use distinct caches.
+
+  The cache lives in a caller provided buffer of
+  HEADERBYTES + capacity * ENTRYBYTES bytes, which should come from
+  sodium_malloc since it holds the secret key and every shared key. The
+  buffer must be 8 byte aligned. Peers are found through a table of
+  chains indexed by a keyed SipHash of the public key, and the least
+  recently used peer is evicted once the cache is full.
+*/
+
+#define sn__extension_box_cache_HEADERBYTES 64U
+
+#define sn__extension_box_cache_ENTRYBYTES 80U
+
+typedef struct sn__extension_box_cache_entry {
+  unsigned char pk[crypto_box_PUBLICKEYBYTES];
+  unsigned char k[crypto_box_BEFORENMBYTES];
+  uint32_t prev;
+  uint32_t next;
+  uint32_t chain;
+  uint32_t bucket;
+} sn__extension_box_cache_entry;
+
+typedef struct sn__extension_box_cache {
+  unsigned char sk[crypto_box_SECRETKEYBYTES];
+  unsigned char hash_key[crypto_shorthash_KEYBYTES];
+  uint32_t capacity;
+  uint32_t size;
+  uint32_t head;
+  uint32_t tail;
+  sn__extension_box_cache_entry entries[];
+} sn__extension_box_cache;
+
+// capacity for a buffer of len bytes, 0 if it cannot hold a single entry
+uint32_t sn__extension_box_cache_capacity(size_t len);
+
+// returns -1 if len has no room for an entry or is not HEADERBYTES + n * ENTRYBYTES
+int sn__extension_box_cache_init(sn__extension_box_cache *cache, size_t len, const unsigned char *sk);
+
+// shared key for pk, computed and inserted on a miss, NULL if pk is rejected by crypto_box_beforenm
+const unsigned char *sn__extension_box_cache_get(sn__extension_box_cache *cache, const unsigned char *pk);
+
+// forget every peer but keep the secret key
+void sn__extension_box_cache_clear(sn__extension_box_cache *cache);
+
+// wipe the whole cache, including the secret key
+void sn__extension_box_cache_final(sn__extension_box_cache *cache);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
@@ -0,0 +1,141 @@
+#include <string.h>
+
+#include "box_seal_many.h"
+#include "../x25519/x25519.h"
+
+static void
+_extension_box_seal_many_nonce (unsigned char *nonce, const unsigned char *epk, const unsigned char *pk) {
+  crypto_generichash_state st;
+
+  crypto_generichash_init(&st, NULL, 0U, crypto_box_NONCEBYTES);
+  crypto_generichash_update(&st, epk, crypto_box_PUBLICKEYBYTES);
+  crypto_generichash_update(&st, pk, crypto_box_PUBLICKEYBYTES);
+  crypto_generichash_final(&st, nonce, crypto_box_NONCEBYTES);
+}
+
+// checks the tag of box i against key j without writing the message, keeps the shared key in k
+static int
+_extension_box_seal_many_verify (const sn__extension_box_seal_many_batch *batch,
+                                 size_t i, size_t j,
+                                 unsigned char *nonce, unsigned char *k)
+{
+  const unsigned char *box = batch->c + batch->offsets[i];
+  const size_t clen = batch->offsets[i + 1] - batch->offsets[i];
+  const unsigned char *pk = batch->pks + j * crypto_box_PUBLICKEYBYTES;
+
+  if (sn__extension_x25519_box_beforenm(k, box, batch->sks + j * crypto_box_SECRETKEYBYTES) != 0) return -1;
+
+  _extension_box_seal_many_nonce(nonce, box, pk);
+
+  unsigned char block0[crypto_onetimeauth_poly1305_KEYBYTES];
+  crypto_stream_xsalsa20(block0, sizeof(block0), nonce, k);
+
+  const unsigned char *mac = box + crypto_box_PUBLICKEYBYTES;
+  int res = crypto_onetimeauth_poly1305_verify(mac, mac + crypto_box_MACBYTES,
+                                               clen - crypto_box_SEALBYTES, block0);
+
+  sodium_memzero(block0, sizeof(block0));
+
+  return res;
+}
+
+static unsigned char *
+_extension_box_seal_many_message (const sn__extension_box_seal_many_batch *batch, size_t i) {
+  return batch->m + (batch->offsets[i] - batch->offsets[0]) - i * crypto_box_SEALBYTES;
+}
+
+size_t
+sn__extension_box_seal_many_open (const sn__extension_box_seal_many_batch *batch,
+                                  size_t lane, size_t lanes)
+{
+  unsigned char nonce[crypto_box_NONCEBYTES];
+  unsigned char k[crypto_box_BEFORENMBYTES];
+  size_t opened = 0;
+
+  for (size_t i = lane; i < batch->n; i += lanes) {
+    const unsigned char *box = batch->c + batch->offsets[i];
+    const size_t clen = batch->offsets[i + 1] - batch->offsets[i];
+
+    batch->matches[i] = sn__extension_box_seal_many_FAILED;
+    batch->lengths[i] = sn__extension_box_seal_many_FAILED;
+
+    for (size_t j = 0; j < batch->keys; j++) {
+      if (sn__extension_x25519_box_beforenm(k, box, batch->sks + j * crypto_box_SECRETKEYBYTES) != 0) break;
+
+      _extension_box_seal_many_nonce(nonce, box, batch->pks + j * crypto_box_PUBLICKEYBYTES);
+
+      if (crypto_box_open_easy_afternm(_extension_box_seal_many_message(batch, i),
+                                       box + crypto_box_PUBLICKEYBYTES, clen - crypto_box_PUBLICKEYBYTES,
+                                       nonce, k) != 0) continue;
+
+      batch->matches[i] = (uint32_t) j;
+      batch->lengths[i] = (uint32_t) (clen - crypto_box_SEALBYTES);
+      opened++;
+      break;
+    }
+  }
+
+  sodium_memzero(k, sizeof(k));
+
+  return opened;
+}
+
+void
+sn__extension_box_seal_many_match (const sn__extension_box_seal_many_batch *batch,
+                                   size_t lane, size_t lanes)
+{
+  unsigned char nonce[crypto_box_NONCEBYTES];
+
+  for (size_t i = 0; i < batch->n; i++) {
+    const size_t slot = i * lanes + lane;
+    unsigned char *k = batch->shared + slot * crypto_box_BEFORENMBYTES;
+
+    batch->found[slot] = sn__extension_box_seal_many_FAILED;
+
+    for (size_t j = lane; j < batch->keys; j += lanes) {
+      if (_extension_box_seal_many_verify(batch, i, j, nonce, k) != 0) continue;
+
+      batch->found[slot] = (uint32_t) j;
+      break;
+    }
+  }
+}
+
+size_t
+sn__extension_box_seal_many_resolve (const sn__extension_box_seal_many_batch *batch, size_t lanes) {
+  unsigned char nonce[crypto_box_NONCEBYTES];
+  size_t opened = 0;
+
+  for (size_t i = 0; i < batch->n; i++) {
+    const unsigned char *box = batch->c + batch->offsets[i];
+    const size_t clen = batch->offsets[i + 1] - batch->offsets[i];
+
+    uint32_t match = sn__extension_box_seal_many_FAILED;
+    size_t slot = 0;
+
+    for (size_t lane = 0; lane < lanes; lane++) {
+      uint32_t j = batch->found[i * lanes + lane];
+      if (j < match) {
+        match = j;
+        slot = i * lanes + lane;
+      }
+    }
+
+    batch->matches[i] = sn__extension_box_seal_many_FAILED;
+    batch->lengths[i] = sn__extension_box_seal_many_FAILED;
+
+    if (match == sn__extension_box_seal_many_FAILED) continue;
+
+    _extension_box_seal_many_nonce(nonce, box, batch->pks + (size_t) match * crypto_box_PUBLICKEYBYTES);
+
+    if (crypto_box_open_easy_afternm(_extension_box_seal_many_message(batch, i),
+                                     box + crypto_box_PUBLICKEYBYTES, clen - crypto_box_PUBLICKEYBYTES,
+                                     nonce, batch->shared + slot * crypto_box_BEFORENMBYTES) != 0) continue;
+
+    batch->matches[i] = match;
+    batch->lengths[i] = (uint32_t) (clen - crypto_box_SEALBYTES);
+    opened++;
+  }
+
+  return opened;
+}
@@ -0,0 +1,67 @@
+#ifndef SN_EXTENSION_BOX_SEAL_MANY_H
+#define SN_EXTENSION_BOX_SEAL_MANY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <sodium.h>
+
+/*
+  Trial decryption of sealed boxes.
+
+  Opens n sealed boxes against a table of recipient keypairs, recording
+  for every box the index of the keypair that opened it and the length of
+  the message. Box i covers `c[offsets[i]..offsets[i + 1]]` and its message
+  is written packed, at `(offsets[i] - offsets[0]) - i * SEALBYTES` in m.
+
+  Every attempt is a single crypto_box_beforenm of the ephemeral key with
+  the recipient scalar, and a box is only decrypted by the attempt whose
+  tag verifies, so the shared key is never derived twice for one pair.
+
+  A batch splits over `lanes` pool threads by box, lane k taking the boxes
+  with `i % lanes == k`. A batch with fewer boxes than lanes splits over the key
+  table instead: lanes only verify, each recording the first key of its
+  share that matches, and sn__extension_box_seal_many_resolve then picks
+  the lowest matching key per box and decrypts with the shared key the
+  lane kept.
+*/
+
+#define sn__extension_box_seal_many_FAILED 0xffffffffU
+
+#define sn__extension_box_seal_many_THREADS_MAX 64U
+
+// attempts below which a scan is not worth another lane
+#define sn__extension_box_seal_many_ATTEMPTS_MIN 64U
+
+typedef struct sn__extension_box_seal_many_batch {
+  size_t n;
+  const uint32_t *offsets;
+  const unsigned char *c;
+  unsigned char *m;
+  size_t keys;
+  const unsigned char *pks;
+  const unsigned char *sks;
+  uint32_t *matches;
+  uint32_t *lengths;
+  // key split only, n * lanes match slots and n * lanes * crypto_box_BEFORENMBYTES shared keys
+  uint32_t *found;
+  unsigned char *shared;
+} sn__extension_box_seal_many_batch;
+
+// returns the number of boxes in this lane that were opened
+size_t sn__extension_box_seal_many_open(const sn__extension_box_seal_many_batch *batch,
+                                        size_t lane, size_t lanes);
+
+void sn__extension_box_seal_many_match(const sn__extension_box_seal_many_batch *batch,
+                                       size_t lane, size_t lanes);
+
+// returns the number of boxes opened, after every lane has run sn__extension_box_seal_many_match
+size_t sn__extension_box_seal_many_resolve(const sn__extension_box_seal_many_batch *batch, size_t lanes);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
@@ -0,0 +1,434 @@
+#include <string.h>
+
+#include "ed25519_convert.h"
+
+#define _extension_ed25519_convert_NIL UINT32_MAX
+
+_Static_assert(sizeof(sn__extension_ed25519_convert_cache) == sn__extension_ed25519_convert_HEADERBYTES, "ed25519 convert cache header size");
+_Static_assert(sizeof(sn__extension_ed25519_convert_entry) == sn__extension_ed25519_convert_ENTRYBYTES, "ed25519 convert cache entry size");
+
+static void
+_extension_ed25519_convert_one (unsigned char *x25519_pk, const unsigned char *ed25519_pk, size_t *failures) {
+  if (crypto_sign_ed25519_pk_to_curve25519(x25519_pk, ed25519_pk) == 0) return;
+
+  memset(x25519_pk, 0, crypto_scalarmult_curve25519_BYTES);
+  (*failures)++;
+}
+
+#if defined(__SIZEOF_INT128__)
+
+// radix 2^51, limbs may run a couple of bits over between reductions
+typedef uint64_t _extension_ed25519_convert_fe[5];
+
+#define _extension_ed25519_convert_MASK ((UINT64_C(1) << 51) - 1)
+
+static uint64_t
+_extension_ed25519_convert_load64 (const unsigned char *src) {
+  uint64_t w = 0;
+
+  for (int i = 7; i >= 0; i--) w = (w << 8) | src[i];
+
+  return w;
+}
+
+static void
+_extension_ed25519_convert_store64 (unsigned char *dst, uint64_t w) {
+  for (int i = 0; i < 8; i++, w >>= 8) dst[i] = (unsigned char) w;
+}
+
+// y < p, so bit 255 (the sign of x) is simply dropped
+static void
+_extension_ed25519_convert_frombytes (_extension_ed25519_convert_fe h, const unsigned char *s) {
+  h[0] = _extension_ed25519_convert_load64(s) & _extension_ed25519_convert_MASK;
+  h[1] = (_extension_ed25519_convert_load64(s + 6) >> 3) & _extension_ed25519_convert_MASK;
+  h[2] = (_extension_ed25519_convert_load64(s + 12) >> 6) & _extension_ed25519_convert_MASK;
+  h[3] = (_extension_ed25519_convert_load64(s + 19) >> 1) & _extension_ed25519_convert_MASK;
+  h[4] = (_extension_ed25519_convert_load64(s + 24) >> 12) & _extension_ed25519_convert_MASK;
+}
+
+static void
+_extension_ed25519_convert_mul (_extension_ed25519_convert_fe h, const _extension_ed25519_convert_fe f, const _extension_ed25519_convert_fe g) {
+  typedef unsigned __int128 u128;
+
+  const uint64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+  const uint64_t g0 = g[0], g1 = g[1], g2 = g[2], g3 = g[3], g4 = g[4];
+  const uint64_t g1_19 = 19 * g1, g2_19 = 19 * g2, g3_19 = 19 * g3, g4_19 = 19 * g4;
+
+  u128 r0 = (u128) f0 * g0 + (u128) f1 * g4_19 + (u128) f2 * g3_19 + (u128) f3 * g2_19 + (u128) f4 * g1_19;
+  u128 r1 = (u128) f0 * g1 + (u128) f1 * g0 + (u128) f2 * g4_19 + (u128) f3 * g3_19 + (u128) f4 * g2_19;
+  u128 r2 = (u128) f0 * g2 + (u128) f1 * g1 + (u128) f2 * g0 + (u128) f3 * g4_19 + (u128) f4 * g3_19;
+  u128 r3 = (u128) f0 * g3 + (u128) f1 * g2 + (u128) f2 * g1 + (u128) f3 * g0 + (u128) f4 * g4_19;
+  u128 r4 = (u128) f0 * g4 + (u128) f1 * g3 + (u128) f2 * g2 + (u128) f3 * g1 + (u128) f4 * g0;
+
+  r1 += (uint64_t) (r0 >> 51);
+  r2 += (uint64_t) (r1 >> 51);
+  r3 += (uint64_t) (r2 >> 51);
+  r4 += (uint64_t) (r3 >> 51);
+
+  uint64_t h0 = (uint64_t) r0 & _extension_ed25519_convert_MASK;
+  uint64_t h1 = (uint64_t) r1 & _extension_ed25519_convert_MASK;
+
+  h0 += 19 * (uint64_t) (r4 >> 51);
+  h1 += h0 >> 51;
+
+  h[0] = h0 & _extension_ed25519_convert_MASK;
+  h[1] = h1;
+  h[2] = (uint64_t) r2 & _extension_ed25519_convert_MASK;
+  h[3] = (uint64_t) r3 & _extension_ed25519_convert_MASK;
+  h[4] = (uint64_t) r4 & _extension_ed25519_convert_MASK;
+}
+
+static void
+_extension_ed25519_convert_sqr_n (_extension_ed25519_convert_fe h, const _extension_ed25519_convert_fe f, int n) {
+  _extension_ed25519_convert_mul(h, f, f);
+
+  for (int i = 1; i < n; i++) _extension_ed25519_convert_mul(h, h, h);
+}
+
+// z^(p - 2), the usual addition chain
+static void
+_extension_ed25519_convert_invert (_extension_ed25519_convert_fe out, const _extension_ed25519_convert_fe z) {
+  _extension_ed25519_convert_fe z2, z9, z11, z2_5_0, z2_10_0, z2_20_0, z2_50_0, z2_100_0, t;
+
+  _extension_ed25519_convert_sqr_n(z2, z, 1);
+  _extension_ed25519_convert_sqr_n(t, z2, 2);
+  _extension_ed25519_convert_mul(z9, t, z);
+  _extension_ed25519_convert_mul(z11, z9, z2);
+  _extension_ed25519_convert_sqr_n(t, z11, 1);
+  _extension_ed25519_convert_mul(z2_5_0, t, z9);
+  _extension_ed25519_convert_sqr_n(t, z2_5_0, 5);
+  _extension_ed25519_convert_mul(z2_10_0, t, z2_5_0);
+  _extension_ed25519_convert_sqr_n(t, z2_10_0, 10);
+  _extension_ed25519_convert_mul(z2_20_0, t, z2_10_0);
+  _extension_ed25519_convert_sqr_n(t, z2_20_0, 20);
+  _extension_ed25519_convert_mul(t, t, z2_20_0);
+  _extension_ed25519_convert_sqr_n(t, t, 10);
+  _extension_ed25519_convert_mul(z2_50_0, t, z2_10_0);
+  _extension_ed25519_convert_sqr_n(t, z2_50_0, 50);
+  _extension_ed25519_convert_mul(z2_100_0, t, z2_50_0);
+  _extension_ed25519_convert_sqr_n(t, z2_100_0, 100);
+  _extension_ed25519_convert_mul(t, t, z2_100_0);
+  _extension_ed25519_convert_sqr_n(t, t, 50);
+  _extension_ed25519_convert_mul(t, t, z2_50_0);
+  _extension_ed25519_convert_sqr_n(t, t, 5);
+  _extension_ed25519_convert_mul(out, t, z11);
+}
+
+static void
+_extension_ed25519_convert_carry (uint64_t t[5], int fold) {
+  t[1] += t[0] >> 51;
+  t[0] &= _extension_ed25519_convert_MASK;
+  t[2] += t[1] >> 51;
+  t[1] &= _extension_ed25519_convert_MASK;
+  t[3] += t[2] >> 51;
+  t[2] &= _extension_ed25519_convert_MASK;
+  t[4] += t[3] >> 51;
+  t[3] &= _extension_ed25519_convert_MASK;
+  if (fold) t[0] += 19 * (t[4] >> 51);
+  t[4] &= _extension_ed25519_convert_MASK;
+}
+
+static void
+_extension_ed25519_convert_tobytes (unsigned char *s, const _extension_ed25519_convert_fe h) {
+  uint64_t t[5] = {h[0], h[1], h[2], h[3], h[4]};
+
+  _extension_ed25519_convert_carry(t, 1);
+  _extension_ed25519_convert_carry(t, 1);
+
+  // t < 2^255, add 19 so that t >= p carries into bit 255, then take 2^255 - 19 back off
+  t[0] += 19;
+  _extension_ed25519_convert_carry(t, 1);
+
+  t[0] += (UINT64_C(1) << 51) - 19;
+  t[1] += (UINT64_C(1) << 51) - 1;
+  t[2] += (UINT64_C(1) << 51) - 1;
+  t[3] += (UINT64_C(1) << 51) - 1;
+  t[4] += (UINT64_C(1) << 51) - 1;
+  _extension_ed25519_convert_carry(t, 0);
+
+  _extension_ed25519_convert_store64(s, t[0] | (t[1] << 51));
+  _extension_ed25519_convert_store64(s + 8, (t[1] >> 13) | (t[2] << 38));
+  _extension_ed25519_convert_store64(s + 16, (t[2] >> 26) | (t[3] << 25));
+  _extension_ed25519_convert_store64(s + 24, (t[3] >> 39) | (t[4] << 12));
+}
+
+// y >= p is read modulo p by the conversion but rejected by crypto_core_ed25519_is_valid_point
+static int
+_extension_ed25519_convert_is_canonical (const unsigned char *s) {
+  if ((s[31] & 0x7f) != 0x7f) return 1;
+
+  for (int i = 30; i > 0; i--) {
+    if (s[i] != 0xff) return 1;
+  }
+
+  return s[0] < 0xed;
+}
+
+typedef struct _extension_ed25519_convert_batch {
+  size_t n;
+  size_t index[SN_ED25519_CONVERT_BATCH];
+  _extension_ed25519_convert_fe num[SN_ED25519_CONVERT_BATCH];
+  _extension_ed25519_convert_fe den[SN_ED25519_CONVERT_BATCH];
+  _extension_ed25519_convert_fe acc[SN_ED25519_CONVERT_BATCH];
+} _extension_ed25519_convert_batch;
+
+// u = (1 + y) / (1 - y) for the whole batch with a single inversion, 1 - y is never 0 for a valid point
+static void
+_extension_ed25519_convert_flush (_extension_ed25519_convert_batch *batch, unsigned char *x25519_pks) {
+  _extension_ed25519_convert_fe inv, u;
+
+  memcpy(batch->acc[0], batch->den[0], sizeof(batch->acc[0]));
+
+  for (size_t i = 1; i < batch->n; i++) {
+    _extension_ed25519_convert_mul(batch->acc[i], batch->acc[i - 1], batch->den[i]);
+  }
+
+  _extension_ed25519_convert_invert(inv, batch->acc[batch->n - 1]);
+
+  for (size_t i = batch->n - 1; i > 0; i--) {
+    // inv is 1 / (den[0] * .. * den[i]) here
+    _extension_ed25519_convert_mul(u, inv, batch->acc[i - 1]);
+    _extension_ed25519_convert_mul(inv, inv, batch->den[i]);
+    _extension_ed25519_convert_mul(u, u, batch->num[i]);
+    _extension_ed25519_convert_tobytes(x25519_pks + batch->index[i] * crypto_scalarmult_curve25519_BYTES, u);
+  }
+
+  _extension_ed25519_convert_mul(u, inv, batch->num[0]);
+  _extension_ed25519_convert_tobytes(x25519_pks + batch->index[0] * crypto_scalarmult_curve25519_BYTES, u);
+
+  batch->n = 0;
+}
+
+size_t
+sn__extension_ed25519_convert_range (unsigned char *x25519_pks, const unsigned char *ed25519_pks,
+                                     const unsigned char *skip, size_t from, size_t to) {
+  _extension_ed25519_convert_batch batch;
+  size_t failures = 0;
+
+  batch.n = 0;
+
+  for (size_t i = from; i < to; i++) {
+    if (skip != NULL && skip[i]) continue;
+
+    unsigned char *x25519_pk = x25519_pks + i * crypto_scalarmult_curve25519_BYTES;
+    const unsigned char *ed25519_pk = ed25519_pks + i * crypto_sign_ed25519_PUBLICKEYBYTES;
+
+    if (!_extension_ed25519_convert_is_canonical(ed25519_pk)) {
+      _extension_ed25519_convert_one(x25519_pk, ed25519_pk, &failures);
+      continue;
+    }
+
+    if (!crypto_core_ed25519_is_valid_point(ed25519_pk)) {
+      memset(x25519_pk, 0, crypto_scalarmult_curve25519_BYTES);
+      failures++;
+      continue;
+    }
+
+    _extension_ed25519_convert_fe y;
+    _extension_ed25519_convert_frombytes(y, ed25519_pk);
+
+    size_t k = batch.n++;
+
+    batch.index[k] = i;
+    batch.num[k][0] = 1 + y[0];
+    batch.den[k][0] = 2 * ((UINT64_C(1) << 51) - 19) + 1 - y[0];
+
+    for (int j = 1; j < 5; j++) {
+      batch.num[k][j] = y[j];
+      batch.den[k][j] = 2 * ((UINT64_C(1) << 51) - 1) - y[j];
+    }
+
+    if (batch.n == SN_ED25519_CONVERT_BATCH) _extension_ed25519_convert_flush(&batch, x25519_pks);
+  }
+
+  if (batch.n > 0) _extension_ed25519_convert_flush(&batch, x25519_pks);
+
+  return failures;
+}
+
+#else
+
+size_t
+sn__extension_ed25519_convert_range (unsigned char *x25519_pks, const unsigned char *ed25519_pks,
+                                     const unsigned char *skip, size_t from, size_t to) {
+  size_t failures = 0;
+
+  for (size_t i = from; i < to; i++) {
+    if (skip != NULL && skip[i]) continue;
+
+    _extension_ed25519_convert_one(x25519_pks + i * crypto_scalarmult_curve25519_BYTES, ed25519_pks + i * crypto_sign_ed25519_PUBLICKEYBYTES, &failures);
+  }
+
+  return failures;
+}
+
+#endif
+
+uint32_t
+sn__extension_ed25519_convert_cache_capacity (size_t len) {
+  if (len < sn__extension_ed25519_convert_HEADERBYTES + sn__extension_ed25519_convert_ENTRYBYTES) return 0;
+
+  size_t capacity = (len - sn__extension_ed25519_convert_HEADERBYTES) / sn__extension_ed25519_convert_ENTRYBYTES;
+
+  return capacity >= _extension_ed25519_convert_NIL ? _extension_ed25519_convert_NIL - 1 : (uint32_t) capacity;
+}
+
+int
+sn__extension_ed25519_convert_cache_init (sn__extension_ed25519_convert_cache *cache, size_t len) {
+  uint32_t capacity = sn__extension_ed25519_convert_cache_capacity(len);
+
+  if (capacity == 0) return -1;
+  if ((len - sn__extension_ed25519_convert_HEADERBYTES) % sn__extension_ed25519_convert_ENTRYBYTES != 0) return -1;
+
+  randombytes_buf(cache->hash_key, sizeof(cache->hash_key));
+  cache->capacity = capacity;
+
+  sn__extension_ed25519_convert_cache_clear(cache);
+
+  return 0;
+}
+
+static uint32_t
+_extension_ed25519_convert_bucket (sn__extension_ed25519_convert_cache *cache, const unsigned char *pk) {
+  unsigned char h[crypto_shorthash_BYTES];
+  crypto_shorthash(h, pk, crypto_sign_ed25519_PUBLICKEYBYTES, cache->hash_key);
+
+  uint64_t v = 0;
+  for (int i = 0; i < 8; i++) v |= (uint64_t) h[i] << (8 * i);
+
+  return (uint32_t) (v % cache->capacity);
+}
+
+// entries past size are unused, so a live index is always below size
+static inline int
+_extension_ed25519_convert_live (sn__extension_ed25519_convert_cache *cache, uint32_t i) {
+  return i < cache->size;
+}
+
+static inline int
+_extension_ed25519_convert_link (sn__extension_ed25519_convert_cache *cache, uint32_t i) {
+  return i == _extension_ed25519_convert_NIL || i < cache->size;
+}
+
+static int
+_extension_ed25519_convert_unlink (sn__extension_ed25519_convert_cache *cache, uint32_t i) {
+  sn__extension_ed25519_convert_entry *e = &cache->entries[i];
+
+  if (!_extension_ed25519_convert_link(cache, e->prev) || !_extension_ed25519_convert_link(cache, e->next)) return -1;
+
+  if (e->prev != _extension_ed25519_convert_NIL) cache->entries[e->prev].next = e->next;
+  else cache->head = e->next;
+
+  if (e->next != _extension_ed25519_convert_NIL) cache->entries[e->next].prev = e->prev;
+  else cache->tail = e->prev;
+
+  return 0;
+}
+
+static void
+_extension_ed25519_convert_push_front (sn__extension_ed25519_convert_cache *cache, uint32_t i) {
+  sn__extension_ed25519_convert_entry *e = &cache->entries[i];
+
+  e->prev = _extension_ed25519_convert_NIL;
+  e->next = cache->head;
+
+  if (cache->head != _extension_ed25519_convert_NIL) cache->entries[cache->head].prev = i;
+  cache->head = i;
+
+  if (cache->tail == _extension_ed25519_convert_NIL) cache->tail = i;
+}
+
+static int
+_extension_ed25519_convert_unchain (sn__extension_ed25519_convert_cache *cache, uint32_t i) {
+  uint32_t *link = &cache->entries[_extension_ed25519_convert_bucket(cache, cache->entries[i].ed25519_pk)].bucket;
+
+  for (uint32_t n = 0; *link != i; n++) {
+    if (n >= cache->size || !_extension_ed25519_convert_live(cache, *link)) return -1;
+    link = &cache->entries[*link].chain;
+  }
+
+  *link = cache->entries[i].chain;
+
+  return 0;
+}
+
+// the header and links live in caller memory, anything out of range drops every key
+static int
+_extension_ed25519_convert_sane (sn__extension_ed25519_convert_cache *cache) {
+  if (cache->size > cache->capacity) return 0;
+  if (cache->size == 0) return cache->head == _extension_ed25519_convert_NIL && cache->tail == _extension_ed25519_convert_NIL;
+
+  return _extension_ed25519_convert_live(cache, cache->head) && _extension_ed25519_convert_live(cache, cache->tail);
+}
+
+const unsigned char *
+sn__extension_ed25519_convert_cache_get (sn__extension_ed25519_convert_cache *cache, const unsigned char *ed25519_pk) {
+  if (!_extension_ed25519_convert_sane(cache)) sn__extension_ed25519_convert_cache_clear(cache);
+
+  uint32_t b = _extension_ed25519_convert_bucket(cache, ed25519_pk);
+  uint32_t n = 0;
+
+  for (uint32_t i = cache->entries[b].bucket; i != _extension_ed25519_convert_NIL; i = cache->entries[i].chain) {
+    if (n++ >= cache->size || !_extension_ed25519_convert_live(cache, i)) {
+      sn__extension_ed25519_convert_cache_clear(cache);
+      break;
+    }
+
+    if (memcmp(cache->entries[i].ed25519_pk, ed25519_pk, crypto_sign_ed25519_PUBLICKEYBYTES) != 0) continue;
+
+    if (cache->head != i) {
+      if (_extension_ed25519_convert_unlink(cache, i) != 0) {
+        sn__extension_ed25519_convert_cache_clear(cache);
+        break;
+      }
+
+      _extension_ed25519_convert_push_front(cache, i);
+    }
+
+    return cache->entries[i].x25519_pk;
+  }
+
+  return NULL;
+}
+
+void
+sn__extension_ed25519_convert_cache_put (sn__extension_ed25519_convert_cache *cache,
+                                         const unsigned char *ed25519_pk, const unsigned char *x25519_pk) {
+  if (!_extension_ed25519_convert_sane(cache)) sn__extension_ed25519_convert_cache_clear(cache);
+
+  uint32_t b = _extension_ed25519_convert_bucket(cache, ed25519_pk);
+  uint32_t i = _extension_ed25519_convert_NIL;
+
+  if (cache->size == cache->capacity) {
+    i = cache->tail;
+
+    if (_extension_ed25519_convert_unlink(cache, i) != 0 || _extension_ed25519_convert_unchain(cache, i) != 0) {
+      sn__extension_ed25519_convert_cache_clear(cache);
+    }
+  }
+
+  if (cache->size < cache->capacity) i = cache->size++;
+
+  sn__extension_ed25519_convert_entry *e = &cache->entries[i];
+
+  memcpy(e->ed25519_pk, ed25519_pk, sizeof(e->ed25519_pk));
+  memcpy(e->x25519_pk, x25519_pk, sizeof(e->x25519_pk));
+
+  e->chain = cache->entries[b].bucket;
+  cache->entries[b].bucket = i;
+
+  _extension_ed25519_convert_push_front(cache, i);
+}
+
+void
+sn__extension_ed25519_convert_cache_clear (sn__extension_ed25519_convert_cache *cache) {
+  memset(cache->entries, 0, (size_t) cache->capacity * sizeof(sn__extension_ed25519_convert_entry));
+
+  for (uint32_t i = 0; i < cache->capacity; i++) {
+    cache->entries[i].bucket = _extension_ed25519_convert_NIL;
+  }
+
+  cache->size = 0;
+  cache->head = _extension_ed25519_convert_NIL;
+  cache->tail = _extension_ed25519_convert_NIL;
+}
@@ -0,0 +1,83 @@
+#ifndef SN_EXTENSION_ED25519_CONVERT_H
+#define SN_EXTENSION_ED25519_CONVERT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <sodium.h>
+
+/*
+  Batched Ed25519 to X25519 public key conversion.
+
+  crypto_sign_ed25519_pk_to_curve25519 validates the point (small order,
+  decompression and main subgroup) and then computes u = (1 + y) / (1 - y)
+  with one field inversion. Here every key is validated the same way by
+  crypto_core_ed25519_is_valid_point, and the inversions of up to BATCH
+  keys are shared with Montgomery's trick, so a batch costs one inversion
+  and three multiplications per key. Non-canonical encodings, which the
+  two validations treat differently, and builds without 128 bit integers
+  take the libsodium call one key at a time, so results always match it.
+
+  The cache maps Ed25519 keys to their converted X25519 keys for the most
+  recently used peers, in a caller provided buffer of
+  HEADERBYTES + capacity * ENTRYBYTES bytes, which must be 8 byte aligned.
+  It has the chains, keyed SipHash and LRU eviction of the box cache and
+  only ever holds keys that converted.
+*/
+
+#if defined(__SIZEOF_INT128__)
+#define SN_ED25519_CONVERT_BATCH 64U
+#else
+#define SN_ED25519_CONVERT_BATCH 1U
+#endif
+
+#define sn__extension_ed25519_convert_HEADERBYTES 32U
+
+#define sn__extension_ed25519_convert_ENTRYBYTES 80U
+
+typedef struct sn__extension_ed25519_convert_entry {
+  unsigned char ed25519_pk[crypto_sign_ed25519_PUBLICKEYBYTES];
+  unsigned char x25519_pk[crypto_scalarmult_curve25519_BYTES];
+  uint32_t prev;
+  uint32_t next;
+  uint32_t chain;
+  uint32_t bucket;
+} sn__extension_ed25519_convert_entry;
+
+typedef struct sn__extension_ed25519_convert_cache {
+  unsigned char hash_key[crypto_shorthash_KEYBYTES];
+  uint32_t capacity;
+  uint32_t size;
+  uint32_t head;
+  uint32_t tail;
+  sn__extension_ed25519_convert_entry entries[];
+} sn__extension_ed25519_convert_cache;
+
+// converts the keys in [from, to) whose skip byte is 0 (skip may be NULL), failed keys are
+// left all zero, returns the number that failed
+size_t sn__extension_ed25519_convert_range(unsigned char *x25519_pks, const unsigned char *ed25519_pks,
+                                           const unsigned char *skip, size_t from, size_t to);
+
+// capacity for a buffer of len bytes, 0 if it cannot hold a single entry
+uint32_t sn__extension_ed25519_convert_cache_capacity(size_t len);
+
+// returns -1 if len has no room for an entry or is not HEADERBYTES + n * ENTRYBYTES
+int sn__extension_ed25519_convert_cache_init(sn__extension_ed25519_convert_cache *cache, size_t len);
+
+// converted key for ed25519_pk, marking it most recently used, NULL on a miss
+const unsigned char *sn__extension_ed25519_convert_cache_get(sn__extension_ed25519_convert_cache *cache,
+                                                             const unsigned char *ed25519_pk);
+
+// ed25519_pk must not be cached yet, evicts the least recently used key once full
+void sn__extension_ed25519_convert_cache_put(sn__extension_ed25519_convert_cache *cache,
+                                             const unsigned char *ed25519_pk, const unsigned char *x25519_pk);
+
+void sn__extension_ed25519_convert_cache_clear(sn__extension_ed25519_convert_cache *cache);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
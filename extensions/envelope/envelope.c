@@ -0,0 +1,122 @@
+#include <string.h>
+
+#include "envelope.h"
+#include "../x25519/x25519.h"
+
+static const unsigned char _extension_envelope_body_nonce[crypto_aead_xchacha20poly1305_ietf_NPUBBYTES] = {0};
+
+static void
+_extension_envelope_nonce (unsigned char *nonce, const unsigned char *epk, const unsigned char *pk) {
+  crypto_generichash_state st;
+
+  crypto_generichash_init(&st, NULL, 0U, crypto_secretbox_NONCEBYTES);
+  crypto_generichash_update(&st, epk, crypto_box_PUBLICKEYBYTES);
+  crypto_generichash_update(&st, pk, crypto_box_PUBLICKEYBYTES);
+  crypto_generichash_final(&st, nonce, crypto_secretbox_NONCEBYTES);
+}
+
+void
+sn__extension_envelope_header (unsigned char *header, const unsigned char *epk, uint32_t n) {
+  memcpy(header, epk, crypto_box_PUBLICKEYBYTES);
+
+  header[crypto_box_PUBLICKEYBYTES + 0] = (unsigned char) n;
+  header[crypto_box_PUBLICKEYBYTES + 1] = (unsigned char) (n >> 8);
+  header[crypto_box_PUBLICKEYBYTES + 2] = (unsigned char) (n >> 16);
+  header[crypto_box_PUBLICKEYBYTES + 3] = (unsigned char) (n >> 24);
+}
+
+size_t
+sn__extension_envelope_wrap (const sn__extension_envelope_wrap_batch *batch,
+                             size_t lane, size_t lanes)
+{
+  unsigned char nonce[crypto_secretbox_NONCEBYTES];
+  unsigned char k[crypto_box_BEFORENMBYTES];
+  size_t failures = 0;
+
+  for (size_t i = lane; i < batch->n; i += lanes) {
+    const unsigned char *pk = batch->pks + i * crypto_box_PUBLICKEYBYTES;
+    unsigned char *entry = batch->entries + i * sn__extension_envelope_ENTRYBYTES;
+
+    if (sn__extension_x25519_box_beforenm(k, pk, batch->esk) != 0) {
+      failures++;
+      continue;
+    }
+
+    _extension_envelope_nonce(nonce, batch->epk, pk);
+
+    crypto_secretbox_easy(entry, batch->ck, crypto_secretbox_KEYBYTES, nonce, k);
+  }
+
+  sodium_memzero(k, sizeof(k));
+
+  return failures;
+}
+
+int
+sn__extension_envelope_seal_body (unsigned char *c, size_t hlen,
+                                  const unsigned char *m, unsigned long long mlen,
+                                  const unsigned char *ck)
+{
+  return crypto_aead_xchacha20poly1305_ietf_encrypt(c + hlen, NULL, m, mlen, c, hlen, NULL,
+                                                    _extension_envelope_body_nonce, ck);
+}
+
+uint32_t
+sn__extension_envelope_recipients (const unsigned char *c, unsigned long long clen) {
+  if (clen < sn__extension_envelope_HEADERBYTES + sn__extension_envelope_ABYTES) return 0;
+
+  const unsigned char *count = c + crypto_box_PUBLICKEYBYTES;
+  uint32_t n = (uint32_t) count[0] | (uint32_t) count[1] << 8 | (uint32_t) count[2] << 16 | (uint32_t) count[3] << 24;
+
+  if (n == 0 || n > sn__extension_envelope_RECIPIENTS_MAX) return 0;
+  if (clen < sn__extension_envelope_HEADERBYTES + (unsigned long long) n * sn__extension_envelope_ENTRYBYTES + sn__extension_envelope_ABYTES) return 0;
+
+  return n;
+}
+
+int64_t
+sn__extension_envelope_open (unsigned char *m,
+                             const unsigned char *c, unsigned long long clen,
+                             uint32_t hint,
+                             const unsigned char *pk, const unsigned char *sk)
+{
+  uint32_t n = sn__extension_envelope_recipients(c, clen);
+  if (n == 0) return -1;
+
+  unsigned char k[crypto_box_BEFORENMBYTES];
+  if (sn__extension_x25519_box_beforenm(k, c, sk) != 0) return -1;
+
+  unsigned char nonce[crypto_secretbox_NONCEBYTES];
+  _extension_envelope_nonce(nonce, c, pk);
+
+  const unsigned char *entries = c + sn__extension_envelope_HEADERBYTES;
+  const size_t hlen = sn__extension_envelope_HEADERBYTES + (size_t) n * sn__extension_envelope_ENTRYBYTES;
+
+  unsigned char ck[crypto_secretbox_KEYBYTES];
+  int64_t index = -1;
+
+  if (hint < n && crypto_secretbox_open_easy(ck, entries + (size_t) hint * sn__extension_envelope_ENTRYBYTES,
+                                             sn__extension_envelope_ENTRYBYTES, nonce, k) == 0) {
+    index = hint;
+  }
+
+  for (uint32_t i = 0; index < 0 && i < n; i++) {
+    if (i == hint) continue;
+
+    if (crypto_secretbox_open_easy(ck, entries + (size_t) i * sn__extension_envelope_ENTRYBYTES,
+                                   sn__extension_envelope_ENTRYBYTES, nonce, k) == 0) {
+      index = i;
+    }
+  }
+
+  sodium_memzero(k, sizeof(k));
+
+  if (index >= 0 && crypto_aead_xchacha20poly1305_ietf_decrypt(m, NULL, NULL, c + hlen, clen - hlen, c, hlen,
+                                                              _extension_envelope_body_nonce, ck) != 0) {
+    index = -1;
+  }
+
+  sodium_memzero(ck, sizeof(ck));
+
+  return index;
+}
@@ -0,0 +1,84 @@
+#ifndef SN_EXTENSION_ENVELOPE_H
+#define SN_EXTENSION_ENVELOPE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <sodium.h>
+
+/*
+  Multi-recipient envelopes.
+
+  The payload is encrypted once with XChaCha20-Poly1305 under a random
+  content key, and the content key is wrapped for every recipient:
+
+    epk || count (u32le) || count * (secretbox(ck)) || aead(m, ad = header)
+
+  Every envelope has its own ephemeral X25519 keypair, shared by all the
+  recipients, so entry i is crypto_secretbox_easy of the content key under
+  crypto_box_beforenm(pk_i, esk) with the nonce blake2b(epk || pk_i), the
+  same derivation as crypto_box_seal. The content key is never reused, so
+  the body uses an all zero nonce.
+
+  Wrapping is one scalar multiplication per recipient and a batch of
+  recipients splits over `lanes` pool threads, lane k taking the
+  recipients with `i % lanes == k`. Opening is a single scalar multiplication, as the
+  ephemeral key and our own public key give the same shared key and nonce
+  for every entry: the hinted entry is tried first and the others are
+  only scanned if it does not open.
+
+  Like sealed boxes, envelopes do not authenticate the sender, and any
+  recipient holds the content key and could write another body under the
+  same header.
+*/
+
+#define sn__extension_envelope_HEADERBYTES (crypto_box_PUBLICKEYBYTES + 4U)
+
+#define sn__extension_envelope_ENTRYBYTES (crypto_secretbox_KEYBYTES + crypto_secretbox_MACBYTES)
+
+#define sn__extension_envelope_ABYTES crypto_aead_xchacha20poly1305_ietf_ABYTES
+
+#define sn__extension_envelope_RECIPIENTS_MAX 65536U
+
+#define sn__extension_envelope_THREADS_MAX 64U
+
+// recipients below which wrapping is not worth another lane
+#define sn__extension_envelope_RECIPIENTS_PER_THREAD_MIN 32U
+
+typedef struct sn__extension_envelope_wrap_batch {
+  size_t n;
+  const unsigned char *pks;
+  const unsigned char *epk;
+  const unsigned char *esk;
+  const unsigned char *ck;
+  unsigned char *entries;
+} sn__extension_envelope_wrap_batch;
+
+// writes epk and the recipient count to the header
+void sn__extension_envelope_header(unsigned char *header, const unsigned char *epk, uint32_t n);
+
+// returns the number of recipients in this lane that could not be wrapped for (low order keys)
+size_t sn__extension_envelope_wrap(const sn__extension_envelope_wrap_batch *batch,
+                                   size_t lane, size_t lanes);
+
+// encrypts the body behind a complete header of hlen bytes at c
+int sn__extension_envelope_seal_body(unsigned char *c, size_t hlen,
+                                     const unsigned char *m, unsigned long long mlen,
+                                     const unsigned char *ck);
+
+// recipient count of a header, 0 if clen cannot hold the envelope it describes
+uint32_t sn__extension_envelope_recipients(const unsigned char *c, unsigned long long clen);
+
+// returns the entry that opened, or -1
+int64_t sn__extension_envelope_open(unsigned char *m,
+                                    const unsigned char *c, unsigned long long clen,
+                                    uint32_t hint,
+                                    const unsigned char *pk, const unsigned char *sk);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
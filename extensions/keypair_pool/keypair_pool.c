@@ -0,0 +1,135 @@
+#include <string.h>
+
+#include "keypair_pool.h"
+#include "../x25519/x25519.h"
+
+_Static_assert(sizeof(sn__extension_keypair_pool) == sn__extension_keypair_pool_HEADERBYTES, "keypair pool header size");
+
+uint32_t
+sn__extension_keypair_pool_capacity (size_t len) {
+  if (len < sn__extension_keypair_pool_HEADERBYTES + sn__extension_keypair_pool_KEYPAIRBYTES) return 0;
+
+  size_t capacity = (len - sn__extension_keypair_pool_HEADERBYTES) / sn__extension_keypair_pool_KEYPAIRBYTES;
+
+  return capacity > UINT32_MAX ? UINT32_MAX : (uint32_t) capacity;
+}
+
+int
+sn__extension_keypair_pool_init (sn__extension_keypair_pool *pool, size_t len, uint32_t watermark) {
+  uint32_t capacity = sn__extension_keypair_pool_capacity(len);
+
+  if (capacity == 0) return -1;
+  if ((len - sn__extension_keypair_pool_HEADERBYTES) % sn__extension_keypair_pool_KEYPAIRBYTES != 0) return -1;
+  if (watermark > capacity) return -1;
+
+  sodium_memzero(pool, len);
+
+  // a fresh random epoch, so fills queued before this init never land
+  do randombytes_buf(&pool->epoch, sizeof(pool->epoch));
+  while (pool->epoch == 0);
+
+  pool->capacity = capacity;
+  pool->watermark = watermark;
+  pool->low = UINT32_MAX;
+
+  return 0;
+}
+
+int
+sn__extension_keypair_pool_draw (sn__extension_keypair_pool *pool, unsigned char *pk, unsigned char *sk) {
+  pool->draws++;
+
+  if (pool->available == 0) {
+    pool->misses++;
+    pool->low = 0;
+    return -1;
+  }
+
+  unsigned char *keypair = pool->keypairs + (size_t) --pool->available * sn__extension_keypair_pool_KEYPAIRBYTES;
+
+  memcpy(pk, keypair, crypto_box_PUBLICKEYBYTES);
+  memcpy(sk, keypair + crypto_box_PUBLICKEYBYTES, crypto_box_SECRETKEYBYTES);
+  sodium_memzero(keypair, sn__extension_keypair_pool_KEYPAIRBYTES);
+
+  if (pool->available < pool->low) pool->low = pool->available;
+
+  return 0;
+}
+
+uint32_t
+sn__extension_keypair_pool_wanted (const sn__extension_keypair_pool *pool) {
+  uint64_t have = (uint64_t) pool->available + pool->pending;
+
+  return have >= pool->capacity ? 0 : (uint32_t) (pool->capacity - have);
+}
+
+void
+sn__extension_keypair_pool_generate (unsigned char *keypairs, uint32_t n) {
+  for (uint32_t i = 0; i < n; i++) {
+    unsigned char *keypair = keypairs + (size_t) i * sn__extension_keypair_pool_KEYPAIRBYTES;
+
+    crypto_box_keypair(keypair, keypair + crypto_box_PUBLICKEYBYTES);
+  }
+}
+
+uint32_t
+sn__extension_keypair_pool_publish (sn__extension_keypair_pool *pool, uint64_t epoch,
+                                    unsigned char *keypairs, uint32_t n)
+{
+  uint32_t moved = 0;
+
+  if (pool->epoch == epoch) {
+    pool->pending = pool->pending > n ? pool->pending - n : 0;
+
+    moved = pool->capacity - pool->available;
+    if (moved > n) moved = n;
+
+    memcpy(pool->keypairs + (size_t) pool->available * sn__extension_keypair_pool_KEYPAIRBYTES,
+           keypairs, (size_t) moved * sn__extension_keypair_pool_KEYPAIRBYTES);
+
+    pool->available += moved;
+    pool->fills++;
+  }
+
+  sodium_memzero(keypairs, (size_t) n * sn__extension_keypair_pool_KEYPAIRBYTES);
+
+  return moved;
+}
+
+int
+sn__extension_keypair_pool_seal (unsigned char *c, const unsigned char *m, unsigned long long mlen,
+                                 const unsigned char *pk,
+                                 const unsigned char *epk, const unsigned char *esk)
+{
+  unsigned char nonce[crypto_box_NONCEBYTES];
+  crypto_generichash_state st;
+
+  crypto_generichash_init(&st, NULL, 0U, crypto_box_NONCEBYTES);
+  crypto_generichash_update(&st, epk, crypto_box_PUBLICKEYBYTES);
+  crypto_generichash_update(&st, pk, crypto_box_PUBLICKEYBYTES);
+  crypto_generichash_final(&st, nonce, crypto_box_NONCEBYTES);
+
+  int res = sn__extension_x25519_box_easy(c + crypto_box_PUBLICKEYBYTES, m, mlen, nonce, pk, esk);
+
+  memcpy(c, epk, crypto_box_PUBLICKEYBYTES);
+
+  return res;
+}
+
+void
+sn__extension_keypair_pool_stats (sn__extension_keypair_pool *pool, uint32_t *stats) {
+  stats[0] = pool->available;
+  stats[1] = pool->capacity;
+  stats[2] = pool->low < pool->available ? pool->low : pool->available;
+  stats[3] = pool->pending;
+  stats[4] = pool->draws;
+  stats[5] = pool->misses;
+  stats[6] = pool->fills;
+
+  pool->low = UINT32_MAX;
+}
+
+void
+sn__extension_keypair_pool_final (sn__extension_keypair_pool *pool) {
+  sodium_memzero(pool, sn__extension_keypair_pool_HEADERBYTES + (size_t) pool->capacity * sn__extension_keypair_pool_KEYPAIRBYTES);
+}
@@ -0,0 +1,85 @@
+#ifndef SN_EXTENSION_KEYPAIR_POOL_H
+#define SN_EXTENSION_KEYPAIR_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <sodium.h>
+
+/*
+  Ephemeral keypair pool.
+
+  A stack of X25519 keypairs (pk || sk, as made by crypto_box_keypair and
+  crypto_kx_keypair) kept in a caller provided buffer of
+  HEADERBYTES + capacity * KEYPAIRBYTES bytes, which should come from
+  sodium_malloc. Every keypair is handed out once and wiped from the pool
+  as it is drawn.
+
+  The pool is only ever touched from one thread. Keypairs are generated
+  elsewhere into a scratch area with sn__extension_keypair_pool_generate
+  and then moved in with sn__extension_keypair_pool_publish, which drops
+  them if the pool was finalised or initialised again in the meantime
+  (the epoch changed). A draw from an empty pool fails, leaving the caller
+  to generate a keypair inline and record the miss.
+
+  `low` is the fewest keypairs left after a draw since init or the last
+  sn__extension_keypair_pool_stats call (the current count if nothing was
+  drawn), the number to size the capacity and watermark by.
+*/
+
+#define sn__extension_keypair_pool_HEADERBYTES 64U
+
+#define sn__extension_keypair_pool_KEYPAIRBYTES (crypto_box_PUBLICKEYBYTES + crypto_box_SECRETKEYBYTES)
+
+#define sn__extension_keypair_pool_STATS 7U
+
+typedef struct sn__extension_keypair_pool {
+  uint64_t epoch;
+  uint32_t capacity;
+  uint32_t watermark;
+  uint32_t available;
+  uint32_t pending;
+  uint32_t low;
+  uint32_t draws;
+  uint32_t misses;
+  uint32_t fills;
+  unsigned char reserved[24];
+  unsigned char keypairs[];
+} sn__extension_keypair_pool;
+
+// capacity for a buffer of len bytes, 0 if it cannot hold a single keypair
+uint32_t sn__extension_keypair_pool_capacity(size_t len);
+
+// returns -1 unless len is HEADERBYTES + n * KEYPAIRBYTES for some n > 0
+int sn__extension_keypair_pool_init(sn__extension_keypair_pool *pool, size_t len, uint32_t watermark);
+
+// returns -1 if the pool is empty
+int sn__extension_keypair_pool_draw(sn__extension_keypair_pool *pool, unsigned char *pk, unsigned char *sk);
+
+// keypairs to generate so the pool would be full once everything pending lands
+uint32_t sn__extension_keypair_pool_wanted(const sn__extension_keypair_pool *pool);
+
+// safe to call from any thread, it does not touch the pool
+void sn__extension_keypair_pool_generate(unsigned char *keypairs, uint32_t n);
+
+// returns the number of keypairs moved into the pool, the scratch is wiped either way
+uint32_t sn__extension_keypair_pool_publish(sn__extension_keypair_pool *pool, uint64_t epoch,
+                                            unsigned char *keypairs, uint32_t n);
+
+// crypto_box_seal with a given ephemeral keypair, the output opens with crypto_box_seal_open
+int sn__extension_keypair_pool_seal(unsigned char *c, const unsigned char *m, unsigned long long mlen,
+                                    const unsigned char *pk,
+                                    const unsigned char *epk, const unsigned char *esk);
+
+// available, capacity, low, pending, draws, misses, fills, resets low to available
+void sn__extension_keypair_pool_stats(sn__extension_keypair_pool *pool, uint32_t *stats);
+
+void sn__extension_keypair_pool_final(sn__extension_keypair_pool *pool);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
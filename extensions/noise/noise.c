@@ -0,0 +1,443 @@
+#include <string.h>
+
+#include "noise.h"
+#include "../x25519/x25519.h"
+
+_Static_assert(sizeof(sn__extension_noise_state) == sn__extension_noise_STATEBYTES, "noise state size");
+
+#define SN_NOISE_HAS_K 0x01
+#define SN_NOISE_HAS_RS 0x02
+#define SN_NOISE_SPLIT 0x04
+#define SN_NOISE_FAILED 0x08
+#define SN_NOISE_FIXED_E 0x10
+
+#define SN_NOISE_BLOCKBYTES 128
+
+enum {
+  SN_NOISE_END,
+  SN_NOISE_E,
+  SN_NOISE_S,
+  SN_NOISE_EE,
+  SN_NOISE_ES,
+  SN_NOISE_SE,
+  SN_NOISE_SS
+};
+
+// message patterns, indexed by pattern - 1, ending with an empty message
+static const unsigned char sn_noise_patterns[2][4][5] = {
+  {
+    {SN_NOISE_E},
+    {SN_NOISE_E, SN_NOISE_EE, SN_NOISE_S, SN_NOISE_ES},
+    {SN_NOISE_S, SN_NOISE_SE},
+    {SN_NOISE_END}
+  },
+  {
+    {SN_NOISE_E, SN_NOISE_ES, SN_NOISE_S, SN_NOISE_SS},
+    {SN_NOISE_E, SN_NOISE_EE, SN_NOISE_SE},
+    {SN_NOISE_END},
+    {SN_NOISE_END}
+  }
+};
+
+static const char *sn_noise_names[2] = {
+  "Noise_XX_25519_ChaChaPoly_BLAKE2b",
+  "Noise_IK_25519_ChaChaPoly_BLAKE2b"
+};
+
+// NULL once every message of the pattern has been processed
+static const unsigned char *
+sn_noise_tokens (const sn__extension_noise_state *state) {
+  if (!sn__extension_noise_initialised(state)) return NULL;
+
+  const unsigned char *tokens = sn_noise_patterns[state->pattern - 1][state->message];
+
+  return tokens[0] == SN_NOISE_END ? NULL : tokens;
+}
+
+static void
+sn_noise_hmac (unsigned char out[sn__extension_noise_HASHBYTES], const unsigned char key[sn__extension_noise_HASHBYTES],
+               const unsigned char *a, size_t a_len, const unsigned char *b, size_t b_len) {
+  crypto_generichash_state hash;
+  unsigned char pad[SN_NOISE_BLOCKBYTES];
+  unsigned char inner[sn__extension_noise_HASHBYTES];
+
+  memset(pad, 0x36, sizeof(pad));
+  for (size_t i = 0; i < sn__extension_noise_HASHBYTES; i++) pad[i] ^= key[i];
+
+  crypto_generichash_init(&hash, NULL, 0, sizeof(inner));
+  crypto_generichash_update(&hash, pad, sizeof(pad));
+  crypto_generichash_update(&hash, a, a_len);
+  crypto_generichash_update(&hash, b, b_len);
+  crypto_generichash_final(&hash, inner, sizeof(inner));
+
+  memset(pad, 0x5c, sizeof(pad));
+  for (size_t i = 0; i < sn__extension_noise_HASHBYTES; i++) pad[i] ^= key[i];
+
+  crypto_generichash_init(&hash, NULL, 0, sn__extension_noise_HASHBYTES);
+  crypto_generichash_update(&hash, pad, sizeof(pad));
+  crypto_generichash_update(&hash, inner, sizeof(inner));
+  crypto_generichash_final(&hash, out, sn__extension_noise_HASHBYTES);
+
+  sodium_memzero(&hash, sizeof(hash));
+  sodium_memzero(pad, sizeof(pad));
+  sodium_memzero(inner, sizeof(inner));
+}
+
+// HKDF with two outputs, out1 may alias ck
+static void
+sn_noise_hkdf (unsigned char *out1, unsigned char *out2, const unsigned char *ck, const unsigned char *ikm, size_t ikm_len) {
+  static const unsigned char one = 0x01;
+  static const unsigned char two = 0x02;
+  unsigned char temp[sn__extension_noise_HASHBYTES];
+  unsigned char first[sn__extension_noise_HASHBYTES];
+
+  sn_noise_hmac(temp, ck, ikm, ikm_len, NULL, 0);
+  sn_noise_hmac(first, temp, &one, 1, NULL, 0);
+  sn_noise_hmac(out2, temp, first, sizeof(first), &two, 1);
+  memcpy(out1, first, sizeof(first));
+
+  sodium_memzero(temp, sizeof(temp));
+  sodium_memzero(first, sizeof(first));
+}
+
+static void
+sn_noise_mix_hash (sn__extension_noise_state *state, const unsigned char *data, size_t data_len) {
+  crypto_generichash_state hash;
+
+  crypto_generichash_init(&hash, NULL, 0, sn__extension_noise_HASHBYTES);
+  crypto_generichash_update(&hash, state->h, sn__extension_noise_HASHBYTES);
+  crypto_generichash_update(&hash, data, data_len);
+  crypto_generichash_final(&hash, state->h, sn__extension_noise_HASHBYTES);
+}
+
+static void
+sn_noise_mix_key (sn__extension_noise_state *state, const unsigned char *ikm, size_t ikm_len) {
+  unsigned char k[sn__extension_noise_HASHBYTES];
+
+  sn_noise_hkdf(state->ck, k, state->ck, ikm, ikm_len);
+
+  memcpy(state->k, k, sn__extension_noise_KEYBYTES);
+  memset(state->n, 0, sizeof(state->n));
+  state->flags |= SN_NOISE_HAS_K;
+
+  sodium_memzero(k, sizeof(k));
+}
+
+// 4 zero bytes followed by the 64 bit counter, little endian
+static void
+sn_noise_nonce (unsigned char nonce[crypto_aead_chacha20poly1305_ietf_NPUBBYTES], const sn__extension_noise_state *state) {
+  memset(nonce, 0, 4);
+  memcpy(nonce + 4, state->n, sizeof(state->n));
+}
+
+static void
+sn_noise_mix_dh (sn__extension_noise_state *state, int *res, const unsigned char *sk, const unsigned char *pk) {
+  unsigned char q[crypto_scalarmult_curve25519_BYTES];
+
+  if (sn__extension_x25519_scalarmult(q, sk, pk) != 0) *res = -1;
+
+  // mixing the zeroed output keeps the work constant, the state is failed anyway
+  sn_noise_mix_key(state, q, sizeof(q));
+
+  sodium_memzero(q, sizeof(q));
+}
+
+static void
+sn_noise_dh (sn__extension_noise_state *state, int *res, unsigned char token) {
+  const unsigned char *e_sk = state->e + sn__extension_noise_PUBLICKEYBYTES;
+  const unsigned char *s_sk = state->s + sn__extension_noise_PUBLICKEYBYTES;
+
+  switch (token) {
+  case SN_NOISE_EE:
+    sn_noise_mix_dh(state, res, e_sk, state->re);
+    break;
+  case SN_NOISE_ES:
+    if (state->initiator) sn_noise_mix_dh(state, res, e_sk, state->rs);
+    else sn_noise_mix_dh(state, res, s_sk, state->re);
+    break;
+  case SN_NOISE_SE:
+    if (state->initiator) sn_noise_mix_dh(state, res, s_sk, state->re);
+    else sn_noise_mix_dh(state, res, e_sk, state->rs);
+    break;
+  case SN_NOISE_SS:
+    sn_noise_mix_dh(state, res, s_sk, state->rs);
+    break;
+  }
+}
+
+static size_t
+sn_noise_encrypt_and_hash (sn__extension_noise_state *state, unsigned char *out, const unsigned char *m, size_t m_len) {
+  unsigned char nonce[crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+  size_t out_len = m_len;
+
+  if (state->flags & SN_NOISE_HAS_K) {
+    sn_noise_nonce(nonce, state);
+    crypto_aead_chacha20poly1305_ietf_encrypt(out, NULL, m, m_len, state->h, sn__extension_noise_HASHBYTES, NULL, nonce, state->k);
+    sodium_increment(state->n, sizeof(state->n));
+    out_len += sn__extension_noise_MACBYTES;
+  } else {
+    memmove(out, m, m_len);
+  }
+
+  sn_noise_mix_hash(state, out, out_len);
+
+  return out_len;
+}
+
+// out may alias c, the next h is taken from the ciphertext before it is opened
+static int
+sn_noise_decrypt_and_hash (sn__extension_noise_state *state, unsigned char *out, const unsigned char *c, size_t c_len) {
+  crypto_generichash_state hash;
+  unsigned char h[sn__extension_noise_HASHBYTES];
+  unsigned char nonce[crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+
+  crypto_generichash_init(&hash, NULL, 0, sizeof(h));
+  crypto_generichash_update(&hash, state->h, sizeof(h));
+  crypto_generichash_update(&hash, c, c_len);
+  crypto_generichash_final(&hash, h, sizeof(h));
+
+  if (state->flags & SN_NOISE_HAS_K) {
+    sn_noise_nonce(nonce, state);
+    if (crypto_aead_chacha20poly1305_ietf_decrypt(out, NULL, NULL, c, c_len, state->h, sn__extension_noise_HASHBYTES, nonce, state->k) != 0) {
+      return -1;
+    }
+    sodium_increment(state->n, sizeof(state->n));
+  } else {
+    memmove(out, c, c_len);
+  }
+
+  memcpy(state->h, h, sizeof(h));
+
+  return 0;
+}
+
+static void
+sn_noise_fail (sn__extension_noise_state *state) {
+  unsigned char pattern = state->pattern;
+
+  sodium_memzero(state, sizeof(*state));
+
+  state->pattern = pattern;
+  state->flags = SN_NOISE_FAILED;
+}
+
+int
+sn__extension_noise_initialised (const sn__extension_noise_state *state) {
+  return (state->pattern == sn__extension_noise_XX || state->pattern == sn__extension_noise_IK) && state->message < 4;
+}
+
+int
+sn__extension_noise_init (sn__extension_noise_state *state, uint32_t pattern, int initiator,
+                          const unsigned char *prologue, size_t prologue_len,
+                          const unsigned char *s_pk, const unsigned char *s_sk,
+                          const unsigned char *rs) {
+  if (pattern != sn__extension_noise_XX && pattern != sn__extension_noise_IK) return -1;
+  if (pattern == sn__extension_noise_IK && initiator && rs == NULL) return -1;
+
+  const char *name = sn_noise_names[pattern - 1];
+
+  sodium_memzero(state, sizeof(*state));
+
+  state->pattern = (unsigned char) pattern;
+  state->initiator = initiator ? 1 : 0;
+
+  // protocol names are shorter than HASHLEN, so h is the zero padded name
+  memcpy(state->h, name, strlen(name));
+  memcpy(state->ck, state->h, sn__extension_noise_HASHBYTES);
+
+  sn_noise_mix_hash(state, prologue, prologue_len);
+
+  memcpy(state->s, s_pk, sn__extension_noise_PUBLICKEYBYTES);
+  memcpy(state->s + sn__extension_noise_PUBLICKEYBYTES, s_sk, sn__extension_noise_SECRETKEYBYTES);
+
+  // IK pre-message: <- s
+  if (pattern == sn__extension_noise_IK) {
+    if (state->initiator) {
+      memcpy(state->rs, rs, sn__extension_noise_PUBLICKEYBYTES);
+      state->flags |= SN_NOISE_HAS_RS;
+      sn_noise_mix_hash(state, state->rs, sn__extension_noise_PUBLICKEYBYTES);
+    } else {
+      sn_noise_mix_hash(state, s_pk, sn__extension_noise_PUBLICKEYBYTES);
+    }
+  }
+
+  return 0;
+}
+
+int
+sn__extension_noise_fixed_ephemeral (sn__extension_noise_state *state, const unsigned char *e_sk) {
+  if (sn__extension_noise_turn(state) < 0) return -1;
+
+  memcpy(state->e + sn__extension_noise_PUBLICKEYBYTES, e_sk, sn__extension_noise_SECRETKEYBYTES);
+  crypto_scalarmult_curve25519_base(state->e, e_sk);
+
+  state->flags |= SN_NOISE_FIXED_E;
+
+  return 0;
+}
+
+int
+sn__extension_noise_turn (const sn__extension_noise_state *state) {
+  if (state->flags & (SN_NOISE_FAILED | SN_NOISE_SPLIT)) return -1;
+  if (sn_noise_tokens(state) == NULL) return -1;
+
+  // the initiator writes the even messages
+  return (state->message % 2 == 0) == (state->initiator == 1) ? 1 : 0;
+}
+
+size_t
+sn__extension_noise_overhead (const sn__extension_noise_state *state) {
+  if (sn__extension_noise_turn(state) < 0) return 0;
+
+  const unsigned char *tokens = sn_noise_tokens(state);
+  int has_k = state->flags & SN_NOISE_HAS_K;
+  size_t size = 0;
+
+  for (; *tokens != SN_NOISE_END; tokens++) {
+    switch (*tokens) {
+    case SN_NOISE_E:
+      size += sn__extension_noise_PUBLICKEYBYTES;
+      break;
+    case SN_NOISE_S:
+      size += sn__extension_noise_PUBLICKEYBYTES + (has_k ? sn__extension_noise_MACBYTES : 0);
+      break;
+    default:
+      has_k = 1;
+      break;
+    }
+  }
+
+  return size + (has_k ? sn__extension_noise_MACBYTES : 0);
+}
+
+int
+sn__extension_noise_write_message (sn__extension_noise_state *state, unsigned char *out,
+                                   const unsigned char *payload, size_t payload_len) {
+  if (sn__extension_noise_turn(state) != 1) return -1;
+  if (payload_len + sn__extension_noise_overhead(state) > sn__extension_noise_MESSAGEBYTES_MAX) return -1;
+
+  const unsigned char *tokens = sn_noise_tokens(state);
+  unsigned char *p = out;
+  int res = 0;
+
+  for (; *tokens != SN_NOISE_END; tokens++) {
+    switch (*tokens) {
+    case SN_NOISE_E:
+      if (!(state->flags & SN_NOISE_FIXED_E)) crypto_box_keypair(state->e, state->e + sn__extension_noise_PUBLICKEYBYTES);
+      state->flags &= ~SN_NOISE_FIXED_E;
+      memcpy(p, state->e, sn__extension_noise_PUBLICKEYBYTES);
+      sn_noise_mix_hash(state, p, sn__extension_noise_PUBLICKEYBYTES);
+      p += sn__extension_noise_PUBLICKEYBYTES;
+      break;
+    case SN_NOISE_S:
+      p += sn_noise_encrypt_and_hash(state, p, state->s, sn__extension_noise_PUBLICKEYBYTES);
+      break;
+    default:
+      sn_noise_dh(state, &res, *tokens);
+      break;
+    }
+  }
+
+  if (res != 0) {
+    sn_noise_fail(state);
+    return -1;
+  }
+
+  sn_noise_encrypt_and_hash(state, p, payload, payload_len);
+  state->message++;
+
+  return 0;
+}
+
+int
+sn__extension_noise_read_message (sn__extension_noise_state *state, unsigned char *payload,
+                                  const unsigned char *msg, size_t msg_len) {
+  if (sn__extension_noise_turn(state) != 0) return -1;
+
+  size_t overhead = sn__extension_noise_overhead(state);
+
+  if (msg_len < overhead || msg_len > sn__extension_noise_MESSAGEBYTES_MAX) {
+    sn_noise_fail(state);
+    return -1;
+  }
+
+  const unsigned char *tokens = sn_noise_tokens(state);
+  const unsigned char *p = msg;
+  int res = 0;
+
+  for (; *tokens != SN_NOISE_END && res == 0; tokens++) {
+    switch (*tokens) {
+    case SN_NOISE_E:
+      memcpy(state->re, p, sn__extension_noise_PUBLICKEYBYTES);
+      sn_noise_mix_hash(state, state->re, sn__extension_noise_PUBLICKEYBYTES);
+      p += sn__extension_noise_PUBLICKEYBYTES;
+      break;
+    case SN_NOISE_S: {
+      size_t len = sn__extension_noise_PUBLICKEYBYTES + ((state->flags & SN_NOISE_HAS_K) ? sn__extension_noise_MACBYTES : 0);
+      res = sn_noise_decrypt_and_hash(state, state->rs, p, len);
+      state->flags |= SN_NOISE_HAS_RS;
+      p += len;
+      break;
+    }
+    default:
+      sn_noise_dh(state, &res, *tokens);
+      break;
+    }
+  }
+
+  if (res != 0 || sn_noise_decrypt_and_hash(state, payload, p, msg_len - (size_t) (p - msg)) != 0) {
+    sn_noise_fail(state);
+    return -1;
+  }
+
+  state->message++;
+
+  return (int) (msg_len - overhead);
+}
+
+int
+sn__extension_noise_split (sn__extension_noise_state *state, unsigned char *tx, unsigned char *rx) {
+  if (!sn__extension_noise_initialised(state)) return -1;
+  if (state->flags & (SN_NOISE_FAILED | SN_NOISE_SPLIT)) return -1;
+  if (sn_noise_tokens(state) != NULL) return -1;
+
+  unsigned char k1[sn__extension_noise_HASHBYTES];
+  unsigned char k2[sn__extension_noise_HASHBYTES];
+
+  sn_noise_hkdf(k1, k2, state->ck, NULL, 0);
+
+  memcpy(tx, state->initiator ? k1 : k2, sn__extension_noise_KEYBYTES);
+  memcpy(rx, state->initiator ? k2 : k1, sn__extension_noise_KEYBYTES);
+
+  sodium_memzero(k1, sizeof(k1));
+  sodium_memzero(k2, sizeof(k2));
+
+  sodium_memzero(state->ck, sizeof(state->ck));
+  sodium_memzero(state->k, sizeof(state->k));
+  sodium_memzero(state->n, sizeof(state->n));
+  sodium_memzero(state->s, sizeof(state->s));
+  sodium_memzero(state->e, sizeof(state->e));
+  sodium_memzero(state->re, sizeof(state->re));
+
+  state->flags = (state->flags & SN_NOISE_HAS_RS) | SN_NOISE_SPLIT;
+
+  return 0;
+}
+
+int
+sn__extension_noise_handshake_hash (const sn__extension_noise_state *state, unsigned char *h) {
+  if (!(state->flags & SN_NOISE_SPLIT)) return -1;
+
+  memcpy(h, state->h, sn__extension_noise_HASHBYTES);
+
+  return 0;
+}
+
+int
+sn__extension_noise_remote_static (const sn__extension_noise_state *state, unsigned char *rs) {
+  if (!(state->flags & SN_NOISE_HAS_RS) || (state->flags & SN_NOISE_FAILED)) return -1;
+
+  memcpy(rs, state->rs, sn__extension_noise_PUBLICKEYBYTES);
+
+  return 0;
+}
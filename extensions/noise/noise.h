@@ -0,0 +1,106 @@
+#ifndef SN_EXTENSION_NOISE_H
+#define SN_EXTENSION_NOISE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <sodium.h>
+
+/*
+  Noise handshake state.
+
+  Noise_XX_25519_ChaChaPoly_BLAKE2b and Noise_IK_25519_ChaChaPoly_BLAKE2b,
+  as specified in revision 34 of the Noise Protocol Framework, with the
+  whole HandshakeState (h, ck, k, n and the local and remote keys) kept in
+  a caller provided buffer of STATEBYTES bytes, which should come from
+  sodium_malloc. HKDF is HMAC-BLAKE2b over crypto_generichash, the
+  cipher is crypto_aead_chacha20poly1305_ietf with the counter in the last
+  eight nonce bytes (little endian), and DH goes through the X25519
+  dispatcher.
+
+  Each side calls write_message and read_message in turn, the initiator
+  writing first, and split once the pattern is done. A message that fails
+  to decrypt, or a DH with a low order point, fails the state for good,
+  as Noise requires the handshake to be abandoned. Split wipes everything
+  but the handshake hash and the remote static key.
+
+  The state is plain bytes, so any alignment will do.
+*/
+
+#define sn__extension_noise_STATEBYTES 384U
+
+#define sn__extension_noise_XX 1U
+
+#define sn__extension_noise_IK 2U
+
+#define sn__extension_noise_PUBLICKEYBYTES crypto_scalarmult_curve25519_BYTES
+
+#define sn__extension_noise_SECRETKEYBYTES crypto_scalarmult_curve25519_SCALARBYTES
+
+#define sn__extension_noise_HASHBYTES crypto_generichash_BYTES_MAX
+
+#define sn__extension_noise_KEYBYTES crypto_aead_chacha20poly1305_ietf_KEYBYTES
+
+#define sn__extension_noise_MACBYTES crypto_aead_chacha20poly1305_ietf_ABYTES
+
+#define sn__extension_noise_MESSAGEBYTES_MAX 65535U
+
+typedef struct sn__extension_noise_state {
+  unsigned char h[sn__extension_noise_HASHBYTES];
+  unsigned char ck[sn__extension_noise_HASHBYTES];
+  unsigned char k[sn__extension_noise_KEYBYTES];
+  unsigned char n[8];
+  unsigned char s[sn__extension_noise_PUBLICKEYBYTES + sn__extension_noise_SECRETKEYBYTES];
+  unsigned char e[sn__extension_noise_PUBLICKEYBYTES + sn__extension_noise_SECRETKEYBYTES];
+  unsigned char rs[sn__extension_noise_PUBLICKEYBYTES];
+  unsigned char re[sn__extension_noise_PUBLICKEYBYTES];
+  unsigned char pattern;
+  unsigned char initiator;
+  unsigned char message; // index of the next message in the pattern
+  unsigned char flags;
+  unsigned char reserved[20];
+} sn__extension_noise_state;
+
+// returns -1 for an unknown pattern, or an IK initiator without rs (which is ignored otherwise)
+int sn__extension_noise_init(sn__extension_noise_state *state, uint32_t pattern, int initiator,
+                             const unsigned char *prologue, size_t prologue_len,
+                             const unsigned char *s_pk, const unsigned char *s_sk,
+                             const unsigned char *rs);
+
+// 1 once init has run on the state, failed or not
+int sn__extension_noise_initialised(const sn__extension_noise_state *state);
+
+// the next e token we write uses e_sk instead of a fresh keypair, only for known answer tests as
+// it gives up forward secrecy, returns -1 once the handshake is done or failed
+int sn__extension_noise_fixed_ephemeral(sn__extension_noise_state *state, const unsigned char *e_sk);
+
+// 1 when the next message is ours to write, 0 when it is ours to read, -1 once done or failed
+int sn__extension_noise_turn(const sn__extension_noise_state *state);
+
+// bytes the next message adds to its payload
+size_t sn__extension_noise_overhead(const sn__extension_noise_state *state);
+
+// out must be payload_len + overhead bytes, returns -1 if it is not our turn or a DH fails
+int sn__extension_noise_write_message(sn__extension_noise_state *state, unsigned char *out,
+                                      const unsigned char *payload, size_t payload_len);
+
+// payload must be msg_len - overhead bytes, returns its length, or -1 if it is not our turn or the message is rejected
+int sn__extension_noise_read_message(sn__extension_noise_state *state, unsigned char *payload,
+                                     const unsigned char *msg, size_t msg_len);
+
+// tx and rx as seen from this side, returns -1 unless every message has been processed
+int sn__extension_noise_split(sn__extension_noise_state *state, unsigned char *tx, unsigned char *rx);
+
+// returns -1 until split
+int sn__extension_noise_handshake_hash(const sn__extension_noise_state *state, unsigned char *h);
+
+// returns -1 while the remote static key is unknown
+int sn__extension_noise_remote_static(const sn__extension_noise_state *state, unsigned char *rs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
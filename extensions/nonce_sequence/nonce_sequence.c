@@ -0,0 +1,60 @@
+#include <string.h>
+
+#include "nonce_sequence.h"
+
+int sn__extension_nonce_sequence_init (sn__extension_nonce_sequence_state *state,
+                                       size_t noncebytes, size_t prefixbytes)
+{
+  if (noncebytes == 0 || noncebytes > sn__extension_nonce_sequence_NONCEBYTES_MAX) return -1;
+  if (prefixbytes >= noncebytes) return -1;
+
+  memset(state, 0, sizeof(*state));
+
+  state->noncebytes = (unsigned char) noncebytes;
+  state->prefixbytes = (unsigned char) prefixbytes;
+  state->mode = sn__extension_nonce_sequence_COUNTER;
+
+  randombytes_buf(state->next, prefixbytes);
+
+  return 0;
+}
+
+int sn__extension_nonce_sequence_init_random (sn__extension_nonce_sequence_state *state,
+                                              size_t noncebytes)
+{
+  if (noncebytes == 0 || noncebytes > sn__extension_nonce_sequence_NONCEBYTES_MAX) return -1;
+
+  memset(state, 0, sizeof(*state));
+
+  state->noncebytes = (unsigned char) noncebytes;
+  state->mode = sn__extension_nonce_sequence_RANDOM;
+
+  return 0;
+}
+
+int sn__extension_nonce_sequence_next (sn__extension_nonce_sequence_state *state)
+{
+  if (state->noncebytes == 0 || state->noncebytes > sn__extension_nonce_sequence_NONCEBYTES_MAX) return -1;
+
+  if (state->mode == sn__extension_nonce_sequence_RANDOM) {
+    randombytes_buf(state->nonce, state->noncebytes);
+    return 0;
+  }
+
+  if (state->exhausted) return -1;
+
+  memcpy(state->nonce, state->next, state->noncebytes);
+
+  // constant time little endian increment of the counter bytes
+  unsigned int carry = 1;
+  for (size_t i = state->prefixbytes; i < state->noncebytes; i++) {
+    carry += state->next[i];
+    state->next[i] = (unsigned char) carry;
+    carry >>= 8;
+  }
+
+  // the nonce just handed out was the last one
+  state->exhausted = (unsigned char) carry;
+
+  return 0;
+}
@@ -0,0 +1,51 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <sodium.h>
+
+/*
+  Nonce sequence.
+
+  A small state that hands out a fresh nonce for every encryption. The _seq
+  variants of the AEAD and secretbox encrypt calls take it in place of the
+  nonce, draw the nonce and advance the sequence inside that same call.
+
+  Counter sequences are laid out as `random prefix || little endian counter`
+  and refuse to hand out more nonces once the counter wraps around. Random
+  sequences draw every nonce from randombytes_buf.
+
+  The nonce used by the latest call is kept in the first `noncebytes` bytes
+  of the state, so it can be read back without copying.
+
+  All fields are bytes so the state can live in any (unaligned) buffer.
+*/
+
+#define sn__extension_nonce_sequence_NONCEBYTES_MAX 24U
+
+#define sn__extension_nonce_sequence_COUNTER 0
+
+#define sn__extension_nonce_sequence_RANDOM 1
+
+typedef struct sn__extension_nonce_sequence_state {
+  unsigned char nonce[sn__extension_nonce_sequence_NONCEBYTES_MAX];
+  unsigned char next[sn__extension_nonce_sequence_NONCEBYTES_MAX];
+  unsigned char noncebytes;
+  unsigned char prefixbytes;
+  unsigned char mode;
+  unsigned char exhausted;
+} sn__extension_nonce_sequence_state;
+
+// counter sequence with prefixbytes random leading bytes, returns -1 on invalid sizes
+int sn__extension_nonce_sequence_init(sn__extension_nonce_sequence_state *state,
+                                      size_t noncebytes, size_t prefixbytes);
+
+int sn__extension_nonce_sequence_init_random(sn__extension_nonce_sequence_state *state,
+                                             size_t noncebytes);
+
+// draws the next nonce into state->nonce, returns -1 once a counter sequence is exhausted
+int sn__extension_nonce_sequence_next(sn__extension_nonce_sequence_state *state);
+
+#ifdef __cplusplus
+};
+#endif
@@ -0,0 +1,218 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "pad.h"
+#include "../aead/aead.h"
+#include "../poly1305/poly1305.h"
+
+static const unsigned char _extension_pad_zeros[256] = { 0 };
+
+static const unsigned char _extension_pad_marker = 0x80;
+
+size_t
+sn__extension_pad_padded_length (size_t unpadded_len, size_t blocksize) {
+  if (blocksize == 0) return 0;
+
+  size_t xpadlen = blocksize - 1 - (unpadded_len % blocksize);
+
+  if (unpadded_len > SIZE_MAX - xpadlen - 1) return 0;
+
+  return unpadded_len + xpadlen + 1;
+}
+
+typedef void (*_extension_pad_transform_t)(void *ctx, unsigned char *out, const unsigned char *in, size_t len);
+
+// runs m || 0x80 || zeros through transform, writing padded_len bytes to out
+static void
+_extension_pad_feed (void *ctx, _extension_pad_transform_t transform, unsigned char *out, const unsigned char *m, size_t mlen, size_t padded_len) {
+  transform(ctx, out, m, mlen);
+  transform(ctx, out + mlen, &_extension_pad_marker, 1);
+
+  for (size_t i = mlen + 1; i < padded_len;) {
+    size_t n = padded_len - i;
+    if (n > sizeof(_extension_pad_zeros)) n = sizeof(_extension_pad_zeros);
+
+    transform(ctx, out + i, _extension_pad_zeros, n);
+    i += n;
+  }
+}
+
+// as in libsodium, a message that partly overlaps its output is moved there first and encrypted in place
+static const unsigned char *
+_extension_pad_move (unsigned char *out, const unsigned char *m, size_t mlen) {
+  uintptr_t o = (uintptr_t) out;
+  uintptr_t i = (uintptr_t) m;
+
+  if ((o > i && o - i < mlen) || (i > o && i - o < mlen)) {
+    memmove(out, m, mlen);
+    return out;
+  }
+
+  return m;
+}
+
+static void
+_extension_pad_aead_transform (void *ctx, unsigned char *out, const unsigned char *in, size_t len) {
+  sn__extension_aead_chacha20poly1305_ietf_encrypt_update((sn__extension_aead_chacha20poly1305_ietf_state *) ctx, out, in, len);
+}
+
+static int
+_extension_pad_aead_encrypt (sn__extension_aead_chacha20poly1305_ietf_state *state, unsigned char *c, const unsigned char *m, size_t mlen, size_t blocksize, const unsigned char *ad, size_t adlen) {
+  size_t padded_len = sn__extension_pad_padded_length(mlen, blocksize);
+
+  if (padded_len == 0) {
+    sodium_memzero(state, sizeof(*state));
+    return -1;
+  }
+
+  m = _extension_pad_move(c, m, mlen);
+
+  sn__extension_aead_chacha20poly1305_ietf_update_ad(state, ad, adlen);
+  _extension_pad_feed(state, _extension_pad_aead_transform, c, m, mlen, padded_len);
+  sn__extension_aead_chacha20poly1305_ietf_final(state, c + padded_len);
+
+  sodium_memzero(state, sizeof(*state));
+
+  return 0;
+}
+
+int
+sn__extension_pad_aead_chacha20poly1305_ietf_encrypt (unsigned char *c, const unsigned char *m, size_t mlen, size_t blocksize, const unsigned char *ad, size_t adlen, const unsigned char *npub, const unsigned char *k) {
+  sn__extension_aead_chacha20poly1305_ietf_state state;
+
+  if (sn__extension_aead_chacha20poly1305_ietf_init(&state, npub, k) != 0) return -1;
+
+  return _extension_pad_aead_encrypt(&state, c, m, mlen, blocksize, ad, adlen);
+}
+
+int
+sn__extension_pad_aead_xchacha20poly1305_ietf_encrypt (unsigned char *c, const unsigned char *m, size_t mlen, size_t blocksize, const unsigned char *ad, size_t adlen, const unsigned char *npub, const unsigned char *k) {
+  sn__extension_aead_chacha20poly1305_ietf_state state;
+
+  if (sn__extension_aead_xchacha20poly1305_ietf_init(&state, npub, k) != 0) return -1;
+
+  return _extension_pad_aead_encrypt(&state, c, m, mlen, blocksize, ad, adlen);
+}
+
+static int
+_extension_pad_unpad (unsigned char *m, size_t *mlen, size_t padded_len, size_t blocksize) {
+  if (sodium_unpad(mlen, m, padded_len, blocksize) != 0) {
+    sodium_memzero(m, padded_len);
+    return -1;
+  }
+
+  return 0;
+}
+
+int
+sn__extension_pad_aead_chacha20poly1305_ietf_decrypt (unsigned char *m, size_t *mlen, const unsigned char *c, size_t clen, size_t blocksize, const unsigned char *ad, size_t adlen, const unsigned char *npub, const unsigned char *k) {
+  if (blocksize == 0 || clen < crypto_aead_chacha20poly1305_ietf_ABYTES) return -1;
+
+  size_t padded_len = clen - crypto_aead_chacha20poly1305_ietf_ABYTES;
+  if (padded_len == 0 || padded_len % blocksize != 0) return -1;
+
+  if (sn__extension_aead_chacha20poly1305_ietf_decrypt_detached(m, c, padded_len, c + padded_len, ad, adlen, npub, k) != 0) return -1;
+
+  return _extension_pad_unpad(m, mlen, padded_len, blocksize);
+}
+
+int
+sn__extension_pad_aead_xchacha20poly1305_ietf_decrypt (unsigned char *m, size_t *mlen, const unsigned char *c, size_t clen, size_t blocksize, const unsigned char *ad, size_t adlen, const unsigned char *npub, const unsigned char *k) {
+  if (blocksize == 0 || clen < crypto_aead_xchacha20poly1305_ietf_ABYTES) return -1;
+
+  size_t padded_len = clen - crypto_aead_xchacha20poly1305_ietf_ABYTES;
+  if (padded_len == 0 || padded_len % blocksize != 0) return -1;
+
+  if (sn__extension_aead_xchacha20poly1305_ietf_decrypt_detached(m, c, padded_len, c + padded_len, ad, adlen, npub, k) != 0) return -1;
+
+  return _extension_pad_unpad(m, mlen, padded_len, blocksize);
+}
+
+/*
+  crypto_secretbox_easy is XSalsa20 with the first 32 bytes of keystream
+  used as the Poly1305 key and the message encrypted from keystream byte 32.
+  The stream below tracks that byte position so the message and the padding
+  can be encrypted as separate runs, with whole blocks going straight to
+  salsa20 and only the two seams costing a block of their own.
+*/
+
+typedef struct _extension_pad_salsa20_stream {
+  unsigned char n[crypto_stream_salsa20_NONCEBYTES];
+  unsigned char k[crypto_stream_salsa20_KEYBYTES];
+  uint64_t pos;
+} _extension_pad_salsa20_stream;
+
+static void
+_extension_pad_salsa20_transform (void *ctx, unsigned char *out, const unsigned char *in, size_t len) {
+  _extension_pad_salsa20_stream *stream = (_extension_pad_salsa20_stream *) ctx;
+
+  while (len) {
+    size_t offset = stream->pos & 63;
+
+    if (offset == 0 && len >= 64) {
+      size_t bulk = len & ~((size_t) 63);
+
+      crypto_stream_salsa20_xor_ic(out, in, bulk, stream->n, stream->pos >> 6, stream->k);
+
+      stream->pos += bulk;
+      out += bulk;
+      in += bulk;
+      len -= bulk;
+      continue;
+    }
+
+    unsigned char block[64] = { 0 };
+    crypto_stream_salsa20_xor_ic(block, block, sizeof(block), stream->n, stream->pos >> 6, stream->k);
+
+    size_t n = 64 - offset;
+    if (n > len) n = len;
+
+    for (size_t i = 0; i < n; i++) out[i] = in[i] ^ block[offset + i];
+
+    sodium_memzero(block, sizeof(block));
+
+    stream->pos += n;
+    out += n;
+    in += n;
+    len -= n;
+  }
+}
+
+int
+sn__extension_pad_secretbox_easy (unsigned char *c, const unsigned char *m, size_t mlen, size_t blocksize, const unsigned char *n, const unsigned char *k) {
+  size_t padded_len = sn__extension_pad_padded_length(mlen, blocksize);
+  if (padded_len == 0) return -1;
+
+  _extension_pad_salsa20_stream stream;
+  unsigned char mac_key[sn__extension_poly1305_KEYBYTES];
+
+  crypto_core_hsalsa20(stream.k, n, k, NULL);
+  memcpy(stream.n, n + crypto_core_hsalsa20_INPUTBYTES, sizeof(stream.n));
+
+  crypto_stream_salsa20(mac_key, sizeof(mac_key), stream.n, stream.k);
+  stream.pos = sizeof(mac_key);
+
+  unsigned char *body = c + crypto_secretbox_MACBYTES;
+
+  m = _extension_pad_move(body, m, mlen);
+
+  _extension_pad_feed(&stream, _extension_pad_salsa20_transform, body, m, mlen, padded_len);
+  sn__extension_poly1305(c, body, padded_len, mac_key);
+
+  sodium_memzero(&stream, sizeof(stream));
+  sodium_memzero(mac_key, sizeof(mac_key));
+
+  return 0;
+}
+
+int
+sn__extension_pad_secretbox_open_easy (unsigned char *m, size_t *mlen, const unsigned char *c, size_t clen, size_t blocksize, const unsigned char *n, const unsigned char *k) {
+  if (blocksize == 0 || clen < crypto_secretbox_MACBYTES) return -1;
+
+  size_t padded_len = clen - crypto_secretbox_MACBYTES;
+  if (padded_len == 0 || padded_len % blocksize != 0) return -1;
+
+  if (crypto_secretbox_open_easy(m, c, clen, n, k) != 0) return -1;
+
+  return _extension_pad_unpad(m, mlen, padded_len, blocksize);
+}
@@ -0,0 +1,74 @@
+#ifndef SN_EXTENSION_PAD_H
+#define SN_EXTENSION_PAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <sodium.h>
+
+/*
+  Length hiding encryption.
+
+  The message is padded to a multiple of blocksize with ISO/IEC 7816-4
+  padding (0x80 followed by zeros, always at least one byte), exactly like
+  sodium_pad, but the padding is fed to the cipher right after the message
+  instead of being written to a copy first. The output is identical to
+  sodium_pad followed by the regular encrypt call.
+
+  Opening verifies first and only then strips the padding, returning the
+  unpadded length. A ciphertext whose padding is malformed is rejected like
+  one that fails to verify, and m is zeroed.
+*/
+
+// padded length of an unpadded_len byte message, 0 if blocksize is 0 or the result overflows
+size_t sn__extension_pad_padded_length(size_t unpadded_len, size_t blocksize);
+
+// c must hold padded_length(mlen, blocksize) + crypto_aead_chacha20poly1305_ietf_ABYTES bytes
+int sn__extension_pad_aead_chacha20poly1305_ietf_encrypt(unsigned char *c,
+                                                        const unsigned char *m, size_t mlen,
+                                                        size_t blocksize,
+                                                        const unsigned char *ad, size_t adlen,
+                                                        const unsigned char *npub,
+                                                        const unsigned char *k);
+
+int sn__extension_pad_aead_xchacha20poly1305_ietf_encrypt(unsigned char *c,
+                                                         const unsigned char *m, size_t mlen,
+                                                         size_t blocksize,
+                                                         const unsigned char *ad, size_t adlen,
+                                                         const unsigned char *npub,
+                                                         const unsigned char *k);
+
+// m must hold clen - crypto_aead_chacha20poly1305_ietf_ABYTES bytes, returns 0 and sets mlen on success
+int sn__extension_pad_aead_chacha20poly1305_ietf_decrypt(unsigned char *m, size_t *mlen,
+                                                        const unsigned char *c, size_t clen,
+                                                        size_t blocksize,
+                                                        const unsigned char *ad, size_t adlen,
+                                                        const unsigned char *npub,
+                                                        const unsigned char *k);
+
+int sn__extension_pad_aead_xchacha20poly1305_ietf_decrypt(unsigned char *m, size_t *mlen,
+                                                         const unsigned char *c, size_t clen,
+                                                         size_t blocksize,
+                                                         const unsigned char *ad, size_t adlen,
+                                                         const unsigned char *npub,
+                                                         const unsigned char *k);
+
+// c must hold padded_length(mlen, blocksize) + crypto_secretbox_MACBYTES bytes, laid out like crypto_secretbox_easy
+int sn__extension_pad_secretbox_easy(unsigned char *c,
+                                     const unsigned char *m, size_t mlen,
+                                     size_t blocksize,
+                                     const unsigned char *n,
+                                     const unsigned char *k);
+
+int sn__extension_pad_secretbox_open_easy(unsigned char *m, size_t *mlen,
+                                          const unsigned char *c, size_t clen,
+                                          size_t blocksize,
+                                          const unsigned char *n,
+                                          const unsigned char *k);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
@@ -0,0 +1,400 @@
+/*
+  Adapted from libsodium/crypto_onetimeauth/poly1305/donna/poly1305_donna{64,32}.h
+*/
+
+#include <string.h>
+
+#include "poly1305.h"
+
+static void _extension_poly1305_store64_le (unsigned char *dst, uint64_t w)
+{
+  for (int i = 0; i < 8; i++) dst[i] = (unsigned char) (w >> (8 * i));
+}
+
+#ifdef SN_POLY1305_DONNA64
+
+typedef unsigned __int128 sn_poly1305_uint128_t;
+
+static uint64_t _extension_poly1305_load64_le (const unsigned char *src)
+{
+  uint64_t w = 0;
+  for (int i = 7; i >= 0; i--) w = (w << 8) | src[i];
+  return w;
+}
+
+void sn__extension_poly1305_init (sn__extension_poly1305_state *st, const unsigned char *key)
+{
+  uint64_t t0 = _extension_poly1305_load64_le(&key[0]);
+  uint64_t t1 = _extension_poly1305_load64_le(&key[8]);
+
+  // r &= 0xffffffc0ffffffc0ffffffc0fffffff
+  st->r[0] = (t0) & 0xffc0fffffff;
+  st->r[1] = ((t0 >> 44) | (t1 << 20)) & 0xfffffc0ffff;
+  st->r[2] = ((t1 >> 24)) & 0x00ffffffc0f;
+
+  st->h[0] = 0;
+  st->h[1] = 0;
+  st->h[2] = 0;
+
+  st->pad[0] = _extension_poly1305_load64_le(&key[16]);
+  st->pad[1] = _extension_poly1305_load64_le(&key[24]);
+
+  st->leftover = 0;
+  st->final = 0;
+#ifdef SN_POLY1305_AVX2
+  st->powers_ready = 0;
+#endif
+}
+
+void sn__extension_poly1305_blocks (sn__extension_poly1305_state *st, const unsigned char *m, size_t bytes)
+{
+  const uint64_t hibit = st->final ? 0ULL : (1ULL << 40);
+  uint64_t r0 = st->r[0], r1 = st->r[1], r2 = st->r[2];
+  uint64_t s1 = r1 * (5 << 2), s2 = r2 * (5 << 2);
+  uint64_t h0 = st->h[0], h1 = st->h[1], h2 = st->h[2];
+
+  while (bytes >= sn__extension_poly1305_BLOCKBYTES) {
+    uint64_t t0 = _extension_poly1305_load64_le(&m[0]);
+    uint64_t t1 = _extension_poly1305_load64_le(&m[8]);
+
+    h0 += t0 & 0xfffffffffff;
+    h1 += ((t0 >> 44) | (t1 << 20)) & 0xfffffffffff;
+    h2 += (((t1 >> 24)) & 0x3ffffffffff) | hibit;
+
+    sn_poly1305_uint128_t d0 = (sn_poly1305_uint128_t) h0 * r0 + (sn_poly1305_uint128_t) h1 * s2 + (sn_poly1305_uint128_t) h2 * s1;
+    sn_poly1305_uint128_t d1 = (sn_poly1305_uint128_t) h0 * r1 + (sn_poly1305_uint128_t) h1 * r0 + (sn_poly1305_uint128_t) h2 * s2;
+    sn_poly1305_uint128_t d2 = (sn_poly1305_uint128_t) h0 * r2 + (sn_poly1305_uint128_t) h1 * r1 + (sn_poly1305_uint128_t) h2 * r0;
+
+    uint64_t c = (uint64_t) (d0 >> 44);
+    h0 = (uint64_t) d0 & 0xfffffffffff;
+    d1 += c;
+    c = (uint64_t) (d1 >> 44);
+    h1 = (uint64_t) d1 & 0xfffffffffff;
+    d2 += c;
+    c = (uint64_t) (d2 >> 42);
+    h2 = (uint64_t) d2 & 0x3ffffffffff;
+    h0 += c * 5;
+    c = h0 >> 44;
+    h0 = h0 & 0xfffffffffff;
+    h1 += c;
+
+    m += sn__extension_poly1305_BLOCKBYTES;
+    bytes -= sn__extension_poly1305_BLOCKBYTES;
+  }
+
+  st->h[0] = h0;
+  st->h[1] = h1;
+  st->h[2] = h2;
+}
+
+static void _extension_poly1305_finish (sn__extension_poly1305_state *st, unsigned char *mac)
+{
+  uint64_t h0 = st->h[0], h1 = st->h[1], h2 = st->h[2];
+  uint64_t c, g0, g1, g2, t0, t1;
+
+  // fully carry h
+  c = (h1 >> 44);
+  h1 &= 0xfffffffffff;
+  h2 += c;
+  c = (h2 >> 42);
+  h2 &= 0x3ffffffffff;
+  h0 += c * 5;
+  c = (h0 >> 44);
+  h0 &= 0xfffffffffff;
+  h1 += c;
+  c = (h1 >> 44);
+  h1 &= 0xfffffffffff;
+  h2 += c;
+  c = (h2 >> 42);
+  h2 &= 0x3ffffffffff;
+  h0 += c * 5;
+  c = (h0 >> 44);
+  h0 &= 0xfffffffffff;
+  h1 += c;
+
+  // compute h + -p
+  g0 = h0 + 5;
+  c = (g0 >> 44);
+  g0 &= 0xfffffffffff;
+  g1 = h1 + c;
+  c = (g1 >> 44);
+  g1 &= 0xfffffffffff;
+  g2 = h2 + c - (1ULL << 42);
+
+  // select h if h < p, or h + -p if h >= p
+  c = (g2 >> ((sizeof(uint64_t) * 8) - 1)) - 1;
+  g0 &= c;
+  g1 &= c;
+  g2 &= c;
+  c = ~c;
+  h0 = (h0 & c) | g0;
+  h1 = (h1 & c) | g1;
+  h2 = (h2 & c) | g2;
+
+  // h = (h + pad)
+  t0 = st->pad[0];
+  t1 = st->pad[1];
+
+  h0 += ((t0) & 0xfffffffffff);
+  c = (h0 >> 44);
+  h0 &= 0xfffffffffff;
+  h1 += (((t0 >> 44) | (t1 << 20)) & 0xfffffffffff) + c;
+  c = (h1 >> 44);
+  h1 &= 0xfffffffffff;
+  h2 += (((t1 >> 24)) & 0x3ffffffffff) + c;
+  h2 &= 0x3ffffffffff;
+
+  // mac = h % (2^128)
+  h0 = ((h0) | (h1 << 44));
+  h1 = ((h1 >> 20) | (h2 << 24));
+
+  _extension_poly1305_store64_le(&mac[0], h0);
+  _extension_poly1305_store64_le(&mac[8], h1);
+}
+
+#else
+
+static uint32_t _extension_poly1305_load32_le (const unsigned char *src)
+{
+  return (uint32_t) src[0] | ((uint32_t) src[1] << 8) | ((uint32_t) src[2] << 16) | ((uint32_t) src[3] << 24);
+}
+
+void sn__extension_poly1305_init (sn__extension_poly1305_state *st, const unsigned char *key)
+{
+  // r &= 0xffffffc0ffffffc0ffffffc0fffffff
+  st->r[0] = (_extension_poly1305_load32_le(&key[0])) & 0x3ffffff;
+  st->r[1] = (_extension_poly1305_load32_le(&key[3]) >> 2) & 0x3ffff03;
+  st->r[2] = (_extension_poly1305_load32_le(&key[6]) >> 4) & 0x3ffc0ff;
+  st->r[3] = (_extension_poly1305_load32_le(&key[9]) >> 6) & 0x3f03fff;
+  st->r[4] = (_extension_poly1305_load32_le(&key[12]) >> 8) & 0x00fffff;
+
+  st->h[0] = 0;
+  st->h[1] = 0;
+  st->h[2] = 0;
+  st->h[3] = 0;
+  st->h[4] = 0;
+
+  st->pad[0] = _extension_poly1305_load32_le(&key[16]);
+  st->pad[1] = _extension_poly1305_load32_le(&key[20]);
+  st->pad[2] = _extension_poly1305_load32_le(&key[24]);
+  st->pad[3] = _extension_poly1305_load32_le(&key[28]);
+
+  st->leftover = 0;
+  st->final = 0;
+#ifdef SN_POLY1305_AVX2
+  st->powers_ready = 0;
+#endif
+}
+
+void sn__extension_poly1305_blocks (sn__extension_poly1305_state *st, const unsigned char *m, size_t bytes)
+{
+  const uint32_t hibit = st->final ? 0UL : (1UL << 24);
+  uint32_t r0 = st->r[0], r1 = st->r[1], r2 = st->r[2], r3 = st->r[3], r4 = st->r[4];
+  uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+  uint32_t h0 = st->h[0], h1 = st->h[1], h2 = st->h[2], h3 = st->h[3], h4 = st->h[4];
+  uint64_t d0, d1, d2, d3, d4;
+  uint32_t c;
+
+  while (bytes >= sn__extension_poly1305_BLOCKBYTES) {
+    h0 += (_extension_poly1305_load32_le(m + 0)) & 0x3ffffff;
+    h1 += (_extension_poly1305_load32_le(m + 3) >> 2) & 0x3ffffff;
+    h2 += (_extension_poly1305_load32_le(m + 6) >> 4) & 0x3ffffff;
+    h3 += (_extension_poly1305_load32_le(m + 9) >> 6) & 0x3ffffff;
+    h4 += (_extension_poly1305_load32_le(m + 12) >> 8) | hibit;
+
+    d0 = ((uint64_t) h0 * r0) + ((uint64_t) h1 * s4) + ((uint64_t) h2 * s3) + ((uint64_t) h3 * s2) + ((uint64_t) h4 * s1);
+    d1 = ((uint64_t) h0 * r1) + ((uint64_t) h1 * r0) + ((uint64_t) h2 * s4) + ((uint64_t) h3 * s3) + ((uint64_t) h4 * s2);
+    d2 = ((uint64_t) h0 * r2) + ((uint64_t) h1 * r1) + ((uint64_t) h2 * r0) + ((uint64_t) h3 * s4) + ((uint64_t) h4 * s3);
+    d3 = ((uint64_t) h0 * r3) + ((uint64_t) h1 * r2) + ((uint64_t) h2 * r1) + ((uint64_t) h3 * r0) + ((uint64_t) h4 * s4);
+    d4 = ((uint64_t) h0 * r4) + ((uint64_t) h1 * r3) + ((uint64_t) h2 * r2) + ((uint64_t) h3 * r1) + ((uint64_t) h4 * r0);
+
+    c = (uint32_t) (d0 >> 26);
+    h0 = (uint32_t) d0 & 0x3ffffff;
+    d1 += c;
+    c = (uint32_t) (d1 >> 26);
+    h1 = (uint32_t) d1 & 0x3ffffff;
+    d2 += c;
+    c = (uint32_t) (d2 >> 26);
+    h2 = (uint32_t) d2 & 0x3ffffff;
+    d3 += c;
+    c = (uint32_t) (d3 >> 26);
+    h3 = (uint32_t) d3 & 0x3ffffff;
+    d4 += c;
+    c = (uint32_t) (d4 >> 26);
+    h4 = (uint32_t) d4 & 0x3ffffff;
+    h0 += c * 5;
+    c = (h0 >> 26);
+    h0 = h0 & 0x3ffffff;
+    h1 += c;
+
+    m += sn__extension_poly1305_BLOCKBYTES;
+    bytes -= sn__extension_poly1305_BLOCKBYTES;
+  }
+
+  st->h[0] = h0;
+  st->h[1] = h1;
+  st->h[2] = h2;
+  st->h[3] = h3;
+  st->h[4] = h4;
+}
+
+static void _extension_poly1305_finish (sn__extension_poly1305_state *st, unsigned char *mac)
+{
+  uint32_t h0 = st->h[0], h1 = st->h[1], h2 = st->h[2], h3 = st->h[3], h4 = st->h[4];
+  uint32_t c, g0, g1, g2, g3, g4, mask;
+  uint64_t f;
+
+  // fully carry h
+  c = h1 >> 26;
+  h1 = h1 & 0x3ffffff;
+  h2 += c;
+  c = h2 >> 26;
+  h2 = h2 & 0x3ffffff;
+  h3 += c;
+  c = h3 >> 26;
+  h3 = h3 & 0x3ffffff;
+  h4 += c;
+  c = h4 >> 26;
+  h4 = h4 & 0x3ffffff;
+  h0 += c * 5;
+  c = h0 >> 26;
+  h0 = h0 & 0x3ffffff;
+  h1 += c;
+
+  // compute h + -p
+  g0 = h0 + 5;
+  c = g0 >> 26;
+  g0 &= 0x3ffffff;
+  g1 = h1 + c;
+  c = g1 >> 26;
+  g1 &= 0x3ffffff;
+  g2 = h2 + c;
+  c = g2 >> 26;
+  g2 &= 0x3ffffff;
+  g3 = h3 + c;
+  c = g3 >> 26;
+  g3 &= 0x3ffffff;
+  g4 = h4 + c - (1UL << 26);
+
+  // select h if h < p, or h + -p if h >= p
+  mask = (g4 >> ((sizeof(uint32_t) * 8) - 1)) - 1;
+  g0 &= mask;
+  g1 &= mask;
+  g2 &= mask;
+  g3 &= mask;
+  g4 &= mask;
+  mask = ~mask;
+
+  h0 = (h0 & mask) | g0;
+  h1 = (h1 & mask) | g1;
+  h2 = (h2 & mask) | g2;
+  h3 = (h3 & mask) | g3;
+  h4 = (h4 & mask) | g4;
+
+  // h = h % (2^128)
+  h0 = ((h0) | (h1 << 26)) & 0xffffffff;
+  h1 = ((h1 >> 6) | (h2 << 20)) & 0xffffffff;
+  h2 = ((h2 >> 12) | (h3 << 14)) & 0xffffffff;
+  h3 = ((h3 >> 18) | (h4 << 8)) & 0xffffffff;
+
+  // mac = (h + pad) % (2^128)
+  f = (uint64_t) h0 + st->pad[0];
+  h0 = (uint32_t) f;
+  f = (uint64_t) h1 + st->pad[1] + (f >> 32);
+  h1 = (uint32_t) f;
+  f = (uint64_t) h2 + st->pad[2] + (f >> 32);
+  h2 = (uint32_t) f;
+  f = (uint64_t) h3 + st->pad[3] + (f >> 32);
+  h3 = (uint32_t) f;
+
+  _extension_poly1305_store64_le(&mac[0], (uint64_t) h0 | ((uint64_t) h1 << 32));
+  _extension_poly1305_store64_le(&mac[8], (uint64_t) h2 | ((uint64_t) h3 << 32));
+}
+
+#endif
+
+void sn__extension_poly1305_update (sn__extension_poly1305_state *st, const unsigned char *m, size_t bytes)
+{
+  // handle leftover
+  if (st->leftover) {
+    size_t want = sn__extension_poly1305_BLOCKBYTES - st->leftover;
+    if (want > bytes) want = bytes;
+
+    memcpy(st->buffer + st->leftover, m, want);
+    bytes -= want;
+    m += want;
+    st->leftover += want;
+
+    if (st->leftover < sn__extension_poly1305_BLOCKBYTES) return;
+
+    sn__extension_poly1305_blocks(st, st->buffer, sn__extension_poly1305_BLOCKBYTES);
+    st->leftover = 0;
+  }
+
+  // process full blocks
+  if (bytes >= sn__extension_poly1305_BLOCKBYTES) {
+    size_t want = bytes & ~(sn__extension_poly1305_BLOCKBYTES - 1);
+
+#ifdef SN_POLY1305_AVX2
+    if (want >= sn__extension_poly1305_AVX2_MINBYTES && sodium_runtime_has_avx2()) {
+      size_t wide = want & ~((size_t) 4 * sn__extension_poly1305_BLOCKBYTES - 1);
+
+      sn__extension_poly1305_blocks_avx2(st, m, wide);
+      m += wide;
+      bytes -= wide;
+      want -= wide;
+    }
+#endif
+
+    sn__extension_poly1305_blocks(st, m, want);
+    m += want;
+    bytes -= want;
+  }
+
+  // store leftover
+  if (bytes) {
+    memcpy(st->buffer + st->leftover, m, bytes);
+    st->leftover += bytes;
+  }
+}
+
+void sn__extension_poly1305_final (sn__extension_poly1305_state *st, unsigned char *mac)
+{
+  // process the remaining block
+  if (st->leftover) {
+    size_t i = st->leftover;
+
+    st->buffer[i++] = 1;
+    for (; i < sn__extension_poly1305_BLOCKBYTES; i++) st->buffer[i] = 0;
+
+    st->final = 1;
+    sn__extension_poly1305_blocks(st, st->buffer, sn__extension_poly1305_BLOCKBYTES);
+  }
+
+  _extension_poly1305_finish(st, mac);
+
+  sodium_memzero((void *) st, sizeof(*st));
+}
+
+int sn__extension_poly1305 (unsigned char *mac, const unsigned char *m, size_t bytes, const unsigned char *key)
+{
+  sn__extension_poly1305_state st;
+
+  sn__extension_poly1305_init(&st, key);
+  sn__extension_poly1305_update(&st, m, bytes);
+  sn__extension_poly1305_final(&st, mac);
+
+  return 0;
+}
+
+int sn__extension_poly1305_verify (const unsigned char *mac, const unsigned char *m, size_t bytes, const unsigned char *key)
+{
+  unsigned char correct[sn__extension_poly1305_BYTES];
+
+  sn__extension_poly1305(correct, m, bytes, key);
+
+  int ret = crypto_verify_16(correct, mac);
+  sodium_memzero(correct, sizeof correct);
+
+  return ret;
+}
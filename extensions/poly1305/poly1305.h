@@ -0,0 +1,79 @@
+#ifndef SN_EXTENSION_POLY1305_H
+#define SN_EXTENSION_POLY1305_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <sodium.h>
+
+/*
+  Poly1305 with an exposed state layout.
+
+  libsodium keeps its Poly1305 state opaque, which makes it impossible for
+  the stitched AEAD kernels to accumulate the MAC while the keystream is
+  being generated. This is a straight port of the "donna" implementations
+  libsodium uses, 64 bit limbs where 128 bit multiplication is available and
+  32 bit limbs elsewhere, so the output is identical.
+*/
+
+#if defined(__SIZEOF_INT128__)
+#define SN_POLY1305_DONNA64 1
+#endif
+
+// 4-way AVX2 backend, radix 2^26, picked at runtime for long inputs
+#if defined(SN_POLY1305_DONNA64) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SN_POLY1305_AVX2 1
+#endif
+
+#define sn__extension_poly1305_BYTES 16U
+
+#define sn__extension_poly1305_KEYBYTES 32U
+
+#define sn__extension_poly1305_BLOCKBYTES 16U
+
+// below this the cost of setting up the lanes outweighs the 4-way loop
+#define sn__extension_poly1305_AVX2_MINBYTES 256U
+
+typedef struct sn__extension_poly1305_state {
+#ifdef SN_POLY1305_DONNA64
+  uint64_t r[3];
+  uint64_t h[3];
+  uint64_t pad[2];
+#else
+  uint32_t r[5];
+  uint32_t h[5];
+  uint32_t pad[4];
+#endif
+  size_t leftover;
+  unsigned char buffer[sn__extension_poly1305_BLOCKBYTES];
+  unsigned char final;
+#ifdef SN_POLY1305_AVX2
+  unsigned char powers_ready;
+  uint32_t powers[4][5]; // r^4, r^3, r^2, r^1 in radix 2^26
+#endif
+} sn__extension_poly1305_state;
+
+void sn__extension_poly1305_init(sn__extension_poly1305_state *state, const unsigned char *key);
+
+void sn__extension_poly1305_update(sn__extension_poly1305_state *state, const unsigned char *m, size_t bytes);
+
+void sn__extension_poly1305_final(sn__extension_poly1305_state *state, unsigned char *mac);
+
+int sn__extension_poly1305(unsigned char *mac, const unsigned char *m, size_t bytes, const unsigned char *key);
+
+int sn__extension_poly1305_verify(const unsigned char *mac, const unsigned char *m, size_t bytes, const unsigned char *key);
+
+// absorb whole 16 byte blocks, bypassing the buffer
+void sn__extension_poly1305_blocks(sn__extension_poly1305_state *state, const unsigned char *m, size_t bytes);
+
+#ifdef SN_POLY1305_AVX2
+// absorb whole 64 byte groups four blocks at a time, caller checks for AVX2
+void sn__extension_poly1305_blocks_avx2(sn__extension_poly1305_state *state, const unsigned char *m, size_t bytes);
+#endif
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
@@ -0,0 +1,23 @@
+#include "poly1305.h"
+
+#ifdef SN_POLY1305_AVX2
+
+#include "poly1305_avx2.h"
+
+__attribute__((target("avx2"))) void
+sn__extension_poly1305_blocks_avx2 (sn__extension_poly1305_state *st, const unsigned char *m, size_t bytes)
+{
+  sn_poly1305_avx2_t p;
+
+  _extension_poly1305_avx2_start(&p, st);
+
+  while (bytes >= 64) {
+    _extension_poly1305_avx2_update(&p, m);
+    m += 64;
+    bytes -= 64;
+  }
+
+  _extension_poly1305_avx2_finish(&p, st);
+}
+
+#endif
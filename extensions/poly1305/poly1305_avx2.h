@@ -0,0 +1,252 @@
+#ifndef SN_EXTENSION_POLY1305_AVX2_H
+#define SN_EXTENSION_POLY1305_AVX2_H
+
+/*
+  4-way AVX2 Poly1305 helpers, shared by the multi-block backend and the
+  stitched AEAD kernels.
+
+  Four independent accumulators each take every fourth block and are
+  multiplied by r^4 per step. At the end lane i is multiplied by r^(4 - i)
+  and the lanes are summed, which gives the same result as the serial
+  Horner evaluation. Limbs are 26 bits so that products fit
+  _mm256_mul_epu32, the scalar state is converted on entry and exit.
+
+  Only include this from translation units compiled for x86-64.
+*/
+
+#include <immintrin.h>
+
+#include "poly1305.h"
+
+#define SN_POLY1305_MASK26 0x3ffffffULL
+#define SN_POLY1305_MASK42 0x3ffffffffffULL
+#define SN_POLY1305_MASK44 0xfffffffffffULL
+
+// 44/44/42 bit limbs to 26 bit limbs, fully carrying first
+static inline void _extension_poly1305_to26 (uint32_t out[5], uint64_t h0, uint64_t h1, uint64_t h2)
+{
+  uint64_t c;
+
+  c = h0 >> 44;
+  h0 &= SN_POLY1305_MASK44;
+  h1 += c;
+  c = h1 >> 44;
+  h1 &= SN_POLY1305_MASK44;
+  h2 += c;
+  c = h2 >> 42;
+  h2 &= SN_POLY1305_MASK42;
+  h0 += c * 5;
+  c = h0 >> 44;
+  h0 &= SN_POLY1305_MASK44;
+  h1 += c;
+
+  out[0] = (uint32_t) (h0 & SN_POLY1305_MASK26);
+  out[1] = (uint32_t) ((h0 >> 26) + ((h1 & 0xff) << 18));
+  out[2] = (uint32_t) ((h1 >> 8) & SN_POLY1305_MASK26);
+  out[3] = (uint32_t) ((h1 >> 34) + ((h2 & 0xffff) << 10));
+  out[4] = (uint32_t) (h2 >> 16);
+}
+
+// 26 bit limbs (possibly oversized) back to 44/44/42 bit limbs
+static inline void _extension_poly1305_from26 (uint64_t h[3], uint64_t l0, uint64_t l1, uint64_t l2, uint64_t l3, uint64_t l4)
+{
+  uint64_t c, t;
+
+  c = l0 >> 26;
+  l0 &= SN_POLY1305_MASK26;
+  l1 += c;
+  c = l1 >> 26;
+  l1 &= SN_POLY1305_MASK26;
+  l2 += c;
+  c = l2 >> 26;
+  l2 &= SN_POLY1305_MASK26;
+  l3 += c;
+  c = l3 >> 26;
+  l3 &= SN_POLY1305_MASK26;
+  l4 += c;
+  c = l4 >> 26;
+  l4 &= SN_POLY1305_MASK26;
+  l0 += c * 5;
+  c = l0 >> 26;
+  l0 &= SN_POLY1305_MASK26;
+  l1 += c;
+
+  t = l0 + (l1 << 26);
+  h[0] = t & SN_POLY1305_MASK44;
+  t = (t >> 44) + (l2 << 8) + (l3 << 34);
+  h[1] = t & SN_POLY1305_MASK44;
+  t = (t >> 44) + (l4 << 16);
+  h[2] = t & SN_POLY1305_MASK42;
+  h[0] += (t >> 42) * 5;
+  c = h[0] >> 44;
+  h[0] &= SN_POLY1305_MASK44;
+  h[1] += c;
+}
+
+// out = a * b mod 2^130 - 5, partially reduced
+static inline void _extension_poly1305_mul26 (uint32_t out[5], const uint32_t a[5], const uint32_t b[5])
+{
+  uint64_t s1 = (uint64_t) b[1] * 5, s2 = (uint64_t) b[2] * 5, s3 = (uint64_t) b[3] * 5, s4 = (uint64_t) b[4] * 5;
+
+  uint64_t d0 = (uint64_t) a[0] * b[0] + a[1] * s4 + a[2] * s3 + a[3] * s2 + a[4] * s1;
+  uint64_t d1 = (uint64_t) a[0] * b[1] + (uint64_t) a[1] * b[0] + a[2] * s4 + a[3] * s3 + a[4] * s2;
+  uint64_t d2 = (uint64_t) a[0] * b[2] + (uint64_t) a[1] * b[1] + (uint64_t) a[2] * b[0] + a[3] * s4 + a[4] * s3;
+  uint64_t d3 = (uint64_t) a[0] * b[3] + (uint64_t) a[1] * b[2] + (uint64_t) a[2] * b[1] + (uint64_t) a[3] * b[0] + a[4] * s4;
+  uint64_t d4 = (uint64_t) a[0] * b[4] + (uint64_t) a[1] * b[3] + (uint64_t) a[2] * b[2] + (uint64_t) a[3] * b[1] + (uint64_t) a[4] * b[0];
+
+  uint64_t c = d0 >> 26;
+  d0 &= SN_POLY1305_MASK26;
+  d1 += c;
+  c = d1 >> 26;
+  d1 &= SN_POLY1305_MASK26;
+  d2 += c;
+  c = d2 >> 26;
+  d2 &= SN_POLY1305_MASK26;
+  d3 += c;
+  c = d3 >> 26;
+  d3 &= SN_POLY1305_MASK26;
+  d4 += c;
+  c = d4 >> 26;
+  d4 &= SN_POLY1305_MASK26;
+  d0 += c * 5;
+  c = d0 >> 26;
+  d0 &= SN_POLY1305_MASK26;
+  d1 += c;
+
+  out[0] = (uint32_t) d0;
+  out[1] = (uint32_t) d1;
+  out[2] = (uint32_t) d2;
+  out[3] = (uint32_t) d3;
+  out[4] = (uint32_t) d4;
+}
+
+static inline void _extension_poly1305_powers (sn__extension_poly1305_state *st)
+{
+  uint32_t *r4 = st->powers[0], *r3 = st->powers[1], *r2 = st->powers[2], *r1 = st->powers[3];
+
+  _extension_poly1305_to26(r1, st->r[0], st->r[1], st->r[2]);
+  _extension_poly1305_mul26(r2, r1, r1);
+  _extension_poly1305_mul26(r3, r2, r1);
+  _extension_poly1305_mul26(r4, r2, r2);
+
+  st->powers_ready = 1;
+}
+
+// h = h * r mod 2^130 - 5 on four lanes, s = 5 * r
+static inline __attribute__((always_inline, target("avx2"))) void
+_extension_poly1305_mul_avx2 (__m256i h[5], const __m256i r[5], const __m256i s[5], __m256i mask)
+{
+  __m256i d0 = _mm256_add_epi64(_mm256_add_epi64(_mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epu32(h[0], r[0]), _mm256_mul_epu32(h[1], s[4])), _mm256_mul_epu32(h[2], s[3])), _mm256_mul_epu32(h[3], s[2])), _mm256_mul_epu32(h[4], s[1]));
+  __m256i d1 = _mm256_add_epi64(_mm256_add_epi64(_mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epu32(h[0], r[1]), _mm256_mul_epu32(h[1], r[0])), _mm256_mul_epu32(h[2], s[4])), _mm256_mul_epu32(h[3], s[3])), _mm256_mul_epu32(h[4], s[2]));
+  __m256i d2 = _mm256_add_epi64(_mm256_add_epi64(_mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epu32(h[0], r[2]), _mm256_mul_epu32(h[1], r[1])), _mm256_mul_epu32(h[2], r[0])), _mm256_mul_epu32(h[3], s[4])), _mm256_mul_epu32(h[4], s[3]));
+  __m256i d3 = _mm256_add_epi64(_mm256_add_epi64(_mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epu32(h[0], r[3]), _mm256_mul_epu32(h[1], r[2])), _mm256_mul_epu32(h[2], r[1])), _mm256_mul_epu32(h[3], r[0])), _mm256_mul_epu32(h[4], s[4]));
+  __m256i d4 = _mm256_add_epi64(_mm256_add_epi64(_mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epu32(h[0], r[4]), _mm256_mul_epu32(h[1], r[3])), _mm256_mul_epu32(h[2], r[2])), _mm256_mul_epu32(h[3], r[1])), _mm256_mul_epu32(h[4], r[0]));
+  __m256i c;
+
+  c = _mm256_srli_epi64(d0, 26);
+  d0 = _mm256_and_si256(d0, mask);
+  d1 = _mm256_add_epi64(d1, c);
+  c = _mm256_srli_epi64(d1, 26);
+  d1 = _mm256_and_si256(d1, mask);
+  d2 = _mm256_add_epi64(d2, c);
+  c = _mm256_srli_epi64(d2, 26);
+  d2 = _mm256_and_si256(d2, mask);
+  d3 = _mm256_add_epi64(d3, c);
+  c = _mm256_srli_epi64(d3, 26);
+  d3 = _mm256_and_si256(d3, mask);
+  d4 = _mm256_add_epi64(d4, c);
+  c = _mm256_srli_epi64(d4, 26);
+  d4 = _mm256_and_si256(d4, mask);
+  d0 = _mm256_add_epi64(d0, _mm256_add_epi64(c, _mm256_slli_epi64(c, 2)));
+  c = _mm256_srli_epi64(d0, 26);
+  d0 = _mm256_and_si256(d0, mask);
+  d1 = _mm256_add_epi64(d1, c);
+
+  h[0] = d0;
+  h[1] = d1;
+  h[2] = d2;
+  h[3] = d3;
+  h[4] = d4;
+}
+
+// h += four message blocks, block i in lane i
+static inline __attribute__((always_inline, target("avx2"))) void
+_extension_poly1305_absorb_avx2 (__m256i h[5], const unsigned char *m, __m256i mask, __m256i hibit)
+{
+  __m256i a = _mm256_loadu_si256((const __m256i *) m);
+  __m256i b = _mm256_loadu_si256((const __m256i *) (m + 32));
+  __m256i lo = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a, b), 0xd8);
+  __m256i hi = _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(a, b), 0xd8);
+
+  h[0] = _mm256_add_epi64(h[0], _mm256_and_si256(lo, mask));
+  h[1] = _mm256_add_epi64(h[1], _mm256_and_si256(_mm256_srli_epi64(lo, 26), mask));
+  h[2] = _mm256_add_epi64(h[2], _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(lo, 52), _mm256_slli_epi64(hi, 12)), mask));
+  h[3] = _mm256_add_epi64(h[3], _mm256_and_si256(_mm256_srli_epi64(hi, 14), mask));
+  h[4] = _mm256_add_epi64(h[4], _mm256_or_si256(_mm256_srli_epi64(hi, 40), hibit));
+}
+
+typedef struct {
+  __m256i h[5];
+  __m256i r[5];
+  __m256i s[5];
+  __m256i mask;
+  __m256i hibit;
+  int empty;
+} sn_poly1305_avx2_t;
+
+// load the scalar accumulator into lane 0, computing the key powers on first use
+static inline __attribute__((always_inline, target("avx2"))) void
+_extension_poly1305_avx2_start (sn_poly1305_avx2_t *p, sn__extension_poly1305_state *st)
+{
+  uint32_t h26[5];
+
+  if (!st->powers_ready) _extension_poly1305_powers(st);
+
+  _extension_poly1305_to26(h26, st->h[0], st->h[1], st->h[2]);
+
+  for (int i = 0; i < 5; i++) {
+    p->r[i] = _mm256_set1_epi64x(st->powers[0][i]);
+    p->s[i] = _mm256_set1_epi64x((long long) st->powers[0][i] * 5);
+    p->h[i] = _mm256_set_epi64x(0, 0, 0, h26[i]);
+  }
+
+  p->mask = _mm256_set1_epi64x((long long) SN_POLY1305_MASK26);
+  p->hibit = _mm256_set1_epi64x(1LL << 24);
+  p->empty = 1;
+}
+
+// absorb one 64 byte group
+static inline __attribute__((always_inline, target("avx2"))) void
+_extension_poly1305_avx2_update (sn_poly1305_avx2_t *p, const unsigned char *m)
+{
+  if (!p->empty) _extension_poly1305_mul_avx2(p->h, p->r, p->s, p->mask);
+
+  _extension_poly1305_absorb_avx2(p->h, m, p->mask, p->hibit);
+  p->empty = 0;
+}
+
+// fold the lanes back into the scalar accumulator
+static inline __attribute__((always_inline, target("avx2"))) void
+_extension_poly1305_avx2_finish (sn_poly1305_avx2_t *p, sn__extension_poly1305_state *st)
+{
+  if (p->empty) return;
+
+  // lane i still owes r^(4 - i)
+  for (int i = 0; i < 5; i++) {
+    p->r[i] = _mm256_set_epi64x(st->powers[3][i], st->powers[2][i], st->powers[1][i], st->powers[0][i]);
+    p->s[i] = _mm256_add_epi64(p->r[i], _mm256_slli_epi64(p->r[i], 2));
+  }
+
+  _extension_poly1305_mul_avx2(p->h, p->r, p->s, p->mask);
+
+  uint64_t l[5];
+
+  for (int i = 0; i < 5; i++) {
+    __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(p->h[i]), _mm256_extracti128_si256(p->h[i], 1));
+    l[i] = (uint64_t) _mm_cvtsi128_si64(sum) + (uint64_t) _mm_extract_epi64(sum, 1);
+  }
+
+  _extension_poly1305_from26(st->h, l[0], l[1], l[2], l[3], l[4]);
+}
+
+#endif
@@ -0,0 +1,245 @@
+#include <string.h>
+
+#include "ratchet.h"
+
+_Static_assert(sizeof(sn__extension_ratchet_state) == sn__extension_ratchet_STATEBYTES, "ratchet state size");
+_Static_assert(sizeof(sn__extension_ratchet_skipped) == sn__extension_ratchet_SKIPBYTES, "ratchet skipped key size");
+
+#define SN_RATCHET_INIT 0x01
+
+#define SN_RATCHET_MESSAGE_KEY 1
+#define SN_RATCHET_CHAIN_KEY 2
+
+static uint64_t
+sn_ratchet_load64 (const unsigned char *src) {
+  uint64_t w = 0;
+
+  for (int i = 7; i >= 0; i--) w = (w << 8) | src[i];
+
+  return w;
+}
+
+static void
+sn_ratchet_store64 (unsigned char *dst, uint64_t w) {
+  for (int i = 0; i < 8; i++, w >>= 8) dst[i] = (unsigned char) w;
+}
+
+static uint32_t
+sn_ratchet_load32 (const unsigned char *src) {
+  return (uint32_t) src[0] | ((uint32_t) src[1] << 8) | ((uint32_t) src[2] << 16) | ((uint32_t) src[3] << 24);
+}
+
+static void
+sn_ratchet_store32 (unsigned char *dst, uint32_t w) {
+  for (int i = 0; i < 4; i++, w >>= 8) dst[i] = (unsigned char) w;
+}
+
+static void
+sn_ratchet_nonce (unsigned char nonce[crypto_aead_chacha20poly1305_ietf_NPUBBYTES], uint64_t counter) {
+  memset(nonce, 0, 4);
+  sn_ratchet_store64(nonce + 4, counter);
+}
+
+// writes the message key of chain_key (unless key is NULL) and replaces chain_key with the next one
+static void
+sn_ratchet_step (unsigned char *key, unsigned char *chain_key, const unsigned char *ctx) {
+  unsigned char next[sn__extension_ratchet_KEYBYTES];
+
+  if (key != NULL) {
+    crypto_kdf_derive_from_key(key, sn__extension_ratchet_KEYBYTES, SN_RATCHET_MESSAGE_KEY, (const char *) ctx, chain_key);
+  }
+
+  crypto_kdf_derive_from_key(next, sizeof(next), SN_RATCHET_CHAIN_KEY, (const char *) ctx, chain_key);
+  memcpy(chain_key, next, sizeof(next));
+
+  sodium_memzero(next, sizeof(next));
+}
+
+static int64_t
+sn_ratchet_find (const sn__extension_ratchet_state *state, uint64_t counter) {
+  uint32_t size = sn_ratchet_load32(state->size);
+
+  for (uint32_t i = 0; i < size; i++) {
+    if (sn_ratchet_load64(state->skipped[i].counter) == counter) return i;
+  }
+
+  return -1;
+}
+
+static void
+sn_ratchet_remove (sn__extension_ratchet_state *state, uint32_t i) {
+  uint32_t last = sn_ratchet_load32(state->size) - 1;
+
+  if (i != last) memcpy(&state->skipped[i], &state->skipped[last], sizeof(state->skipped[i]));
+
+  sodium_memzero(&state->skipped[last], sizeof(state->skipped[last]));
+  sn_ratchet_store32(state->size, last);
+}
+
+static void
+sn_ratchet_keep (sn__extension_ratchet_state *state, uint64_t counter, const unsigned char *key) {
+  uint32_t capacity = sn_ratchet_load32(state->capacity);
+  uint32_t size = sn_ratchet_load32(state->size);
+  uint32_t slot = size;
+
+  if (size == capacity) {
+    slot = 0;
+
+    for (uint32_t i = 1; i < size; i++) {
+      if (sn_ratchet_load64(state->skipped[i].counter) < sn_ratchet_load64(state->skipped[slot].counter)) slot = i;
+    }
+  } else {
+    sn_ratchet_store32(state->size, size + 1);
+  }
+
+  sn_ratchet_store64(state->skipped[slot].counter, counter);
+  memcpy(state->skipped[slot].key, key, sn__extension_ratchet_KEYBYTES);
+}
+
+// advances the chain to counter to, keeping the keys passed over that will not be evicted right away
+static void
+sn_ratchet_advance (sn__extension_ratchet_state *state, uint64_t to) {
+  unsigned char key[sn__extension_ratchet_KEYBYTES];
+  uint32_t capacity = sn_ratchet_load32(state->capacity);
+
+  for (uint64_t c = sn_ratchet_load64(state->counter); c < to; c++) {
+    if (to - c <= capacity) {
+      sn_ratchet_step(key, state->chain_key, state->ctx);
+      sn_ratchet_keep(state, c, key);
+    } else {
+      sn_ratchet_step(NULL, state->chain_key, state->ctx);
+    }
+  }
+
+  sn_ratchet_store64(state->counter, to);
+
+  sodium_memzero(key, sizeof(key));
+}
+
+int
+sn__extension_ratchet_init (sn__extension_ratchet_state *state, size_t len,
+                            const unsigned char *chain_key, const unsigned char *ctx) {
+  if (len < sn__extension_ratchet_STATEBYTES) return -1;
+  if ((len - sn__extension_ratchet_STATEBYTES) % sn__extension_ratchet_SKIPBYTES != 0) return -1;
+
+  size_t capacity = (len - sn__extension_ratchet_STATEBYTES) / sn__extension_ratchet_SKIPBYTES;
+
+  if (capacity > UINT32_MAX) return -1;
+
+  sodium_memzero(state, len);
+
+  memcpy(state->chain_key, chain_key, sn__extension_ratchet_KEYBYTES);
+  memcpy(state->ctx, ctx, sn__extension_ratchet_CONTEXTBYTES);
+  sn_ratchet_store32(state->capacity, (uint32_t) capacity);
+
+  state->flags = SN_RATCHET_INIT;
+
+  return 0;
+}
+
+int
+sn__extension_ratchet_initialised (const sn__extension_ratchet_state *state, size_t len) {
+  if (len < sn__extension_ratchet_STATEBYTES || !(state->flags & SN_RATCHET_INIT)) return 0;
+
+  uint32_t capacity = sn_ratchet_load32(state->capacity);
+
+  // find, keep and remove index the table by size
+  if (sn_ratchet_load32(state->size) > capacity) return 0;
+
+  return capacity == (len - sn__extension_ratchet_STATEBYTES) / sn__extension_ratchet_SKIPBYTES;
+}
+
+int
+sn__extension_ratchet_next (sn__extension_ratchet_state *state, unsigned char *key, uint64_t *counter) {
+  uint64_t current = sn_ratchet_load64(state->counter);
+
+  if (current == UINT64_MAX) return -1;
+
+  sn_ratchet_step(key, state->chain_key, state->ctx);
+  sn_ratchet_store64(state->counter, current + 1);
+
+  *counter = current;
+
+  return 0;
+}
+
+int
+sn__extension_ratchet_skip (sn__extension_ratchet_state *state, uint64_t n) {
+  uint64_t current = sn_ratchet_load64(state->counter);
+
+  if (n > sn__extension_ratchet_SKIP_MAX || UINT64_MAX - current < n) return -1;
+
+  sn_ratchet_advance(state, current + n);
+
+  return 0;
+}
+
+int
+sn__extension_ratchet_encrypt (sn__extension_ratchet_state *state, unsigned char *c,
+                               const unsigned char *m, size_t m_len,
+                               const unsigned char *ad, size_t ad_len) {
+  unsigned char nonce[crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+  unsigned char key[sn__extension_ratchet_KEYBYTES];
+  uint64_t counter;
+
+  if (sn__extension_ratchet_next(state, key, &counter) != 0) return -1;
+
+  sn_ratchet_nonce(nonce, counter);
+  sn_ratchet_store64(c, counter);
+
+  crypto_aead_chacha20poly1305_ietf_encrypt(c + sn__extension_ratchet_HEADERBYTES, NULL, m, m_len, ad, ad_len, NULL, nonce, key);
+
+  sodium_memzero(key, sizeof(key));
+
+  return 0;
+}
+
+int
+sn__extension_ratchet_decrypt (sn__extension_ratchet_state *state, unsigned char *m,
+                               const unsigned char *c, size_t c_len,
+                               const unsigned char *ad, size_t ad_len) {
+  if (c_len < sn__extension_ratchet_HEADERBYTES + sn__extension_ratchet_ABYTES) return -1;
+
+  unsigned char nonce[crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+  uint64_t counter = sn_ratchet_load64(c);
+  uint64_t current = sn_ratchet_load64(state->counter);
+
+  sn_ratchet_nonce(nonce, counter);
+
+  if (counter < current) {
+    int64_t i = sn_ratchet_find(state, counter);
+
+    if (i < 0) return -1;
+
+    int res = crypto_aead_chacha20poly1305_ietf_decrypt(m, NULL, NULL, c + sn__extension_ratchet_HEADERBYTES, c_len - sn__extension_ratchet_HEADERBYTES, ad, ad_len, nonce, state->skipped[i].key);
+
+    if (res == 0) sn_ratchet_remove(state, (uint32_t) i);
+
+    return res;
+  }
+
+  if (counter == UINT64_MAX || counter - current > sn__extension_ratchet_SKIP_MAX) return -1;
+
+  unsigned char chain_key[sn__extension_ratchet_KEYBYTES];
+  unsigned char key[sn__extension_ratchet_KEYBYTES];
+
+  memcpy(chain_key, state->chain_key, sizeof(chain_key));
+
+  for (uint64_t i = current; i < counter; i++) sn_ratchet_step(NULL, chain_key, state->ctx);
+  sn_ratchet_step(key, chain_key, state->ctx);
+
+  int res = crypto_aead_chacha20poly1305_ietf_decrypt(m, NULL, NULL, c + sn__extension_ratchet_HEADERBYTES, c_len - sn__extension_ratchet_HEADERBYTES, ad, ad_len, nonce, key);
+
+  if (res == 0) {
+    // derives the skipped keys a second time, which only costs anything when messages were lost
+    sn_ratchet_advance(state, counter);
+
+    memcpy(state->chain_key, chain_key, sizeof(chain_key));
+    sn_ratchet_store64(state->counter, counter + 1);
+  }
+
+  sodium_memzero(chain_key, sizeof(chain_key));
+  sodium_memzero(key, sizeof(key));
+
+  return res;
+}
@@ -0,0 +1,92 @@
+#ifndef SN_EXTENSION_RATCHET_H
+#define SN_EXTENSION_RATCHET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <sodium.h>
+
+/*
+  Symmetric key ratchet.
+
+  A chain key that advances once per message, with message key n and
+  chain key n + 1 derived from chain key n by crypto_kdf_derive_from_key
+  under subkey ids 1 and 2 and a caller chosen context. The old chain key
+  is overwritten, so a message key cannot be recovered once it is used.
+
+  encrypt and decrypt derive the key, run crypto_aead_chacha20poly1305_ietf
+  and wipe the key in one call. A message is `counter || ciphertext || tag`,
+  with the 64 bit little endian counter in the clear and the nonce being
+  four zero bytes followed by the same counter.
+
+  Keys of messages that were skipped, by skip or by decrypting a newer
+  message, are kept in a table after the header so late messages still
+  decrypt, once. The table holds (len - STATEBYTES) / SKIPBYTES keys and
+  drops the oldest once full, and a single call never derives more than
+  SKIP_MAX keys ahead. decrypt only changes the state when the tag
+  verifies.
+
+  All fields are bytes so the state can live in any (unaligned) buffer,
+  which should come from sodium_malloc since it holds the chain key and
+  every skipped message key.
+*/
+
+#define sn__extension_ratchet_STATEBYTES 64U
+
+#define sn__extension_ratchet_SKIPBYTES 40U
+
+#define sn__extension_ratchet_KEYBYTES crypto_kdf_KEYBYTES
+
+#define sn__extension_ratchet_CONTEXTBYTES crypto_kdf_CONTEXTBYTES
+
+#define sn__extension_ratchet_HEADERBYTES 8U
+
+#define sn__extension_ratchet_ABYTES crypto_aead_chacha20poly1305_ietf_ABYTES
+
+#define sn__extension_ratchet_SKIP_MAX 1024U
+
+typedef struct sn__extension_ratchet_skipped {
+  unsigned char counter[8];
+  unsigned char key[sn__extension_ratchet_KEYBYTES];
+} sn__extension_ratchet_skipped;
+
+typedef struct sn__extension_ratchet_state {
+  unsigned char chain_key[sn__extension_ratchet_KEYBYTES];
+  unsigned char counter[8];
+  unsigned char ctx[sn__extension_ratchet_CONTEXTBYTES];
+  unsigned char capacity[4];
+  unsigned char size[4];
+  unsigned char flags;
+  unsigned char reserved[7];
+  sn__extension_ratchet_skipped skipped[];
+} sn__extension_ratchet_state;
+
+// returns -1 if len is not STATEBYTES + n * SKIPBYTES
+int sn__extension_ratchet_init(sn__extension_ratchet_state *state, size_t len,
+                               const unsigned char *chain_key, const unsigned char *ctx);
+
+int sn__extension_ratchet_initialised(const sn__extension_ratchet_state *state, size_t len);
+
+// writes the next message key and its counter, returns -1 once the counter is exhausted
+int sn__extension_ratchet_next(sn__extension_ratchet_state *state, unsigned char *key, uint64_t *counter);
+
+// keeps the next n message keys in the skipped table, returns -1 if n is over SKIP_MAX or exhausts the counter
+int sn__extension_ratchet_skip(sn__extension_ratchet_state *state, uint64_t n);
+
+// c must be m_len + HEADERBYTES + ABYTES bytes, returns -1 once the counter is exhausted
+int sn__extension_ratchet_encrypt(sn__extension_ratchet_state *state, unsigned char *c,
+                                  const unsigned char *m, size_t m_len,
+                                  const unsigned char *ad, size_t ad_len);
+
+// m must be c_len - HEADERBYTES - ABYTES bytes, returns -1 on a forged, replayed or too far ahead message
+int sn__extension_ratchet_decrypt(sn__extension_ratchet_state *state, unsigned char *m,
+                                  const unsigned char *c, size_t c_len,
+                                  const unsigned char *ad, size_t ad_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
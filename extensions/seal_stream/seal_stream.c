@@ -0,0 +1,154 @@
+#include <string.h>
+
+#include "seal_stream.h"
+#include "../x25519/x25519.h"
+
+static int
+sn_seal_stream_key (unsigned char key[crypto_secretstream_xchacha20poly1305_KEYBYTES],
+                    const unsigned char *esk_or_sk, const unsigned char *epk_or_pk,
+                    const unsigned char epk[crypto_box_PUBLICKEYBYTES],
+                    const unsigned char pk[crypto_box_PUBLICKEYBYTES]) {
+  unsigned char shared[crypto_scalarmult_BYTES];
+
+  if (sn__extension_x25519_scalarmult(shared, esk_or_sk, epk_or_pk) != 0) return -1;
+
+  crypto_generichash_state h;
+  crypto_generichash_init(&h, NULL, 0, crypto_secretstream_xchacha20poly1305_KEYBYTES);
+  crypto_generichash_update(&h, shared, sizeof(shared));
+  crypto_generichash_update(&h, epk, crypto_box_PUBLICKEYBYTES);
+  crypto_generichash_update(&h, pk, crypto_box_PUBLICKEYBYTES);
+  crypto_generichash_final(&h, key, crypto_secretstream_xchacha20poly1305_KEYBYTES);
+
+  sodium_memzero(shared, sizeof(shared));
+
+  return 0;
+}
+
+// fresh ephemeral keypair, epk goes out and the derived key stays
+static int
+sn_seal_stream_ephemeral (unsigned char key[crypto_secretstream_xchacha20poly1305_KEYBYTES],
+                          unsigned char epk[crypto_box_PUBLICKEYBYTES],
+                          const unsigned char pk[crypto_box_PUBLICKEYBYTES]) {
+  unsigned char esk[crypto_box_SECRETKEYBYTES];
+
+  crypto_box_keypair(epk, esk);
+  int res = sn_seal_stream_key(key, esk, pk, epk, pk);
+  sodium_memzero(esk, sizeof(esk));
+
+  return res;
+}
+
+int
+sn__extension_seal_stream_init (sn__extension_seal_stream_state *state,
+                                 unsigned char header[sn__extension_seal_stream_HEADERBYTES],
+                                 const unsigned char pk[sn__extension_seal_stream_PUBLICKEYBYTES]) {
+  unsigned char key[crypto_secretstream_xchacha20poly1305_KEYBYTES];
+
+  if (sn_seal_stream_ephemeral(key, header, pk) != 0) return -1;
+
+  crypto_secretstream_xchacha20poly1305_init_push(&state->stream, header + crypto_box_PUBLICKEYBYTES, key);
+  state->finished = 0;
+
+  sodium_memzero(key, sizeof(key));
+
+  return 0;
+}
+
+int
+sn__extension_seal_stream_push (sn__extension_seal_stream_state *state,
+                                 unsigned char *c,
+                                 const unsigned char *m, size_t mlen,
+                                 int final) {
+  if (state->finished) return -1;
+
+  unsigned char tag = final ? crypto_secretstream_xchacha20poly1305_TAG_FINAL : crypto_secretstream_xchacha20poly1305_TAG_MESSAGE;
+
+  if (crypto_secretstream_xchacha20poly1305_push(&state->stream, c, NULL, m, mlen, NULL, 0, tag) != 0) return -1;
+
+  state->finished = final != 0;
+
+  return 0;
+}
+
+int
+sn__extension_seal_stream_open_init (sn__extension_seal_stream_state *state,
+                                      const unsigned char header[sn__extension_seal_stream_HEADERBYTES],
+                                      const unsigned char pk[sn__extension_seal_stream_PUBLICKEYBYTES],
+                                      const unsigned char sk[sn__extension_seal_stream_SECRETKEYBYTES]) {
+  unsigned char key[crypto_secretstream_xchacha20poly1305_KEYBYTES];
+
+  if (sn_seal_stream_key(key, sk, header, header, pk) != 0) return -1;
+
+  int res = crypto_secretstream_xchacha20poly1305_init_pull(&state->stream, header + crypto_box_PUBLICKEYBYTES, key);
+  state->finished = 0;
+
+  sodium_memzero(key, sizeof(key));
+
+  return res;
+}
+
+int
+sn__extension_seal_stream_pull (sn__extension_seal_stream_state *state,
+                                 unsigned char *m,
+                                 const unsigned char *c, size_t clen,
+                                 int *final) {
+  unsigned char tag;
+
+  if (state->finished) return -1;
+
+  if (crypto_secretstream_xchacha20poly1305_pull(&state->stream, m, NULL, &tag, c, clen, NULL, 0) != 0) return -1;
+
+  if (tag != crypto_secretstream_xchacha20poly1305_TAG_MESSAGE && tag != crypto_secretstream_xchacha20poly1305_TAG_FINAL) return -1;
+
+  state->finished = tag == crypto_secretstream_xchacha20poly1305_TAG_FINAL;
+  *final = state->finished;
+
+  return 0;
+}
+
+int
+sn__extension_seal_stream_file_run (sn__extension_secretstream_file_job *job,
+                                     const unsigned char pk[sn__extension_seal_stream_PUBLICKEYBYTES],
+                                     const unsigned char *sk) {
+  unsigned char epk[crypto_box_PUBLICKEYBYTES];
+  int res;
+
+  if (sk == NULL) {
+    if (sn_seal_stream_ephemeral(job->key, epk, pk) != 0) return sn__extension_secretstream_file_EAUTH;
+
+    job->encrypt = 1;
+    job->start = 0;
+  } else {
+    uv_fs_t req;
+    uv_buf_t buf = uv_buf_init((char *) epk, sizeof(epk));
+
+    res = uv_fs_open(job->loop, &req, job->src, UV_FS_O_RDONLY, 0, NULL);
+    uv_fs_req_cleanup(&req);
+    if (res < 0) return res;
+
+    uv_file fd = res;
+
+    res = uv_fs_read(job->loop, &req, fd, &buf, 1, 0, NULL);
+    uv_fs_req_cleanup(&req);
+
+    uv_fs_close(job->loop, &req, fd, NULL);
+    uv_fs_req_cleanup(&req);
+
+    if (res < 0) return res;
+    if (res != sizeof(epk)) return sn__extension_secretstream_file_EFORMAT;
+
+    if (sn_seal_stream_key(job->key, sk, epk, epk, pk) != 0) return sn__extension_secretstream_file_EAUTH;
+
+    job->encrypt = 0;
+  }
+
+  job->prefix = epk;
+  job->prefix_len = sizeof(epk);
+
+  res = sn__extension_secretstream_file_run(job);
+
+  sodium_memzero(job->key, sizeof(job->key));
+  job->prefix = NULL;
+
+  return res;
+}
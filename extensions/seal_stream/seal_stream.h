@@ -0,0 +1,71 @@
+#ifndef SN_EXTENSION_SEAL_STREAM_H
+#define SN_EXTENSION_SEAL_STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <sodium.h>
+
+#include "../secretstream_file/secretstream_file.h"
+
+/*
+  Streaming sealed box.
+
+  An anonymous sender encrypts a stream of chunks to a crypto_box public
+  key, in constant memory:
+
+    epk, esk  = fresh X25519 keypair
+    key       = BLAKE2b-256(X25519(esk, pk) || epk || pk)
+    header    = epk || secretstream header
+    chunk     = crypto_secretstream_xchacha20poly1305 frame
+
+  The last chunk is tagged FINAL, so truncation is detected. The ephemeral
+  secret key is wiped as soon as the stream key is derived.
+*/
+
+#define sn__extension_seal_stream_PUBLICKEYBYTES crypto_box_PUBLICKEYBYTES
+
+#define sn__extension_seal_stream_SECRETKEYBYTES crypto_box_SECRETKEYBYTES
+
+#define sn__extension_seal_stream_HEADERBYTES (crypto_box_PUBLICKEYBYTES + crypto_secretstream_xchacha20poly1305_HEADERBYTES)
+
+#define sn__extension_seal_stream_ABYTES crypto_secretstream_xchacha20poly1305_ABYTES
+
+typedef struct sn__extension_seal_stream_state {
+  crypto_secretstream_xchacha20poly1305_state stream;
+  unsigned char finished;
+} sn__extension_seal_stream_state;
+
+// returns -1 if pk is a low order point
+int sn__extension_seal_stream_init(sn__extension_seal_stream_state *state,
+                                   unsigned char header[sn__extension_seal_stream_HEADERBYTES],
+                                   const unsigned char pk[sn__extension_seal_stream_PUBLICKEYBYTES]);
+
+// c must hold mlen + ABYTES bytes, fails once the final chunk has been pushed
+int sn__extension_seal_stream_push(sn__extension_seal_stream_state *state,
+                                   unsigned char *c,
+                                   const unsigned char *m, size_t mlen,
+                                   int final);
+
+int sn__extension_seal_stream_open_init(sn__extension_seal_stream_state *state,
+                                        const unsigned char header[sn__extension_seal_stream_HEADERBYTES],
+                                        const unsigned char pk[sn__extension_seal_stream_PUBLICKEYBYTES],
+                                        const unsigned char sk[sn__extension_seal_stream_SECRETKEYBYTES]);
+
+// m must hold clen - ABYTES bytes, sets final once the last chunk is pulled
+int sn__extension_seal_stream_pull(sn__extension_seal_stream_state *state,
+                                   unsigned char *m,
+                                   const unsigned char *c, size_t clen,
+                                   int *final);
+
+// seals job->src into job->dst when sk is NULL, opens it otherwise, job->key and prefix are set here
+int sn__extension_seal_stream_file_run(sn__extension_secretstream_file_job *job,
+                                       const unsigned char pk[sn__extension_seal_stream_PUBLICKEYBYTES],
+                                       const unsigned char *sk);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
@@ -0,0 +1,58 @@
+#include "secretstream_engine.h"
+
+void sn__extension_secretstream_engine_push (const sn__extension_secretstream_engine_batch *batch,
+                                             size_t lane, size_t lanes)
+{
+  const uint32_t start = batch->offsets[0];
+
+  for (size_t i = 0; i < batch->n; i++) {
+    const uint32_t stream = batch->streams[i];
+    if (stream % lanes != lane) continue;
+
+    const size_t mlen = batch->offsets[i + 1] - batch->offsets[i];
+    const size_t at = (batch->offsets[i] - start) + i * crypto_secretstream_xchacha20poly1305_ABYTES;
+
+    unsigned long long clen;
+    crypto_secretstream_xchacha20poly1305_push(&batch->table[stream], batch->out + at, &clen,
+                                               batch->in + batch->offsets[i], mlen,
+                                               NULL, 0, batch->tags[i]);
+
+    batch->lengths[i] = (uint32_t) clen;
+  }
+}
+
+size_t sn__extension_secretstream_engine_pull (const sn__extension_secretstream_engine_batch *batch,
+                                               size_t lane, size_t lanes)
+{
+  const uint32_t start = batch->offsets[0];
+  size_t failures = 0;
+
+  for (size_t i = 0; i < batch->n; i++) {
+    const uint32_t stream = batch->streams[i];
+    if (stream % lanes != lane) continue;
+
+    // a stream stays stopped at its first bad frame for the rest of the batch
+    if (batch->failed[stream]) {
+      batch->lengths[i] = sn__extension_secretstream_engine_FAILED;
+      failures++;
+      continue;
+    }
+
+    const size_t clen = batch->offsets[i + 1] - batch->offsets[i];
+    const size_t at = (batch->offsets[i] - start) - i * crypto_secretstream_xchacha20poly1305_ABYTES;
+
+    unsigned long long mlen;
+    if (crypto_secretstream_xchacha20poly1305_pull(&batch->table[stream], batch->out + at, &mlen,
+                                                   &batch->tags[i], batch->in + batch->offsets[i], clen,
+                                                   NULL, 0) != 0) {
+      batch->failed[stream] = 1;
+      batch->lengths[i] = sn__extension_secretstream_engine_FAILED;
+      failures++;
+      continue;
+    }
+
+    batch->lengths[i] = (uint32_t) mlen;
+  }
+
+  return failures;
+}
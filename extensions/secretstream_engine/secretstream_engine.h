@@ -0,0 +1,53 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <sodium.h>
+
+/*
+  Secretstream engine.
+
+  Pushes or pulls one tick worth of messages for many
+  crypto_secretstream_xchacha20poly1305 streams at once. The streams live
+  back to back in a single table of states, each initialised with the usual
+  init_push / init_pull.
+
+  Entry i of a batch goes to stream `streams[i]` and covers
+  `in[offsets[i]..offsets[i + 1]]`. Outputs are packed in submission order,
+  so the output offset of every entry follows from the input offsets alone
+  (plus or minus ABYTES per preceding entry) and entries can be processed
+  out of order.
+
+  Entries for the same stream are always processed in submission order by
+  one lane; a batch can be split over `lanes` pool threads, lane k taking
+  the streams with `stream % lanes == k`.
+*/
+
+#define sn__extension_secretstream_engine_FAILED 0xffffffffU
+
+#define sn__extension_secretstream_engine_THREADS_MAX 64U
+
+typedef struct sn__extension_secretstream_engine_batch {
+  crypto_secretstream_xchacha20poly1305_state *table;
+  size_t n;
+  const uint32_t *streams;
+  const uint32_t *offsets;
+  const unsigned char *in;
+  unsigned char *out;
+  unsigned char *tags;
+  uint32_t *lengths;
+  // pull only, one zeroed byte per stream in the table
+  unsigned char *failed;
+} sn__extension_secretstream_engine_batch;
+
+void sn__extension_secretstream_engine_push(const sn__extension_secretstream_engine_batch *batch,
+                                            size_t lane, size_t lanes);
+
+// returns the number of entries in this lane that were not delivered, their lengths are set to FAILED
+size_t sn__extension_secretstream_engine_pull(const sn__extension_secretstream_engine_batch *batch,
+                                              size_t lane, size_t lanes);
+
+#ifdef __cplusplus
+};
+#endif
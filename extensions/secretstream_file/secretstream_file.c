@@ -0,0 +1,326 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "secretstream_file.h"
+
+#define SN_SECRETSTREAM_FILE_HEADERBYTES crypto_secretstream_xchacha20poly1305_HEADERBYTES
+#define SN_SECRETSTREAM_FILE_ABYTES crypto_secretstream_xchacha20poly1305_ABYTES
+
+typedef struct sn_secretstream_file_slot {
+  unsigned char *data;
+  const unsigned char *out;
+  size_t len;
+  int64_t offset;
+  size_t plain;
+} sn_secretstream_file_slot;
+
+static int
+sn_secretstream_file_open (uv_loop_t *loop, const char *path, int flags, uv_file *fd) {
+  uv_fs_t req;
+  int res = uv_fs_open(loop, &req, path, flags, 0644, NULL);
+  uv_fs_req_cleanup(&req);
+
+  if (res < 0) return res;
+
+  *fd = res;
+  return 0;
+}
+
+static void
+sn_secretstream_file_close (uv_loop_t *loop, uv_file fd) {
+  uv_fs_t req;
+  uv_fs_close(loop, &req, fd, NULL);
+  uv_fs_req_cleanup(&req);
+}
+
+static int
+sn_secretstream_file_size (uv_loop_t *loop, uv_file fd, uint64_t *size) {
+  uv_fs_t req;
+  int res = uv_fs_fstat(loop, &req, fd, NULL);
+  if (res == 0) *size = req.statbuf.st_size;
+  uv_fs_req_cleanup(&req);
+
+  return res;
+}
+
+// reads exactly len bytes, a short file is reported as ECHANGED
+static int
+sn_secretstream_file_read (uv_loop_t *loop, uv_file fd, unsigned char *data, size_t len, int64_t offset) {
+  while (len > 0) {
+    uv_fs_t req;
+    uv_buf_t buf = uv_buf_init((char *) data, len > 0x7fffffff ? 0x7fffffff : (unsigned int) len);
+
+    int res = uv_fs_read(loop, &req, fd, &buf, 1, offset, NULL);
+    uv_fs_req_cleanup(&req);
+
+    if (res < 0) return res;
+    if (res == 0) return sn__extension_secretstream_file_ECHANGED;
+
+    data += res;
+    len -= res;
+    offset += res;
+  }
+
+  return 0;
+}
+
+static int
+sn_secretstream_file_write (uv_loop_t *loop, uv_file fd, const unsigned char *data, size_t len, int64_t offset) {
+  while (len > 0) {
+    uv_fs_t req;
+    uv_buf_t buf = uv_buf_init((char *) data, len > 0x7fffffff ? 0x7fffffff : (unsigned int) len);
+
+    int res = uv_fs_write(loop, &req, fd, &buf, 1, offset, NULL);
+    uv_fs_req_cleanup(&req);
+
+    if (res < 0) return res;
+
+    data += res;
+    len -= res;
+    offset += res;
+  }
+
+  return 0;
+}
+
+static int
+sn_secretstream_file_truncate (uv_loop_t *loop, uv_file fd, int64_t size) {
+  uv_fs_t req;
+  int res = uv_fs_ftruncate(loop, &req, fd, size, NULL);
+  uv_fs_req_cleanup(&req);
+
+  return res;
+}
+
+// pulls frame i in place, only the last frame may (and must) carry TAG_FINAL
+static int
+sn_secretstream_file_pull (crypto_secretstream_xchacha20poly1305_state *state, unsigned char *frame, size_t len, int last, size_t *plain) {
+  unsigned long long mlen;
+  unsigned char tag;
+
+  if (crypto_secretstream_xchacha20poly1305_pull(state, frame + 1, &mlen, &tag, frame, len, NULL, 0) != 0) {
+    return sn__extension_secretstream_file_EAUTH;
+  }
+
+  if ((tag == crypto_secretstream_xchacha20poly1305_TAG_FINAL) != last) {
+    return sn__extension_secretstream_file_EAUTH;
+  }
+
+  *plain = (size_t) mlen;
+  return 0;
+}
+
+// writes a batch of frames, which follow each other in the output, with vectored writes
+static int
+sn_secretstream_file_write_slots (uv_loop_t *loop, uv_file fd, const sn_secretstream_file_slot *slots, size_t len) {
+  uv_buf_t bufs[sn__extension_secretstream_file_SLOTS];
+
+  for (size_t i = 0; i < len; i++) bufs[i] = uv_buf_init((char *) slots[i].out, (unsigned int) slots[i].len);
+
+  uv_buf_t *buf = bufs;
+  int64_t offset = slots[0].offset;
+
+  while (len > 0) {
+    uv_fs_t req;
+    int res = uv_fs_write(loop, &req, fd, buf, (unsigned int) len, offset, NULL);
+    uv_fs_req_cleanup(&req);
+
+    if (res < 0) return res;
+
+    size_t written = (size_t) res;
+    offset += res;
+
+    while (len > 0 && written >= buf->len) {
+      written -= buf->len;
+      buf++;
+      len--;
+    }
+
+    if (len > 0) {
+      buf->base += written;
+      buf->len -= written;
+    }
+  }
+
+  return 0;
+}
+
+int
+sn__extension_secretstream_file_run (sn__extension_secretstream_file_job *job) {
+  uv_loop_t *loop = job->loop;
+  const size_t frame_size = job->chunk_size + SN_SECRETSTREAM_FILE_ABYTES;
+  const uint64_t base = job->prefix_len + SN_SECRETSTREAM_FILE_HEADERBYTES;
+
+  if (job->chunk_size == 0 || job->chunk_size > sn__extension_secretstream_file_CHUNKBYTES_MAX) return UV_EINVAL;
+
+  uv_file src, dst;
+  int res = sn_secretstream_file_open(loop, job->src, UV_FS_O_RDONLY, &src);
+  if (res != 0) return res;
+
+  int flags = (job->encrypt ? UV_FS_O_RDWR : UV_FS_O_WRONLY) | UV_FS_O_CREAT;
+  if (job->start == 0) flags |= UV_FS_O_TRUNC;
+
+  res = sn_secretstream_file_open(loop, job->dst, flags, &dst);
+  if (res != 0) {
+    sn_secretstream_file_close(loop, src);
+    return res;
+  }
+
+  crypto_secretstream_xchacha20poly1305_state state;
+  unsigned char header[SN_SECRETSTREAM_FILE_HEADERBYTES];
+
+  sn_secretstream_file_slot slots[sn__extension_secretstream_file_SLOTS];
+  memset(slots, 0, sizeof(slots));
+
+  uint64_t size, n, total;
+  uint64_t bytes = 0;
+
+  res = sn_secretstream_file_size(loop, src, &size);
+  if (res != 0) goto close;
+
+  // n frames, total is the size of the finished output
+  if (job->encrypt) {
+    n = size == 0 ? 1 : (size + job->chunk_size - 1) / job->chunk_size;
+    total = base + size + n * SN_SECRETSTREAM_FILE_ABYTES;
+  } else {
+    if (size < base + SN_SECRETSTREAM_FILE_ABYTES) {
+      res = sn__extension_secretstream_file_EFORMAT;
+      goto close;
+    }
+
+    uint64_t body = size - base;
+    n = (body + frame_size - 1) / frame_size;
+
+    if (body - (n - 1) * frame_size < SN_SECRETSTREAM_FILE_ABYTES) {
+      res = sn__extension_secretstream_file_EFORMAT;
+      goto close;
+    }
+
+    total = body - n * SN_SECRETSTREAM_FILE_ABYTES;
+  }
+
+  if (job->start > n) {
+    res = UV_EINVAL;
+    goto close;
+  }
+
+  for (size_t i = 0; i < sn__extension_secretstream_file_SLOTS; i++) {
+    slots[i].data = (unsigned char *) malloc(frame_size);
+    if (slots[i].data == NULL) {
+      res = UV_ENOMEM;
+      goto close;
+    }
+  }
+
+  if (job->encrypt && job->start == 0) {
+    crypto_secretstream_xchacha20poly1305_init_push(&state, header, job->key);
+
+    res = sn_secretstream_file_write(loop, dst, job->prefix, job->prefix_len, 0);
+    if (res == 0) res = sn_secretstream_file_write(loop, dst, header, sizeof(header), job->prefix_len);
+    if (res != 0) goto close;
+  } else {
+    // push and pull states start out the same, so an encryption resumes by pulling its own output
+    uv_file cipher = job->encrypt ? dst : src;
+    uint64_t cipher_size = size;
+
+    if (job->encrypt) {
+      res = sn_secretstream_file_size(loop, dst, &cipher_size);
+      if (res != 0) goto close;
+    }
+
+    res = sn_secretstream_file_read(loop, cipher, header, sizeof(header), job->prefix_len);
+    if (res != 0) goto close;
+
+    crypto_secretstream_xchacha20poly1305_init_pull(&state, header, job->key);
+
+    for (uint64_t i = 0; i < job->start; i++) {
+      int64_t offset = base + i * frame_size;
+      size_t len = i == n - 1 ? (size_t) ((job->encrypt ? total : size) - offset) : frame_size;
+      size_t plain;
+
+      if (offset + len > cipher_size) {
+        res = sn__extension_secretstream_file_ECHANGED;
+        goto close;
+      }
+
+      res = sn_secretstream_file_read(loop, cipher, slots[0].data, len, offset);
+      if (res != 0) goto close;
+
+      res = sn_secretstream_file_pull(&state, slots[0].data, len, i == n - 1, &plain);
+      if (res != 0) goto close;
+
+      bytes += plain;
+    }
+  }
+
+  job->chunks = job->start;
+  job->bytes = bytes;
+
+  for (uint64_t i = job->start; i < n;) {
+    size_t filled = 0;
+    int err = 0;
+
+    for (; filled < sn__extension_secretstream_file_SLOTS && i < n; filled++, i++) {
+      sn_secretstream_file_slot *slot = &slots[filled];
+      int last = i == n - 1;
+
+      if (job->encrypt) {
+        size_t mlen = last ? (size_t) (size - i * job->chunk_size) : job->chunk_size;
+        unsigned char tag = last ? crypto_secretstream_xchacha20poly1305_TAG_FINAL : crypto_secretstream_xchacha20poly1305_TAG_MESSAGE;
+
+        err = sn_secretstream_file_read(loop, src, slot->data + 1, mlen, i * job->chunk_size);
+        if (err != 0) break;
+
+        crypto_secretstream_xchacha20poly1305_push(&state, slot->data, NULL, slot->data + 1, mlen, NULL, 0, tag);
+
+        slot->out = slot->data;
+        slot->len = mlen + SN_SECRETSTREAM_FILE_ABYTES;
+        slot->offset = base + i * frame_size;
+        slot->plain = mlen;
+      } else {
+        int64_t offset = base + i * frame_size;
+        size_t clen = last ? (size_t) (size - offset) : frame_size;
+
+        err = sn_secretstream_file_read(loop, src, slot->data, clen, offset);
+        if (err == 0) err = sn_secretstream_file_pull(&state, slot->data, clen, last, &slot->plain);
+        if (err != 0) break;
+
+        slot->out = slot->data + 1;
+        slot->len = slot->plain;
+        slot->offset = i * job->chunk_size;
+      }
+    }
+
+    // frames filled before a read or pull error are still written, they are complete
+    if (filled > 0) {
+      res = sn_secretstream_file_write_slots(loop, dst, slots, filled);
+      if (res != 0) break;
+
+      job->chunks += filled;
+      for (size_t k = 0; k < filled; k++) job->bytes += slots[k].plain;
+
+      if (job->progress) job->progress(job->progress_data, job->chunks, job->bytes);
+    }
+
+    if (err != 0) {
+      res = err;
+      break;
+    }
+  }
+
+  if (res == 0) res = sn_secretstream_file_truncate(loop, dst, (int64_t) total);
+
+close:
+  sodium_memzero(&state, sizeof(state));
+
+  for (size_t i = 0; i < sn__extension_secretstream_file_SLOTS; i++) {
+    if (slots[i].data == NULL) continue;
+    sodium_memzero(slots[i].data, frame_size);
+    free(slots[i].data);
+  }
+
+  sn_secretstream_file_close(loop, src);
+  sn_secretstream_file_close(loop, dst);
+
+  return res;
+}
@@ -0,0 +1,76 @@
+#ifndef SN_EXTENSION_SECRETSTREAM_FILE_H
+#define SN_EXTENSION_SECRETSTREAM_FILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <sodium.h>
+#include <uv.h>
+
+/*
+  Secretstream file pipeline.
+
+  Encrypts a file into, or decrypts it from,
+
+    [prefix] || header || frame 0 || frame 1 || ... || frame n - 1
+
+  where every frame but the last holds exactly `chunk_size` bytes of
+  plaintext plus ABYTES, and the last one is tagged FINAL. Frames live at
+  fixed offsets, so they are read and written with positional IO.
+
+  Every stage runs on the calling thread: up to SLOTS frames are read and
+  pushed or pulled, then written with a single vectored write. Memory use is
+  bounded by SLOTS frames regardless of the file size.
+
+  A run can resume at chunk `start`. Frames 0..start - 1 are then pulled
+  again from the ciphertext (the output for encryption, the input for
+  decryption) to rebuild the stream state. This also checks that the
+  part written before the interruption is intact.
+
+  `prefix_len` bytes owned by the caller can precede the header, they are
+  written from `prefix` when encrypting and skipped when decrypting.
+
+  Must be called off the loop thread, all file system calls are synchronous.
+*/
+
+#define sn__extension_secretstream_file_SLOTS 4
+
+#define sn__extension_secretstream_file_CHUNKBYTES_MAX (64U * 1024 * 1024)
+
+// errors above zero, errors below zero are libuv error codes
+#define sn__extension_secretstream_file_EAUTH 1
+#define sn__extension_secretstream_file_EFORMAT 2
+#define sn__extension_secretstream_file_ECHANGED 3
+
+typedef void (*sn__extension_secretstream_file_progress_cb)(void *data, uint64_t chunks, uint64_t bytes);
+
+typedef struct sn__extension_secretstream_file_job {
+  uv_loop_t *loop;
+  const char *src;
+  const char *dst;
+  unsigned char key[crypto_secretstream_xchacha20poly1305_KEYBYTES];
+  size_t chunk_size;
+  uint64_t start;
+  int encrypt;
+
+  const unsigned char *prefix;
+  size_t prefix_len;
+
+  // called after every written batch of frames, may be NULL
+  sn__extension_secretstream_file_progress_cb progress;
+  void *progress_data;
+
+  // chunks written so far (including the resumed ones) and plaintext bytes they hold
+  uint64_t chunks;
+  uint64_t bytes;
+} sn__extension_secretstream_file_job;
+
+int sn__extension_secretstream_file_run(sn__extension_secretstream_file_job *job);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
@@ -0,0 +1,201 @@
+#include <string.h>
+
+#include "transport.h"
+
+_Static_assert(sizeof(sn__extension_transport_state) == sn__extension_transport_STATEBYTES, "transport state size");
+
+#define SN_TRANSPORT_INIT 0x01
+#define SN_TRANSPORT_HAS_PREV 0x02
+
+#define SN_TRANSPORT_OVERHEAD (sn__extension_transport_HEADERBYTES + sn__extension_transport_ABYTES)
+
+static uint64_t
+sn_transport_load64 (const unsigned char *src) {
+  uint64_t w = 0;
+
+  for (int i = 7; i >= 0; i--) w = (w << 8) | src[i];
+
+  return w;
+}
+
+static void
+sn_transport_store64 (unsigned char *dst, uint64_t w) {
+  for (int i = 0; i < 8; i++, w >>= 8) dst[i] = (unsigned char) w;
+}
+
+static void
+sn_transport_nonce (unsigned char nonce[crypto_aead_chacha20poly1305_ietf_NPUBBYTES], uint64_t counter) {
+  memset(nonce, 0, 4);
+  sn_transport_store64(nonce + 4, counter);
+}
+
+// Noise REKEY: the first 32 bytes of encrypting 32 zero bytes under nonce 2^64 - 1
+static void
+sn_transport_rekey (unsigned char *out, const unsigned char *k) {
+  static const unsigned char zero[sn__extension_transport_KEYBYTES] = {0};
+  unsigned char nonce[crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+  unsigned char c[sizeof(zero) + sn__extension_transport_ABYTES];
+
+  sn_transport_nonce(nonce, UINT64_MAX);
+  crypto_aead_chacha20poly1305_ietf_encrypt(c, NULL, zero, sizeof(zero), NULL, 0, NULL, nonce, k);
+  memcpy(out, c, sn__extension_transport_KEYBYTES);
+
+  sodium_memzero(c, sizeof(c));
+}
+
+static uint64_t
+sn_transport_epoch (const sn__extension_transport_state *state, uint64_t counter) {
+  uint64_t rekey = sn_transport_load64(state->rekey);
+
+  return rekey == 0 ? 0 : counter / rekey;
+}
+
+// t is counter + 1, so that a zero top means nothing has been opened
+static int
+sn_transport_replayed (const sn__extension_transport_state *state, uint64_t t) {
+  uint64_t top = sn_transport_load64(state->rx_top);
+
+  if (t > top) return 0;
+  if (top - t > sn__extension_transport_WINDOW) return 1;
+
+  return (state->bitmap[(t >> 3) % sn__extension_transport_BITMAPBYTES] >> (t & 7)) & 1;
+}
+
+static void
+sn_transport_accept (sn__extension_transport_state *state, uint64_t t) {
+  uint64_t top = sn_transport_load64(state->rx_top);
+
+  if (t > top) {
+    uint64_t current = top >> 3;
+    uint64_t steps = (t >> 3) - current;
+
+    if (steps > sn__extension_transport_BITMAPBYTES) steps = sn__extension_transport_BITMAPBYTES;
+
+    for (uint64_t i = 1; i <= steps; i++) {
+      state->bitmap[(current + i) % sn__extension_transport_BITMAPBYTES] = 0;
+    }
+
+    sn_transport_store64(state->rx_top, t);
+  }
+
+  state->bitmap[(t >> 3) % sn__extension_transport_BITMAPBYTES] |= (unsigned char) (1 << (t & 7));
+}
+
+void
+sn__extension_transport_init (sn__extension_transport_state *state,
+                              const unsigned char *tx, const unsigned char *rx,
+                              uint64_t rekey) {
+  sodium_memzero(state, sizeof(*state));
+
+  memcpy(state->tx_key, tx, sn__extension_transport_KEYBYTES);
+  memcpy(state->rx_key, rx, sn__extension_transport_KEYBYTES);
+  sn_transport_store64(state->rekey, rekey);
+
+  state->flags = SN_TRANSPORT_INIT;
+}
+
+int
+sn__extension_transport_initialised (const sn__extension_transport_state *state) {
+  return (state->flags & SN_TRANSPORT_INIT) != 0;
+}
+
+int
+sn__extension_transport_seal (sn__extension_transport_state *state, unsigned char *c,
+                              const unsigned char *m, size_t m_len) {
+  unsigned char nonce[crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+  uint64_t counter = sn_transport_load64(state->tx_counter);
+
+  // 2^64 - 1 is the rekey nonce
+  if (counter == UINT64_MAX) return -1;
+
+  if (counter > 0 && sn_transport_epoch(state, counter) != sn_transport_epoch(state, counter - 1)) {
+    sn_transport_rekey(state->tx_key, state->tx_key);
+  }
+
+  sn_transport_nonce(nonce, counter);
+  sn_transport_store64(c, counter);
+
+  crypto_aead_chacha20poly1305_ietf_encrypt(c + sn__extension_transport_HEADERBYTES, NULL, m, m_len, NULL, 0, NULL, nonce, state->tx_key);
+
+  sn_transport_store64(state->tx_counter, counter + 1);
+
+  return 0;
+}
+
+int
+sn__extension_transport_open (sn__extension_transport_state *state, unsigned char *m,
+                              const unsigned char *c, size_t c_len) {
+  if (c_len < SN_TRANSPORT_OVERHEAD) return -1;
+
+  uint64_t counter = sn_transport_load64(c);
+
+  if (counter == UINT64_MAX || sn_transport_replayed(state, counter + 1)) return -1;
+
+  uint64_t epoch = sn_transport_epoch(state, counter);
+  uint64_t current = sn_transport_load64(state->rx_epoch);
+
+  unsigned char nonce[crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+  unsigned char prev[sn__extension_transport_KEYBYTES];
+  unsigned char next[sn__extension_transport_KEYBYTES];
+  const unsigned char *k;
+
+  if (epoch == current) {
+    k = state->rx_key;
+  } else if (epoch + 1 == current && (state->flags & SN_TRANSPORT_HAS_PREV)) {
+    k = state->rx_prev;
+  } else if (epoch > current && epoch - current <= sn__extension_transport_EPOCHS_AHEAD) {
+    memcpy(next, state->rx_key, sizeof(next));
+
+    for (uint64_t e = current; e < epoch; e++) {
+      memcpy(prev, next, sizeof(prev));
+      sn_transport_rekey(next, prev);
+    }
+
+    k = next;
+  } else {
+    return -1;
+  }
+
+  sn_transport_nonce(nonce, counter);
+
+  int res = crypto_aead_chacha20poly1305_ietf_decrypt(m, NULL, NULL, c + sn__extension_transport_HEADERBYTES, c_len - sn__extension_transport_HEADERBYTES, NULL, 0, nonce, k);
+
+  if (res == 0) {
+    if (k == next) {
+      memcpy(state->rx_prev, prev, sizeof(prev));
+      memcpy(state->rx_key, next, sizeof(next));
+      sn_transport_store64(state->rx_epoch, epoch);
+      state->flags |= SN_TRANSPORT_HAS_PREV;
+    }
+
+    sn_transport_accept(state, counter + 1);
+  }
+
+  if (k == next) {
+    sodium_memzero(prev, sizeof(prev));
+    sodium_memzero(next, sizeof(next));
+  }
+
+  return res;
+}
+
+size_t
+sn__extension_transport_open_many (sn__extension_transport_state *state, unsigned char *m,
+                                   const unsigned char *c, const uint32_t *offsets,
+                                   uint32_t *lengths, size_t n) {
+  size_t opened = 0;
+
+  for (size_t i = 0; i < n; i++) {
+    size_t c_len = offsets[i + 1] - offsets[i];
+    unsigned char *out = m + (offsets[i] - offsets[0]) - i * SN_TRANSPORT_OVERHEAD;
+
+    if (sn__extension_transport_open(state, out, c + offsets[i], c_len) == 0) {
+      lengths[i] = (uint32_t) (c_len - SN_TRANSPORT_OVERHEAD);
+      opened++;
+    } else {
+      lengths[i] = sn__extension_transport_FAILED;
+    }
+  }
+
+  return opened;
+}
@@ -0,0 +1,88 @@
+#ifndef SN_EXTENSION_TRANSPORT_H
+#define SN_EXTENSION_TRANSPORT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <sodium.h>
+
+/*
+  Transport session.
+
+  A pair of one-way keys, typically from a Noise split, used to seal and
+  open datagrams that may be lost, duplicated or reordered. A datagram is
+  `counter || ciphertext || tag`, with the 64 bit little endian counter
+  in the clear and the crypto_aead_chacha20poly1305_ietf nonce being four
+  zero bytes followed by the same counter, as in Noise.
+
+  Opened counters are tracked in a 2048 bit ring bitmap, RFC 6479 style,
+  so anything within WINDOW of the newest counter is accepted once and
+  anything older is dropped. The window only moves after a tag verifies.
+
+  With a rekey interval of N, counter c is sealed under the key of epoch
+  c / N, where each epoch key is the Noise REKEY of the previous one. The
+  receiver keeps the current and the previous epoch key, so reordering
+  across a rekey still opens, and derives at most EPOCHS_AHEAD epochs
+  forward for a datagram that claims to be newer. Counters keep running
+  across epochs, so the replay window does not care about rekeys.
+
+  All fields are bytes so the state can live in any (unaligned) buffer.
+*/
+
+#define sn__extension_transport_STATEBYTES 400U
+
+#define sn__extension_transport_KEYBYTES crypto_aead_chacha20poly1305_ietf_KEYBYTES
+
+#define sn__extension_transport_HEADERBYTES 8U
+
+#define sn__extension_transport_ABYTES crypto_aead_chacha20poly1305_ietf_ABYTES
+
+#define sn__extension_transport_BITMAPBYTES 256U
+
+// the newest byte of the ring is shared with counters ahead of it
+#define sn__extension_transport_WINDOW (8U * sn__extension_transport_BITMAPBYTES - 8U)
+
+#define sn__extension_transport_EPOCHS_AHEAD 4U
+
+#define sn__extension_transport_FAILED 0xffffffffU
+
+typedef struct sn__extension_transport_state {
+  unsigned char tx_key[sn__extension_transport_KEYBYTES];
+  unsigned char rx_key[sn__extension_transport_KEYBYTES];
+  unsigned char rx_prev[sn__extension_transport_KEYBYTES];
+  unsigned char tx_counter[8];
+  unsigned char rx_top[8]; // newest opened counter + 1, 0 before the first
+  unsigned char rx_epoch[8];
+  unsigned char rekey[8]; // 0 never rekeys
+  unsigned char bitmap[sn__extension_transport_BITMAPBYTES];
+  unsigned char flags;
+  unsigned char reserved[15];
+} sn__extension_transport_state;
+
+void sn__extension_transport_init(sn__extension_transport_state *state,
+                                  const unsigned char *tx, const unsigned char *rx,
+                                  uint64_t rekey);
+
+int sn__extension_transport_initialised(const sn__extension_transport_state *state);
+
+// c must be m_len + HEADERBYTES + ABYTES bytes, returns -1 once the counter is exhausted
+int sn__extension_transport_seal(sn__extension_transport_state *state, unsigned char *c,
+                                 const unsigned char *m, size_t m_len);
+
+// m must be c_len - HEADERBYTES - ABYTES bytes, returns -1 on a forged, replayed or too old datagram
+int sn__extension_transport_open(sn__extension_transport_state *state, unsigned char *m,
+                                 const unsigned char *c, size_t c_len);
+
+// datagram i is c[offsets[i]..offsets[i + 1]] and opens to (offsets[i] - offsets[0]) - i * (HEADERBYTES + ABYTES)
+// in m, in order, lengths[i] is FAILED for those that do not open, returns the number opened
+size_t sn__extension_transport_open_many(sn__extension_transport_state *state, unsigned char *m,
+                                         const unsigned char *c, const uint32_t *offsets,
+                                         uint32_t *lengths, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,159 @@
+#include <string.h>
+
+#include "x25519.h"
+
+#ifdef SN_X25519_ADX
+#include <cpuid.h>
+
+// -1 until probed, the race on first use is benign as every thread stores the same value
+static volatile int sn_x25519_adx = -1;
+
+static int
+sn_x25519_probe (void) {
+  unsigned int eax, ebx, ecx, edx;
+
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return 0;
+
+  // leaf 7 ebx: bit 8 is BMI2 (MULX), bit 19 is ADX (ADCX/ADOX)
+  return (ebx & (1U << 8)) && (ebx & (1U << 19));
+}
+#endif
+
+int
+sn__extension_x25519_has_adx (void) {
+#ifdef SN_X25519_ADX
+  int adx = sn_x25519_adx;
+
+  if (adx < 0) sn_x25519_adx = adx = sn_x25519_probe();
+
+  return adx;
+#else
+  return 0;
+#endif
+}
+
+int
+sn__extension_x25519_scalarmult (unsigned char *q, const unsigned char *n, const unsigned char *p) {
+#ifdef SN_X25519_ADX
+  if (sn__extension_x25519_has_adx()) return sn__extension_x25519_scalarmult_adx(q, n, p);
+#endif
+
+  return crypto_scalarmult_curve25519(q, n, p);
+}
+
+int
+sn__extension_x25519_box_beforenm (unsigned char *k, const unsigned char *pk, const unsigned char *sk) {
+  static const unsigned char zero[16] = {0};
+  unsigned char s[crypto_scalarmult_curve25519_BYTES];
+
+  if (sn__extension_x25519_scalarmult(s, sk, pk) != 0) return -1;
+
+  int res = crypto_core_hsalsa20(k, zero, s, NULL);
+
+  sodium_memzero(s, sizeof(s));
+
+  return res;
+}
+
+int
+sn__extension_x25519_box_easy (unsigned char *c, const unsigned char *m, unsigned long long mlen, const unsigned char *n, const unsigned char *pk, const unsigned char *sk) {
+  unsigned char k[crypto_box_BEFORENMBYTES];
+
+  if (sn__extension_x25519_box_beforenm(k, pk, sk) != 0) return -1;
+
+  int res = crypto_box_easy_afternm(c, m, mlen, n, k);
+
+  sodium_memzero(k, sizeof(k));
+
+  return res;
+}
+
+int
+sn__extension_x25519_box_open_easy (unsigned char *m, const unsigned char *c, unsigned long long clen, const unsigned char *n, const unsigned char *pk, const unsigned char *sk) {
+  unsigned char k[crypto_box_BEFORENMBYTES];
+
+  if (sn__extension_x25519_box_beforenm(k, pk, sk) != 0) return -1;
+
+  int res = crypto_box_open_easy_afternm(m, c, clen, n, k);
+
+  sodium_memzero(k, sizeof(k));
+
+  return res;
+}
+
+int
+sn__extension_x25519_box_detached (unsigned char *c, unsigned char *mac, const unsigned char *m, unsigned long long mlen, const unsigned char *n, const unsigned char *pk, const unsigned char *sk) {
+  unsigned char k[crypto_box_BEFORENMBYTES];
+
+  if (sn__extension_x25519_box_beforenm(k, pk, sk) != 0) return -1;
+
+  int res = crypto_box_detached_afternm(c, mac, m, mlen, n, k);
+
+  sodium_memzero(k, sizeof(k));
+
+  return res;
+}
+
+int
+sn__extension_x25519_box_open_detached (unsigned char *m, const unsigned char *c, const unsigned char *mac, unsigned long long clen, const unsigned char *n, const unsigned char *pk, const unsigned char *sk) {
+  unsigned char k[crypto_box_BEFORENMBYTES];
+
+  if (sn__extension_x25519_box_beforenm(k, pk, sk) != 0) return -1;
+
+  int res = crypto_box_open_detached_afternm(m, c, mac, clen, n, k);
+
+  sodium_memzero(k, sizeof(k));
+
+  return res;
+}
+
+// keys = BLAKE2b-512(q || client_pk || server_pk), as crypto_kx does it
+static int
+sn_x25519_kx (unsigned char keys[2 * crypto_kx_SESSIONKEYBYTES], const unsigned char *sk, const unsigned char *remote_pk, const unsigned char *client_pk, const unsigned char *server_pk) {
+  crypto_generichash_state h;
+  unsigned char q[crypto_scalarmult_curve25519_BYTES];
+
+  if (sn__extension_x25519_scalarmult(q, sk, remote_pk) != 0) return -1;
+
+  crypto_generichash_init(&h, NULL, 0, 2 * crypto_kx_SESSIONKEYBYTES);
+  crypto_generichash_update(&h, q, sizeof(q));
+  sodium_memzero(q, sizeof(q));
+  crypto_generichash_update(&h, client_pk, crypto_kx_PUBLICKEYBYTES);
+  crypto_generichash_update(&h, server_pk, crypto_kx_PUBLICKEYBYTES);
+  crypto_generichash_final(&h, keys, 2 * crypto_kx_SESSIONKEYBYTES);
+  sodium_memzero(&h, sizeof(h));
+
+  return 0;
+}
+
+int
+sn__extension_x25519_kx_client_session_keys (unsigned char *rx, unsigned char *tx, const unsigned char *client_pk, const unsigned char *client_sk, const unsigned char *server_pk) {
+  unsigned char keys[2 * crypto_kx_SESSIONKEYBYTES];
+
+  if (rx == NULL) rx = tx;
+  if (tx == NULL) tx = rx;
+
+  if (sn_x25519_kx(keys, client_sk, server_pk, client_pk, server_pk) != 0) return -1;
+
+  memcpy(rx, keys, crypto_kx_SESSIONKEYBYTES);
+  memcpy(tx, keys + crypto_kx_SESSIONKEYBYTES, crypto_kx_SESSIONKEYBYTES);
+  sodium_memzero(keys, sizeof(keys));
+
+  return 0;
+}
+
+int
+sn__extension_x25519_kx_server_session_keys (unsigned char *rx, unsigned char *tx, const unsigned char *server_pk, const unsigned char *server_sk, const unsigned char *client_pk) {
+  unsigned char keys[2 * crypto_kx_SESSIONKEYBYTES];
+
+  if (rx == NULL) rx = tx;
+  if (tx == NULL) tx = rx;
+
+  if (sn_x25519_kx(keys, server_sk, client_pk, client_pk, server_pk) != 0) return -1;
+
+  memcpy(tx, keys, crypto_kx_SESSIONKEYBYTES);
+  memcpy(rx, keys + crypto_kx_SESSIONKEYBYTES, crypto_kx_SESSIONKEYBYTES);
+  sodium_memzero(keys, sizeof(keys));
+
+  return 0;
+}
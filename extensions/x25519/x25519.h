@@ -0,0 +1,61 @@
+#ifndef SN_EXTENSION_X25519_H
+#define SN_EXTENSION_X25519_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <sodium.h>
+
+/*
+  Runtime dispatched X25519.
+
+  On x86-64 cores with BMI2 and ADX the Montgomery ladder runs on a field
+  backend with four 64 bit limbs, where MULX and the two independent ADCX
+  and ADOX carry chains make the 256 x 256 bit products and squares much
+  cheaper than the radix 2^51 and 2^25.5 arithmetic libsodium uses. The
+  ladder, clamping and the all-zero output check follow RFC 7748 and
+  crypto_scalarmult_curve25519, so results and return values are identical.
+  Everything else falls through to libsodium.
+*/
+
+#if defined(__x86_64__) && defined(__SIZEOF_INT128__) && (defined(__GNUC__) || defined(__clang__))
+#define SN_X25519_ADX 1
+#endif
+
+#define sn__extension_x25519_BYTES crypto_scalarmult_curve25519_BYTES
+
+#define sn__extension_x25519_SCALARBYTES crypto_scalarmult_curve25519_SCALARBYTES
+
+// 1 when the ADX backend is used on this machine
+int sn__extension_x25519_has_adx(void);
+
+// drop-in for crypto_scalarmult_curve25519
+int sn__extension_x25519_scalarmult(unsigned char *q, const unsigned char *n, const unsigned char *p);
+
+// drop-in for crypto_box_beforenm
+int sn__extension_x25519_box_beforenm(unsigned char *k, const unsigned char *pk, const unsigned char *sk);
+
+// drop-ins for crypto_box_easy, crypto_box_open_easy, crypto_box_detached and crypto_box_open_detached
+int sn__extension_x25519_box_easy(unsigned char *c, const unsigned char *m, unsigned long long mlen, const unsigned char *n, const unsigned char *pk, const unsigned char *sk);
+
+int sn__extension_x25519_box_open_easy(unsigned char *m, const unsigned char *c, unsigned long long clen, const unsigned char *n, const unsigned char *pk, const unsigned char *sk);
+
+int sn__extension_x25519_box_detached(unsigned char *c, unsigned char *mac, const unsigned char *m, unsigned long long mlen, const unsigned char *n, const unsigned char *pk, const unsigned char *sk);
+
+int sn__extension_x25519_box_open_detached(unsigned char *m, const unsigned char *c, const unsigned char *mac, unsigned long long clen, const unsigned char *n, const unsigned char *pk, const unsigned char *sk);
+
+// drop-ins for crypto_kx_client_session_keys and crypto_kx_server_session_keys
+int sn__extension_x25519_kx_client_session_keys(unsigned char *rx, unsigned char *tx, const unsigned char *client_pk, const unsigned char *client_sk, const unsigned char *server_pk);
+
+int sn__extension_x25519_kx_server_session_keys(unsigned char *rx, unsigned char *tx, const unsigned char *server_pk, const unsigned char *server_sk, const unsigned char *client_pk);
+
+#ifdef SN_X25519_ADX
+int sn__extension_x25519_scalarmult_adx(unsigned char *q, const unsigned char *n, const unsigned char *p);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
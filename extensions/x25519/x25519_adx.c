@@ -0,0 +1,534 @@
+#include "x25519.h"
+
+#ifdef SN_X25519_ADX
+
+#include <string.h>
+#include <x86intrin.h>
+
+/*
+  Field elements are four 64 bit limbs holding any value below 2^256, only
+  reduced mod 2^255 - 19 when encoded. Products are folded with
+  2^256 = 38 (mod p). Everything is branch free and the ladder swaps in
+  constant time.
+*/
+
+#define SN_X25519_ADX_TARGET __attribute__((target("bmi2,adx")))
+
+typedef uint64_t sn_x25519_fe[4];
+
+// the four limbs behind a pointer, as an asm memory operand
+#define SN_X25519_FE(p) (*(sn_x25519_fe *) (p))
+
+/*
+  mul, sqr and addsub clobber most of the general registers, so they take
+  "memory" instead of memory operands for their limbs: at -O0 each memory
+  operand needs an address register of its own and the constraints would
+  not fit.
+*/
+
+/*
+  Folds the 512 bit product in r8..r15 into r with 2^256 = 38, low halves on
+  the ADOX chain and high halves on the ADCX chain, then folds the last
+  carry word the same way.
+*/
+#define SN_X25519_ADX_REDUCE \
+  "movq $38, %%rdx\n\t" \
+  "xorl %%ecx, %%ecx\n\t" \
+  "mulxq %%r12, %%rax, %%r12\n\t" \
+  "adoxq %%r8, %%rax\n\t" \
+  "adcxq %%r12, %%r9\n\t" \
+  "mulxq %%r13, %%rcx, %%r13\n\t" \
+  "adoxq %%rcx, %%r9\n\t" \
+  "adcxq %%r13, %%r10\n\t" \
+  "mulxq %%r14, %%rcx, %%r14\n\t" \
+  "adoxq %%rcx, %%r10\n\t" \
+  "adcxq %%r14, %%r11\n\t" \
+  "mulxq %%r15, %%rcx, %%r15\n\t" \
+  "adoxq %%rcx, %%r11\n\t" \
+  "adcxq %[zero], %%r15\n\t" \
+  "adoxq %[zero], %%r15\n\t" \
+  "imulq $38, %%r15, %%r15\n\t" \
+  "addq %%r15, %%rax\n\t" \
+  "adcq $0, %%r9\n\t" \
+  "adcq $0, %%r10\n\t" \
+  "adcq $0, %%r11\n\t" \
+  "sbbq %%r15, %%r15\n\t" \
+  "andq $38, %%r15\n\t" \
+  "addq %%r15, %%rax\n\t" \
+  "movq %%rax, 0(%[r])\n\t" \
+  "movq %%r9, 8(%[r])\n\t" \
+  "movq %%r10, 16(%[r])\n\t" \
+  "movq %%r11, 24(%[r])\n\t"
+
+// ADCX and ADOX only take register or memory sources, this is the zero for closing both chains
+static const uint64_t sn_x25519_zero = 0;
+
+// adds rcx * 38 to r8..r11 and stores them to r, rcx * 38 must fit in 64 bits
+#define SN_X25519_ADX_FOLD \
+  "imulq $38, %%rcx, %%rcx\n\t" \
+  "addq %%rcx, %%r8\n\t" \
+  "adcq $0, %%r9\n\t" \
+  "adcq $0, %%r10\n\t" \
+  "adcq $0, %%r11\n\t" \
+  "sbbq %%rcx, %%rcx\n\t" \
+  "andq $38, %%rcx\n\t" \
+  "addq %%rcx, %%r8\n\t" \
+  "movq %%r8, 0(%[r])\n\t" \
+  "movq %%r9, 8(%[r])\n\t" \
+  "movq %%r10, 16(%[r])\n\t" \
+  "movq %%r11, 24(%[r])\n\t"
+
+/*
+  r = a * b mod 2^256 - 38. Each row of the schoolbook product keeps the
+  low halves on the ADOX (overflow flag) chain and the high halves on the
+  ADCX (carry flag) chain so the two additions interleave with the MULX
+  issue. The high 256 bits are then folded in times 38 the same way. r may
+  alias a or b, it is only written once everything has been read.
+*/
+static inline SN_X25519_ADX_TARGET void
+sn_x25519_mul (uint64_t r[4], const uint64_t a[4], const uint64_t b[4]) {
+  __asm__(
+    // row 0, t0..t4 in r8, r9, r10, r11, r12
+    "movq 0(%[a]), %%rdx\n\t"
+    "mulxq 0(%[b]), %%r8, %%r9\n\t"
+    "mulxq 8(%[b]), %%rax, %%r10\n\t"
+    "addq %%rax, %%r9\n\t"
+    "mulxq 16(%[b]), %%rax, %%r11\n\t"
+    "adcq %%rax, %%r10\n\t"
+    "mulxq 24(%[b]), %%rax, %%r12\n\t"
+    "adcq %%rax, %%r11\n\t"
+    "adcq $0, %%r12\n\t"
+
+    // row 1
+    "movq 8(%[a]), %%rdx\n\t"
+    "xorl %%ecx, %%ecx\n\t"
+    "mulxq 0(%[b]), %%rax, %%rcx\n\t"
+    "adoxq %%rax, %%r9\n\t"
+    "adcxq %%rcx, %%r10\n\t"
+    "mulxq 8(%[b]), %%rax, %%rcx\n\t"
+    "adoxq %%rax, %%r10\n\t"
+    "adcxq %%rcx, %%r11\n\t"
+    "mulxq 16(%[b]), %%rax, %%rcx\n\t"
+    "adoxq %%rax, %%r11\n\t"
+    "adcxq %%rcx, %%r12\n\t"
+    "mulxq 24(%[b]), %%rax, %%r13\n\t"
+    "adoxq %%rax, %%r12\n\t"
+    "adcxq %[zero], %%r13\n\t"
+    "adoxq %[zero], %%r13\n\t"
+
+    // row 2
+    "movq 16(%[a]), %%rdx\n\t"
+    "xorl %%ecx, %%ecx\n\t"
+    "mulxq 0(%[b]), %%rax, %%rcx\n\t"
+    "adoxq %%rax, %%r10\n\t"
+    "adcxq %%rcx, %%r11\n\t"
+    "mulxq 8(%[b]), %%rax, %%rcx\n\t"
+    "adoxq %%rax, %%r11\n\t"
+    "adcxq %%rcx, %%r12\n\t"
+    "mulxq 16(%[b]), %%rax, %%rcx\n\t"
+    "adoxq %%rax, %%r12\n\t"
+    "adcxq %%rcx, %%r13\n\t"
+    "mulxq 24(%[b]), %%rax, %%r14\n\t"
+    "adoxq %%rax, %%r13\n\t"
+    "adcxq %[zero], %%r14\n\t"
+    "adoxq %[zero], %%r14\n\t"
+
+    // row 3
+    "movq 24(%[a]), %%rdx\n\t"
+    "xorl %%ecx, %%ecx\n\t"
+    "mulxq 0(%[b]), %%rax, %%rcx\n\t"
+    "adoxq %%rax, %%r11\n\t"
+    "adcxq %%rcx, %%r12\n\t"
+    "mulxq 8(%[b]), %%rax, %%rcx\n\t"
+    "adoxq %%rax, %%r12\n\t"
+    "adcxq %%rcx, %%r13\n\t"
+    "mulxq 16(%[b]), %%rax, %%rcx\n\t"
+    "adoxq %%rax, %%r13\n\t"
+    "adcxq %%rcx, %%r14\n\t"
+    "mulxq 24(%[b]), %%rax, %%r15\n\t"
+    "adoxq %%rax, %%r14\n\t"
+    "adcxq %[zero], %%r15\n\t"
+    "adoxq %[zero], %%r15\n\t"
+
+    SN_X25519_ADX_REDUCE
+
+    :
+    : [r] "r"(r), [a] "r"(a), [b] "r"(b), [zero] "m"(sn_x25519_zero)
+    : "rax", "rcx", "rdx", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15", "cc", "memory"
+  );
+}
+
+/*
+  r = a^2 mod 2^256 - 38. The six cross products are summed once and
+  doubled, then the four squares are added on the diagonal.
+*/
+static inline SN_X25519_ADX_TARGET void
+sn_x25519_sqr (uint64_t r[4], const uint64_t a[4]) {
+  __asm__(
+    // cross products into r9..r14: a0 * (a1, a2, a3)
+    "movq 0(%[a]), %%rdx\n\t"
+    "mulxq 8(%[a]), %%r9, %%r10\n\t"
+    "mulxq 16(%[a]), %%rax, %%r11\n\t"
+    "addq %%rax, %%r10\n\t"
+    "mulxq 24(%[a]), %%rax, %%r12\n\t"
+    "adcq %%rax, %%r11\n\t"
+    "adcq $0, %%r12\n\t"
+
+    // a1 * (a2, a3)
+    "movq 8(%[a]), %%rdx\n\t"
+    "xorl %%ecx, %%ecx\n\t"
+    "mulxq 16(%[a]), %%rax, %%rcx\n\t"
+    "adoxq %%rax, %%r11\n\t"
+    "adcxq %%rcx, %%r12\n\t"
+    "mulxq 24(%[a]), %%rax, %%r13\n\t"
+    "adoxq %%rax, %%r12\n\t"
+    "adcxq %[zero], %%r13\n\t"
+    "adoxq %[zero], %%r13\n\t"
+
+    // a2 * a3
+    "movq 16(%[a]), %%rdx\n\t"
+    "mulxq 24(%[a]), %%rax, %%r14\n\t"
+    "addq %%rax, %%r13\n\t"
+    "adcq $0, %%r14\n\t"
+
+    // doubled, then the diagonal a0^2, a1^2, a2^2, a3^2
+    "xorl %%ecx, %%ecx\n\t"
+    "movq 0(%[a]), %%rdx\n\t"
+    "mulxq %%rdx, %%r8, %%rcx\n\t"
+    "adcxq %%r9, %%r9\n\t"
+    "adoxq %%rcx, %%r9\n\t"
+    "movq 8(%[a]), %%rdx\n\t"
+    "mulxq %%rdx, %%rax, %%rcx\n\t"
+    "adcxq %%r10, %%r10\n\t"
+    "adoxq %%rax, %%r10\n\t"
+    "adcxq %%r11, %%r11\n\t"
+    "adoxq %%rcx, %%r11\n\t"
+    "movq 16(%[a]), %%rdx\n\t"
+    "mulxq %%rdx, %%rax, %%rcx\n\t"
+    "adcxq %%r12, %%r12\n\t"
+    "adoxq %%rax, %%r12\n\t"
+    "adcxq %%r13, %%r13\n\t"
+    "adoxq %%rcx, %%r13\n\t"
+    "movq 24(%[a]), %%rdx\n\t"
+    "mulxq %%rdx, %%rax, %%r15\n\t"
+    "adcxq %%r14, %%r14\n\t"
+    "adoxq %%rax, %%r14\n\t"
+    "adcxq %[zero], %%r15\n\t"
+    "adoxq %[zero], %%r15\n\t"
+
+    SN_X25519_ADX_REDUCE
+
+    :
+    : [r] "r"(r), [a] "r"(a), [zero] "m"(sn_x25519_zero)
+    : "rax", "rcx", "rdx", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15", "cc", "memory"
+  );
+}
+
+static inline SN_X25519_ADX_TARGET void
+sn_x25519_sub (uint64_t r[4], const uint64_t a[4], const uint64_t b[4]) {
+  __asm__(
+    "movq 0(%[a]), %%r8\n\t"
+    "movq 8(%[a]), %%r9\n\t"
+    "movq 16(%[a]), %%r10\n\t"
+    "movq 24(%[a]), %%r11\n\t"
+    "subq 0(%[b]), %%r8\n\t"
+    "sbbq 8(%[b]), %%r9\n\t"
+    "sbbq 16(%[b]), %%r10\n\t"
+    "sbbq 24(%[b]), %%r11\n\t"
+
+    // a borrow wrapped by 2^256, take 38 back off
+    "sbbq %%rcx, %%rcx\n\t"
+    "andq $38, %%rcx\n\t"
+    "subq %%rcx, %%r8\n\t"
+    "sbbq $0, %%r9\n\t"
+    "sbbq $0, %%r10\n\t"
+    "sbbq $0, %%r11\n\t"
+
+    // borrowing again leaves r8 near 2^64, so this cannot borrow
+    "sbbq %%rcx, %%rcx\n\t"
+    "andq $38, %%rcx\n\t"
+    "subq %%rcx, %%r8\n\t"
+    "movq %%r8, 0(%[r])\n\t"
+    "movq %%r9, 8(%[r])\n\t"
+    "movq %%r10, 16(%[r])\n\t"
+    "movq %%r11, 24(%[r])\n\t"
+
+    : "=m"(SN_X25519_FE(r))
+    : [r] "r"(r), [a] "r"(a), [b] "r"(b), "m"(SN_X25519_FE(a)), "m"(SN_X25519_FE(b))
+    : "rcx", "r8", "r9", "r10", "r11", "cc"
+  );
+}
+
+// s = a + b, d = a - b, loading a and b once
+static inline SN_X25519_ADX_TARGET void
+sn_x25519_addsub (uint64_t s[4], uint64_t d[4], const uint64_t a[4], const uint64_t b[4]) {
+  __asm__(
+    "movq 0(%[a]), %%r8\n\t"
+    "movq 8(%[a]), %%r9\n\t"
+    "movq 16(%[a]), %%r10\n\t"
+    "movq 24(%[a]), %%r11\n\t"
+    "movq %%r8, %%r12\n\t"
+    "movq %%r9, %%r13\n\t"
+    "movq %%r10, %%r14\n\t"
+    "movq %%r11, %%r15\n\t"
+
+    "subq 0(%[b]), %%r12\n\t"
+    "sbbq 8(%[b]), %%r13\n\t"
+    "sbbq 16(%[b]), %%r14\n\t"
+    "sbbq 24(%[b]), %%r15\n\t"
+    "sbbq %%rcx, %%rcx\n\t"
+    "andq $38, %%rcx\n\t"
+    "subq %%rcx, %%r12\n\t"
+    "sbbq $0, %%r13\n\t"
+    "sbbq $0, %%r14\n\t"
+    "sbbq $0, %%r15\n\t"
+    "sbbq %%rcx, %%rcx\n\t"
+    "andq $38, %%rcx\n\t"
+    "subq %%rcx, %%r12\n\t"
+
+    "addq 0(%[b]), %%r8\n\t"
+    "adcq 8(%[b]), %%r9\n\t"
+    "adcq 16(%[b]), %%r10\n\t"
+    "adcq 24(%[b]), %%r11\n\t"
+    "sbbq %%rcx, %%rcx\n\t"
+    "negq %%rcx\n\t"
+
+    "movq %%r12, 0(%[d])\n\t"
+    "movq %%r13, 8(%[d])\n\t"
+    "movq %%r14, 16(%[d])\n\t"
+    "movq %%r15, 24(%[d])\n\t"
+
+    SN_X25519_ADX_FOLD
+
+    :
+    : [r] "r"(s), [d] "r"(d), [a] "r"(a), [b] "r"(b)
+    : "rcx", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15", "cc", "memory"
+  );
+}
+
+// r = a * 121666 + b, 121666 being (A + 2) / 4 for curve25519
+static inline SN_X25519_ADX_TARGET void
+sn_x25519_mul121666_add (uint64_t r[4], const uint64_t a[4], const uint64_t b[4]) {
+  __asm__(
+    "movl $121666, %%edx\n\t"
+    "mulxq 0(%[a]), %%r8, %%r9\n\t"
+    "mulxq 8(%[a]), %%rax, %%r10\n\t"
+    "addq %%rax, %%r9\n\t"
+    "mulxq 16(%[a]), %%rax, %%r11\n\t"
+    "adcq %%rax, %%r10\n\t"
+    "mulxq 24(%[a]), %%rax, %%rcx\n\t"
+    "adcq %%rax, %%r11\n\t"
+    "adcq $0, %%rcx\n\t"
+    "addq 0(%[b]), %%r8\n\t"
+    "adcq 8(%[b]), %%r9\n\t"
+    "adcq 16(%[b]), %%r10\n\t"
+    "adcq 24(%[b]), %%r11\n\t"
+    "adcq $0, %%rcx\n\t"
+
+    SN_X25519_ADX_FOLD
+
+    : "=m"(SN_X25519_FE(r))
+    : [r] "r"(r), [a] "r"(a), [b] "r"(b), "m"(SN_X25519_FE(a)), "m"(SN_X25519_FE(b))
+    : "rax", "rcx", "rdx", "r8", "r9", "r10", "r11", "cc"
+  );
+}
+
+static inline SN_X25519_ADX_TARGET void
+sn_x25519_sqr_n (uint64_t r[4], const uint64_t a[4], int n) {
+  sn_x25519_sqr(r, a);
+
+  while (--n > 0) sn_x25519_sqr(r, r);
+}
+
+// r = z^(p - 2), the addition chain from ref10
+static SN_X25519_ADX_TARGET void
+sn_x25519_invert (uint64_t r[4], const uint64_t z[4]) {
+  sn_x25519_fe t0, t1, t2, t3;
+
+  sn_x25519_sqr(t0, z);
+  sn_x25519_sqr_n(t1, t0, 2);
+  sn_x25519_mul(t1, z, t1);
+  sn_x25519_mul(t0, t0, t1);
+  sn_x25519_sqr(t2, t0);
+  sn_x25519_mul(t1, t1, t2);
+  sn_x25519_sqr_n(t2, t1, 5);
+  sn_x25519_mul(t1, t2, t1);
+  sn_x25519_sqr_n(t2, t1, 10);
+  sn_x25519_mul(t2, t2, t1);
+  sn_x25519_sqr_n(t3, t2, 20);
+  sn_x25519_mul(t2, t3, t2);
+  sn_x25519_sqr_n(t2, t2, 10);
+  sn_x25519_mul(t1, t2, t1);
+  sn_x25519_sqr_n(t2, t1, 50);
+  sn_x25519_mul(t2, t2, t1);
+  sn_x25519_sqr_n(t3, t2, 100);
+  sn_x25519_mul(t2, t3, t2);
+  sn_x25519_sqr_n(t2, t2, 50);
+  sn_x25519_mul(t1, t2, t1);
+  sn_x25519_sqr_n(t1, t1, 5);
+  sn_x25519_mul(r, t1, t0);
+}
+
+/*
+  Swaps a and b when swap is 1, in constant time. Written out limb by limb
+  so the compiler cannot turn it into 16 byte loads, which would stall on
+  forwarding from the 8 byte stores the field routines just made.
+*/
+static inline void
+sn_x25519_cswap (uint64_t a[4], uint64_t b[4], uint64_t swap) {
+  uint64_t mask = 0 - swap;
+
+  __asm__(
+    "movq 0(%[a]), %%r8\n\t"
+    "movq 0(%[b]), %%r9\n\t"
+    "movq %%r8, %%rax\n\t"
+    "xorq %%r9, %%rax\n\t"
+    "andq %[mask], %%rax\n\t"
+    "xorq %%rax, %%r8\n\t"
+    "xorq %%rax, %%r9\n\t"
+    "movq %%r8, 0(%[a])\n\t"
+    "movq %%r9, 0(%[b])\n\t"
+    "movq 8(%[a]), %%r8\n\t"
+    "movq 8(%[b]), %%r9\n\t"
+    "movq %%r8, %%rax\n\t"
+    "xorq %%r9, %%rax\n\t"
+    "andq %[mask], %%rax\n\t"
+    "xorq %%rax, %%r8\n\t"
+    "xorq %%rax, %%r9\n\t"
+    "movq %%r8, 8(%[a])\n\t"
+    "movq %%r9, 8(%[b])\n\t"
+    "movq 16(%[a]), %%r8\n\t"
+    "movq 16(%[b]), %%r9\n\t"
+    "movq %%r8, %%rax\n\t"
+    "xorq %%r9, %%rax\n\t"
+    "andq %[mask], %%rax\n\t"
+    "xorq %%rax, %%r8\n\t"
+    "xorq %%rax, %%r9\n\t"
+    "movq %%r8, 16(%[a])\n\t"
+    "movq %%r9, 16(%[b])\n\t"
+    "movq 24(%[a]), %%r8\n\t"
+    "movq 24(%[b]), %%r9\n\t"
+    "movq %%r8, %%rax\n\t"
+    "xorq %%r9, %%rax\n\t"
+    "andq %[mask], %%rax\n\t"
+    "xorq %%rax, %%r8\n\t"
+    "xorq %%rax, %%r9\n\t"
+    "movq %%r8, 24(%[a])\n\t"
+    "movq %%r9, 24(%[b])\n\t"
+
+    : "+m"(SN_X25519_FE(a)), "+m"(SN_X25519_FE(b))
+    : [a] "r"(a), [b] "r"(b), [mask] "r"(mask)
+    : "rax", "r8", "r9"
+  );
+}
+
+static inline void
+sn_x25519_load (uint64_t r[4], const unsigned char *s) {
+  for (int i = 0; i < 4; i++) {
+    uint64_t w = 0;
+
+    for (int j = 7; j >= 0; j--) w = (w << 8) | s[8 * i + j];
+
+    r[i] = w;
+  }
+
+  // RFC 7748 ignores the top bit of u
+  r[3] &= 0x7fffffffffffffffULL;
+}
+
+// fully reduced mod 2^255 - 19, little endian
+static inline SN_X25519_ADX_TARGET void
+sn_x25519_store (unsigned char *s, const uint64_t a[4]) {
+  unsigned long long r[4], t[4];
+  unsigned char cf;
+
+  // below 2^255 + 19 after folding bit 255
+  cf = _addcarryx_u64(0, a[0], (a[3] >> 63) * 19, &r[0]);
+  cf = _addcarryx_u64(cf, a[1], 0, &r[1]);
+  cf = _addcarryx_u64(cf, a[2], 0, &r[2]);
+  _addcarryx_u64(cf, a[3] & 0x7fffffffffffffffULL, 0, &r[3]);
+
+  // r >= p exactly when r + 19 reaches bit 255
+  cf = _addcarryx_u64(0, r[0], 19, &t[0]);
+  cf = _addcarryx_u64(cf, r[1], 0, &t[1]);
+  cf = _addcarryx_u64(cf, r[2], 0, &t[2]);
+  _addcarryx_u64(cf, r[3], 0, &t[3]);
+
+  uint64_t mask = 0 - (t[3] >> 63);
+  t[3] &= 0x7fffffffffffffffULL;
+
+  for (int i = 0; i < 4; i++) {
+    uint64_t w = (t[i] & mask) | (r[i] & ~mask);
+
+    for (int j = 0; j < 8; j++) s[8 * i + j] = (unsigned char) (w >> (8 * j));
+  }
+}
+
+SN_X25519_ADX_TARGET int
+sn__extension_x25519_scalarmult_adx (unsigned char *q, const unsigned char *n, const unsigned char *p) {
+  unsigned char e[32];
+  sn_x25519_fe x1, x2, z2, x3, z3, a, aa, b, bb, c, d, da, cb, t;
+  uint64_t swap = 0;
+
+  memcpy(e, n, 32);
+  e[0] &= 248;
+  e[31] &= 127;
+  e[31] |= 64;
+
+  sn_x25519_load(x1, p);
+
+  memset(x2, 0, sizeof(x2));
+  memset(z2, 0, sizeof(z2));
+  memset(z3, 0, sizeof(z3));
+  memcpy(x3, x1, sizeof(x3));
+  x2[0] = 1;
+  z3[0] = 1;
+
+  for (int pos = 254; pos >= 0; pos--) {
+    uint64_t bit = (e[pos / 8] >> (pos & 7)) & 1;
+
+    swap ^= bit;
+    sn_x25519_cswap(x2, x3, swap);
+    sn_x25519_cswap(z2, z3, swap);
+    swap = bit;
+
+    sn_x25519_addsub(a, b, x2, z2);
+    sn_x25519_addsub(c, d, x3, z3);
+    sn_x25519_mul(da, d, a);
+    sn_x25519_mul(cb, c, b);
+    sn_x25519_sqr(aa, a);
+    sn_x25519_sqr(bb, b);
+
+    sn_x25519_addsub(x3, z3, da, cb);
+    sn_x25519_sqr(x3, x3);
+    sn_x25519_sqr(z3, z3);
+    sn_x25519_mul(z3, z3, x1);
+
+    sn_x25519_mul(x2, aa, bb);
+    sn_x25519_sub(t, aa, bb);
+    sn_x25519_mul121666_add(z2, t, bb);
+    sn_x25519_mul(z2, z2, t);
+  }
+
+  sn_x25519_cswap(x2, x3, swap);
+  sn_x25519_cswap(z2, z3, swap);
+
+  sn_x25519_invert(z2, z2);
+  sn_x25519_mul(x2, x2, z2);
+  sn_x25519_store(q, x2);
+
+  sodium_memzero(e, sizeof(e));
+  sodium_memzero(x2, sizeof(x2));
+  sodium_memzero(z2, sizeof(z2));
+  sodium_memzero(x3, sizeof(x3));
+  sodium_memzero(z3, sizeof(z3));
+
+  // same all-zero output check as crypto_scalarmult_curve25519
+  volatile unsigned char acc = 0;
+
+  for (int i = 0; i < 32; i++) acc |= q[i];
+
+  return -(1 & ((acc - 1) >> 8));
+}
+
+#endif
@@ -3,6 +3,9 @@ const { isNode } = require('which-runtime')
 
 module.exports = exports = { ...binding }
 
+// pins the next noise ephemeral key, for known answer tests only
+delete exports._extension_noise_fixed_ephemeral
+
 exports.sodium_malloc = function (size) {
   const buf = Buffer.from(binding._sodium_malloc(size))
   buf.secure = true
@@ -140,6 +143,44 @@ exports.crypto_secretstream_xchacha20poly1305_pull = function (state, m, tag, c,
   return res
 }
 
+// encrypts frame[TAGBYTES..frame.byteLength - ABYTES + TAGBYTES] where it lies, frame becomes tag || c || mac
+/** @returns {number} */
+exports.crypto_secretstream_xchacha20poly1305_push_inplace = function (state, frame, ad, tag) {
+  ad ||= OPTIONAL
+
+  if (frame.byteLength < binding.crypto_secretstream_xchacha20poly1305_ABYTES) throw new Error('invalid frame length')
+
+  const res = binding.crypto_secretstream_xchacha20poly1305_push_inplace(
+    state.buffer, state.byteOffset, state.byteLength,
+    frame.buffer, frame.byteOffset, frame.byteLength,
+    ad.buffer, ad.byteOffset, ad.byteLength,
+    tag
+  )
+
+  if (res < 0) throw new Error('push failed')
+
+  return res
+}
+
+// decrypts over the ciphertext, leaving the message at frame[TAGBYTES..], a frame that fails to verify is left as is
+/** @returns {number} */
+exports.crypto_secretstream_xchacha20poly1305_pull_inplace = function (state, tag, frame, ad) {
+  ad ||= OPTIONAL
+
+  if (frame.byteLength < binding.crypto_secretstream_xchacha20poly1305_ABYTES) throw new Error('invalid frame length')
+
+  const res = binding.crypto_secretstream_xchacha20poly1305_pull_inplace(
+    state.buffer, state.byteOffset, state.byteLength,
+    tag.buffer, tag.byteOffset, tag.byteLength,
+    frame.buffer, frame.byteOffset, frame.byteLength,
+    ad.buffer, ad.byteOffset, ad.byteLength
+  )
+
+  if (res < 0) throw new Error('pull failed')
+
+  return res
+}
+
 /** @returns {boolean} */
 exports.crypto_sign_verify_detached = function (sig, m, pk) {
   return binding.crypto_sign_verify_detached(
@@ -159,3 +200,67 @@ exports.crypto_stream_xor = function (c, m, n, k) {
 
   if (res !== 0) throw new Error('status: ' + res)
 }
+
+// resolves, or calls cb, once every block-aligned range has been xored on the worker pool
+exports.crypto_stream_chacha20_xor_parallel = function (c, m, n, k, ic = 0, cb) {
+  if (cb === undefined) return binding.crypto_stream_chacha20_xor_parallel(c, m, n, k, ic)
+  binding.crypto_stream_chacha20_xor_parallel(c, m, n, k, ic, cb)
+}
+
+exports.crypto_stream_chacha20_ietf_xor_parallel = function (c, m, n, k, ic = 0, cb) {
+  if (cb === undefined) return binding.crypto_stream_chacha20_ietf_xor_parallel(c, m, n, k, ic)
+  binding.crypto_stream_chacha20_ietf_xor_parallel(c, m, n, k, ic, cb)
+}
+
+exports.crypto_stream_xchacha20_xor_parallel = function (c, m, n, k, ic = 0, cb) {
+  if (cb === undefined) return binding.crypto_stream_xchacha20_xor_parallel(c, m, n, k, ic)
+  binding.crypto_stream_xchacha20_xor_parallel(c, m, n, k, ic, cb)
+}
+
+exports.crypto_stream_salsa20_xor_parallel = function (c, m, n, k, ic = 0, cb) {
+  if (cb === undefined) return binding.crypto_stream_salsa20_xor_parallel(c, m, n, k, ic)
+  binding.crypto_stream_salsa20_xor_parallel(c, m, n, k, ic, cb)
+}
+
+// low is the fewest keypairs left after a draw since the previous call
+exports.extension_keypair_pool_stats = function (pool) {
+  const stats = new Uint32Array(binding.extension_keypair_pool_STATS)
+  binding.extension_keypair_pool_stats(pool, stats)
+
+  return {
+    available: stats[0],
+    capacity: stats[1],
+    low: stats[2],
+    pending: stats[3],
+    draws: stats[4],
+    misses: stats[5],
+    fills: stats[6]
+  }
+}
+
+// nonce used by the latest call that drew from the sequence
+exports.extension_nonce_sequence_nonce = function (state) {
+  return state.subarray(0, state[2 * binding.extension_nonce_sequence_NONCEBYTES_MAX])
+}
+
+// resolves with the number of chunks, opts.start resumes at a chunk (see err.chunks on failure)
+exports.extension_secretstream_encrypt_file = function (src, dst, key, chunkSize, opts = {}) {
+  return binding.extension_secretstream_encrypt_file(src, dst, key, chunkSize, opts.start || 0, opts.onprogress || null)
+}
+
+exports.extension_secretstream_decrypt_file = function (src, dst, key, chunkSize, opts = {}) {
+  return binding.extension_secretstream_decrypt_file(src, dst, key, chunkSize, opts.start || 0, opts.onprogress || null)
+}
+
+exports.extension_seal_stream_seal_file = function (src, dst, pk, chunkSize, opts = {}) {
+  return binding.extension_seal_stream_seal_file(src, dst, pk, chunkSize, 0, opts.onprogress || null)
+}
+
+exports.extension_seal_stream_open_file = function (src, dst, pk, sk, chunkSize, opts = {}) {
+  return binding.extension_seal_stream_open_file(src, dst, pk, sk, chunkSize, opts.start || 0, opts.onprogress || null)
+}
+
+// rs is the responder's static key, required by an IK initiator
+exports.extension_noise_init = function (state, pattern, initiator, prologue, pk, sk, rs = null) {
+  binding.extension_noise_init(state, pattern, initiator ? 1 : 0, prologue, pk, sk, rs)
+}
@@ -221,6 +221,51 @@
   SN_TYPEDARRAY_ASSERT(name, name##_argv, #name " must be an instance of TypedArray") \
   SN_TYPEDARRAY_PTR(name, name##_argv)
 
+#define SN_ARGV_IOVECS(name, index) \
+  std::vector<sn_iovec_t> name; \
+  size_t name##_size = 0; \
+  if (sn_get_iovecs(env, argv[index], false, name, &name##_size, #name " must be an instance of TypedArray or an Array of TypedArrays") != 0) { \
+    return NULL; \
+  }
+
+#define SN_ARGV_OPTS_IOVECS(name, index) \
+  std::vector<sn_iovec_t> name; \
+  size_t name##_size = 0; \
+  if (sn_get_iovecs(env, argv[index], true, name, &name##_size, #name " must be an instance of TypedArray or an Array of TypedArrays") != 0) { \
+    return NULL; \
+  }
+
+// in the _seq variants of a binding the nonce argument is a nonce sequence state, the next nonce is drawn from it
+#define SN_ASSERT_NONCE(sequence, name, bytes) \
+  if (sequence) { \
+    SN_THROWS(name##_size != sizeof(sn__extension_nonce_sequence_state), #name " must be 'extension_nonce_sequence_STATEBYTES' bytes") \
+    SN_THROWS(((sn__extension_nonce_sequence_state *) name##_data)->noncebytes != bytes, "nonce sequence must be initialised with " #bytes) \
+  } else { \
+    SN_THROWS(name##_size != bytes, "\"" #name "\" must be " #bytes " bytes long") \
+  }
+
+// advances the sequence, so it comes after every other argument check
+#define SN_NONCE_SEQUENCE(sequence, name, bytes) \
+  if (sequence) { \
+    sn__extension_nonce_sequence_state *name##_sequence = (sn__extension_nonce_sequence_state *) name##_data; \
+    SN_THROWS(sn__extension_nonce_sequence_next(name##_sequence) != 0, "nonce sequence exhausted") \
+    name##_data = name##_sequence->nonce; \
+    name##_size = bytes; \
+  }
+
+#define SN_ARGV_UINT32ARRAY(name, index) \
+  js_value_t *name##_argv = argv[index]; \
+  SN_TYPEDARRAY_ASSERT(name, name##_argv, #name " must be an instance of Uint32Array") \
+  js_typedarray_type_t name##_type; \
+  size_t name##_length; \
+  uint32_t *name##_data = NULL; \
+  SN_STATUS_THROWS(js_get_typedarray_info(env, name##_argv, &name##_type, (void **) &name##_data, &name##_length, NULL, NULL), "") \
+  if (name##_type != js_uint32array) { \
+    err = js_throw_type_error(env, NULL, #name " must be an instance of Uint32Array"); \
+    assert(err == 0); \
+    return NULL; \
+  }
+
 #define SN_ARGV_BUFFER_CAST(type, name, index) \
   js_value_t *name##_argv = argv[index]; \
   SN_BUFFER_CAST(type, name, name##_argv)
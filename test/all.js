@@ -29,7 +29,17 @@ async function runTests () {
   await import('./crypto_stream.js')
   await import('./crypto_stream_chacha20.js')
   await import('./crypto_stream_chacha20_ietf.js')
+  await import('./extension_box_cache.js')
+  await import('./extension_envelope.js')
+  await import('./extension_keypair_pool.js')
+  await import('./extension_noise.js')
+  await import('./extension_nonce_sequence.js')
   await import('./extension_pbkdf2.js')
+  await import('./extension_ratchet.js')
+  await import('./extension_seal_stream.js')
+  await import('./extension_secretstream_engine.js')
+  await import('./extension_secretstream_file.js')
+  await import('./extension_transport.js')
   await import('./extension_tweak_ed25519.js')
   await import('./helpers.js')
   await import('./memory.js')
@@ -298,6 +298,208 @@ test('non-detached -> detached', function (t) {
   t.alike(m, m1)
 })
 
+test('encryptv / decryptv over segments', function (t) {
+  const key = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_KEYBYTES)
+  const nonce = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES)
+  sodium.randombytes_buf(key)
+  sodium.randombytes_buf(nonce)
+
+  for (const mlen of [0, 1, 63, 64, 65, 1000]) {
+    const m = Buffer.alloc(mlen)
+    const ad = Buffer.alloc(37)
+    sodium.randombytes_buf(m)
+    sodium.randombytes_buf(ad)
+
+    const expected = Buffer.alloc(mlen + sodium.crypto_aead_xchacha20poly1305_ietf_ABYTES)
+    sodium.crypto_aead_xchacha20poly1305_ietf_encrypt(expected, m, ad, null, nonce, key)
+
+    const c = Buffer.alloc(expected.byteLength)
+    t.is(sodium.crypto_aead_xchacha20poly1305_ietf_encryptv(split(c), split(m), split(ad), null, nonce, key), c.byteLength)
+    t.alike(c, expected)
+
+    const m1 = Buffer.alloc(mlen)
+    t.is(sodium.crypto_aead_xchacha20poly1305_ietf_decryptv(split(m1), null, split(c), split(ad), nonce, key), mlen)
+    t.alike(m1, m)
+
+    const m2 = Buffer.alloc(mlen)
+    t.is(sodium.crypto_aead_xchacha20poly1305_ietf_decryptv(m2, null, c, ad, nonce, key), mlen)
+    t.alike(m2, m)
+  }
+})
+
+test('encryptv_detached / decryptv_detached in place', function (t) {
+  const key = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_KEYBYTES)
+  const nonce = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES)
+  sodium.randombytes_buf(key)
+  sodium.randombytes_buf(nonce)
+
+  const m = Buffer.alloc(777)
+  sodium.randombytes_buf(m)
+
+  const expected = Buffer.alloc(m.byteLength)
+  const expectedMac = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_ABYTES)
+  sodium.crypto_aead_xchacha20poly1305_ietf_encrypt_detached(expected, expectedMac, m, null, null, nonce, key)
+
+  const buf = Buffer.from(m)
+  const segments = split(buf)
+  const mac = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_ABYTES)
+
+  t.is(sodium.crypto_aead_xchacha20poly1305_ietf_encryptv_detached(segments, mac, segments, null, null, nonce, key), mac.byteLength)
+  t.alike(buf, expected)
+  t.alike(mac, expectedMac)
+
+  sodium.crypto_aead_xchacha20poly1305_ietf_decryptv_detached(segments, null, segments, mac, null, nonce, key)
+  t.alike(buf, m)
+})
+
+test('decryptv rejects tampered segments', function (t) {
+  const key = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_KEYBYTES)
+  const nonce = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES)
+  sodium.randombytes_buf(key)
+  sodium.randombytes_buf(nonce)
+
+  const m = Buffer.from('Ladies and Gentlemen of the class of \'99')
+  const ad = Buffer.from('header')
+  const c = Buffer.alloc(m.byteLength + sodium.crypto_aead_xchacha20poly1305_ietf_ABYTES)
+  sodium.crypto_aead_xchacha20poly1305_ietf_encryptv(c, [m.subarray(0, 10), m.subarray(10)], ad, null, nonce, key)
+
+  const m1 = Buffer.alloc(m.byteLength)
+
+  c[c.byteLength - 1] ^= 1
+  t.exception.all(() => sodium.crypto_aead_xchacha20poly1305_ietf_decryptv(m1, null, split(c), ad, nonce, key))
+  t.ok(sodium.sodium_is_zero(m1), 'no unverified plaintext is released')
+  c[c.byteLength - 1] ^= 1
+
+  t.exception.all(() => sodium.crypto_aead_xchacha20poly1305_ietf_decryptv(m1, null, c, Buffer.from('Header'), nonce, key))
+  t.exception.all(() => sodium.crypto_aead_xchacha20poly1305_ietf_encryptv(c, [m, 'not a buffer'], ad, null, nonce, key))
+})
+
+test('verify / verify_detached', function (t) {
+  const key = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_KEYBYTES)
+  const nonce = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES)
+  sodium.randombytes_buf(key)
+  sodium.randombytes_buf(nonce)
+
+  const m = Buffer.from('Ladies and Gentlemen of the class of \'99')
+  const ad = Buffer.from('header')
+
+  const c = Buffer.alloc(m.byteLength + sodium.crypto_aead_xchacha20poly1305_ietf_ABYTES)
+  sodium.crypto_aead_xchacha20poly1305_ietf_encrypt(c, m, ad, null, nonce, key)
+
+  const ciphertext = c.subarray(0, m.byteLength)
+  const mac = c.subarray(m.byteLength)
+
+  t.ok(sodium.crypto_aead_xchacha20poly1305_ietf_verify(c, ad, nonce, key))
+  t.ok(sodium.crypto_aead_xchacha20poly1305_ietf_verify_detached(ciphertext, mac, ad, nonce, key))
+
+  t.absent(sodium.crypto_aead_xchacha20poly1305_ietf_verify(c, null, nonce, key))
+  t.absent(sodium.crypto_aead_xchacha20poly1305_ietf_verify_detached(ciphertext, mac, Buffer.from('Header'), nonce, key))
+
+  const empty = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_ABYTES)
+  sodium.crypto_aead_xchacha20poly1305_ietf_encrypt(empty, Buffer.alloc(0), null, null, nonce, key)
+  t.ok(sodium.crypto_aead_xchacha20poly1305_ietf_verify(empty, null, nonce, key))
+
+  c[0] ^= 1
+  t.absent(sodium.crypto_aead_xchacha20poly1305_ietf_verify(c, ad, nonce, key))
+  t.absent(sodium.crypto_aead_xchacha20poly1305_ietf_verify_detached(ciphertext, mac, ad, nonce, key))
+  c[0] ^= 1
+
+  mac[0] ^= 1
+  t.absent(sodium.crypto_aead_xchacha20poly1305_ietf_verify_detached(ciphertext, mac, ad, nonce, key))
+  mac[0] ^= 1
+
+  t.exception.all(() => sodium.crypto_aead_xchacha20poly1305_ietf_verify(Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_ABYTES - 1), null, nonce, key))
+})
+
+test('large messages match the segmented path', function (t) {
+  const key = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_KEYBYTES)
+  const nonce = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES)
+  sodium.randombytes_buf(key)
+  sodium.randombytes_buf(nonce)
+
+  // split() keeps every segment below the 512 byte stitched chunk
+  for (const mlen of [511, 512, 513, 1023, 1024, 1600, 4096 + 17, 65536 + 3]) {
+    const m = Buffer.alloc(mlen)
+    const ad = Buffer.alloc(29)
+    sodium.randombytes_buf(m)
+    sodium.randombytes_buf(ad)
+
+    const c = Buffer.alloc(mlen + sodium.crypto_aead_xchacha20poly1305_ietf_ABYTES)
+    sodium.crypto_aead_xchacha20poly1305_ietf_encrypt(c, m, ad, null, nonce, key)
+
+    const chunked = Buffer.alloc(c.byteLength)
+    sodium.crypto_aead_xchacha20poly1305_ietf_encryptv(split(chunked), split(m), ad, null, nonce, key)
+    t.alike(chunked, c)
+
+    const m1 = Buffer.alloc(mlen)
+    const mac = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_ABYTES)
+    sodium.crypto_aead_xchacha20poly1305_ietf_encrypt_detached(m1, mac, m, ad, null, nonce, key)
+    t.alike(m1, c.subarray(0, mlen))
+    t.alike(mac, c.subarray(mlen))
+
+    sodium.crypto_aead_xchacha20poly1305_ietf_decrypt_detached(m1, null, m1, mac, ad, nonce, key)
+    t.alike(m1, m)
+
+    mac[0] ^= 1
+    t.exception.all(() => sodium.crypto_aead_xchacha20poly1305_ietf_decrypt_detached(m1, null, c.subarray(0, mlen), mac, ad, nonce, key))
+    t.alike(m1, Buffer.alloc(mlen))
+  }
+})
+
+test('encrypt_padded / decrypt_padded', function (t) {
+  const key = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_KEYBYTES)
+  const nonce = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES)
+  const ad = Buffer.from('header')
+
+  sodium.randombytes_buf(key)
+  sodium.randombytes_buf(nonce)
+
+  for (const [len, blockSize] of [[0, 32], [5, 32], [31, 32], [32, 32], [40, 7], [4096, 512]]) {
+    const message = Buffer.alloc(len)
+    sodium.randombytes_buf(message)
+
+    const paddedLength = len + blockSize - (len % blockSize)
+
+    const padded = Buffer.alloc(paddedLength)
+    message.copy(padded)
+    sodium.sodium_pad(padded, len, blockSize)
+
+    const expected = Buffer.alloc(paddedLength + sodium.crypto_aead_xchacha20poly1305_ietf_ABYTES)
+    sodium.crypto_aead_xchacha20poly1305_ietf_encrypt(expected, padded, ad, null, nonce, key)
+
+    const c = Buffer.alloc(expected.byteLength)
+    t.is(sodium.crypto_aead_xchacha20poly1305_ietf_encrypt_padded(c, message, ad, null, nonce, key, blockSize), expected.byteLength)
+    t.alike(c, expected, 'same as sodium_pad then encrypt')
+
+    const m = Buffer.alloc(paddedLength)
+    t.is(sodium.crypto_aead_xchacha20poly1305_ietf_decrypt_padded(m, null, c, ad, nonce, key, blockSize), len)
+    t.alike(m.subarray(0, len), message)
+  }
+
+  const c = Buffer.alloc(32 + sodium.crypto_aead_xchacha20poly1305_ietf_ABYTES)
+  sodium.crypto_aead_xchacha20poly1305_ietf_encrypt_padded(c, Buffer.from('hi'), null, null, nonce, key, 32)
+
+  t.exception(() => sodium.crypto_aead_xchacha20poly1305_ietf_decrypt_padded(Buffer.alloc(32), null, c, ad, nonce, key, 32), 'wrong additional data')
+
+  c[3] ^= 1
+  t.exception(() => sodium.crypto_aead_xchacha20poly1305_ietf_decrypt_padded(Buffer.alloc(32), null, c, null, nonce, key, 32), 'tampered')
+})
+
+function split (buf) {
+  const segments = []
+  let offset = 0
+
+  while (offset < buf.byteLength) {
+    const len = Math.floor(Math.random() * 80)
+    segments.push(buf.subarray(offset, offset + len))
+    offset += len
+  }
+
+  segments.push(buf.subarray(buf.byteLength))
+
+  return segments
+}
+
 /**
  * Need to test in-place encryption
  * detach can talk to non detach
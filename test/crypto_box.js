@@ -1,6 +1,172 @@
 const test = require('brittle')
 const sodium = require('..')
 
+function sealMany (messages, pks) {
+  const offsets = new Uint32Array(messages.length + 1)
+  for (let i = 0; i < messages.length; i++) offsets[i + 1] = offsets[i] + messages[i].byteLength + sodium.crypto_box_SEALBYTES
+
+  const c = Buffer.alloc(offsets[messages.length])
+  for (let i = 0; i < messages.length; i++) sodium.crypto_box_seal(c.subarray(offsets[i], offsets[i + 1]), messages[i], pks[i])
+
+  return { c, offsets }
+}
+
+for (const async of [false, true]) {
+  const openMany = async ? sodium.crypto_box_seal_open_many_async : sodium.crypto_box_seal_open_many
+
+  test('crypto_box_seal_open_many many boxes against one keypair' + (async ? ' async' : ''), async function (t) {
+    const pk = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
+    const sk = Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES)
+    const otherPk = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
+    const otherSk = Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES)
+
+    sodium.crypto_box_keypair(pk, sk)
+    sodium.crypto_box_keypair(otherPk, otherSk)
+
+    const messages = []
+    const recipients = []
+
+    // enough boxes for the async call to split them over the pool
+    for (let i = 0; i < 300; i++) {
+      const m = Buffer.alloc(i % 17)
+      sodium.randombytes_buf(m)
+      messages.push(m)
+      recipients.push(i % 3 === 0 ? otherPk : pk)
+    }
+
+    const { c, offsets } = sealMany(messages, recipients)
+    const m = Buffer.alloc(c.byteLength - messages.length * sodium.crypto_box_SEALBYTES)
+    const matches = new Uint32Array(messages.length)
+    const lengths = new Uint32Array(messages.length)
+
+    t.is(await openMany(m, c, offsets, pk, sk, matches, lengths), 200)
+
+    let at = 0
+    let ok = true
+
+    for (let i = 0; i < messages.length; i++) {
+      if (recipients[i] === pk) {
+        ok = ok && matches[i] === 0 && lengths[i] === messages[i].byteLength && m.subarray(at, at + lengths[i]).equals(messages[i])
+      } else {
+        ok = ok && matches[i] === sodium.crypto_box_seal_open_many_FAILED && lengths[i] === sodium.crypto_box_seal_open_many_FAILED
+      }
+
+      at += messages[i].byteLength
+    }
+
+    t.ok(ok, 'opens every box addressed to the keypair')
+  })
+
+  test('crypto_box_seal_open_many one box against a key table' + (async ? ' async' : ''), async function (t) {
+    // enough keys for the async call to split a single box by key
+    const keys = 200
+    const pks = Buffer.alloc(keys * sodium.crypto_box_PUBLICKEYBYTES)
+    const sks = Buffer.alloc(keys * sodium.crypto_box_SECRETKEYBYTES)
+
+    for (let j = 0; j < keys; j++) {
+      sodium.crypto_box_keypair(
+        pks.subarray(j * sodium.crypto_box_PUBLICKEYBYTES, (j + 1) * sodium.crypto_box_PUBLICKEYBYTES),
+        sks.subarray(j * sodium.crypto_box_SECRETKEYBYTES, (j + 1) * sodium.crypto_box_SECRETKEYBYTES)
+      )
+    }
+
+    const message = Buffer.from('Hello, sealed World!')
+    const matches = new Uint32Array(1)
+    const lengths = new Uint32Array(1)
+
+    for (const j of [0, 117, keys - 1]) {
+      const pk = pks.subarray(j * sodium.crypto_box_PUBLICKEYBYTES, (j + 1) * sodium.crypto_box_PUBLICKEYBYTES)
+      const { c, offsets } = sealMany([message], [pk])
+      const m = Buffer.alloc(message.byteLength)
+
+      t.is(await openMany(m, c, offsets, pks, sks, matches, lengths), 1)
+      t.is(matches[0], j)
+      t.is(lengths[0], message.byteLength)
+      t.alike(m, message)
+    }
+
+    const stranger = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
+    sodium.crypto_box_keypair(stranger, Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES))
+
+    const { c, offsets } = sealMany([message], [stranger])
+
+    t.is(await openMany(Buffer.alloc(message.byteLength), c, offsets, pks, sks, matches, lengths), 0)
+    t.is(matches[0], sodium.crypto_box_seal_open_many_FAILED)
+  })
+}
+
+test('crypto_box_seal_open_many_async ignores offsets changed while pending', async function (t) {
+  const pk = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
+  const sk = Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES)
+  sodium.crypto_box_keypair(pk, sk)
+
+  const messages = []
+  for (let i = 0; i < 200; i++) messages.push(Buffer.from('message ' + i))
+
+  const { c, offsets } = sealMany(messages, messages.map(() => pk))
+  const m = Buffer.alloc(c.byteLength - messages.length * sodium.crypto_box_SEALBYTES)
+  const matches = new Uint32Array(messages.length)
+  const lengths = new Uint32Array(messages.length)
+
+  const opening = sodium.crypto_box_seal_open_many_async(m, c, offsets, pk, sk, matches, lengths)
+  offsets.fill(0xffffffff)
+
+  t.is(await opening, messages.length)
+  t.alike(m, Buffer.concat(messages))
+})
+
+test('crypto_box_seal_open_many_async with a callback', function (t) {
+  t.plan(3)
+
+  const pk = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
+  const sk = Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES)
+  sodium.crypto_box_keypair(pk, sk)
+
+  const message = Buffer.from('hi')
+  const { c, offsets } = sealMany([message], [pk])
+  const m = Buffer.alloc(message.byteLength)
+
+  sodium.crypto_box_seal_open_many_async(m, c, offsets, pk, sk, new Uint32Array(1), new Uint32Array(1), function (err, opened) {
+    t.absent(err)
+    t.is(opened, 1)
+    t.alike(m, message)
+  })
+})
+
+test('crypto_box_seal_open_many validates input', function (t) {
+  const pk = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
+  const sk = Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES)
+  sodium.crypto_box_keypair(pk, sk)
+
+  const { c, offsets } = sealMany([Buffer.from('hi')], [pk])
+  const matches = new Uint32Array(1)
+  const lengths = new Uint32Array(1)
+
+  t.exception.all(function () {
+    sodium.crypto_box_seal_open_many(Buffer.alloc(2), c, offsets, pk, sk.subarray(1), matches, lengths)
+  }, 'sks must be whole keys')
+
+  t.exception.all(function () {
+    sodium.crypto_box_seal_open_many(Buffer.alloc(2), c, offsets, pk, Buffer.concat([sk, sk]), matches, lengths)
+  }, 'one public key per secret key')
+
+  t.exception.all(function () {
+    sodium.crypto_box_seal_open_many(Buffer.alloc(1), c, offsets, pk, sk, matches, lengths)
+  }, 'm must fit every message')
+
+  t.exception.all(function () {
+    sodium.crypto_box_seal_open_many(Buffer.alloc(2), c, new Uint32Array([0, c.byteLength + 1]), pk, sk, matches, lengths)
+  }, 'offsets must lie within c')
+
+  t.exception.all(function () {
+    sodium.crypto_box_seal_open_many_async(Buffer.alloc(2), c, offsets, pk, sk, matches, lengths, 'not a function')
+  }, 'callback must be a function')
+
+  t.exception.all(function () {
+    sodium.crypto_box_seal_open_many(Buffer.alloc(2), c, offsets, pk, sk, matches, lengths, function () {})
+  }, 'sync call takes no callback')
+})
+
 test('crypto_box_seed_keypair', function (t) {
   const pk = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
   const sk = Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES)
@@ -302,3 +468,93 @@ test('crypto_box_easy2', t => {
 
   t.end()
 })
+
+test('crypto_box_beforenm', function (t) {
+  const alicepk = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
+  const alicesk = Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES)
+  const bobpk = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
+  const bobsk = Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES)
+
+  sodium.crypto_box_keypair(alicepk, alicesk)
+  sodium.crypto_box_keypair(bobpk, bobsk)
+
+  const a = Buffer.alloc(sodium.crypto_box_BEFORENMBYTES)
+  const b = Buffer.alloc(sodium.crypto_box_BEFORENMBYTES)
+
+  sodium.crypto_box_beforenm(a, bobpk, alicesk)
+  sodium.crypto_box_beforenm(b, alicepk, bobsk)
+
+  t.alike(a, b, 'both sides derive the same key')
+
+  t.exception.all(function () {
+    sodium.crypto_box_beforenm(a, Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES), alicesk)
+  }, 'rejects low order public keys')
+
+  t.exception.all(function () {
+    sodium.crypto_box_beforenm(Buffer.alloc(0), bobpk, alicesk)
+  }, 'should validate input length')
+})
+
+test('crypto_box_easy_afternm', function (t) {
+  const alicepk = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
+  const alicesk = Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES)
+  const bobpk = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
+  const bobsk = Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES)
+  const nonce = Buffer.alloc(sodium.crypto_box_NONCEBYTES)
+
+  sodium.crypto_box_keypair(alicepk, alicesk)
+  sodium.crypto_box_keypair(bobpk, bobsk)
+  sodium.randombytes_buf(nonce)
+
+  const k = Buffer.alloc(sodium.crypto_box_BEFORENMBYTES)
+  sodium.crypto_box_beforenm(k, bobpk, alicesk)
+
+  const message = Buffer.from('Hello, World!')
+  const cipher = Buffer.alloc(message.length + sodium.crypto_box_MACBYTES)
+  const expected = Buffer.alloc(cipher.length)
+
+  sodium.crypto_box_easy_afternm(cipher, message, nonce, k)
+  sodium.crypto_box_easy(expected, message, nonce, bobpk, alicesk)
+
+  t.alike(cipher, expected, 'same as crypto_box_easy')
+
+  const plain = Buffer.alloc(message.length)
+  t.absent(sodium.crypto_box_open_easy_afternm(plain, Buffer.alloc(cipher.length), nonce, k), 'does not decrypt')
+  t.ok(sodium.crypto_box_open_easy_afternm(plain, cipher, nonce, k), 'decrypts')
+  t.alike(plain, message, 'same message')
+
+  t.ok(sodium.crypto_box_open_easy(plain, cipher, nonce, alicepk, bobsk), 'opens with crypto_box_open_easy')
+})
+
+test('crypto_box_detached_afternm', function (t) {
+  const alicepk = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
+  const alicesk = Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES)
+  const bobpk = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
+  const bobsk = Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES)
+  const nonce = Buffer.alloc(sodium.crypto_box_NONCEBYTES)
+
+  sodium.crypto_box_keypair(alicepk, alicesk)
+  sodium.crypto_box_keypair(bobpk, bobsk)
+
+  const k = Buffer.alloc(sodium.crypto_box_BEFORENMBYTES)
+  sodium.crypto_box_beforenm(k, alicepk, bobsk)
+
+  const message = Buffer.from('Hello, World!')
+  const mac = Buffer.alloc(sodium.crypto_box_MACBYTES)
+  const cipher = Buffer.alloc(message.length)
+
+  sodium.crypto_box_detached(cipher, mac, message, nonce, alicepk, bobsk)
+
+  const plain = Buffer.alloc(cipher.length)
+  t.absent(sodium.crypto_box_open_detached_afternm(plain, cipher, Buffer.alloc(mac.length), nonce, k), 'does not decrypt')
+  t.ok(sodium.crypto_box_open_detached_afternm(plain, cipher, mac, nonce, k), 'decrypts')
+  t.alike(plain, message, 'same message')
+
+  const mac2 = Buffer.alloc(sodium.crypto_box_MACBYTES)
+  const cipher2 = Buffer.alloc(message.length)
+
+  sodium.crypto_box_detached_afternm(cipher2, mac2, message, nonce, k)
+
+  t.alike(cipher2, cipher, 'same ciphertext')
+  t.alike(mac2, mac, 'same mac')
+})
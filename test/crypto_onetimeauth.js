@@ -34,3 +34,45 @@ test('crypto_onetimeauth_state', function (t) {
 
   t.alike(mac.toString('hex'), 'ac35df70e6b95051e015de11a6cbf4ab', 'streaming mac')
 })
+
+test('crypto_onetimeauth long inputs', function (t) {
+  const key = Buffer.alloc(sodium.crypto_onetimeauth_KEYBYTES)
+  const value = Buffer.alloc(4096 + 13)
+  const mac = Buffer.alloc(sodium.crypto_onetimeauth_BYTES)
+
+  for (let i = 0; i < key.byteLength; i++) key[i] = i
+  for (let i = 0; i < value.byteLength; i++) value[i] = (i * 7) & 0xff
+
+  sodium.crypto_onetimeauth(mac, value, key)
+  t.alike(mac.toString('hex'), 'b1a146280085630ab3788f0aabddad4a')
+
+  key.fill(0xff)
+  value.fill(0xff)
+
+  sodium.crypto_onetimeauth(mac, value, key)
+  t.alike(mac.toString('hex'), 'f97746e70edb5c90012d7ee209abc43c', 'largest limbs')
+})
+
+test('crypto_onetimeauth_state matches one shot across block sizes', function (t) {
+  const key = Buffer.alloc(sodium.crypto_onetimeauth_KEYBYTES)
+  sodium.randombytes_buf(key)
+
+  for (const len of [0, 15, 16, 63, 64, 255, 256, 257, 1000, 65536 + 7]) {
+    const value = Buffer.alloc(len)
+    sodium.randombytes_buf(value)
+
+    const expected = Buffer.alloc(sodium.crypto_onetimeauth_BYTES)
+    sodium.crypto_onetimeauth(expected, value, key)
+
+    // 15 byte pieces never reach the 4-way path
+    const state = Buffer.alloc(sodium.crypto_onetimeauth_STATEBYTES)
+    sodium.crypto_onetimeauth_init(state, key)
+    for (let i = 0; i < len; i += 15) sodium.crypto_onetimeauth_update(state, value.subarray(i, i + 15))
+
+    const mac = Buffer.alloc(sodium.crypto_onetimeauth_BYTES)
+    sodium.crypto_onetimeauth_final(state, mac)
+
+    t.alike(mac, expected, len + ' bytes')
+    t.ok(sodium.crypto_onetimeauth_verify(mac, value, key))
+  }
+})
@@ -24,6 +24,139 @@ test('crypto_scalarmult', function (t) {
   t.alike(shared1, shared2, 'same shared secret')
 })
 
+test('crypto_scalarmult rfc 7748 vectors', function (t) {
+  const vectors = [
+    ['a546e36bf0527c9d3b16154b82465edd62144c0ac1fc5a18506a2244ba449ac4', 'e6db6867583030db3594c1a424b15f7c726624ec26b3353b10a903a6d0ab1c4c', 'c3da55379de9c6908e94ea4df28d084f32eccf03491c71f754b4075577a28552'],
+    ['4b66e9d4d1b4673c5ad22691957d6af5c11b6421e0ea01d42ca4169e7918ba0d', 'e5210f12786811d3f4b7959d0538ae2c31dbe7106fc03c3efc4cd549c715a493', '95cbde9476e8907d7aade45cb4b873f88b595a68799fa152e6f8f7647aac7957']
+  ]
+
+  for (const [n, p, expected] of vectors) {
+    const q = Buffer.alloc(sodium.crypto_scalarmult_BYTES)
+    sodium.crypto_scalarmult(q, Buffer.from(n, 'hex'), Buffer.from(p, 'hex'))
+    t.is(q.toString('hex'), expected)
+  }
+
+  let k = Buffer.alloc(32)
+  let u = Buffer.alloc(32)
+  k[0] = u[0] = 9
+
+  for (let i = 0; i < 1000; i++) {
+    const q = Buffer.alloc(sodium.crypto_scalarmult_BYTES)
+    sodium.crypto_scalarmult(q, k, u)
+    u = k
+    k = q
+  }
+
+  t.is(k.toString('hex'), '684cf59ba83309552800ef566f2f4d3c1c3887c49360e3875f2eb94d99532c51', '1000 iterations')
+})
+
+test('crypto_scalarmult non-canonical points', function (t) {
+  const { secretKey } = keyPair()
+  const nine = Buffer.alloc(32)
+  nine[0] = 9
+
+  // 2^255 - 19 + 9
+  const wrapped = Buffer.alloc(32, 0xff)
+  wrapped[0] = 0xf6
+  wrapped[31] = 0x7f
+
+  // bit 255 is ignored
+  const high = Buffer.from(nine)
+  high[31] = 0x80
+
+  const expected = Buffer.alloc(sodium.crypto_scalarmult_BYTES)
+  sodium.crypto_scalarmult(expected, secretKey, nine)
+
+  for (const p of [wrapped, high]) {
+    const q = Buffer.alloc(sodium.crypto_scalarmult_BYTES)
+    sodium.crypto_scalarmult(q, secretKey, p)
+    t.alike(q, expected)
+  }
+
+  // 2^255 - 19 is zero, a low order point
+  const zero = Buffer.alloc(32, 0xff)
+  zero[0] = 0xed
+  zero[31] = 0x7f
+
+  t.exception(function () {
+    sodium.crypto_scalarmult(Buffer.alloc(sodium.crypto_scalarmult_BYTES), secretKey, zero)
+  })
+})
+
+function batch (count) {
+  const n = Buffer.alloc(count * sodium.crypto_scalarmult_SCALARBYTES)
+  const p = Buffer.alloc(count * sodium.crypto_scalarmult_BYTES)
+  const expected = Buffer.alloc(count * sodium.crypto_scalarmult_BYTES)
+
+  sodium.randombytes_buf(n)
+
+  for (let i = 0; i < count; i++) {
+    const peer = keyPair()
+    const at = i * sodium.crypto_scalarmult_BYTES
+
+    p.set(peer.publicKey, at)
+    sodium.crypto_scalarmult(
+      expected.subarray(at, at + sodium.crypto_scalarmult_BYTES),
+      n.subarray(i * sodium.crypto_scalarmult_SCALARBYTES, (i + 1) * sodium.crypto_scalarmult_SCALARBYTES),
+      peer.publicKey
+    )
+  }
+
+  return { n, p, expected }
+}
+
+test('crypto_scalarmult_many', function (t) {
+  for (const count of [0, 1, 3, 300]) {
+    const { n, p, expected } = batch(count)
+    const q = Buffer.alloc(count * sodium.crypto_scalarmult_BYTES)
+
+    sodium.crypto_scalarmult_many(q, n, p, count)
+
+    t.alike(q, expected, count + ' points')
+  }
+
+  t.exception.all(function () {
+    sodium.crypto_scalarmult_many(Buffer.alloc(32), Buffer.alloc(64), Buffer.alloc(64), 2)
+  }, 'should validate input length')
+})
+
+test('crypto_scalarmult_many rejects low order points', function (t) {
+  const { n, p } = batch(4)
+  const q = Buffer.alloc(4 * sodium.crypto_scalarmult_BYTES)
+
+  p.fill(0, 2 * sodium.crypto_scalarmult_BYTES, 3 * sodium.crypto_scalarmult_BYTES)
+
+  t.exception(function () {
+    sodium.crypto_scalarmult_many(q, n, p, 4)
+  })
+
+  t.ok(sodium.sodium_is_zero(q.subarray(2 * sodium.crypto_scalarmult_BYTES, 3 * sodium.crypto_scalarmult_BYTES)), 'failed point is all zero')
+})
+
+test('crypto_scalarmult_many_async', async function (t) {
+  const { n, p, expected } = batch(300)
+  const q = Buffer.alloc(300 * sodium.crypto_scalarmult_BYTES)
+
+  await sodium.crypto_scalarmult_many_async(q, n, p, 300)
+
+  t.alike(q, expected)
+
+  p.fill(0, 0, sodium.crypto_scalarmult_BYTES)
+  await t.exception(sodium.crypto_scalarmult_many_async(q, n, p, 300))
+})
+
+test('crypto_scalarmult_many_async callback', function (t) {
+  t.plan(2)
+
+  const { n, p, expected } = batch(2)
+  const q = Buffer.alloc(2 * sodium.crypto_scalarmult_BYTES)
+
+  sodium.crypto_scalarmult_many_async(q, n, p, 2, function (err) {
+    t.absent(err)
+    t.alike(q, expected)
+  })
+})
+
 function keyPair () {
   const secretKey = Buffer.alloc(sodium.crypto_scalarmult_SCALARBYTES)
   sodium.randombytes_buf(secretKey)
@@ -69,3 +69,63 @@ test('crypto_secretbox_detached', function (t) {
 
   t.alike(result, message, 'decrypted message is correct')
 })
+
+test('crypto_secretbox_easy_padded', function (t) {
+  const key = Buffer.alloc(sodium.crypto_secretbox_KEYBYTES)
+  sodium.randombytes_buf(key)
+
+  const nonce = Buffer.alloc(sodium.crypto_secretbox_NONCEBYTES)
+  sodium.randombytes_buf(nonce)
+
+  for (const [len, blockSize] of [[0, 16], [15, 16], [16, 16], [17, 16], [100, 1], [1000, 256]]) {
+    const message = Buffer.alloc(len)
+    sodium.randombytes_buf(message)
+
+    const paddedLength = len + blockSize - (len % blockSize)
+
+    // same output as sodium_pad into a copy followed by crypto_secretbox_easy
+    const padded = Buffer.alloc(paddedLength)
+    message.copy(padded)
+    sodium.sodium_pad(padded, len, blockSize)
+
+    const expected = Buffer.alloc(paddedLength + sodium.crypto_secretbox_MACBYTES)
+    sodium.crypto_secretbox_easy(expected, padded, nonce, key)
+
+    const c = Buffer.alloc(expected.byteLength + 10)
+    t.is(sodium.crypto_secretbox_easy_padded(c, message, nonce, key, blockSize), expected.byteLength)
+    t.alike(c.subarray(0, expected.byteLength), expected)
+
+    const m = Buffer.alloc(paddedLength)
+    t.is(sodium.crypto_secretbox_open_easy_padded(m, expected, nonce, key, blockSize), len)
+    t.alike(m.subarray(0, len), message)
+  }
+
+  // m overlapping c, as in crypto_secretbox_easy
+  for (const offset of [0, 5, 16, 20]) {
+    const message = Buffer.alloc(40)
+    sodium.randombytes_buf(message)
+
+    const expected = Buffer.alloc(48 + sodium.crypto_secretbox_MACBYTES)
+    sodium.crypto_secretbox_easy_padded(expected, message, nonce, key, 16)
+
+    const buf = Buffer.alloc(expected.byteLength + offset)
+    message.copy(buf, offset)
+
+    sodium.crypto_secretbox_easy_padded(buf.subarray(0, expected.byteLength), buf.subarray(offset, offset + message.byteLength), nonce, key, 16)
+    t.alike(buf.subarray(0, expected.byteLength), expected, 'm at offset ' + offset + ' of c')
+  }
+
+  const c = Buffer.alloc(16 + sodium.crypto_secretbox_MACBYTES)
+  sodium.crypto_secretbox_easy_padded(c, Buffer.from('hi'), nonce, key, 16)
+
+  t.exception(() => sodium.crypto_secretbox_easy_padded(Buffer.alloc(16), Buffer.from('hi'), nonce, key, 16), 'c too small')
+  t.exception(() => sodium.crypto_secretbox_open_easy_padded(Buffer.alloc(16), c, nonce, key, 5), 'not a multiple of the block size')
+
+  c[0] ^= 1
+  t.exception(() => sodium.crypto_secretbox_open_easy_padded(Buffer.alloc(16), c, nonce, key, 16), 'tampered')
+
+  // authentic, but not padded
+  const unpadded = Buffer.alloc(16 + sodium.crypto_secretbox_MACBYTES)
+  sodium.crypto_secretbox_easy(unpadded, Buffer.alloc(16), nonce, key)
+  t.exception(() => sodium.crypto_secretbox_open_easy_padded(Buffer.alloc(16), unpadded, nonce, key, 16), 'bad padding')
+})
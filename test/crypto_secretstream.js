@@ -145,3 +145,157 @@ test('crypto_secretstream', function (t) {
   sodium.crypto_secretstream_xchacha20poly1305_pull(state, m2, tag, c2, null)
   t.alike(tag[0], sodium.crypto_secretstream_xchacha20poly1305_TAG_MESSAGE)
 })
+
+test('crypto_secretstream push_many / pull_many', function (t) {
+  const {
+    crypto_secretstream_xchacha20poly1305_ABYTES: ABYTES,
+    crypto_secretstream_xchacha20poly1305_TAG_MESSAGE: TAG_MESSAGE,
+    crypto_secretstream_xchacha20poly1305_TAG_PUSH: TAG_PUSH,
+    crypto_secretstream_xchacha20poly1305_TAG_FINAL: TAG_FINAL
+  } = sodium
+
+  const key = Buffer.alloc(sodium.crypto_secretstream_xchacha20poly1305_KEYBYTES)
+  const header = Buffer.alloc(sodium.crypto_secretstream_xchacha20poly1305_HEADERBYTES)
+  sodium.crypto_secretstream_xchacha20poly1305_keygen(key)
+
+  const messages = [0, 1, 17, 300, 64, 1000].map(function (len) {
+    const buf = Buffer.alloc(len)
+    sodium.randombytes_buf(buf)
+    return buf
+  })
+
+  const m = Buffer.concat(messages)
+  const offsets = new Uint32Array(messages.length + 1)
+  for (let i = 0; i < messages.length; i++) offsets[i + 1] = offsets[i] + messages[i].byteLength
+
+  const tags = Buffer.from([TAG_MESSAGE, TAG_PUSH, TAG_MESSAGE, TAG_MESSAGE, TAG_PUSH, TAG_FINAL])
+  const lengths = new Uint32Array(messages.length)
+  const c = Buffer.alloc(m.byteLength + messages.length * ABYTES)
+
+  const state = Buffer.alloc(sodium.crypto_secretstream_xchacha20poly1305_STATEBYTES)
+  sodium.crypto_secretstream_xchacha20poly1305_init_push(state, header, key)
+
+  t.is(sodium.crypto_secretstream_xchacha20poly1305_push_many(state, c, m, offsets, tags, lengths), c.byteLength)
+
+  // each frame pulls with the single message api
+  sodium.crypto_secretstream_xchacha20poly1305_init_pull(state, header, key)
+
+  const tag = Buffer.alloc(1)
+  let at = 0
+  for (let i = 0; i < messages.length; i++) {
+    t.is(lengths[i], messages[i].byteLength + ABYTES)
+
+    const plain = Buffer.alloc(messages[i].byteLength)
+    sodium.crypto_secretstream_xchacha20poly1305_pull(state, plain, tag, c.subarray(at, at + lengths[i]), null)
+    t.alike(plain, messages[i])
+    t.is(tag[0], tags[i])
+    at += lengths[i]
+  }
+
+  // and the whole batch pulls in one call
+  const coffsets = new Uint32Array(messages.length + 1)
+  for (let i = 0; i < messages.length; i++) coffsets[i + 1] = coffsets[i] + lengths[i]
+
+  const plain = Buffer.alloc(m.byteLength)
+  const outTags = Buffer.alloc(messages.length, 0xdb)
+  const outLengths = new Uint32Array(messages.length)
+
+  sodium.crypto_secretstream_xchacha20poly1305_init_pull(state, header, key)
+  t.is(sodium.crypto_secretstream_xchacha20poly1305_pull_many(state, plain, outTags, c, coffsets, outLengths), messages.length)
+  t.alike(plain, m)
+  t.alike(outTags, tags)
+  t.alike(Array.from(outLengths), messages.map(b => b.byteLength))
+
+  // the first forged message is reported, earlier ones are delivered
+  c[coffsets[3] + 5] ^= 1
+  plain.fill(0)
+  outLengths.fill(0)
+
+  sodium.crypto_secretstream_xchacha20poly1305_init_pull(state, header, key)
+  t.is(sodium.crypto_secretstream_xchacha20poly1305_pull_many(state, plain, outTags, c, coffsets, outLengths), 3)
+  t.alike(plain.subarray(0, offsets[3]), m.subarray(0, offsets[3]))
+  t.is(outLengths[3], 0)
+
+  t.exception.all(function () {
+    sodium.crypto_secretstream_xchacha20poly1305_push_many(state, c.subarray(1), m, offsets, tags, lengths)
+  }, 'c too short')
+
+  t.exception.all(function () {
+    sodium.crypto_secretstream_xchacha20poly1305_push_many(state, c, m, offsets.subarray(1), tags, lengths)
+  }, 'offsets length mismatch')
+
+  t.exception.all(function () {
+    sodium.crypto_secretstream_xchacha20poly1305_pull_many(state, plain, outTags, c, new Uint32Array([0, 4, 4, 4, 4, 4, 4]), outLengths)
+  }, 'ciphertext shorter than ABYTES')
+})
+
+test('crypto_secretstream push_inplace / pull_inplace', function (t) {
+  const {
+    crypto_secretstream_xchacha20poly1305_ABYTES: ABYTES,
+    crypto_secretstream_xchacha20poly1305_TAGBYTES: TAGBYTES,
+    crypto_secretstream_xchacha20poly1305_TAG_MESSAGE: TAG_MESSAGE,
+    crypto_secretstream_xchacha20poly1305_TAG_FINAL: TAG_FINAL
+  } = sodium
+
+  const key = Buffer.alloc(sodium.crypto_secretstream_xchacha20poly1305_KEYBYTES)
+  const header = Buffer.alloc(sodium.crypto_secretstream_xchacha20poly1305_HEADERBYTES)
+  sodium.crypto_secretstream_xchacha20poly1305_keygen(key)
+
+  const ad = Buffer.from('frame header')
+  const pushState = Buffer.alloc(sodium.crypto_secretstream_xchacha20poly1305_STATEBYTES)
+  const inplaceState = Buffer.alloc(sodium.crypto_secretstream_xchacha20poly1305_STATEBYTES)
+
+  sodium.crypto_secretstream_xchacha20poly1305_init_push(pushState, header, key)
+  inplaceState.set(pushState)
+
+  // frames packed into one slab, as a frame encoder would
+  const lengths = [0, 1, 63, 64, 1000]
+  const messages = lengths.map(function (len) {
+    const m = Buffer.alloc(len)
+    sodium.randombytes_buf(m)
+    return m
+  })
+
+  const slab = Buffer.alloc(lengths.reduce((a, b) => a + b + ABYTES, 0))
+  const frames = []
+
+  let at = 0
+  for (let i = 0; i < messages.length; i++) {
+    const frame = slab.subarray(at, at + messages[i].byteLength + ABYTES)
+    at += frame.byteLength
+
+    const tag = i === messages.length - 1 ? TAG_FINAL : TAG_MESSAGE
+    const expected = Buffer.alloc(frame.byteLength)
+    sodium.crypto_secretstream_xchacha20poly1305_push(pushState, expected, messages[i], ad, tag)
+
+    frame.set(messages[i], TAGBYTES)
+    t.is(sodium.crypto_secretstream_xchacha20poly1305_push_inplace(inplaceState, frame, ad, tag), frame.byteLength)
+    t.alike(frame, expected, lengths[i] + ' byte frame matches push')
+
+    frames.push(frame)
+  }
+
+  const pullState = Buffer.alloc(sodium.crypto_secretstream_xchacha20poly1305_STATEBYTES)
+  sodium.crypto_secretstream_xchacha20poly1305_init_pull(pullState, header, key)
+
+  const tag = Buffer.alloc(1)
+
+  // a forged frame is rejected and left as it was
+  frames[0][frames[0].byteLength - 1] ^= 1
+  const forged = Buffer.from(frames[0])
+  t.exception.all(function () {
+    sodium.crypto_secretstream_xchacha20poly1305_pull_inplace(pullState, tag, frames[0], ad)
+  })
+  t.alike(frames[0], forged)
+  frames[0][frames[0].byteLength - 1] ^= 1
+
+  for (let i = 0; i < frames.length; i++) {
+    t.is(sodium.crypto_secretstream_xchacha20poly1305_pull_inplace(pullState, tag, frames[i], ad), lengths[i])
+    t.alike(frames[i].subarray(TAGBYTES, TAGBYTES + lengths[i]), messages[i])
+    t.is(tag[0], i === frames.length - 1 ? TAG_FINAL : TAG_MESSAGE)
+  }
+
+  t.exception.all(function () {
+    sodium.crypto_secretstream_xchacha20poly1305_push_inplace(inplaceState, Buffer.alloc(ABYTES - 1), null, TAG_MESSAGE)
+  }, 'frame shorter than ABYTES')
+})
@@ -317,6 +317,116 @@ test('ed25519 convert', function (t) {
   t.end()
 })
 
+function edKeys (count) {
+  const ed25519_pks = new Uint8Array(count * sodium.crypto_sign_PUBLICKEYBYTES)
+  const expected = new Uint8Array(count * sodium.crypto_box_PUBLICKEYBYTES)
+  const sk = new Uint8Array(sodium.crypto_sign_SECRETKEYBYTES)
+
+  for (let i = 0; i < count; i++) {
+    const pk = ed25519_pks.subarray(i * sodium.crypto_sign_PUBLICKEYBYTES, (i + 1) * sodium.crypto_sign_PUBLICKEYBYTES)
+
+    sodium.crypto_sign_keypair(pk, sk)
+    sodium.crypto_sign_ed25519_pk_to_curve25519(expected.subarray(i * sodium.crypto_box_PUBLICKEYBYTES, (i + 1) * sodium.crypto_box_PUBLICKEYBYTES), pk)
+  }
+
+  return { ed25519_pks, expected }
+}
+
+test('ed25519 convert many', function (t) {
+  for (const count of [0, 1, 3, 65, 300]) {
+    const { ed25519_pks, expected } = edKeys(count)
+    const x25519_pks = new Uint8Array(count * sodium.crypto_box_PUBLICKEYBYTES)
+
+    sodium.crypto_sign_ed25519_pk_to_curve25519_many(x25519_pks, ed25519_pks, count)
+
+    t.alike(x25519_pks, expected, count + ' keys')
+  }
+
+  t.exception.all(function () {
+    sodium.crypto_sign_ed25519_pk_to_curve25519_many(new Uint8Array(32), new Uint8Array(64), 2)
+  }, 'should validate input length')
+})
+
+test('ed25519 convert many rejects invalid keys', function (t) {
+  const { ed25519_pks, expected } = edKeys(4)
+  const x25519_pks = new Uint8Array(4 * sodium.crypto_box_PUBLICKEYBYTES)
+
+  // small order, and y = p + 1 which only the non-canonical path reads
+  ed25519_pks.fill(0, 32, 64)
+  ed25519_pks.fill(0xff, 64, 96)
+  ed25519_pks[64] = 0xee
+  ed25519_pks[95] = 0x7f
+
+  t.exception(function () {
+    sodium.crypto_sign_ed25519_pk_to_curve25519_many(x25519_pks, ed25519_pks, 4)
+  })
+
+  t.alike(x25519_pks.subarray(0, 32), expected.subarray(0, 32))
+  t.ok(sodium.sodium_is_zero(x25519_pks.subarray(32, 96)), 'failed keys are all zero')
+  t.alike(x25519_pks.subarray(96), expected.subarray(96))
+})
+
+test('ed25519 convert many with a cache', function (t) {
+  const cache = sodium.sodium_malloc(sodium.extension_ed25519_convert_HEADERBYTES + 16 * sodium.extension_ed25519_convert_ENTRYBYTES)
+  sodium.extension_ed25519_convert_cache_init(cache)
+
+  const { ed25519_pks, expected } = edKeys(40)
+  const x25519_pks = new Uint8Array(40 * sodium.crypto_box_PUBLICKEYBYTES)
+
+  for (let round = 0; round < 3; round++) {
+    x25519_pks.fill(0)
+    sodium.crypto_sign_ed25519_pk_to_curve25519_many(x25519_pks, ed25519_pks, 40, cache)
+    t.alike(x25519_pks, expected, 'round ' + round)
+  }
+
+  // the same key twice in one batch
+  const twice = new Uint8Array(64)
+  twice.set(ed25519_pks.subarray(0, 32), 0)
+  twice.set(ed25519_pks.subarray(0, 32), 32)
+
+  const out = new Uint8Array(64)
+  sodium.crypto_sign_ed25519_pk_to_curve25519_many(out, twice, 2, cache)
+  t.alike(out.subarray(32), expected.subarray(0, 32))
+
+  sodium.extension_ed25519_convert_cache_clear(cache)
+  sodium.crypto_sign_ed25519_pk_to_curve25519_many(x25519_pks, ed25519_pks, 40, cache)
+  t.alike(x25519_pks, expected)
+
+  t.exception(function () {
+    sodium.crypto_sign_ed25519_pk_to_curve25519_many(x25519_pks, ed25519_pks, 40, sodium.sodium_malloc(sodium.extension_ed25519_convert_HEADERBYTES + sodium.extension_ed25519_convert_ENTRYBYTES))
+  }, 'uninitialised cache')
+})
+
+test('ed25519 convert cache with out of range links', function (t) {
+  const cache = sodium.sodium_malloc(sodium.extension_ed25519_convert_HEADERBYTES + 4 * sodium.extension_ed25519_convert_ENTRYBYTES)
+  sodium.extension_ed25519_convert_cache_init(cache)
+
+  const { ed25519_pks, expected } = edKeys(8)
+  const x25519_pks = new Uint8Array(8 * sodium.crypto_box_PUBLICKEYBYTES)
+
+  sodium.crypto_sign_ed25519_pk_to_curve25519_many(x25519_pks, ed25519_pks, 8, cache)
+
+  const view = new DataView(cache.buffer, cache.byteOffset, cache.byteLength)
+  const links = sodium.extension_ed25519_convert_HEADERBYTES + 64
+
+  // prev, next, chain and bucket of every entry
+  for (let i = 0; i < 4; i++) {
+    for (let j = 0; j < 4; j++) view.setUint32(links + i * sodium.extension_ed25519_convert_ENTRYBYTES + j * 4, 9 + i + j, true)
+  }
+
+  for (let round = 0; round < 2; round++) {
+    x25519_pks.fill(0)
+    sodium.crypto_sign_ed25519_pk_to_curve25519_many(x25519_pks, ed25519_pks, 8, cache)
+    t.alike(x25519_pks, expected, 'round ' + round)
+  }
+
+  view.setUint32(20, 5, true)
+
+  t.exception(function () {
+    sodium.crypto_sign_ed25519_pk_to_curve25519_many(x25519_pks, ed25519_pks, 8, cache)
+  }, 'size past capacity')
+})
+
 function parseTest (t) {
   return {
     sk: new Uint8Array(t[0]),
@@ -201,6 +201,32 @@ test('crypto_stream_xor state after GC', { skip: isBare }, function (t) {
   t.alike(out, message, 'decrypted')
 })
 
+test('crypto_stream_xor state seek', function (t) {
+  const nonce = random(sodium.crypto_stream_NONCEBYTES)
+  const key = random(sodium.crypto_stream_KEYBYTES)
+
+  const message = random(1000)
+  const expected = Buffer.alloc(message.byteLength)
+  sodium.crypto_stream_xor(expected, message, nonce, key)
+
+  const state = Buffer.alloc(sodium.crypto_stream_xor_STATEBYTES)
+  sodium.crypto_stream_xor_init(state, nonce, key)
+
+  for (const [start, end] of [[0, 1000], [64, 128], [1, 2], [63, 200], [500, 501], [999, 1000], [130, 130], [7, 900]]) {
+    const out = Buffer.alloc(end - start)
+    const mid = Math.min(start + 3, end)
+
+    sodium.crypto_stream_xor_seek(state, start)
+    sodium.crypto_stream_xor_update(state, out.subarray(0, mid - start), message.subarray(start, mid))
+    sodium.crypto_stream_xor_update(state, out.subarray(mid - start), message.subarray(mid, end))
+
+    if (!out.equals(expected.subarray(start, end))) t.fail('range ' + start + '..' + end)
+  }
+
+  sodium.crypto_stream_xor_final(state)
+  t.pass('seeked ranges match')
+})
+
 function random (n) {
   const buf = Buffer.alloc(n)
   sodium.randombytes_buf(buf)
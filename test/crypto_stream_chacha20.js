@@ -272,6 +272,155 @@ test('crypto_stream_chacha20_xor state after GC', { skip: isBare }, function (t)
   t.alike(out, message, 'decrypted')
 })
 
+test('crypto_stream_chacha20_xor state mixing small and bulk updates', function (t) {
+  const nonce = random(sodium.crypto_stream_chacha20_NONCEBYTES)
+  const key = random(sodium.crypto_stream_chacha20_KEYBYTES)
+
+  const message = random(64 * 1024)
+  const expected = Buffer.alloc(message.byteLength)
+  sodium.crypto_stream_chacha20_xor(expected, message, nonce, key)
+
+  const state = Buffer.alloc(sodium.crypto_stream_chacha20_xor_STATEBYTES)
+  sodium.crypto_stream_chacha20_xor_init(state, nonce, key)
+
+  const out = Buffer.alloc(message.byteLength)
+  const sizes = [5, 40, 8192, 1, 4096, 4095, 17, 10000, 3, 64, 128]
+
+  for (let offset = 0, i = 0; offset < message.byteLength; i++) {
+    const end = Math.min(offset + sizes[i % sizes.length], message.byteLength)
+    sodium.crypto_stream_chacha20_xor_update(state, out.subarray(offset, end), message.subarray(offset, end))
+    offset = end
+  }
+
+  sodium.crypto_stream_chacha20_xor_final(state)
+  t.alike(out, expected, 'same as encrypting all at once')
+})
+
+test('crypto_stream_xchacha20_xor state', function (t) {
+  const nonce = random(sodium.crypto_stream_xchacha20_NONCEBYTES)
+  const key = random(sodium.crypto_stream_xchacha20_KEYBYTES)
+
+  const message = random(10000)
+  const expected = Buffer.alloc(message.byteLength)
+  sodium.crypto_stream_xchacha20_xor(expected, message, nonce, key)
+
+  const state = Buffer.alloc(sodium.crypto_stream_xchacha20_xor_STATEBYTES)
+  sodium.crypto_stream_xchacha20_xor_init(state, nonce, key)
+
+  const out = Buffer.alloc(message.byteLength)
+  for (let offset = 0; offset < message.byteLength;) {
+    const end = Math.min(offset + Math.floor(Math.random() * 5000), message.byteLength)
+    sodium.crypto_stream_xchacha20_xor_update(state, out.subarray(offset, end), message.subarray(offset, end))
+    offset = end
+  }
+
+  t.alike(out, expected, 'same as encrypting all at once')
+
+  sodium.crypto_stream_xchacha20_xor_seek(state, 4097)
+  sodium.crypto_stream_xchacha20_xor_update(state, out.subarray(0, 100), message.subarray(4097, 4197))
+  t.alike(out.subarray(0, 100), expected.subarray(4097, 4197), 'seek')
+
+  sodium.crypto_stream_xchacha20_xor_final(state)
+})
+
+test('crypto_stream_chacha20_xor state seek', function (t) {
+  const nonce = random(sodium.crypto_stream_chacha20_NONCEBYTES)
+  const key = random(sodium.crypto_stream_chacha20_KEYBYTES)
+
+  const message = random(1000)
+  const expected = Buffer.alloc(message.byteLength)
+  sodium.crypto_stream_chacha20_xor(expected, message, nonce, key)
+
+  const state = Buffer.alloc(sodium.crypto_stream_chacha20_xor_STATEBYTES)
+  sodium.crypto_stream_chacha20_xor_init(state, nonce, key)
+
+  for (const [start, end] of [[0, 1000], [64, 128], [1, 2], [63, 200], [500, 501], [999, 1000], [130, 130], [7, 900]]) {
+    const out = Buffer.alloc(end - start)
+    const mid = Math.min(start + 3, end)
+
+    sodium.crypto_stream_chacha20_xor_seek(state, start)
+    sodium.crypto_stream_chacha20_xor_update(state, out.subarray(0, mid - start), message.subarray(start, mid))
+    sodium.crypto_stream_chacha20_xor_update(state, out.subarray(mid - start), message.subarray(mid, end))
+
+    if (!out.equals(expected.subarray(start, end))) t.fail('range ' + start + '..' + end)
+  }
+
+  sodium.crypto_stream_chacha20_xor_final(state)
+  t.pass('seeked ranges match')
+})
+
+test('crypto_stream_chacha20_xor_ic with a 64-bit counter', function (t) {
+  const nonce = random(sodium.crypto_stream_chacha20_NONCEBYTES)
+  const key = random(sodium.crypto_stream_chacha20_KEYBYTES)
+
+  const low = Buffer.alloc(128)
+  const high = Buffer.alloc(128)
+
+  sodium.crypto_stream_chacha20_xor_ic(low, low, nonce, 0, key)
+  sodium.crypto_stream_chacha20_xor_ic(high, high, nonce, 2 ** 32, key)
+  t.unlike(high, low, 'counter is not truncated to 32 bits')
+
+  // the second block at 2^32 is the first block at 2^32 + 1
+  const next = Buffer.alloc(64)
+  sodium.crypto_stream_chacha20_xor_ic(next, next, nonce, 2 ** 32 + 1, key)
+  t.alike(next, high.subarray(64))
+
+  // seeking past 256 GiB lands on the same keystream
+  const state = Buffer.alloc(sodium.crypto_stream_chacha20_xor_STATEBYTES)
+  sodium.crypto_stream_chacha20_xor_init(state, nonce, key)
+  sodium.crypto_stream_chacha20_xor_seek(state, 2 ** 38 + 10)
+
+  const out = Buffer.alloc(100)
+  sodium.crypto_stream_chacha20_xor_update(state, out, out)
+  t.alike(out, high.subarray(10, 110))
+
+  t.exception.all(() => sodium.crypto_stream_chacha20_xor_ic(low, low, nonce, -1, key))
+})
+
+test('crypto_stream_*_xor_parallel matches the serial result', async function (t) {
+  const message = random(3 * 1024 * 1024 + 17)
+
+  for (const name of ['chacha20', 'chacha20_ietf', 'xchacha20', 'salsa20']) {
+    const nonce = random(sodium['crypto_stream_' + name + '_NONCEBYTES'])
+    const key = random(sodium['crypto_stream_' + name + '_KEYBYTES'])
+
+    const expected = Buffer.alloc(message.byteLength)
+    sodium['crypto_stream_' + name + '_xor_ic'](expected, message, nonce, 7, key)
+
+    const out = Buffer.alloc(message.byteLength)
+    await sodium['crypto_stream_' + name + '_xor_parallel'](out, message, nonce, key, 7)
+    t.alike(out, expected, name)
+
+    // in place, from counter 0
+    const copy = Buffer.from(message)
+    sodium['crypto_stream_' + name + '_xor'](expected, message, nonce, key)
+    await sodium['crypto_stream_' + name + '_xor_parallel'](copy, copy, nonce, key)
+    t.alike(copy, expected, name + ' in place')
+  }
+
+  const empty = Buffer.alloc(0)
+  await t.execution(sodium.crypto_stream_chacha20_xor_parallel(empty, empty, random(sodium.crypto_stream_chacha20_NONCEBYTES), random(sodium.crypto_stream_chacha20_KEYBYTES)))
+
+  t.exception.all(() => sodium.crypto_stream_chacha20_ietf_xor_parallel(message, message, random(sodium.crypto_stream_chacha20_ietf_NONCEBYTES), random(sodium.crypto_stream_chacha20_ietf_KEYBYTES), 2 ** 32 - 1), 'past the 32-bit counter')
+})
+
+test('crypto_stream_*_xor_parallel with a callback', function (t) {
+  t.plan(2)
+
+  const message = random(1024 * 1024 + 3)
+  const nonce = random(sodium.crypto_stream_xchacha20_NONCEBYTES)
+  const key = random(sodium.crypto_stream_xchacha20_KEYBYTES)
+
+  const expected = Buffer.alloc(message.byteLength)
+  sodium.crypto_stream_xchacha20_xor_ic(expected, message, nonce, 3, key)
+
+  const out = Buffer.alloc(message.byteLength)
+  sodium.crypto_stream_xchacha20_xor_parallel(out, message, nonce, key, 3, function (err) {
+    t.absent(err)
+    t.alike(out, expected)
+  })
+})
+
 function random (n) {
   const buf = Buffer.alloc(n)
   sodium.randombytes_buf(buf)
@@ -291,6 +291,40 @@ test('crypto_stream_chacha20_xor state after GC', { skip: isBare }, function (t)
   t.alike(out, message, 'decrypted')
 })
 
+test('crypto_stream_chacha20_ietf_xor state seek', function (t) {
+  const nonce = random(sodium.crypto_stream_chacha20_ietf_NONCEBYTES)
+  const key = random(sodium.crypto_stream_chacha20_ietf_KEYBYTES)
+
+  const message = random(1000)
+  const expected = Buffer.alloc(message.byteLength)
+  sodium.crypto_stream_chacha20_ietf_xor(expected, message, nonce, key)
+
+  const state = Buffer.alloc(sodium.crypto_stream_chacha20_ietf_xor_STATEBYTES)
+  sodium.crypto_stream_chacha20_ietf_xor_init(state, nonce, key)
+
+  for (const [start, end] of [[0, 1000], [64, 128], [1, 2], [63, 200], [500, 501], [999, 1000], [130, 130], [7, 900]]) {
+    const out = Buffer.alloc(end - start)
+    const mid = Math.min(start + 3, end)
+
+    sodium.crypto_stream_chacha20_ietf_xor_seek(state, start)
+    sodium.crypto_stream_chacha20_ietf_xor_update(state, out.subarray(0, mid - start), message.subarray(start, mid))
+    sodium.crypto_stream_chacha20_ietf_xor_update(state, out.subarray(mid - start), message.subarray(mid, end))
+
+    if (!out.equals(expected.subarray(start, end))) t.fail('range ' + start + '..' + end)
+  }
+
+  sodium.crypto_stream_chacha20_ietf_xor_final(state)
+  t.pass('seeked ranges match')
+})
+
+test('crypto_stream_chacha20_ietf_xor state seek is bound by the 32-bit counter', function (t) {
+  const state = Buffer.alloc(sodium.crypto_stream_chacha20_ietf_xor_STATEBYTES)
+  sodium.crypto_stream_chacha20_ietf_xor_init(state, random(sodium.crypto_stream_chacha20_ietf_NONCEBYTES), random(sodium.crypto_stream_chacha20_ietf_KEYBYTES))
+
+  t.execution(() => sodium.crypto_stream_chacha20_ietf_xor_seek(state, 2 ** 38 - 1))
+  t.exception(() => sodium.crypto_stream_chacha20_ietf_xor_seek(state, 2 ** 38))
+})
+
 function random (n) {
   const buf = Buffer.alloc(n)
   sodium.randombytes_buf(buf)
@@ -0,0 +1,197 @@
+const test = require('brittle')
+const sodium = require('..')
+
+function keypair () {
+  const pk = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
+  const sk = Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES)
+  sodium.crypto_box_keypair(pk, sk)
+  return { pk, sk }
+}
+
+function cache (sk, entries) {
+  const buf = sodium.sodium_malloc(sodium.extension_box_cache_HEADERBYTES + entries * sodium.extension_box_cache_ENTRYBYTES)
+  sodium.extension_box_cache_init(buf, sk)
+  return buf
+}
+
+test('constants', function (t) {
+  t.is(sodium.extension_box_cache_HEADERBYTES, 64)
+  t.is(sodium.extension_box_cache_ENTRYBYTES, 80)
+})
+
+test('init validates the cache size', function (t) {
+  const { sk } = keypair()
+
+  t.exception.all(function () {
+    sodium.extension_box_cache_init(sodium.sodium_malloc(sodium.extension_box_cache_HEADERBYTES), sk)
+  }, 'needs room for an entry')
+
+  t.exception.all(function () {
+    sodium.extension_box_cache_init(sodium.sodium_malloc(sodium.extension_box_cache_HEADERBYTES + sodium.extension_box_cache_ENTRYBYTES + 1), sk)
+  }, 'must be a whole number of entries')
+
+  const m = Buffer.from('hello')
+  const c = Buffer.alloc(m.byteLength + sodium.crypto_box_MACBYTES)
+  const n = Buffer.alloc(sodium.crypto_box_NONCEBYTES)
+
+  t.exception.all(function () {
+    sodium.extension_box_cache_easy(c, m, n, keypair().pk, sodium.sodium_malloc(sodium.extension_box_cache_HEADERBYTES + sodium.extension_box_cache_ENTRYBYTES))
+  }, 'must be initialised')
+})
+
+test('easy matches crypto_box_easy', function (t) {
+  const alice = keypair()
+  const bob = keypair()
+  const a = cache(alice.sk, 4)
+  const b = cache(bob.sk, 4)
+
+  const n = Buffer.alloc(sodium.crypto_box_NONCEBYTES)
+
+  for (let i = 0; i < 4; i++) {
+    sodium.randombytes_buf(n)
+
+    const m = Buffer.from('message ' + i)
+    const c = Buffer.alloc(m.byteLength + sodium.crypto_box_MACBYTES)
+    const expected = Buffer.alloc(c.byteLength)
+
+    sodium.extension_box_cache_easy(c, m, n, bob.pk, a)
+    sodium.crypto_box_easy(expected, m, n, bob.pk, alice.sk)
+
+    t.alike(c, expected, 'same ciphertext')
+
+    const plain = Buffer.alloc(m.byteLength)
+    t.ok(sodium.extension_box_cache_open_easy(plain, c, n, alice.pk, b), 'opens')
+    t.alike(plain, m)
+
+    c[0] ^= 1
+    t.absent(sodium.extension_box_cache_open_easy(plain, c, n, alice.pk, b), 'rejects tampered ciphertext')
+  }
+})
+
+test('detached matches crypto_box_detached', function (t) {
+  const alice = keypair()
+  const bob = keypair()
+  const a = cache(alice.sk, 1)
+
+  const n = Buffer.alloc(sodium.crypto_box_NONCEBYTES)
+  const m = Buffer.from('Hello, World!')
+  const c = Buffer.alloc(m.byteLength)
+  const mac = Buffer.alloc(sodium.crypto_box_MACBYTES)
+
+  sodium.extension_box_cache_detached(c, mac, m, n, bob.pk, a)
+
+  const plain = Buffer.alloc(c.byteLength)
+  t.ok(sodium.crypto_box_open_detached(plain, c, mac, n, alice.pk, bob.sk), 'opens with crypto_box_open_detached')
+  t.alike(plain, m)
+
+  const c2 = Buffer.alloc(m.byteLength)
+  const mac2 = Buffer.alloc(sodium.crypto_box_MACBYTES)
+  sodium.crypto_box_detached(c2, mac2, m, n, alice.pk, bob.sk)
+
+  plain.fill(0)
+  t.ok(sodium.extension_box_cache_open_detached(plain, c2, mac2, n, bob.pk, a), 'opens crypto_box_detached')
+  t.alike(plain, m)
+  t.absent(sodium.extension_box_cache_open_detached(plain, c2, Buffer.alloc(mac2.byteLength), n, bob.pk, a), 'rejects bad mac')
+})
+
+test('evicts the least recently used peer', function (t) {
+  const local = keypair()
+  const peers = []
+  for (let i = 0; i < 16; i++) peers.push(keypair())
+
+  const c = cache(local.sk, 3)
+  const n = Buffer.alloc(sodium.crypto_box_NONCEBYTES)
+  const m = Buffer.from('ping')
+  const out = Buffer.alloc(m.byteLength + sodium.crypto_box_MACBYTES)
+  const expected = Buffer.alloc(out.byteLength)
+
+  // cycle through more peers than fit, and keep coming back to the first one
+  for (let round = 0; round < 4; round++) {
+    for (let i = 0; i < peers.length; i++) {
+      for (const p of [peers[0], peers[i]]) {
+        sodium.randombytes_buf(n)
+        sodium.extension_box_cache_easy(out, m, n, p.pk, c)
+        sodium.crypto_box_easy(expected, m, n, p.pk, local.sk)
+        if (!out.equals(expected)) t.fail('cached key diverged')
+      }
+    }
+  }
+
+  t.pass('every lookup matched crypto_box_easy')
+})
+
+test('rejects low order public keys', function (t) {
+  const local = keypair()
+  const c = cache(local.sk, 2)
+
+  const n = Buffer.alloc(sodium.crypto_box_NONCEBYTES)
+  const m = Buffer.from('hello')
+  const out = Buffer.alloc(m.byteLength + sodium.crypto_box_MACBYTES)
+  const zero = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
+
+  t.exception(function () {
+    sodium.extension_box_cache_easy(out, m, n, zero, c)
+  })
+
+  t.absent(sodium.extension_box_cache_open_easy(Buffer.alloc(m.byteLength), out, n, zero, c))
+})
+
+test('clear and final', function (t) {
+  const alice = keypair()
+  const bob = keypair()
+  const c = cache(alice.sk, 2)
+
+  const n = Buffer.alloc(sodium.crypto_box_NONCEBYTES)
+  const m = Buffer.from('hello')
+  const out = Buffer.alloc(m.byteLength + sodium.crypto_box_MACBYTES)
+  const expected = Buffer.alloc(out.byteLength)
+
+  sodium.extension_box_cache_easy(out, m, n, bob.pk, c)
+  sodium.extension_box_cache_clear(c)
+  sodium.extension_box_cache_easy(out, m, n, bob.pk, c)
+  sodium.crypto_box_easy(expected, m, n, bob.pk, alice.sk)
+
+  t.alike(out, expected, 'keeps the secret key across clear')
+
+  sodium.extension_box_cache_final(c)
+
+  t.ok(sodium.sodium_is_zero(c), 'wipes the cache')
+
+  t.exception.all(function () {
+    sodium.extension_box_cache_easy(out, m, n, bob.pk, c)
+  }, 'cannot be used after final')
+})
+
+test('rebuilds a cache with out of range links', function (t) {
+  const local = keypair()
+  const peers = []
+  for (let i = 0; i < 4; i++) peers.push(keypair())
+
+  const c = cache(local.sk, 3)
+  const n = Buffer.alloc(sodium.crypto_box_NONCEBYTES)
+  const m = Buffer.from('ping')
+  const out = Buffer.alloc(m.byteLength + sodium.crypto_box_MACBYTES)
+  const expected = Buffer.alloc(out.byteLength)
+
+  for (const p of peers) sodium.extension_box_cache_easy(out, m, n, p.pk, c)
+
+  const header = new DataView(c.buffer, c.byteOffset, c.byteLength)
+  const links = sodium.extension_box_cache_HEADERBYTES + 64
+
+  // prev, next, chain and bucket of every entry
+  for (let i = 0; i < 3; i++) {
+    for (let j = 0; j < 4; j++) header.setUint32(links + i * sodium.extension_box_cache_ENTRYBYTES + j * 4, 7 + i + j, true)
+  }
+
+  for (const p of peers) {
+    sodium.extension_box_cache_easy(out, m, n, p.pk, c)
+    sodium.crypto_box_easy(expected, m, n, p.pk, local.sk)
+    t.alike(out, expected)
+  }
+
+  header.setUint32(52, 4, true)
+
+  t.exception.all(function () {
+    sodium.extension_box_cache_easy(out, m, n, peers[0].pk, c)
+  }, 'size past capacity')
+})
@@ -0,0 +1,144 @@
+const test = require('brittle')
+const sodium = require('..')
+
+function recipients (n) {
+  const pks = Buffer.alloc(n * sodium.crypto_box_PUBLICKEYBYTES)
+  const sks = []
+
+  for (let i = 0; i < n; i++) {
+    const sk = Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES)
+    sodium.crypto_box_keypair(pks.subarray(i * sodium.crypto_box_PUBLICKEYBYTES, (i + 1) * sodium.crypto_box_PUBLICKEYBYTES), sk)
+    sks.push(sk)
+  }
+
+  return { pks, sks, pk: (i) => pks.subarray(i * sodium.crypto_box_PUBLICKEYBYTES, (i + 1) * sodium.crypto_box_PUBLICKEYBYTES) }
+}
+
+function envelopeBytes (n, mlen) {
+  return sodium.extension_envelope_HEADERBYTES + n * sodium.extension_envelope_ENTRYBYTES + mlen + sodium.extension_envelope_ABYTES
+}
+
+test('constants', function (t) {
+  t.is(sodium.extension_envelope_HEADERBYTES, 36)
+  t.is(sodium.extension_envelope_ENTRYBYTES, 48)
+  t.is(sodium.extension_envelope_ABYTES, 16)
+  t.is(typeof sodium.extension_envelope_RECIPIENTS_MAX, 'number')
+})
+
+test('every recipient opens the envelope', function (t) {
+  const r = recipients(5)
+  const m = Buffer.from('hello group')
+  const c = Buffer.alloc(envelopeBytes(5, m.byteLength))
+
+  sodium.extension_envelope_seal(c, m, r.pks)
+
+  t.is(sodium.extension_envelope_recipients(c), 5)
+
+  for (let i = 0; i < 5; i++) {
+    const out = Buffer.alloc(m.byteLength)
+    t.ok(sodium.extension_envelope_open(out, c, i, r.pk(i), r.sks[i]), 'opens with the right hint')
+    t.alike(out, m)
+
+    out.fill(0)
+    t.ok(sodium.extension_envelope_open(out, c, (i + 1) % 5, r.pk(i), r.sks[i]), 'opens with a wrong hint')
+    t.alike(out, m)
+  }
+
+  const stranger = recipients(1)
+  t.absent(sodium.extension_envelope_open(Buffer.alloc(m.byteLength), c, 0, stranger.pk(0), stranger.sks[0]), 'others cannot open')
+})
+
+test('large groups', async function (t) {
+  const r = recipients(150)
+  const m = Buffer.alloc(4096)
+  sodium.randombytes_buf(m)
+
+  for (const async of [false, true]) {
+    const c = Buffer.alloc(envelopeBytes(150, m.byteLength))
+
+    if (async) t.is(await sodium.extension_envelope_seal_async(c, m, r.pks), null)
+    else sodium.extension_envelope_seal(c, m, r.pks)
+
+    let ok = true
+
+    for (let i = 0; i < 150; i += 7) {
+      const out = Buffer.alloc(m.byteLength)
+      ok = ok && sodium.extension_envelope_open(out, c, i, r.pk(i), r.sks[i]) && out.equals(m)
+    }
+
+    t.ok(ok, async ? 'seal_async' : 'seal')
+  }
+})
+
+test('seal_async with a callback', function (t) {
+  t.plan(2)
+
+  const r = recipients(2)
+  const m = Buffer.from('hello group')
+  const c = Buffer.alloc(envelopeBytes(2, m.byteLength))
+
+  sodium.extension_envelope_seal_async(c, m, r.pks, function (err) {
+    t.absent(err)
+
+    const out = Buffer.alloc(m.byteLength)
+    t.ok(sodium.extension_envelope_open(out, c, 1, r.pk(1), r.sks[1]) && out.equals(m))
+  })
+})
+
+test('seal_async rejects low order recipients', async function (t) {
+  const r = recipients(40)
+  const m = Buffer.from('hi')
+  const pks = Buffer.concat([r.pks, Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)])
+  const c = Buffer.alloc(envelopeBytes(41, m.byteLength))
+
+  await t.exception(sodium.extension_envelope_seal_async(c, m, pks))
+  t.ok(c.every((b) => b === 0), 'c is wiped')
+})
+
+test('tampering is detected', function (t) {
+  const r = recipients(3)
+  const m = Buffer.from('do not touch')
+  const c = Buffer.alloc(envelopeBytes(3, m.byteLength))
+  const out = Buffer.alloc(m.byteLength)
+
+  sodium.extension_envelope_seal(c, m, r.pks)
+
+  // flipping a byte of another recipient's entry still breaks the body, the whole header is additional data
+  c[sodium.extension_envelope_HEADERBYTES + 2 * sodium.extension_envelope_ENTRYBYTES] ^= 1
+  t.absent(sodium.extension_envelope_open(out, c, 0, r.pk(0), r.sks[0]), 'header')
+  c[sodium.extension_envelope_HEADERBYTES + 2 * sodium.extension_envelope_ENTRYBYTES] ^= 1
+
+  c[c.byteLength - 1] ^= 1
+  t.absent(sodium.extension_envelope_open(out, c, 0, r.pk(0), r.sks[0]), 'body')
+  c[c.byteLength - 1] ^= 1
+
+  t.ok(sodium.extension_envelope_open(out, c, 0, r.pk(0), r.sks[0]))
+})
+
+test('validates input', function (t) {
+  const r = recipients(2)
+  const m = Buffer.from('hi')
+
+  t.exception.all(function () {
+    sodium.extension_envelope_seal(Buffer.alloc(envelopeBytes(2, m.byteLength) - 1), m, r.pks)
+  }, 'c must fit the envelope')
+
+  t.exception.all(function () {
+    sodium.extension_envelope_seal(Buffer.alloc(envelopeBytes(0, m.byteLength)), m, Buffer.alloc(0))
+  }, 'needs a recipient')
+
+  t.exception.all(function () {
+    const pks = Buffer.concat([r.pks, Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)])
+    sodium.extension_envelope_seal(Buffer.alloc(envelopeBytes(3, m.byteLength)), m, pks)
+  }, 'rejects low order recipients')
+
+  t.exception.all(function () {
+    sodium.extension_envelope_seal(Buffer.alloc(envelopeBytes(2, m.byteLength)), m, r.pks, function () {})
+  }, 'sync call takes no callback')
+
+  t.exception.all(function () {
+    sodium.extension_envelope_open(Buffer.alloc(2), Buffer.alloc(10), 0, r.pk(0), r.sks[0])
+  }, 'c must be an envelope')
+
+  t.is(sodium.extension_envelope_recipients(Buffer.alloc(10)), 0)
+})
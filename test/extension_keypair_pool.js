@@ -0,0 +1,157 @@
+const test = require('brittle')
+const sodium = require('..')
+
+function pool (capacity, watermark) {
+  const buf = sodium.sodium_malloc(sodium.extension_keypair_pool_HEADERBYTES + capacity * sodium.extension_keypair_pool_KEYPAIRBYTES)
+  sodium.extension_keypair_pool_init(buf, watermark)
+  return buf
+}
+
+test('constants', function (t) {
+  t.is(sodium.extension_keypair_pool_HEADERBYTES, 64)
+  t.is(sodium.extension_keypair_pool_KEYPAIRBYTES, sodium.crypto_box_PUBLICKEYBYTES + sodium.crypto_box_SECRETKEYBYTES)
+  t.is(sodium.extension_keypair_pool_STATS, 7)
+})
+
+test('init validates the pool', function (t) {
+  t.exception.all(function () {
+    sodium.extension_keypair_pool_init(sodium.sodium_malloc(sodium.extension_keypair_pool_HEADERBYTES), 0)
+  }, 'needs room for a keypair')
+
+  t.exception.all(function () {
+    sodium.extension_keypair_pool_init(sodium.sodium_malloc(sodium.extension_keypair_pool_HEADERBYTES + sodium.extension_keypair_pool_KEYPAIRBYTES + 1), 0)
+  }, 'must be a whole number of keypairs')
+
+  t.exception.all(function () {
+    sodium.extension_keypair_pool_init(sodium.sodium_malloc(sodium.extension_keypair_pool_HEADERBYTES + sodium.extension_keypair_pool_KEYPAIRBYTES), 2)
+  }, 'watermark must fit the pool')
+
+  t.exception.all(function () {
+    sodium.extension_keypair_pool_stats(sodium.sodium_malloc(sodium.extension_keypair_pool_HEADERBYTES + sodium.extension_keypair_pool_KEYPAIRBYTES))
+  }, 'must be initialised')
+
+  const p = pool(2, 0)
+  p.writeUInt32LE(3, 16)
+
+  t.exception.all(function () {
+    sodium.extension_keypair_pool_kx_keypair(Buffer.alloc(sodium.crypto_kx_PUBLICKEYBYTES), Buffer.alloc(sodium.crypto_kx_SECRETKEYBYTES), p)
+  }, 'more keypairs available than fit')
+})
+
+test('fill then draw', async function (t) {
+  const p = pool(8, 0)
+
+  t.alike(sodium.extension_keypair_pool_stats(p), { available: 0, capacity: 8, low: 0, pending: 0, draws: 0, misses: 0, fills: 0 })
+
+  await sodium.extension_keypair_pool_fill(p)
+
+  t.is(sodium.extension_keypair_pool_stats(p).available, 8)
+
+  const seen = new Set()
+
+  for (let i = 0; i < 8; i++) {
+    const pk = Buffer.alloc(sodium.crypto_kx_PUBLICKEYBYTES)
+    const sk = Buffer.alloc(sodium.crypto_kx_SECRETKEYBYTES)
+    sodium.extension_keypair_pool_kx_keypair(pk, sk, p)
+
+    const check = Buffer.alloc(sodium.crypto_scalarmult_BYTES)
+    sodium.crypto_scalarmult_base(check, sk)
+
+    t.alike(check, pk, 'keypair is consistent')
+    seen.add(pk.toString('hex'))
+  }
+
+  t.is(seen.size, 8, 'every keypair is handed out once')
+
+  const stats = sodium.extension_keypair_pool_stats(p)
+  t.is(stats.available, 0)
+  t.is(stats.low, 0)
+  t.is(stats.draws, 8)
+  t.is(stats.misses, 0)
+  t.is(stats.fills, 1)
+})
+
+test('kx keypairs derive working session keys', async function (t) {
+  const p = pool(2, 0)
+  await sodium.extension_keypair_pool_fill(p)
+
+  const cpk = Buffer.alloc(sodium.crypto_kx_PUBLICKEYBYTES)
+  const csk = Buffer.alloc(sodium.crypto_kx_SECRETKEYBYTES)
+  const spk = Buffer.alloc(sodium.crypto_kx_PUBLICKEYBYTES)
+  const ssk = Buffer.alloc(sodium.crypto_kx_SECRETKEYBYTES)
+
+  sodium.extension_keypair_pool_kx_keypair(cpk, csk, p)
+  sodium.extension_keypair_pool_kx_keypair(spk, ssk, p)
+
+  const crx = Buffer.alloc(sodium.crypto_kx_SESSIONKEYBYTES)
+  const ctx = Buffer.alloc(sodium.crypto_kx_SESSIONKEYBYTES)
+  const srx = Buffer.alloc(sodium.crypto_kx_SESSIONKEYBYTES)
+  const stx = Buffer.alloc(sodium.crypto_kx_SESSIONKEYBYTES)
+
+  sodium.crypto_kx_client_session_keys(crx, ctx, cpk, csk, spk)
+  sodium.crypto_kx_server_session_keys(srx, stx, spk, ssk, cpk)
+
+  t.alike(crx, stx)
+  t.alike(ctx, srx)
+})
+
+test('seal opens with crypto_box_seal_open', async function (t) {
+  const p = pool(4, 0)
+  await sodium.extension_keypair_pool_fill(p)
+
+  const pk = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
+  const sk = Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES)
+  sodium.crypto_box_keypair(pk, sk)
+
+  // the last two draws find the pool empty and fall back to a fresh keypair
+  for (let i = 0; i < 6; i++) {
+    const m = Buffer.from('sealed with a pooled keypair ' + i)
+    const c = Buffer.alloc(m.byteLength + sodium.crypto_box_SEALBYTES)
+    const out = Buffer.alloc(m.byteLength)
+
+    sodium.extension_keypair_pool_seal(c, m, pk, p)
+
+    t.ok(sodium.crypto_box_seal_open(out, c, pk, sk))
+    t.alike(out, m)
+  }
+
+  const stats = sodium.extension_keypair_pool_stats(p)
+  t.is(stats.draws, 6)
+  t.is(stats.misses, 2)
+})
+
+test('refills in the background below the watermark', async function (t) {
+  const p = pool(16, 8)
+  await sodium.extension_keypair_pool_fill(p)
+
+  const pk = Buffer.alloc(sodium.crypto_kx_PUBLICKEYBYTES)
+  const sk = Buffer.alloc(sodium.crypto_kx_SECRETKEYBYTES)
+
+  for (let i = 0; i < 9; i++) sodium.extension_keypair_pool_kx_keypair(pk, sk, p)
+
+  let stats = sodium.extension_keypair_pool_stats(p)
+  t.is(stats.low, 7, 'low watermark')
+  t.is(stats.pending, 9, 'refill queued')
+
+  while (sodium.extension_keypair_pool_stats(p).pending > 0) {
+    await new Promise((resolve) => setTimeout(resolve, 5))
+  }
+
+  stats = sodium.extension_keypair_pool_stats(p)
+  t.is(stats.available, 16)
+  t.is(stats.fills, 2)
+  t.is(stats.low, 16, 'low resets on every stats call')
+})
+
+test('final drops fills that are still out', async function (t) {
+  const p = pool(4, 0)
+  const fill = sodium.extension_keypair_pool_fill(p)
+
+  sodium.extension_keypair_pool_final(p)
+  await fill
+
+  t.ok(sodium.sodium_is_zero(p), 'nothing landed after final')
+
+  sodium.extension_keypair_pool_init(p, 0)
+  t.is(sodium.extension_keypair_pool_stats(p).available, 0)
+})
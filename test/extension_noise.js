@@ -0,0 +1,301 @@
+const test = require('brittle')
+const sodium = require('..')
+const binding = require('../binding')
+
+function keyPair () {
+  const publicKey = Buffer.alloc(sodium.extension_noise_PUBLICKEYBYTES)
+  const secretKey = Buffer.alloc(sodium.extension_noise_SECRETKEYBYTES)
+  sodium.crypto_box_keypair(publicKey, secretKey)
+
+  return { publicKey, secretKey }
+}
+
+function state () {
+  return sodium.sodium_malloc(sodium.extension_noise_STATEBYTES)
+}
+
+// runs writer -> reader until the pattern is done, returns the payloads read
+function handshake (initiator, responder) {
+  const received = []
+  let w = initiator
+  let r = responder
+
+  while (sodium.extension_noise_turn(w) === 1) {
+    const payload = Buffer.from('message ' + received.length)
+    const message = Buffer.alloc(payload.byteLength + sodium.extension_noise_overhead(w))
+
+    sodium.extension_noise_write_message(w, message, payload)
+
+    const out = Buffer.alloc(message.byteLength - sodium.extension_noise_overhead(r))
+    if (!sodium.extension_noise_read_message(r, out, message)) return null
+    received.push(out.toString())
+
+    const t = w
+    w = r
+    r = t
+  }
+
+  return received
+}
+
+function split (s) {
+  const tx = Buffer.alloc(sodium.extension_noise_KEYBYTES)
+  const rx = Buffer.alloc(sodium.extension_noise_KEYBYTES)
+  const h = Buffer.alloc(sodium.extension_noise_HASHBYTES)
+
+  sodium.extension_noise_split(s, tx, rx)
+  sodium.extension_noise_handshake_hash(s, h)
+
+  return { tx, rx, h }
+}
+
+test('constants', function (t) {
+  t.is(sodium.extension_noise_STATEBYTES, 384)
+  t.is(sodium.extension_noise_PUBLICKEYBYTES, 32)
+  t.is(sodium.extension_noise_SECRETKEYBYTES, 32)
+  t.is(sodium.extension_noise_HASHBYTES, 64)
+  t.is(sodium.extension_noise_KEYBYTES, 32)
+  t.is(sodium.extension_noise_MACBYTES, 16)
+  t.is(sodium.extension_noise_MESSAGEBYTES_MAX, 65535)
+  t.not(sodium.extension_noise_XX, sodium.extension_noise_IK)
+  t.absent(sodium._extension_noise_fixed_ephemeral, 'fixed ephemeral keys stay out of the public api')
+})
+
+test('XX handshake', function (t) {
+  const a = keyPair()
+  const b = keyPair()
+  const prologue = Buffer.from('prologue')
+
+  const initiator = state()
+  const responder = state()
+
+  sodium.extension_noise_init(initiator, sodium.extension_noise_XX, true, prologue, a.publicKey, a.secretKey)
+  sodium.extension_noise_init(responder, sodium.extension_noise_XX, false, prologue, b.publicKey, b.secretKey)
+
+  t.is(sodium.extension_noise_overhead(initiator), 32, '-> e')
+  t.absent(sodium.extension_noise_remote_static(initiator, Buffer.alloc(32)), 'remote static not known yet')
+
+  t.alike(handshake(initiator, responder), ['message 0', 'message 1', 'message 2'])
+
+  t.is(sodium.extension_noise_turn(initiator), -1)
+  t.is(sodium.extension_noise_turn(responder), -1)
+
+  const i = split(initiator)
+  const r = split(responder)
+
+  t.alike(i.tx, r.rx)
+  t.alike(i.rx, r.tx)
+  t.unlike(i.tx, i.rx)
+  t.alike(i.h, r.h)
+
+  const rs = Buffer.alloc(sodium.extension_noise_PUBLICKEYBYTES)
+  t.ok(sodium.extension_noise_remote_static(initiator, rs))
+  t.alike(rs, b.publicKey)
+  t.ok(sodium.extension_noise_remote_static(responder, rs))
+  t.alike(rs, a.publicKey)
+})
+
+test('IK handshake', function (t) {
+  const a = keyPair()
+  const b = keyPair()
+  const prologue = Buffer.alloc(0)
+
+  const initiator = state()
+  const responder = state()
+
+  sodium.extension_noise_init(initiator, sodium.extension_noise_IK, true, prologue, a.publicKey, a.secretKey, b.publicKey)
+  sodium.extension_noise_init(responder, sodium.extension_noise_IK, false, prologue, b.publicKey, b.secretKey)
+
+  t.is(sodium.extension_noise_overhead(initiator), 32 + 48 + 16, '-> e, es, s, ss')
+
+  t.alike(handshake(initiator, responder), ['message 0', 'message 1'])
+
+  const i = split(initiator)
+  const r = split(responder)
+
+  t.alike(i.tx, r.rx)
+  t.alike(i.rx, r.tx)
+  t.alike(i.h, r.h)
+
+  const rs = Buffer.alloc(sodium.extension_noise_PUBLICKEYBYTES)
+  t.ok(sodium.extension_noise_remote_static(responder, rs))
+  t.alike(rs, a.publicKey)
+})
+
+test('IK with the wrong responder key fails', function (t) {
+  const a = keyPair()
+  const b = keyPair()
+  const initiator = state()
+  const responder = state()
+
+  sodium.extension_noise_init(initiator, sodium.extension_noise_IK, true, Buffer.alloc(0), a.publicKey, a.secretKey, keyPair().publicKey)
+  sodium.extension_noise_init(responder, sodium.extension_noise_IK, false, Buffer.alloc(0), b.publicKey, b.secretKey)
+
+  t.is(handshake(initiator, responder), null)
+  t.is(sodium.extension_noise_turn(responder), -1, 'responder is failed for good')
+})
+
+test('mismatched prologues fail', function (t) {
+  const a = keyPair()
+  const b = keyPair()
+  const initiator = state()
+  const responder = state()
+
+  sodium.extension_noise_init(initiator, sodium.extension_noise_XX, true, Buffer.from('a'), a.publicKey, a.secretKey)
+  sodium.extension_noise_init(responder, sodium.extension_noise_XX, false, Buffer.from('b'), b.publicKey, b.secretKey)
+
+  t.is(handshake(initiator, responder), null)
+})
+
+test('tampered message fails the state', function (t) {
+  const a = keyPair()
+  const b = keyPair()
+  const initiator = state()
+  const responder = state()
+
+  sodium.extension_noise_init(initiator, sodium.extension_noise_XX, true, Buffer.alloc(0), a.publicKey, a.secretKey)
+  sodium.extension_noise_init(responder, sodium.extension_noise_XX, false, Buffer.alloc(0), b.publicKey, b.secretKey)
+
+  const m1 = Buffer.alloc(sodium.extension_noise_overhead(initiator))
+  sodium.extension_noise_write_message(initiator, m1, Buffer.alloc(0))
+  t.ok(sodium.extension_noise_read_message(responder, Buffer.alloc(0), m1))
+
+  const m2 = Buffer.alloc(sodium.extension_noise_overhead(responder))
+  sodium.extension_noise_write_message(responder, m2, Buffer.alloc(0))
+  m2[40] ^= 1
+
+  t.absent(sodium.extension_noise_read_message(initiator, Buffer.alloc(0), m2))
+  t.is(sodium.extension_noise_turn(initiator), -1)
+
+  t.exception(function () {
+    sodium.extension_noise_split(initiator, Buffer.alloc(32), Buffer.alloc(32))
+  })
+})
+
+test('out of turn and early calls throw', function (t) {
+  const a = keyPair()
+  const s = state()
+
+  t.exception(function () {
+    sodium.extension_noise_turn(Buffer.alloc(sodium.extension_noise_STATEBYTES))
+  }, 'uninitialised state')
+
+  t.exception(function () {
+    sodium.extension_noise_init(s, 3, true, Buffer.alloc(0), a.publicKey, a.secretKey)
+  }, 'unknown pattern')
+
+  t.exception(function () {
+    sodium.extension_noise_init(s, sodium.extension_noise_IK, true, Buffer.alloc(0), a.publicKey, a.secretKey)
+  }, 'IK initiator without rs')
+
+  sodium.extension_noise_init(s, sodium.extension_noise_XX, false, Buffer.alloc(0), a.publicKey, a.secretKey)
+
+  t.exception(function () {
+    sodium.extension_noise_write_message(s, Buffer.alloc(48), Buffer.alloc(0))
+  }, 'responder writes first')
+
+  t.exception(function () {
+    sodium.extension_noise_read_message(s, Buffer.alloc(0), Buffer.alloc(31))
+  }, 'short message')
+
+  t.exception(function () {
+    sodium.extension_noise_split(s, Buffer.alloc(32), Buffer.alloc(32))
+  }, 'split before the handshake is done')
+
+  t.exception(function () {
+    sodium.extension_noise_handshake_hash(s, Buffer.alloc(64))
+  }, 'hash before split')
+})
+
+// Inputs of the cacophony Noise_XX / Noise_IK _25519_ChaChaPoly_BLAKE2b vectors, outputs checked
+// against an independent model of revision 34 (HMAC-BLAKE2b HKDF over libsodium's AEAD and X25519)
+const vectors = {
+  initStatic: 'e61ef9919cde45dd5f82166404bd08e38bceb5dfdfded0a34c8df7ed542214d1',
+  initEphemeral: '893e28b9dc6ca8d611ab664754b8ceb7bac5117349a4439a6b0569da977c464a',
+  respStatic: '4a3acbfdb163dec651dfa3194dece676d437029c62a408b4c5ea9114246e4893',
+  respEphemeral: 'bbdb4cdbd309f1a1f2e1456967fe288cadd6f712d65dc7b7793d5e63da6b375b',
+  prologue: 'John Galt',
+  payloads: ['Ludwig von Mises', 'Murray Rothbard', 'F. A. Hayek'],
+  handshakes: [
+    {
+      pattern: 'XX',
+      messages: [
+        'ca35def5ae56cec33dc2036731ab14896bc4c75dbb07a61f879f8e3afa4c79444c756477696720766f6e204d69736573',
+        '95ebc60d2b1fa672c1f46a8aa265ef51bfe38e7ccb39ec5be34069f1448088430505b6745ce64a5f33f0e8e3b83f11ce8802bca507f4f2d8b564dbe277e1966116e132faa2dfd70b8b077b9f94b913df5056ae1319469b824a98d54bbaa82c325595587064f978c4b6d104f7596e6f',
+        '99579e1c1ee15e422a57ddd6b16d37087b17558e8369c18991b4b2ca3a824abf904cdcf5458b5431a75af034ca9e9b982de039eaaf156775e2d580cd4e5ebae89c3f8cb2594b556d8a8169'
+      ],
+      handshakeHash: '8cf47d7b3cb5804c0109d48e8bcdbee2cbb65687d8ea2c92994ca361fb86151ad93627b98936cbb32de56e8abb21def3925011ac3e35db9cbeea73ab9a4392c2',
+      k1: '3acb28e9f096f552129371df67cafa4d4693bec67d288a9b5bf7311649790514',
+      k2: 'c3afbe61fd5761493bc55a143def98f3c8e12991c8371b0916351bc841727f89'
+    },
+    {
+      pattern: 'IK',
+      messages: [
+        'ca35def5ae56cec33dc2036731ab14896bc4c75dbb07a61f879f8e3afa4c7944ba83a447b38c83e327ad936929812f624884847b7831e95e197b2f797088efdd2f88f1db7e1fb0e99c64419097af91cee64e470f4b6fcd9298ce0b56fe20f86e13bf70439c538e3602a7127af71a29cc',
+        '95ebc60d2b1fa672c1f46a8aa265ef51bfe38e7ccb39ec5be34069f1448088439f069b267a06b3de3ecb1043bcb098e9af91d9c64748d998c7b47890871571'
+      ],
+      handshakeHash: '1c8fa891cb414fedba6daa7c6f4ae0a6d98e5f9768cc9cecd27e805614943ee9c8a1b27fbfb76dc197255c8aa69f6b4285c423840b8bedf45e652ca64f797d81',
+      k1: 'e5a7ef420e26421734c82df62522251fa2f56a6626d64039756ffec438b2883f',
+      k2: '065bc21e75d5ac1c0d227dcd158cc9e1979fc30efeb558622535b4b84eb6c80a'
+    }
+  ]
+}
+
+function fixedKeyPair (hex) {
+  const secretKey = Buffer.from(hex, 'hex')
+  const publicKey = Buffer.alloc(sodium.extension_noise_PUBLICKEYBYTES)
+  sodium.crypto_scalarmult_base(publicKey, secretKey)
+
+  return { publicKey, secretKey }
+}
+
+for (const v of vectors.handshakes) {
+  test(v.pattern + ' known answer', function (t) {
+    const pattern = sodium['extension_noise_' + v.pattern]
+    const prologue = Buffer.from(vectors.prologue)
+    const a = fixedKeyPair(vectors.initStatic)
+    const b = fixedKeyPair(vectors.respStatic)
+
+    const initiator = state()
+    const responder = state()
+
+    sodium.extension_noise_init(initiator, pattern, true, prologue, a.publicKey, a.secretKey, v.pattern === 'IK' ? b.publicKey : null)
+    sodium.extension_noise_init(responder, pattern, false, prologue, b.publicKey, b.secretKey)
+
+    binding._extension_noise_fixed_ephemeral(initiator, Buffer.from(vectors.initEphemeral, 'hex'))
+    binding._extension_noise_fixed_ephemeral(responder, Buffer.from(vectors.respEphemeral, 'hex'))
+
+    let w = initiator
+    let r = responder
+
+    for (let i = 0; i < v.messages.length; i++) {
+      const payload = Buffer.from(vectors.payloads[i])
+      const message = Buffer.alloc(payload.byteLength + sodium.extension_noise_overhead(w))
+
+      sodium.extension_noise_write_message(w, message, payload)
+      t.is(message.toString('hex'), v.messages[i], 'message ' + i)
+
+      const out = Buffer.alloc(message.byteLength - sodium.extension_noise_overhead(r))
+      t.ok(sodium.extension_noise_read_message(r, out, message))
+      t.alike(out, payload)
+
+      const tmp = w
+      w = r
+      r = tmp
+    }
+
+    const i = split(initiator)
+    const s = split(responder)
+
+    t.is(i.h.toString('hex'), v.handshakeHash)
+    t.alike(s.h, i.h)
+    t.is(i.tx.toString('hex'), v.k1)
+    t.is(i.rx.toString('hex'), v.k2)
+    t.alike(s.rx, i.tx)
+    t.alike(s.tx, i.rx)
+
+    t.exception(function () {
+      binding._extension_noise_fixed_ephemeral(initiator, Buffer.from(vectors.initEphemeral, 'hex'))
+    }, 'no fixed ephemeral once done')
+  })
+}
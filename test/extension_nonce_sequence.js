@@ -0,0 +1,177 @@
+const test = require('brittle')
+const sodium = require('..')
+
+test('constants', function (t) {
+  t.is(typeof sodium.extension_nonce_sequence_STATEBYTES, 'number')
+  t.is(sodium.extension_nonce_sequence_NONCEBYTES_MAX, 24)
+})
+
+test('counter sequence', function (t) {
+  const state = Buffer.alloc(sodium.extension_nonce_sequence_STATEBYTES)
+  sodium.extension_nonce_sequence_init(state, sodium.crypto_secretbox_NONCEBYTES)
+
+  const expected = Buffer.alloc(sodium.crypto_secretbox_NONCEBYTES)
+  const nonce = Buffer.alloc(sodium.crypto_secretbox_NONCEBYTES)
+
+  for (let i = 0; i < 300; i++) {
+    sodium.extension_nonce_sequence_next(nonce, state)
+    t.alike(nonce, expected)
+    t.alike(sodium.extension_nonce_sequence_nonce(state), expected)
+    sodium.sodium_increment(expected)
+  }
+})
+
+test('counter sequence with random prefix', function (t) {
+  const a = Buffer.alloc(sodium.extension_nonce_sequence_STATEBYTES)
+  const b = Buffer.alloc(sodium.extension_nonce_sequence_STATEBYTES)
+
+  sodium.extension_nonce_sequence_init(a, 12, 4)
+  sodium.extension_nonce_sequence_init(b, 12, 4)
+
+  const na = Buffer.alloc(12)
+  const nb = Buffer.alloc(12)
+
+  sodium.extension_nonce_sequence_next(na, a)
+  sodium.extension_nonce_sequence_next(nb, b)
+
+  t.unlike(na.subarray(0, 4), nb.subarray(0, 4))
+  t.ok(sodium.sodium_is_zero(na.subarray(4)))
+
+  sodium.extension_nonce_sequence_next(na, a)
+  t.is(na[4], 1)
+})
+
+test('counter sequence overflow', function (t) {
+  const state = Buffer.alloc(sodium.extension_nonce_sequence_STATEBYTES)
+  sodium.extension_nonce_sequence_init(state, 12, 11)
+
+  const nonce = Buffer.alloc(12)
+  for (let i = 0; i < 256; i++) sodium.extension_nonce_sequence_next(nonce, state)
+  t.is(nonce[11], 255)
+
+  t.exception.all(() => sodium.extension_nonce_sequence_next(nonce, state))
+
+  const key = Buffer.alloc(sodium.crypto_aead_chacha20poly1305_ietf_KEYBYTES)
+  const c = Buffer.alloc(sodium.crypto_aead_chacha20poly1305_ietf_ABYTES)
+  t.exception.all(() => sodium.crypto_aead_chacha20poly1305_ietf_encrypt(c, Buffer.alloc(0), null, null, state, key))
+})
+
+test('random sequence', function (t) {
+  const state = Buffer.alloc(sodium.extension_nonce_sequence_STATEBYTES)
+  sodium.extension_nonce_sequence_init_random(state, 24)
+
+  const a = Buffer.alloc(24)
+  const b = Buffer.alloc(24)
+
+  sodium.extension_nonce_sequence_next(a, state)
+  sodium.extension_nonce_sequence_next(b, state)
+
+  t.unlike(a, b)
+})
+
+test('invalid parameters', function (t) {
+  const state = Buffer.alloc(sodium.extension_nonce_sequence_STATEBYTES)
+
+  t.exception.all(() => sodium.extension_nonce_sequence_init(state, 25))
+  t.exception.all(() => sodium.extension_nonce_sequence_init(state, 12, 12))
+  t.exception.all(() => sodium.extension_nonce_sequence_init(Buffer.alloc(10), 12))
+})
+
+test('aead encrypt draws from the sequence', function (t) {
+  for (const alg of ['chacha20poly1305_ietf', 'xchacha20poly1305_ietf']) {
+    const NPUBBYTES = sodium['crypto_aead_' + alg + '_NPUBBYTES']
+    const ABYTES = sodium['crypto_aead_' + alg + '_ABYTES']
+    const encrypt = sodium['crypto_aead_' + alg + '_encrypt_seq']
+    const decrypt = sodium['crypto_aead_' + alg + '_decrypt']
+
+    const key = Buffer.alloc(sodium['crypto_aead_' + alg + '_KEYBYTES'])
+    sodium.randombytes_buf(key)
+
+    const state = Buffer.alloc(sodium.extension_nonce_sequence_STATEBYTES)
+    sodium.extension_nonce_sequence_init(state, NPUBBYTES, 4)
+
+    const m = Buffer.from('hello world')
+    let expectedNonce = null
+
+    for (let i = 0; i < 3; i++) {
+      const c = Buffer.alloc(m.byteLength + ABYTES)
+      encrypt(c, m, null, null, state, key)
+
+      const nonce = sodium.extension_nonce_sequence_nonce(state)
+      t.is(nonce.byteLength, NPUBBYTES)
+
+      if (expectedNonce === null) {
+        expectedNonce = Buffer.from(nonce)
+        t.ok(sodium.sodium_is_zero(expectedNonce.subarray(4)))
+      }
+
+      t.alike(nonce, expectedNonce)
+
+      const m1 = Buffer.alloc(m.byteLength)
+      decrypt(m1, null, c, null, nonce, key)
+      t.alike(m1, m)
+
+      sodium.sodium_increment(expectedNonce.subarray(4))
+    }
+
+    const other = Buffer.alloc(sodium.extension_nonce_sequence_STATEBYTES)
+    sodium.extension_nonce_sequence_init(other, NPUBBYTES === 12 ? 24 : 12)
+    t.exception.all(() => encrypt(Buffer.alloc(ABYTES), Buffer.alloc(0), null, null, other, key))
+    t.exception.all(() => encrypt(Buffer.alloc(ABYTES), Buffer.alloc(0), null, null, Buffer.alloc(NPUBBYTES), key), 'should validate state length')
+  }
+})
+
+test('plain encrypt never treats the nonce as a sequence', function (t) {
+  const key = Buffer.alloc(sodium.crypto_aead_chacha20poly1305_ietf_KEYBYTES)
+  const state = Buffer.alloc(sodium.extension_nonce_sequence_STATEBYTES)
+  sodium.extension_nonce_sequence_init(state, sodium.crypto_aead_chacha20poly1305_ietf_NPUBBYTES)
+
+  const copy = Buffer.from(state)
+
+  t.exception.all(function () {
+    sodium.crypto_aead_chacha20poly1305_ietf_encrypt(Buffer.alloc(sodium.crypto_aead_chacha20poly1305_ietf_ABYTES), Buffer.alloc(0), null, null, state, key)
+  }, /npub/)
+
+  t.alike(state, copy, 'state is left alone')
+})
+
+test('secretbox draws from the sequence', function (t) {
+  const key = Buffer.alloc(sodium.crypto_secretbox_KEYBYTES)
+  sodium.randombytes_buf(key)
+
+  const state = Buffer.alloc(sodium.extension_nonce_sequence_STATEBYTES)
+  sodium.extension_nonce_sequence_init_random(state, sodium.crypto_secretbox_NONCEBYTES)
+
+  const m = Buffer.from('hello world')
+  const c = Buffer.alloc(m.byteLength + sodium.crypto_secretbox_MACBYTES)
+  sodium.crypto_secretbox_easy_seq(c, m, state, key)
+
+  const nonce = Buffer.from(sodium.extension_nonce_sequence_nonce(state))
+  const m1 = Buffer.alloc(m.byteLength)
+  t.ok(sodium.crypto_secretbox_open_easy(m1, c, nonce, key))
+  t.alike(m1, m)
+
+  const mac = Buffer.alloc(sodium.crypto_secretbox_MACBYTES)
+  sodium.crypto_secretbox_detached_seq(c.subarray(0, m.byteLength), mac, m, state, key)
+  t.unlike(sodium.extension_nonce_sequence_nonce(state), nonce)
+})
+
+test('a rejected call does not advance the sequence', function (t) {
+  const state = Buffer.alloc(sodium.extension_nonce_sequence_STATEBYTES)
+  sodium.extension_nonce_sequence_init(state, sodium.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES)
+
+  const m = Buffer.from('hello world')
+  const c = Buffer.alloc(m.byteLength + sodium.crypto_aead_xchacha20poly1305_ietf_ABYTES)
+
+  t.exception.all(function () {
+    sodium.crypto_aead_xchacha20poly1305_ietf_encrypt_seq(c, m, null, null, state, Buffer.alloc(1))
+  }, 'short key')
+
+  t.exception.all(function () {
+    sodium.crypto_secretbox_detached_seq(Buffer.alloc(m.byteLength), Buffer.alloc(sodium.crypto_secretbox_MACBYTES), m, state, Buffer.alloc(1))
+  }, 'short secretbox key')
+
+  const nonce = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES)
+  sodium.extension_nonce_sequence_next(nonce, state)
+  t.ok(sodium.sodium_is_zero(nonce), 'first nonce is still unused')
+})
@@ -0,0 +1,138 @@
+const test = require('brittle')
+const sodium = require('..')
+
+const OVERHEAD = sodium.extension_ratchet_HEADERBYTES + sodium.extension_ratchet_ABYTES
+const CTX = Buffer.from('ratchet_')
+
+function ratchet (chainKey, skipped = 0) {
+  const state = sodium.sodium_malloc(sodium.extension_ratchet_STATEBYTES + skipped * sodium.extension_ratchet_SKIPBYTES)
+  sodium.extension_ratchet_init(state, chainKey, CTX)
+  return state
+}
+
+function pair (skipped) {
+  const chainKey = Buffer.alloc(sodium.extension_ratchet_KEYBYTES)
+  sodium.randombytes_buf(chainKey)
+
+  return { a: ratchet(chainKey, skipped), b: ratchet(chainKey, skipped) }
+}
+
+function encrypt (state, m, ad) {
+  const c = Buffer.alloc(m.byteLength + OVERHEAD)
+  sodium.extension_ratchet_encrypt(state, c, m, ad)
+  return c
+}
+
+function decrypt (state, c, ad) {
+  const m = Buffer.alloc(c.byteLength - OVERHEAD)
+  return sodium.extension_ratchet_decrypt(state, m, c, ad) ? m : null
+}
+
+test('constants', function (t) {
+  t.is(sodium.extension_ratchet_STATEBYTES, 64)
+  t.is(sodium.extension_ratchet_SKIPBYTES, 40)
+  t.is(sodium.extension_ratchet_KEYBYTES, 32)
+  t.is(sodium.extension_ratchet_CONTEXTBYTES, 8)
+  t.is(sodium.extension_ratchet_HEADERBYTES, 8)
+  t.is(sodium.extension_ratchet_ABYTES, 16)
+  t.is(sodium.extension_ratchet_SKIP_MAX, 1024)
+})
+
+test('next matches crypto_kdf_derive_from_key', function (t) {
+  const chainKey = Buffer.alloc(sodium.extension_ratchet_KEYBYTES)
+  sodium.randombytes_buf(chainKey)
+
+  const state = ratchet(chainKey)
+  const key = Buffer.alloc(sodium.extension_ratchet_KEYBYTES)
+  const expected = Buffer.alloc(sodium.extension_ratchet_KEYBYTES)
+  const ck = Buffer.from(chainKey)
+
+  for (let i = 0; i < 3; i++) {
+    t.is(sodium.extension_ratchet_next(state, key), i)
+
+    sodium.crypto_kdf_derive_from_key(expected, 1, CTX, ck)
+    sodium.crypto_kdf_derive_from_key(ck, 2, CTX, Buffer.from(ck))
+
+    t.alike(key, expected)
+  }
+
+  t.is(sodium.extension_ratchet_next(state, key), 3, 'skip moves the counter')
+  sodium.extension_ratchet_skip(state, 2)
+  t.is(sodium.extension_ratchet_next(state, key), 6)
+})
+
+test('encrypt and decrypt in order', function (t) {
+  const { a, b } = pair()
+  const ad = Buffer.from('header')
+
+  for (let i = 0; i < 5; i++) {
+    const c = encrypt(a, Buffer.from('message ' + i), ad)
+    t.is(c.readUInt32LE(0), i, 'counter in the clear')
+    t.alike(decrypt(b, c, ad), Buffer.from('message ' + i))
+    t.is(decrypt(b, c, ad), null, 'a message key is only used once')
+  }
+
+  t.is(decrypt(b, encrypt(a, Buffer.from('x'), ad), Buffer.from('other')), null, 'ad is authenticated')
+
+  const key = Buffer.alloc(sodium.extension_ratchet_KEYBYTES)
+  const c = encrypt(a, Buffer.from('no ad'))
+  const m = Buffer.alloc(c.byteLength - OVERHEAD)
+  const nonce = Buffer.alloc(sodium.crypto_aead_chacha20poly1305_ietf_NPUBBYTES)
+
+  t.is(sodium.extension_ratchet_next(b, key), 5)
+  t.is(sodium.extension_ratchet_next(b, key), 6)
+  c.copy(nonce, 4, 0, 8)
+  sodium.crypto_aead_chacha20poly1305_ietf_decrypt(m, null, c.subarray(sodium.extension_ratchet_HEADERBYTES), null, nonce, key)
+  t.alike(m, Buffer.from('no ad'), 'interoperates with next')
+})
+
+test('skipped message keys', function (t) {
+  const { a, b } = pair(4)
+  const sent = []
+
+  for (let i = 0; i < 10; i++) sent.push(encrypt(a, Buffer.from([i])))
+
+  t.alike(decrypt(b, sent[6]), Buffer.from([6]))
+  t.is(decrypt(b, sent[1]), null, 'the oldest skipped keys are dropped')
+
+  for (let i = 5; i >= 2; i--) t.alike(decrypt(b, sent[i]), Buffer.from([i]), 'late message ' + i)
+  t.is(decrypt(b, sent[3]), null, 'skipped keys are only used once')
+
+  const forged = Buffer.from(sent[9])
+  forged[forged.byteLength - 1] ^= 1
+  t.is(decrypt(b, forged), null, 'forged')
+  t.alike(decrypt(b, sent[7]), Buffer.from([7]), 'a forgery does not move the chain')
+
+  sodium.extension_ratchet_skip(b, 2)
+  t.alike(decrypt(b, sent[9]), Buffer.from([9]))
+  t.alike(decrypt(b, sent[8]), Buffer.from([8]))
+})
+
+test('messages too far ahead are dropped', function (t) {
+  const { a, b } = pair()
+  const c = encrypt(a, Buffer.from('hello'))
+
+  c.writeUInt32LE(sodium.extension_ratchet_SKIP_MAX + 1, 0)
+  t.is(decrypt(b, c), null)
+
+  t.exception(function () {
+    sodium.extension_ratchet_skip(b, sodium.extension_ratchet_SKIP_MAX + 1)
+  })
+})
+
+test('state is validated', function (t) {
+  t.exception.all(function () {
+    ratchet(Buffer.alloc(sodium.extension_ratchet_KEYBYTES), 0.5)
+  }, 'should validate state length')
+
+  t.exception(function () {
+    sodium.extension_ratchet_encrypt(Buffer.alloc(sodium.extension_ratchet_STATEBYTES), Buffer.alloc(OVERHEAD), Buffer.alloc(0))
+  }, 'uninitialised state throws')
+
+  const state = ratchet(Buffer.alloc(sodium.extension_ratchet_KEYBYTES), 2)
+  state.writeUInt32LE(3, 52)
+
+  t.exception(function () {
+    sodium.extension_ratchet_encrypt(state, Buffer.alloc(OVERHEAD), Buffer.alloc(0))
+  }, 'more skipped keys than fit throws')
+})
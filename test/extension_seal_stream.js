@@ -0,0 +1,119 @@
+const test = require('brittle')
+const sodium = require('..')
+const { isBare } = require('which-runtime')
+const fs = isBare ? null : require('fs')
+const os = isBare ? null : require('os')
+const path = isBare ? null : require('path')
+
+const {
+  extension_seal_stream_STATEBYTES: STATEBYTES,
+  extension_seal_stream_HEADERBYTES: HEADERBYTES,
+  extension_seal_stream_ABYTES: ABYTES
+} = sodium
+
+test('constants', function (t) {
+  t.is(HEADERBYTES, sodium.crypto_box_PUBLICKEYBYTES + sodium.crypto_secretstream_xchacha20poly1305_HEADERBYTES)
+  t.is(ABYTES, sodium.crypto_secretstream_xchacha20poly1305_ABYTES)
+  t.is(sodium.extension_seal_stream_PUBLICKEYBYTES, sodium.crypto_box_PUBLICKEYBYTES)
+  t.is(sodium.extension_seal_stream_SECRETKEYBYTES, sodium.crypto_box_SECRETKEYBYTES)
+})
+
+test('extension_seal_stream', function (t) {
+  const pk = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
+  const sk = Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES)
+  sodium.crypto_box_keypair(pk, sk)
+
+  const state = Buffer.alloc(STATEBYTES)
+  const header = Buffer.alloc(HEADERBYTES)
+  sodium.extension_seal_stream_init(state, header, pk)
+
+  const chunks = [10, 0, 1000, 3].map(function (len) {
+    const m = Buffer.alloc(len)
+    sodium.randombytes_buf(m)
+    return m
+  })
+
+  const sealed = chunks.map(function (m, i) {
+    const c = Buffer.alloc(m.byteLength + ABYTES)
+    if (i === chunks.length - 1) sodium.extension_seal_stream_final(state, c, m)
+    else sodium.extension_seal_stream_push(state, c, m)
+    return c
+  })
+
+  t.exception.all(function () {
+    sodium.extension_seal_stream_push(state, Buffer.alloc(ABYTES), Buffer.alloc(0))
+  }, 'no pushes after final')
+
+  const other = Buffer.alloc(STATEBYTES)
+  sodium.extension_seal_stream_open_init(other, header, pk, sk)
+
+  for (let i = 0; i < sealed.length; i++) {
+    const m = Buffer.alloc(sealed[i].byteLength - ABYTES)
+    t.is(sodium.extension_seal_stream_pull(other, m, sealed[i]), i === sealed.length - 1)
+    t.alike(m, chunks[i])
+  }
+
+  t.exception.all(function () {
+    sodium.extension_seal_stream_pull(other, Buffer.alloc(0), Buffer.alloc(ABYTES))
+  }, 'no pulls after final')
+
+  // the wrong recipient, or a reordered stream, does not open
+  const pk2 = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
+  const sk2 = Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES)
+  sodium.crypto_box_keypair(pk2, sk2)
+
+  sodium.extension_seal_stream_open_init(other, header, pk2, sk2)
+  t.exception.all(function () {
+    sodium.extension_seal_stream_pull(other, Buffer.alloc(chunks[0].byteLength), sealed[0])
+  }, 'wrong recipient')
+
+  sodium.extension_seal_stream_open_init(other, header, pk, sk)
+  t.exception.all(function () {
+    sodium.extension_seal_stream_pull(other, Buffer.alloc(chunks[1].byteLength), sealed[1])
+  }, 'out of order')
+
+  t.exception.all(function () {
+    sodium.extension_seal_stream_init(state, header, Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES))
+  }, 'low order public key')
+})
+
+test('extension_seal_stream_seal_file / open_file', { skip: isBare }, async function (t) {
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'sodium-native-'))
+  t.teardown(() => fs.rmSync(dir, { recursive: true, force: true }))
+
+  const pk = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
+  const sk = Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES)
+  sodium.crypto_box_keypair(pk, sk)
+
+  const plain = Buffer.alloc(100 * 1000 + 1)
+  sodium.randombytes_buf(plain)
+  fs.writeFileSync(path.join(dir, 'plain'), plain)
+
+  let progress = 0
+  const chunks = await sodium.extension_seal_stream_seal_file(path.join(dir, 'plain'), path.join(dir, 'sealed'), pk, 16384, {
+    onprogress (chunks) { progress = chunks }
+  })
+
+  t.is(chunks, 7)
+  t.is(progress, 7)
+
+  const sealed = fs.readFileSync(path.join(dir, 'sealed'))
+  t.is(sealed.byteLength, HEADERBYTES + plain.byteLength + chunks * ABYTES)
+
+  // the file opens chunk by chunk as well
+  const state = Buffer.alloc(STATEBYTES)
+  sodium.extension_seal_stream_open_init(state, sealed.subarray(0, HEADERBYTES), pk, sk)
+
+  const first = Buffer.alloc(16384)
+  t.is(sodium.extension_seal_stream_pull(state, first, sealed.subarray(HEADERBYTES, HEADERBYTES + 16384 + ABYTES)), false)
+  t.alike(first, plain.subarray(0, 16384))
+
+  await sodium.extension_seal_stream_open_file(path.join(dir, 'sealed'), path.join(dir, 'opened'), pk, sk, 16384)
+  t.alike(fs.readFileSync(path.join(dir, 'opened')), plain)
+
+  const pk2 = Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES)
+  const sk2 = Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES)
+  sodium.crypto_box_keypair(pk2, sk2)
+
+  await t.exception(sodium.extension_seal_stream_open_file(path.join(dir, 'sealed'), path.join(dir, 'opened'), pk2, sk2, 16384), /authenticate/)
+})
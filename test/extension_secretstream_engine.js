@@ -0,0 +1,189 @@
+const test = require('brittle')
+const sodium = require('..')
+
+const {
+  crypto_secretstream_xchacha20poly1305_ABYTES: ABYTES,
+  crypto_secretstream_xchacha20poly1305_STATEBYTES: STATEBYTES,
+  crypto_secretstream_xchacha20poly1305_HEADERBYTES: HEADERBYTES,
+  crypto_secretstream_xchacha20poly1305_KEYBYTES: KEYBYTES,
+  crypto_secretstream_xchacha20poly1305_TAG_MESSAGE: TAG_MESSAGE,
+  crypto_secretstream_xchacha20poly1305_TAG_FINAL: TAG_FINAL
+} = sodium
+
+test('constants', function (t) {
+  t.is(typeof sodium.extension_secretstream_engine_FAILED, 'number')
+})
+
+for (const async of [false, true]) {
+  test('extension_secretstream_engine push / pull' + (async ? ' async' : ''), async function (t) {
+    const pushBatch = async ? sodium.extension_secretstream_engine_push_async : sodium.extension_secretstream_engine_push
+    const pullBatch = async ? sodium.extension_secretstream_engine_pull_async : sodium.extension_secretstream_engine_pull
+
+    const streams = 7
+    const { push, pull, headers, keys } = tables(streams)
+
+    // several entries per stream, interleaved
+    const entries = []
+    for (let i = 0; i < 40; i++) {
+      const m = Buffer.alloc(sodium.randombytes_uniform(200))
+      sodium.randombytes_buf(m)
+      entries.push({ stream: (i * 3) % streams, m, tag: i >= 33 ? TAG_FINAL : TAG_MESSAGE })
+    }
+
+    const batch = pack(entries)
+    const c = Buffer.alloc(batch.m.byteLength + entries.length * ABYTES)
+    const lengths = new Uint32Array(entries.length)
+
+    t.is(await pushBatch(push, c, batch.m, batch.offsets, batch.streams, batch.tags, lengths), c.byteLength)
+
+    // every stream reads back with the single stream api
+    const single = Buffer.alloc(STATEBYTES)
+    const tag = Buffer.alloc(1)
+
+    for (let s = 0; s < streams; s++) {
+      sodium.crypto_secretstream_xchacha20poly1305_init_pull(single, headers[s], keys[s])
+
+      let at = 0
+      for (let i = 0; i < entries.length; i++) {
+        if (entries[i].stream === s) {
+          t.is(lengths[i], entries[i].m.byteLength + ABYTES)
+
+          const m = Buffer.alloc(entries[i].m.byteLength)
+          sodium.crypto_secretstream_xchacha20poly1305_pull(single, m, tag, c.subarray(at, at + lengths[i]), null)
+          if (!m.equals(entries[i].m) || tag[0] !== entries[i].tag) t.fail('stream ' + s + ' entry ' + i)
+        }
+        at += lengths[i]
+      }
+    }
+
+    // and the whole tick pulls in one call
+    const coffsets = new Uint32Array(entries.length + 1)
+    for (let i = 0; i < entries.length; i++) coffsets[i + 1] = coffsets[i] + lengths[i]
+
+    const m = Buffer.alloc(batch.m.byteLength)
+    const tags = Buffer.alloc(entries.length)
+    const mlengths = new Uint32Array(entries.length)
+
+    t.is(await pullBatch(pull, m, tags, c, coffsets, batch.streams, mlengths), 0)
+    t.alike(m, batch.m)
+    t.alike(tags, batch.tags)
+    t.alike(Array.from(mlengths), entries.map(e => e.m.byteLength))
+  })
+}
+
+test('extension_secretstream_engine pull stops a stream at its first bad frame', function (t) {
+  const { push, pull } = tables(2)
+
+  const entries = [0, 1, 0, 1, 0, 1].map(function (stream) {
+    return { stream, m: Buffer.from('hello'), tag: TAG_MESSAGE }
+  })
+
+  const batch = pack(entries)
+  const c = Buffer.alloc(batch.m.byteLength + entries.length * ABYTES)
+  const lengths = new Uint32Array(entries.length)
+
+  sodium.extension_secretstream_engine_push(push, c, batch.m, batch.offsets, batch.streams, batch.tags, lengths)
+
+  const coffsets = new Uint32Array(entries.length + 1)
+  for (let i = 0; i < entries.length; i++) coffsets[i + 1] = coffsets[i] + lengths[i]
+
+  // corrupt the second frame of stream 0
+  c[coffsets[2] + 3] ^= 1
+
+  const m = Buffer.alloc(batch.m.byteLength)
+  const tags = Buffer.alloc(entries.length)
+  const mlengths = new Uint32Array(entries.length)
+
+  t.is(sodium.extension_secretstream_engine_pull(pull, m, tags, c, coffsets, batch.streams, mlengths), 2)
+
+  const FAILED = sodium.extension_secretstream_engine_FAILED
+  t.alike(Array.from(mlengths), [5, 5, FAILED, 5, FAILED, 5])
+  t.alike(m.subarray(15, 20), Buffer.from('hello'), 'other streams are unaffected')
+})
+
+test('extension_secretstream_engine push_async with a callback', function (t) {
+  t.plan(2)
+
+  const { push } = tables(3)
+
+  const batch = pack([0, 1, 2, 0].map(stream => ({ stream, m: Buffer.alloc(10, stream), tag: TAG_MESSAGE })))
+  const c = Buffer.alloc(batch.m.byteLength + 4 * ABYTES)
+  const lengths = new Uint32Array(4)
+
+  sodium.extension_secretstream_engine_push_async(push, c, batch.m, batch.offsets, batch.streams, batch.tags, lengths, function (err, total) {
+    t.absent(err)
+    t.is(total, c.byteLength)
+  })
+})
+
+test('extension_secretstream_engine push_async ignores tables changed while pending', async function (t) {
+  const { push } = tables(3)
+
+  const batch = pack([0, 1, 2, 0].map(stream => ({ stream, m: Buffer.alloc(10, stream), tag: TAG_MESSAGE })))
+  const c = Buffer.alloc(batch.m.byteLength + 4 * ABYTES)
+  const lengths = new Uint32Array(4)
+
+  const pushing = sodium.extension_secretstream_engine_push_async(push, c, batch.m, batch.offsets, batch.streams, batch.tags, lengths)
+  batch.offsets.fill(0xffffffff)
+  batch.streams.fill(0xffffffff)
+
+  t.is(await pushing, c.byteLength)
+  t.alike(Array.from(lengths), [10 + ABYTES, 10 + ABYTES, 10 + ABYTES, 10 + ABYTES])
+})
+
+test('extension_secretstream_engine validates the batch', function (t) {
+  const { push } = tables(2)
+
+  const batch = pack([{ stream: 0, m: Buffer.alloc(4), tag: TAG_MESSAGE }])
+  const c = Buffer.alloc(4 + ABYTES)
+  const lengths = new Uint32Array(1)
+
+  t.exception.all(function () {
+    sodium.extension_secretstream_engine_push(push.subarray(1), c, batch.m, batch.offsets, batch.streams, batch.tags, lengths)
+  }, 'table not a multiple of STATEBYTES')
+
+  t.exception.all(function () {
+    sodium.extension_secretstream_engine_push(push, c, batch.m, batch.offsets, new Uint32Array([2]), batch.tags, lengths)
+  }, 'stream out of range')
+
+  t.exception.all(function () {
+    sodium.extension_secretstream_engine_push(push, c.subarray(1), batch.m, batch.offsets, batch.streams, batch.tags, lengths)
+  }, 'c too short')
+
+  t.exception.all(function () {
+    sodium.extension_secretstream_engine_push_async(push, c, batch.m, batch.offsets, batch.streams, batch.tags, lengths, 'not a function')
+  }, 'callback must be a function')
+})
+
+function tables (streams) {
+  const push = Buffer.alloc(streams * STATEBYTES)
+  const pull = Buffer.alloc(streams * STATEBYTES)
+  const headers = []
+  const keys = []
+
+  for (let s = 0; s < streams; s++) {
+    const key = Buffer.alloc(KEYBYTES)
+    const header = Buffer.alloc(HEADERBYTES)
+    sodium.crypto_secretstream_xchacha20poly1305_keygen(key)
+
+    sodium.crypto_secretstream_xchacha20poly1305_init_push(push.subarray(s * STATEBYTES, (s + 1) * STATEBYTES), header, key)
+    sodium.crypto_secretstream_xchacha20poly1305_init_pull(pull.subarray(s * STATEBYTES, (s + 1) * STATEBYTES), header, key)
+
+    headers.push(header)
+    keys.push(key)
+  }
+
+  return { push, pull, headers, keys }
+}
+
+function pack (entries) {
+  const offsets = new Uint32Array(entries.length + 1)
+  for (let i = 0; i < entries.length; i++) offsets[i + 1] = offsets[i] + entries[i].m.byteLength
+
+  return {
+    m: Buffer.concat(entries.map(e => e.m)),
+    offsets,
+    streams: Uint32Array.from(entries, e => e.stream),
+    tags: Buffer.from(entries.map(e => e.tag))
+  }
+}
@@ -0,0 +1,136 @@
+const test = require('brittle')
+const sodium = require('..')
+const { isBare } = require('which-runtime')
+const fs = isBare ? null : require('fs')
+const os = isBare ? null : require('os')
+const path = isBare ? null : require('path')
+
+const {
+  crypto_secretstream_xchacha20poly1305_ABYTES: ABYTES,
+  crypto_secretstream_xchacha20poly1305_HEADERBYTES: HEADERBYTES,
+  crypto_secretstream_xchacha20poly1305_KEYBYTES: KEYBYTES,
+  crypto_secretstream_xchacha20poly1305_STATEBYTES: STATEBYTES,
+  crypto_secretstream_xchacha20poly1305_TAG_FINAL: TAG_FINAL
+} = sodium
+
+test('extension_secretstream_encrypt_file / decrypt_file', { skip: isBare }, async function (t) {
+  const dir = tmp(t)
+  const key = Buffer.alloc(KEYBYTES)
+  sodium.crypto_secretstream_xchacha20poly1305_keygen(key)
+
+  for (const size of [0, 1, 4096, 4097, 100000]) {
+    const plain = Buffer.alloc(size)
+    sodium.randombytes_buf(plain)
+
+    fs.writeFileSync(path.join(dir, 'plain'), plain)
+
+    const progress = []
+    const chunks = await sodium.extension_secretstream_encrypt_file(path.join(dir, 'plain'), path.join(dir, 'cipher'), key, 4096, {
+      onprogress (chunks, bytes) { progress.push([chunks, bytes]) }
+    })
+
+    const n = Math.max(1, Math.ceil(size / 4096))
+    t.is(chunks, n, size + ' bytes in ' + n + ' chunks')
+    t.alike(progress[progress.length - 1], [n, size], 'progress reaches the end')
+
+    const cipher = fs.readFileSync(path.join(dir, 'cipher'))
+    t.is(cipher.byteLength, HEADERBYTES + size + n * ABYTES)
+
+    // the output is a plain secretstream
+    const state = Buffer.alloc(STATEBYTES)
+    const tag = Buffer.alloc(1)
+    sodium.crypto_secretstream_xchacha20poly1305_init_pull(state, cipher.subarray(0, HEADERBYTES), key)
+
+    const frames = []
+    for (let at = HEADERBYTES; at < cipher.byteLength; at += 4096 + ABYTES) {
+      const frame = cipher.subarray(at, at + 4096 + ABYTES)
+      const m = Buffer.alloc(frame.byteLength - ABYTES)
+      sodium.crypto_secretstream_xchacha20poly1305_pull(state, m, tag, frame, null)
+      frames.push(m)
+    }
+
+    t.alike(Buffer.concat(frames), plain)
+    t.is(tag[0], TAG_FINAL)
+
+    await sodium.extension_secretstream_decrypt_file(path.join(dir, 'cipher'), path.join(dir, 'decrypted'), key, 4096)
+    t.alike(fs.readFileSync(path.join(dir, 'decrypted')), plain)
+  }
+})
+
+test('extension_secretstream_encrypt_file / decrypt_file resume', { skip: isBare }, async function (t) {
+  const dir = tmp(t)
+  const key = Buffer.alloc(KEYBYTES)
+  sodium.crypto_secretstream_xchacha20poly1305_keygen(key)
+
+  const plain = Buffer.alloc(10 * 1000 + 7)
+  sodium.randombytes_buf(plain)
+  fs.writeFileSync(path.join(dir, 'plain'), plain)
+
+  await sodium.extension_secretstream_encrypt_file(path.join(dir, 'plain'), path.join(dir, 'cipher'), key, 1000)
+  const cipher = fs.readFileSync(path.join(dir, 'cipher'))
+
+  // interrupted after 4 whole frames and part of the fifth
+  fs.writeFileSync(path.join(dir, 'partial'), cipher.subarray(0, HEADERBYTES + 4 * (1000 + ABYTES) + 100))
+
+  const progress = []
+  const chunks = await sodium.extension_secretstream_encrypt_file(path.join(dir, 'plain'), path.join(dir, 'partial'), key, 1000, {
+    start: 4,
+    onprogress (chunks) { progress.push(chunks) }
+  })
+
+  t.is(chunks, 11)
+  t.is(progress[0], 5, 'progress continues from the resumed chunk')
+  t.alike(fs.readFileSync(path.join(dir, 'partial')), cipher, 'resumed encryption matches')
+
+  fs.writeFileSync(path.join(dir, 'decrypted'), plain.subarray(0, 3000))
+  await sodium.extension_secretstream_decrypt_file(path.join(dir, 'cipher'), path.join(dir, 'decrypted'), key, 1000, { start: 3 })
+  t.alike(fs.readFileSync(path.join(dir, 'decrypted')), plain, 'resumed decryption matches')
+
+  // resuming onto output from another key fails to replay
+  const other = Buffer.alloc(KEYBYTES)
+  sodium.crypto_secretstream_xchacha20poly1305_keygen(other)
+
+  await t.exception(sodium.extension_secretstream_encrypt_file(path.join(dir, 'plain'), path.join(dir, 'partial'), other, 1000, { start: 4 }), /authenticate/)
+})
+
+test('extension_secretstream_decrypt_file rejects bad input', { skip: isBare }, async function (t) {
+  const dir = tmp(t)
+  const key = Buffer.alloc(KEYBYTES)
+  sodium.crypto_secretstream_xchacha20poly1305_keygen(key)
+
+  const plain = Buffer.alloc(5000)
+  sodium.randombytes_buf(plain)
+  fs.writeFileSync(path.join(dir, 'plain'), plain)
+
+  await sodium.extension_secretstream_encrypt_file(path.join(dir, 'plain'), path.join(dir, 'cipher'), key, 1000)
+  const cipher = fs.readFileSync(path.join(dir, 'cipher'))
+
+  // dropping the final frame
+  fs.writeFileSync(path.join(dir, 'truncated'), cipher.subarray(0, HEADERBYTES + 4 * (1000 + ABYTES)))
+
+  try {
+    await sodium.extension_secretstream_decrypt_file(path.join(dir, 'truncated'), path.join(dir, 'out'), key, 1000)
+    t.fail('truncated file decrypted')
+  } catch (err) {
+    t.is(err.code, 'EAUTH')
+    t.is(err.chunks, 3, 'frames before the failure were written')
+  }
+
+  const tampered = Buffer.from(cipher)
+  tampered[HEADERBYTES + 2 * (1000 + ABYTES) + 10] ^= 1
+  fs.writeFileSync(path.join(dir, 'tampered'), tampered)
+
+  await t.exception(sodium.extension_secretstream_decrypt_file(path.join(dir, 'tampered'), path.join(dir, 'out'), key, 1000), /authenticate/)
+  await t.exception(sodium.extension_secretstream_decrypt_file(path.join(dir, 'cipher'), path.join(dir, 'out'), key, 1100), /authenticate/, 'wrong chunk size')
+  await t.exception(sodium.extension_secretstream_decrypt_file(path.join(dir, 'missing'), path.join(dir, 'out'), key, 1000), /no such file/)
+
+  t.exception.all(function () {
+    sodium.extension_secretstream_encrypt_file(path.join(dir, 'plain'), path.join(dir, 'out'), key, 0)
+  }, 'chunkSize must be positive')
+})
+
+function tmp (t) {
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'sodium-native-'))
+  t.teardown(() => fs.rmSync(dir, { recursive: true, force: true }))
+  return dir
+}
@@ -0,0 +1,143 @@
+const test = require('brittle')
+const sodium = require('..')
+
+const OVERHEAD = sodium.extension_transport_HEADERBYTES + sodium.extension_transport_ABYTES
+
+function pair (rekey = 0) {
+  const k1 = Buffer.alloc(sodium.extension_transport_KEYBYTES)
+  const k2 = Buffer.alloc(sodium.extension_transport_KEYBYTES)
+  sodium.randombytes_buf(k1)
+  sodium.randombytes_buf(k2)
+
+  const a = sodium.sodium_malloc(sodium.extension_transport_STATEBYTES)
+  const b = sodium.sodium_malloc(sodium.extension_transport_STATEBYTES)
+
+  sodium.extension_transport_init(a, k1, k2, rekey)
+  sodium.extension_transport_init(b, k2, k1, rekey)
+
+  return { a, b }
+}
+
+function seal (state, m) {
+  const c = Buffer.alloc(m.byteLength + OVERHEAD)
+  sodium.extension_transport_seal(state, c, m)
+  return c
+}
+
+function open (state, c) {
+  const m = Buffer.alloc(c.byteLength - OVERHEAD)
+  return sodium.extension_transport_open(state, m, c) ? m : null
+}
+
+test('constants', function (t) {
+  t.is(sodium.extension_transport_STATEBYTES, 400)
+  t.is(sodium.extension_transport_KEYBYTES, 32)
+  t.is(sodium.extension_transport_HEADERBYTES, 8)
+  t.is(sodium.extension_transport_ABYTES, 16)
+  t.is(sodium.extension_transport_WINDOW, 2040)
+  t.is(sodium.extension_transport_FAILED, 0xffffffff)
+})
+
+test('seal and open both ways', function (t) {
+  const { a, b } = pair()
+
+  const c = seal(a, Buffer.from('hello'))
+  t.is(c.readUInt32LE(0), 0, 'counter in the clear')
+  t.alike(open(b, c), Buffer.from('hello'))
+
+  t.alike(open(a, seal(b, Buffer.from('world'))), Buffer.from('world'))
+  t.is(seal(a, Buffer.alloc(0)).readUInt32LE(0), 1)
+
+  t.is(open(a, c), null, 'keys are one-way')
+})
+
+test('replays and stale datagrams are dropped', function (t) {
+  const { a, b } = pair()
+  const sent = []
+
+  for (let i = 0; i < sodium.extension_transport_WINDOW + 10; i++) sent.push(seal(a, Buffer.from([i & 0xff])))
+
+  t.ok(open(b, sent[5]))
+  t.is(open(b, sent[5]), null, 'replay')
+  t.ok(open(b, sent[2]), 'reordered')
+
+  const last = sent.length - 1
+  t.ok(open(b, sent[last]))
+  t.ok(open(b, sent[last - sodium.extension_transport_WINDOW]), 'oldest in window')
+  t.is(open(b, sent[last - sodium.extension_transport_WINDOW - 1]), null, 'older than the window')
+
+  const forged = Buffer.from(sent[last - 1])
+  forged[forged.byteLength - 1] ^= 1
+  t.is(open(b, forged), null, 'forged')
+  t.ok(open(b, sent[last - 1]), 'a forgery does not burn the counter')
+})
+
+test('rekeys every N messages', function (t) {
+  const { a, b } = pair(10)
+  const sent = []
+
+  for (let i = 0; i < 60; i++) sent.push(seal(a, Buffer.from([i])))
+
+  // reorder across the epoch boundaries
+  for (let i = 0; i < 60; i += 2) {
+    t.alike(open(b, sent[i + 1]), Buffer.from([i + 1]))
+    t.alike(open(b, sent[i]), Buffer.from([i]))
+  }
+
+  // a rekey after every message puts consecutive datagrams in different epochs
+  const rekeyed = pair(1)
+  const c0 = seal(rekeyed.a, Buffer.from('x'))
+  const c1 = seal(rekeyed.a, Buffer.from('y'))
+  t.ok(open(rekeyed.b, c1), 'derives the next epoch')
+  t.ok(open(rekeyed.b, c0), 'keeps the previous epoch')
+})
+
+test('datagrams too many epochs ahead are dropped', function (t) {
+  const { a, b } = pair(1)
+  const sent = []
+
+  for (let i = 0; i < sodium.extension_transport_EPOCHS_AHEAD + 2; i++) sent.push(seal(a, Buffer.alloc(1)))
+
+  t.is(open(b, sent[sodium.extension_transport_EPOCHS_AHEAD + 1]), null)
+  t.ok(open(b, sent[sodium.extension_transport_EPOCHS_AHEAD]))
+})
+
+test('open many', function (t) {
+  const { a, b } = pair(4)
+  const datagrams = []
+
+  for (let i = 0; i < 10; i++) datagrams.push(seal(a, Buffer.alloc(i * 3, i)))
+
+  datagrams.push(datagrams[2])
+  datagrams[7] = Buffer.from(datagrams[7])
+  datagrams[7][9] ^= 1
+
+  const c = Buffer.concat(datagrams)
+  const offsets = new Uint32Array(datagrams.length + 1)
+  for (let i = 0; i < datagrams.length; i++) offsets[i + 1] = offsets[i] + datagrams[i].byteLength
+
+  const m = Buffer.alloc(c.byteLength - datagrams.length * OVERHEAD)
+  const lengths = new Uint32Array(datagrams.length)
+
+  t.is(sodium.extension_transport_open_many(b, m, c, offsets, lengths), 9)
+
+  for (let i = 0; i < datagrams.length; i++) {
+    if (i === 7 || i === 10) {
+      t.is(lengths[i], sodium.extension_transport_FAILED)
+      continue
+    }
+
+    const at = offsets[i] - i * OVERHEAD
+    t.alike(m.subarray(at, at + lengths[i]), Buffer.alloc(i * 3, i))
+  }
+
+  t.exception.all(function () {
+    sodium.extension_transport_open_many(b, m, c, new Uint32Array([0, 10]), new Uint32Array(1))
+  }, 'should validate datagram length')
+})
+
+test('uninitialised state throws', function (t) {
+  t.exception(function () {
+    sodium.extension_transport_seal(Buffer.alloc(sodium.extension_transport_STATEBYTES), Buffer.alloc(OVERHEAD), Buffer.alloc(0))
+  })
+})
@@ -10,7 +10,9 @@ const N = {
   hash_batch_len: 64,
   hash_batch_calls: 1 * _e,
   stream_xor_calls: 1 * _e,
-  stream_xchacha20_calls: 1 * _e // 2 calls per loop
+  stream_xchacha20_calls: 1 * _e, // 2 calls per loop
+  onetimeauth_calls: 1 * _e,
+  aead_calls: 1 * _e // 2 calls per loop
 }
 
 test('fastcall: crypto_generichash', t => {
@@ -168,6 +170,42 @@ test('fastcall: crypto_secretstream_xchacha20poly1305_push & pull', t => {
   bpush(-1)
 })
 
+test('fastcall: crypto_onetimeauth 64KiB', t => {
+  const message = Buffer.alloc(65536, 0xaa)
+  const key = Buffer.alloc(sodium.crypto_onetimeauth_KEYBYTES)
+  const mac = Buffer.alloc(sodium.crypto_onetimeauth_BYTES)
+
+  sodium.randombytes_buf(key)
+
+  const bpush = benchmark(t)
+
+  for (let i = 0; i < N.onetimeauth_calls; i++) {
+    sodium.crypto_onetimeauth(mac, message, key)
+    bpush(1)
+  }
+
+  bpush(-1)
+})
+
+test('fastcall: crypto_aead_chacha20poly1305_ietf 64KiB', t => {
+  const message = Buffer.alloc(65536, 0xaa)
+  const cipher = Buffer.alloc(message.byteLength + sodium.crypto_aead_chacha20poly1305_ietf_ABYTES)
+  const nonce = Buffer.alloc(sodium.crypto_aead_chacha20poly1305_ietf_NPUBBYTES)
+  const key = Buffer.alloc(sodium.crypto_aead_chacha20poly1305_ietf_KEYBYTES)
+
+  sodium.crypto_aead_chacha20poly1305_ietf_keygen(key)
+
+  const bpush = benchmark(t)
+
+  for (let i = 0; i < N.aead_calls; i++) {
+    sodium.crypto_aead_chacha20poly1305_ietf_encrypt(cipher, message, null, null, nonce, key)
+    sodium.crypto_aead_chacha20poly1305_ietf_decrypt(message, null, cipher, null, nonce, key)
+    bpush(2)
+  }
+
+  bpush(-1)
+})
+
 function benchmark (t, interval = 2000) {
   let prev
   const start = prev = Date.now()